@@ -0,0 +1,230 @@
+#!/usr/bin/env python3
+"""Benchmark regression tracker for math-benchmark.
+
+  compare.py record  --benchmark BIN --baseline FILE [--filter REGEX] [--repetitions N]
+  compare.py compare --benchmark BIN --baseline FILE [--filter REGEX] [--repetitions N]
+                     [--current FILE] [--threshold PCT] [--alpha P]
+
+`record` runs the suite with repetitions and stores google benchmark's JSON output as the
+baseline. `compare` reruns the suite (or loads --current) and compares it against the baseline.
+
+Every ak benchmark is expressed as a ratio to its glm and Eigen counterparts from the same run,
+e.g. Mat4Multiplication<ak::Mat4> / Mat4Multiplication<glm::mat4>, or Mat4Inverse /
+GlmMat4Inverse. Machine speed and noise mostly cancel out of the ratio, so a baseline recorded on
+one day (or one machine of the same type) stays comparable. Benchmarks without a counterpart fall
+back to absolute times.
+
+Per benchmark and reference, the baseline and current per-repetition samples are compared with a
+two-sided Mann-Whitney U test. A benchmark regresses when, for every reference it has, the median
+got slower by more than --threshold percent with p < --alpha. The exit code is 1 if anything
+regressed, 2 on usage errors, 0 otherwise.
+"""
+import argparse
+import json
+import math
+import os
+import re
+import statistics
+import subprocess
+import sys
+import tempfile
+
+# ak type -> (glm type, Eigen type) as they appear in benchmark template arguments
+REFERENCE_TYPES = {
+    "ak::Vec2": ("glm::vec2", "Eigen::Vector2f"),
+    "ak::Vec3": ("glm::vec3", "Eigen::Vector3f"),
+    "ak::Vec4": ("glm::vec4", "Eigen::Vector4f"),
+    "ak::Mat3": ("glm::mat3", "Eigen::Matrix3f"),
+    "ak::Mat4": ("glm::mat4", "Eigen::Matrix4f"),
+    "ak::Quat": ("glm::quat", None),
+}
+REFERENCE_NAMES = ("glm", "Eigen")
+# Plain benchmarks name their counterparts with a library prefix: Mat4Inverse -> GlmMat4Inverse
+REFERENCE_PREFIXES = ("Glm", "Eigen")
+# Benchmarks of non-ak code (other libraries, naive loops) are only used as references
+NON_AK_PREFIXES = REFERENCE_PREFIXES + ("Dx",)
+NON_AK_MARKERS = ("glm::", "Eigen::", "XMMATRIX", "XMVECTOR", "Libm", "Naive", "Loop")
+
+TIME_UNITS = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}
+
+
+def run_suite(benchmark, filter_regex, repetitions, out_path):
+    command = [
+        benchmark,
+        "--benchmark_repetitions=%d" % repetitions,
+        # Interleave repetitions so a slow patch of machine time hits ak and references alike
+        "--benchmark_enable_random_interleaving=true",
+        "--benchmark_out=%s" % out_path,
+        "--benchmark_out_format=json",
+    ]
+    if filter_regex:
+        command.append("--benchmark_filter=%s" % filter_regex)
+    print("Running " + " ".join(command), flush=True)
+    subprocess.run(command, check=True, stdout=subprocess.DEVNULL)
+
+
+def load_samples(path):
+    """Returns {run_name: {repetition index: real time in ns}}."""
+    with open(path) as f:
+        data = json.load(f)
+    samples = {}
+    for run in data["benchmarks"]:
+        if run.get("run_type", "iteration") != "iteration" or run.get("error_occurred"):
+            continue
+        name = run.get("run_name", run["name"])
+        runs = samples.setdefault(name, {})
+        # Older google benchmark versions don't write repetition_index; count in file order
+        index = run.get("repetition_index", len(runs))
+        runs[index] = run["real_time"] * TIME_UNITS[run["time_unit"]]
+    return samples
+
+
+def references(name, names):
+    """Returns [(library, reference run name)] for an ak benchmark name present in `names`."""
+    found = []
+    if "ak::" in name:
+        for index, library in enumerate(REFERENCE_NAMES):
+            candidate = name
+            for ak_type, counterparts in REFERENCE_TYPES.items():
+                pattern = re.escape(ak_type) + r"\b"
+                if counterparts[index] is not None:
+                    candidate = re.sub(pattern, counterparts[index], candidate)
+                elif re.search(pattern, name):
+                    candidate = None  # no counterpart in this library
+                    break
+            if candidate and candidate != name and candidate in names:
+                found.append((library, candidate))
+    else:
+        for library, prefix in zip(REFERENCE_NAMES, REFERENCE_PREFIXES):
+            if prefix + name in names:
+                found.append((library, prefix + name))
+    return found
+
+
+def is_reference(name):
+    return name.startswith(NON_AK_PREFIXES) or any(marker in name for marker in NON_AK_MARKERS)
+
+
+def series(samples, name, reference):
+    """Per-repetition ak/reference ratios, or absolute times without a reference.
+
+    With random interleaving, repetition k of every benchmark runs in the same shuffled round, so
+    a ratio pairs samples by repetition index rather than by their order in the file.
+    """
+    values = samples.get(name, {})
+    if reference is None:
+        return [values[index] for index in sorted(values)]
+    base = samples.get(reference, {})
+    return [values[index] / base[index] for index in sorted(values)
+            if base.get(index, 0.0) > 0.0]
+
+
+def mann_whitney_p(a, b):
+    """Two-sided p-value of the Mann-Whitney U test, normal approximation with tie correction."""
+    n1, n2 = len(a), len(b)
+    if n1 == 0 or n2 == 0:
+        return 1.0
+    combined = sorted([(v, 0) for v in a] + [(v, 1) for v in b])
+    n = n1 + n2
+    ranks = [0.0] * n
+    ties = 0.0
+    ii = 0
+    while ii < n:
+        jj = ii
+        while jj + 1 < n and combined[jj + 1][0] == combined[ii][0]:
+            jj += 1
+        for kk in range(ii, jj + 1):
+            ranks[kk] = (ii + jj) / 2.0 + 1.0
+        t = jj - ii + 1
+        ties += t * t * t - t
+        ii = jj + 1
+    r1 = sum(rank for rank, (_, group) in zip(ranks, combined) if group == 0)
+    u1 = r1 - n1 * (n1 + 1) / 2.0
+    sigma = math.sqrt(n1 * n2 / 12.0 * ((n + 1) - ties / (n * (n - 1))))
+    if sigma == 0.0:
+        return 1.0
+    z = max(abs(u1 - n1 * n2 / 2.0) - 0.5, 0.0) / sigma
+    return math.erfc(z / math.sqrt(2.0))
+
+
+def compare(baseline, current, threshold, alpha):
+    names = set(current)
+    rows = []
+    regressions = []
+    for name in sorted(names):
+        if is_reference(name) or name not in baseline:
+            continue
+        refs = references(name, names) or [(None, None)]
+        verdicts = []
+        for library, reference in refs:
+            if reference is not None and reference not in baseline:
+                continue
+            old = series(baseline, name, reference)
+            new = series(current, name, reference)
+            if not old or not new:
+                continue
+            old_median = statistics.median(old)
+            new_median = statistics.median(new)
+            delta = (new_median / old_median - 1.0) * 100.0 if old_median > 0.0 else 0.0
+            p = mann_whitney_p(old, new)
+            slower = p < alpha and delta > threshold
+            verdicts.append(slower)
+            rows.append((name, library or "abs", old_median, new_median, delta, p, slower))
+        if verdicts and all(verdicts):
+            regressions.append(name)
+    return rows, regressions
+
+
+def print_table(rows):
+    width = max([len("benchmark")] + [len(row[0]) for row in rows])
+    print("%-*s  %-5s  %12s  %12s  %8s  %7s" %
+          (width, "benchmark", "vs", "baseline", "current", "delta", "p"))
+    for name, library, old, new, delta, p, slower in rows:
+        print("%-*s  %-5s  %12.4g  %12.4g  %+7.1f%%  %7.4f%s" %
+              (width, name, library, old, new, delta, p, "  SLOWER" if slower else ""))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="math-benchmark regression tracker")
+    parser.add_argument("mode", choices=["record", "compare"])
+    parser.add_argument("--benchmark", help="Path to the math-benchmark executable")
+    parser.add_argument("--baseline", required=True, help="Baseline JSON to write or compare to")
+    parser.add_argument("--current", help="Compare this JSON instead of running the suite")
+    parser.add_argument("--filter", default="", help="--benchmark_filter regex")
+    parser.add_argument("--repetitions", type=int, default=10)
+    parser.add_argument("--threshold", type=float, default=5.0,
+                        help="Slowdown in percent that counts as a regression")
+    parser.add_argument("--alpha", type=float, default=0.05, help="Significance level")
+    args = parser.parse_args()
+
+    if args.mode == "record":
+        if not args.benchmark:
+            parser.error("record needs --benchmark")
+        run_suite(args.benchmark, args.filter, args.repetitions, args.baseline)
+        print("Baseline written to " + args.baseline)
+        return 0
+
+    if args.current is not None:
+        current = load_samples(args.current)
+    else:
+        if not args.benchmark:
+            parser.error("compare needs --benchmark or --current")
+        with tempfile.TemporaryDirectory() as directory:
+            current_path = os.path.join(directory, "current.json")
+            run_suite(args.benchmark, args.filter, args.repetitions, current_path)
+            current = load_samples(current_path)
+
+    rows, regressions = compare(load_samples(args.baseline), current, args.threshold, args.alpha)
+    print_table(rows)
+    if regressions:
+        print("\n%d regression(s) beyond %.1f%% (p < %g):" %
+              (len(regressions), args.threshold, args.alpha))
+        for name in regressions:
+            print("  " + name)
+        return 1
+    print("\nNo significant regressions beyond %.1f%%" % args.threshold)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
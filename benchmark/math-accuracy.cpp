@@ -0,0 +1,1246 @@
+/*
+ * Accuracy vs speed of akmath's float functions
+ *
+ * Each benchmark runs one implementation over a dense sweep of inputs and compares every result
+ * with a double precision reference. Errors are in ULPs, the float spacing at the reference value:
+ *   - Scalar results are measured component-wise.
+ *   - Vector, quaternion and matrix results are measured norm-wise, against the ULP of their
+ *     largest reference component. A component that cancels to nearly zero carries the absolute
+ *     error of the others, and a relative error on it says nothing about the function.
+ *   - Products (dot, cross, matrix and quaternion products, transforms) are measured against the
+ *     ULP of the magnitude of their terms, e.g. sum(|a[i] * b[i]|) for a dot product. A result
+ *     that cancels has the rounding error of its terms, which no float kernel can avoid.
+ * max_ulp and mean_ulp are the worst and average per-item errors over the whole sweep, and max_abs
+ * the largest absolute error of any component, which is what SinCosFast bounds. The timed loop
+ * covers the first kTimedItems items, which fit in L1/L2, so ns/op is the compute cost and not
+ * memory bandwidth.
+ *
+ * --accuracy_table=FILE also writes every result as a markdown table to FILE. The accuracy-table
+ * target regenerates benchmark/accuracy.md this way. To cover a new function, add a reference
+ * struct and register its variants in main().
+ */
+#include "akmath.h"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+#include <random>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+namespace {
+
+size_t const kTimedItems = 1024;
+
+// Fixed-size array aligned for the widest SIMD loads, since C++14's new ignores alignas(64)
+template<typename T>
+class Buffer
+{
+public:
+    explicit Buffer(size_t const n)
+        : data(static_cast<T*>(_mm_malloc((n != 0 ? n : 1) * sizeof(T), 64)))
+        , count(n)
+    {
+        for (size_t ii = 0; ii < count; ++ii) {
+            new (&data[ii]) T;
+        }
+    }
+    Buffer(size_t const n, void (*const fill)(T*, size_t)) : Buffer(n)
+    {
+        fill(data, count);
+    }
+    ~Buffer()
+    {
+        _mm_free(data);
+    }
+    Buffer(Buffer const&) = delete;
+    Buffer& operator=(Buffer const&) = delete;
+
+    T* data;
+    size_t count;
+};
+
+/*****************************************************************************\
+ * Input sweeps                                                               *
+\*****************************************************************************/
+// Each sweep has its own seed, so inputs don't depend on which benchmarks run
+float Uniform(std::mt19937& rng, float const min, float const max)
+{
+    return std::uniform_real_distribution<float>(min, max)(rng);
+}
+
+// Half in [-8, 8], where results should be near correctly rounded, and half in [-8192, 8192]
+void FillAngles(float* const x, size_t const n)
+{
+    for (size_t ii = 0; ii < n; ++ii) {
+        float const range = ii % 2 == 0 ? 8.0f : 8192.0f;
+        x[ii] = (static_cast<float>(ii / 2) / static_cast<float>(n / 2) * 2.0f - 1.0f) * range;
+    }
+    std::shuffle(x, x + n, std::mt19937(1));
+}
+
+// Directions scaled by 2^-16 to 2^16, well inside the range where LengthSq neither under- nor
+// overflows
+template<typename Vector>
+Vector RandomVector(std::mt19937& rng)
+{
+    Vector v;
+    float const scale = ldexpf(1.0f, static_cast<int>(rng() % 33) - 16);
+    float* const f = &v.x;
+    for (size_t cc = 0; cc < sizeof(Vector) / sizeof(float); ++cc) {
+        f[cc] = Uniform(rng, -1.0f, 1.0f) * scale;
+    }
+    return v;
+}
+template<typename Vector>
+void FillVectors(Vector* const v, size_t const n)
+{
+    std::mt19937 rng(2);
+    for (size_t ii = 0; ii < n; ++ii) {
+        v[ii] = RandomVector<Vector>(rng);
+    }
+}
+
+ak::Quat RandomRotation(std::mt19937& rng)
+{
+    ak::Vec3 axis;
+    do {
+        axis = {Uniform(rng, -1.0f, 1.0f), Uniform(rng, -1.0f, 1.0f), Uniform(rng, -1.0f, 1.0f)};
+    } while (ak::LengthSq(axis) < 0.01f);
+    return ak::Quat::RotationAxis(ak::Normalize(axis), Uniform(rng, -3.14159f, 3.14159f));
+}
+
+// General N x N matrices: entries in [-1, 1] plus N + 1 on the diagonal. Each row's diagonal then
+// exceeds the sum of its other entries by at least 1, so ||m^-1||_inf <= 1 and the condition
+// number ||m||_inf * ||m^-1||_inf is at most 2N + 1 (7 for Mat3, 9 for Mat4). Norm-wise inverse
+// errors scale with it; near-singular inputs would measure the input rather than the kernel.
+void FillMat3(ak::Mat3* const m, size_t const n)
+{
+    std::mt19937 rng(3);
+    for (size_t ii = 0; ii < n; ++ii) {
+        float* const f = &m[ii].c0.x;
+        for (size_t cc = 0; cc < 9; ++cc) {
+            f[cc] = Uniform(rng, -1.0f, 1.0f) + (cc % 4 == 0 ? 4.0f : 0.0f);
+        }
+    }
+}
+void FillMat4(ak::Mat4* const m, size_t const n)
+{
+    std::mt19937 rng(4);
+    for (size_t ii = 0; ii < n; ++ii) {
+        float* const f = &m[ii].c0.x;
+        for (size_t cc = 0; cc < 16; ++cc) {
+            f[cc] = Uniform(rng, -1.0f, 1.0f) + (cc % 5 == 0 ? 5.0f : 0.0f);
+        }
+    }
+}
+// Rotation, non-uniform scale in [0.5, 2] and translation within 100
+void FillAffine(ak::Mat4* const m, size_t const n)
+{
+    std::mt19937 rng(5);
+    for (size_t ii = 0; ii < n; ++ii) {
+        ak::Transform const t = {RandomRotation(rng),
+                                 {Uniform(rng, -100.0f, 100.0f), Uniform(rng, -100.0f, 100.0f),
+                                  Uniform(rng, -100.0f, 100.0f)},
+                                 1.0f};
+        m[ii] = ak::Mat4::FromTransform(t) *
+                ak::Mat4::Scaling(Uniform(rng, 0.5f, 2.0f), Uniform(rng, 0.5f, 2.0f),
+                                  Uniform(rng, 0.5f, 2.0f));
+    }
+}
+void FillRigid(ak::Mat4* const m, size_t const n)
+{
+    std::mt19937 rng(6);
+    for (size_t ii = 0; ii < n; ++ii) {
+        ak::Transform const t = {RandomRotation(rng),
+                                 {Uniform(rng, -100.0f, 100.0f), Uniform(rng, -100.0f, 100.0f),
+                                  Uniform(rng, -100.0f, 100.0f)},
+                                 1.0f};
+        m[ii] = ak::Mat4::FromTransform(t);
+    }
+}
+
+struct SlerpInput
+{
+    ak::Quat a;
+    ak::Quat b;
+    float t;
+};
+void FillSlerp(SlerpInput* const in, size_t const n)
+{
+    std::mt19937 rng(7);
+    for (size_t ii = 0; ii < n; ++ii) {
+        in[ii] = {RandomRotation(rng), RandomRotation(rng), Uniform(rng, 0.0f, 1.0f)};
+    }
+}
+
+// Operands of a binary function
+template<typename T>
+struct Pair
+{
+    T a;
+    T b;
+};
+template<typename Vector>
+void FillVectorPairs(Pair<Vector>* const in, size_t const n)
+{
+    std::mt19937 rng(8);
+    for (size_t ii = 0; ii < n; ++ii) {
+        in[ii].a = RandomVector<Vector>(rng);
+        in[ii].b = RandomVector<Vector>(rng);
+    }
+}
+// Entries in [-1, 1]
+void FillMat4Pairs(Pair<ak::Mat4>* const in, size_t const n)
+{
+    std::mt19937 rng(9);
+    for (size_t ii = 0; ii < n; ++ii) {
+        float* const f = &in[ii].a.c0.x;
+        float* const g = &in[ii].b.c0.x;
+        for (size_t cc = 0; cc < 16; ++cc) {
+            f[cc] = Uniform(rng, -1.0f, 1.0f);
+            g[cc] = Uniform(rng, -1.0f, 1.0f);
+        }
+    }
+}
+void FillQuatPairs(Pair<ak::Quat>* const in, size_t const n)
+{
+    std::mt19937 rng(10);
+    for (size_t ii = 0; ii < n; ++ii) {
+        in[ii] = {RandomRotation(rng), RandomRotation(rng)};
+    }
+}
+
+struct RotateInput
+{
+    ak::Quat q;
+    ak::Vec3 v;
+};
+void FillRotate(RotateInput* const in, size_t const n)
+{
+    std::mt19937 rng(11);
+    for (size_t ii = 0; ii < n; ++ii) {
+        in[ii].q = RandomRotation(rng);
+        in[ii].v = RandomVector<ak::Vec3>(rng);
+    }
+}
+
+// The one transform that point and direction sweeps (FillVectors<Vec3>) go through, like a batch
+// of TransformPoints does
+ak::Mat4 const& TransformMatrix()
+{
+    static Buffer<ak::Mat4> const m(1, FillAffine);
+    return m.data[0];
+}
+
+/*****************************************************************************\
+ * Double precision references                                                *
+\*****************************************************************************/
+// A reference names its input type and sweep, the number of floats per result, whether errors
+// are norm-wise, and computes the exact result into doubles laid out like the float result.
+template<typename Vector>
+void ToDoubles(Vector const& v, double* const out)
+{
+    float const* const f = &v.x;
+    for (size_t cc = 0; cc < sizeof(Vector) / sizeof(float); ++cc) {
+        out[cc] = f[cc];
+    }
+}
+template<size_t kComponents>
+double Norm(double const* const v)
+{
+    double sum = 0.0;
+    for (size_t cc = 0; cc < kComponents; ++cc) {
+        sum += v[cc] * v[cc];
+    }
+    return sqrt(sum);
+}
+
+template<typename Vector>
+struct LengthRef
+{
+    typedef Vector Input;
+    static constexpr size_t kOutputs = 1;
+    static constexpr bool kNormwise = false;
+    static char const* Reference()
+    {
+        return "sqrt of the sum of squares";
+    }
+    static Buffer<Input> const& Inputs()
+    {
+        static Buffer<Input> const inputs(1 << 20, FillVectors<Vector>);
+        return inputs;
+    }
+    static void Exact(Input const& v, double* const out)
+    {
+        double d[sizeof(Vector) / sizeof(float)];
+        ToDoubles(v, d);
+        out[0] = Norm<sizeof(Vector) / sizeof(float)>(d);
+    }
+};
+
+template<typename Vector>
+struct LengthInvRef : LengthRef<Vector>
+{
+    static char const* Reference()
+    {
+        return "1 / length";
+    }
+    static void Exact(Vector const& v, double* const out)
+    {
+        LengthRef<Vector>::Exact(v, out);
+        out[0] = 1.0 / out[0];
+    }
+};
+
+template<typename Vector>
+struct NormalizeRef : LengthRef<Vector>
+{
+    static constexpr size_t kOutputs = sizeof(Vector) / sizeof(float);
+    static constexpr bool kNormwise = true;
+    static char const* Reference()
+    {
+        return "v / length";
+    }
+    static void Exact(Vector const& v, double* const out)
+    {
+        ToDoubles(v, out);
+        double const length = Norm<kOutputs>(out);
+        for (size_t cc = 0; cc < kOutputs; ++cc) {
+            out[cc] /= length;
+        }
+    }
+};
+
+// Results are sin(x), cos(x)
+struct SinCosRef
+{
+    typedef float Input;
+    static constexpr size_t kOutputs = 2;
+    static constexpr bool kNormwise = false;
+    static char const* Reference()
+    {
+        return "libm sin and cos in double";
+    }
+    static Buffer<Input> const& Inputs()
+    {
+        static Buffer<Input> const inputs(1 << 20, FillAngles);
+        return inputs;
+    }
+    static void Exact(float const x, double* const out)
+    {
+        out[0] = sin(static_cast<double>(x));
+        out[1] = cos(static_cast<double>(x));
+    }
+};
+
+// Gauss-Jordan elimination with partial pivoting on a column-major matrix
+template<size_t kN>
+void InverseDouble(double* const m)
+{
+    double inv[kN * kN] = {};
+    for (size_t ii = 0; ii < kN; ++ii) {
+        inv[ii * kN + ii] = 1.0;
+    }
+    for (size_t col = 0; col < kN; ++col) {
+        size_t pivot = col;
+        for (size_t row = col + 1; row < kN; ++row) {
+            pivot = fabs(m[col * kN + row]) > fabs(m[col * kN + pivot]) ? row : pivot;
+        }
+        for (size_t cc = 0; cc < kN; ++cc) {
+            std::swap(m[cc * kN + col], m[cc * kN + pivot]);
+            std::swap(inv[cc * kN + col], inv[cc * kN + pivot]);
+        }
+        double const scale = 1.0 / m[col * kN + col];
+        for (size_t cc = 0; cc < kN; ++cc) {
+            m[cc * kN + col] *= scale;
+            inv[cc * kN + col] *= scale;
+        }
+        for (size_t row = 0; row < kN; ++row) {
+            double const factor = row != col ? m[col * kN + row] : 0.0;
+            for (size_t cc = 0; cc < kN; ++cc) {
+                m[cc * kN + row] -= factor * m[cc * kN + col];
+                inv[cc * kN + row] -= factor * inv[cc * kN + col];
+            }
+        }
+    }
+    memcpy(m, inv, sizeof(inv));
+}
+
+template<typename Matrix, size_t kN, void (*kFill)(Matrix*, size_t)>
+struct InverseRef
+{
+    typedef Matrix Input;
+    static constexpr size_t kOutputs = kN * kN;
+    static constexpr bool kNormwise = true;
+    static char const* Reference()
+    {
+        return "Gauss-Jordan in double";
+    }
+    static Buffer<Input> const& Inputs()
+    {
+        static Buffer<Input> const inputs(1 << 16, kFill);
+        return inputs;
+    }
+    static void Exact(Matrix const& m, double* const out)
+    {
+        float const* const f = &m.c0.x;
+        for (size_t cc = 0; cc < kOutputs; ++cc) {
+            out[cc] = f[cc];
+        }
+        InverseDouble<kN>(out);
+    }
+};
+typedef InverseRef<ak::Mat3, 3, FillMat3> Mat3InverseRef;
+typedef InverseRef<ak::Mat4, 4, FillMat4> Mat4InverseRef;
+typedef InverseRef<ak::Mat4, 4, FillAffine> AffineInverseRef;
+typedef InverseRef<ak::Mat4, 4, FillRigid> RigidInverseRef;
+
+struct SlerpRef
+{
+    typedef SlerpInput Input;
+    static constexpr size_t kOutputs = 4;
+    static constexpr bool kNormwise = true;
+    static char const* Reference()
+    {
+        return "slerp in double, shorter arc";
+    }
+    static Buffer<Input> const& Inputs()
+    {
+        static Buffer<Input> const inputs(1 << 18, FillSlerp);
+        return inputs;
+    }
+    static void Exact(SlerpInput const& in, double* const out)
+    {
+        double a[4], b[4];
+        ToDoubles(in.a, a);
+        ToDoubles(in.b, b);
+        double cosTheta = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+        double const sign = cosTheta < 0.0 ? -1.0 : 1.0;
+        cosTheta = std::min(cosTheta * sign, 1.0);
+        double const theta = acos(cosTheta);
+        double const t = in.t;
+        double wa = 1.0 - t;
+        double wb = t;
+        if (theta > 1e-9) {
+            wa = sin((1.0 - t) * theta) / sin(theta);
+            wb = sin(t * theta) / sin(theta);
+        }
+        for (size_t cc = 0; cc < 4; ++cc) {
+            out[cc] = a[cc] * wa + b[cc] * wb * sign;
+        }
+    }
+};
+
+// Products also give the Magnitude of their terms, which errors are measured against
+template<typename Vector>
+struct DotRef
+{
+    typedef Pair<Vector> Input;
+    static constexpr size_t kComponents = sizeof(Vector) / sizeof(float);
+    static constexpr size_t kOutputs = 1;
+    static constexpr bool kNormwise = true;
+    static char const* Reference()
+    {
+        return "sum of products in double";
+    }
+    static Buffer<Input> const& Inputs()
+    {
+        static Buffer<Input> const inputs(1 << 20, FillVectorPairs<Vector>);
+        return inputs;
+    }
+    static void Exact(Input const& in, double* const out)
+    {
+        double a[kComponents], b[kComponents];
+        ToDoubles(in.a, a);
+        ToDoubles(in.b, b);
+        out[0] = 0.0;
+        for (size_t cc = 0; cc < kComponents; ++cc) {
+            out[0] += a[cc] * b[cc];
+        }
+    }
+    // sum(|a[i] * b[i]|)
+    static double Magnitude(Input const& in)
+    {
+        double a[kComponents], b[kComponents];
+        ToDoubles(in.a, a);
+        ToDoubles(in.b, b);
+        double sum = 0.0;
+        for (size_t cc = 0; cc < kComponents; ++cc) {
+            sum += fabs(a[cc] * b[cc]);
+        }
+        return sum;
+    }
+};
+
+struct CrossRef
+{
+    typedef Pair<ak::Vec3> Input;
+    static constexpr size_t kOutputs = 3;
+    static constexpr bool kNormwise = true;
+    static char const* Reference()
+    {
+        return "cross product in double";
+    }
+    static Buffer<Input> const& Inputs()
+    {
+        static Buffer<Input> const inputs(1 << 20, FillVectorPairs<ak::Vec3>);
+        return inputs;
+    }
+    static void Exact(Input const& in, double* const out)
+    {
+        double a[3], b[3];
+        ToDoubles(in.a, a);
+        ToDoubles(in.b, b);
+        out[0] = a[1] * b[2] - a[2] * b[1];
+        out[1] = a[2] * b[0] - a[0] * b[2];
+        out[2] = a[0] * b[1] - a[1] * b[0];
+    }
+    // |a| * |b|, which bounds |a.y * b.z| + |a.z * b.y| and the other components' terms
+    static double Magnitude(Input const& in)
+    {
+        double a[3], b[3];
+        ToDoubles(in.a, a);
+        ToDoubles(in.b, b);
+        return Norm<3>(a) * Norm<3>(b);
+    }
+};
+
+struct Mat4MultiplyRef
+{
+    typedef Pair<ak::Mat4> Input;
+    static constexpr size_t kOutputs = 16;
+    static constexpr bool kNormwise = true;
+    static char const* Reference()
+    {
+        return "matrix product in double";
+    }
+    static Buffer<Input> const& Inputs()
+    {
+        static Buffer<Input> const inputs(1 << 16, FillMat4Pairs);
+        return inputs;
+    }
+    // Column-major: element (row, col) of m is m[col * 4 + row]
+    static void Exact(Input const& in, double* const out)
+    {
+        float const* const a = &in.a.c0.x;
+        float const* const b = &in.b.c0.x;
+        for (size_t col = 0; col < 4; ++col) {
+            for (size_t row = 0; row < 4; ++row) {
+                double sum = 0.0;
+                for (size_t kk = 0; kk < 4; ++kk) {
+                    sum += static_cast<double>(a[kk * 4 + row]) * b[col * 4 + kk];
+                }
+                out[col * 4 + row] = sum;
+            }
+        }
+    }
+    // The largest sum(|a(row, k) * b(k, col)|)
+    static double Magnitude(Input const& in)
+    {
+        float const* const a = &in.a.c0.x;
+        float const* const b = &in.b.c0.x;
+        double largest = 0.0;
+        for (size_t col = 0; col < 4; ++col) {
+            for (size_t row = 0; row < 4; ++row) {
+                double sum = 0.0;
+                for (size_t kk = 0; kk < 4; ++kk) {
+                    sum += fabs(static_cast<double>(a[kk * 4 + row]) * b[col * 4 + kk]);
+                }
+                largest = std::max(largest, sum);
+            }
+        }
+        return largest;
+    }
+};
+
+// Points (kW = 1) and directions (kW = 0) through TransformMatrix()
+template<int kW>
+struct TransformRef
+{
+    typedef ak::Vec3 Input;
+    static constexpr size_t kOutputs = 3;
+    static constexpr bool kNormwise = true;
+    static char const* Reference()
+    {
+        return kW == 1 ? "m * (p, 1) in double" : "m * (d, 0) in double";
+    }
+    static Buffer<Input> const& Inputs()
+    {
+        static Buffer<Input> const inputs(1 << 20, FillVectors<ak::Vec3>);
+        return inputs;
+    }
+    static void Exact(ak::Vec3 const& v, double* const out)
+    {
+        float const* const m = &TransformMatrix().c0.x;
+        double const x[] = {v.x, v.y, v.z, static_cast<double>(kW)};
+        for (size_t row = 0; row < 3; ++row) {
+            out[row] = 0.0;
+            for (size_t kk = 0; kk < 4; ++kk) {
+                out[row] += m[kk * 4 + row] * x[kk];
+            }
+        }
+    }
+    // The largest sum(|m(row, k) * x[k]|)
+    static double Magnitude(ak::Vec3 const& v)
+    {
+        float const* const m = &TransformMatrix().c0.x;
+        double const x[] = {v.x, v.y, v.z, static_cast<double>(kW)};
+        double largest = 0.0;
+        for (size_t row = 0; row < 3; ++row) {
+            double sum = 0.0;
+            for (size_t kk = 0; kk < 4; ++kk) {
+                sum += fabs(m[kk * 4 + row] * x[kk]);
+            }
+            largest = std::max(largest, sum);
+        }
+        return largest;
+    }
+};
+
+struct QuatMultiplyRef
+{
+    typedef Pair<ak::Quat> Input;
+    static constexpr size_t kOutputs = 4;
+    static constexpr bool kNormwise = true;
+    static char const* Reference()
+    {
+        return "Hamilton product in double";
+    }
+    static Buffer<Input> const& Inputs()
+    {
+        static Buffer<Input> const inputs(1 << 18, FillQuatPairs);
+        return inputs;
+    }
+    static void Exact(Input const& in, double* const out)
+    {
+        double a[4], b[4];
+        ToDoubles(in.a, a);
+        ToDoubles(in.b, b);
+        out[0] = a[3] * b[0] + a[0] * b[3] + a[1] * b[2] - a[2] * b[1];
+        out[1] = a[3] * b[1] - a[0] * b[2] + a[1] * b[3] + a[2] * b[0];
+        out[2] = a[3] * b[2] + a[0] * b[1] - a[1] * b[0] + a[2] * b[3];
+        out[3] = a[3] * b[3] - a[0] * b[0] - a[1] * b[1] - a[2] * b[2];
+    }
+    // |a| * |b|, which bounds the sum of each component's |terms|
+    static double Magnitude(Input const& in)
+    {
+        double a[4], b[4];
+        ToDoubles(in.a, a);
+        ToDoubles(in.b, b);
+        return Norm<4>(a) * Norm<4>(b);
+    }
+};
+
+// The rotation by q normalized in double, since the float q is only unit up to rounding
+struct RotateRef
+{
+    typedef RotateInput Input;
+    static constexpr size_t kOutputs = 3;
+    static constexpr bool kNormwise = true;
+    static char const* Reference()
+    {
+        return "rotation by normalized q in double";
+    }
+    static Buffer<Input> const& Inputs()
+    {
+        static Buffer<Input> const inputs(1 << 20, FillRotate);
+        return inputs;
+    }
+    static void Exact(RotateInput const& in, double* const out)
+    {
+        double q[4], v[3];
+        ToDoubles(in.q, q);
+        ToDoubles(in.v, v);
+        double const length = Norm<4>(q);
+        for (size_t cc = 0; cc < 4; ++cc) {
+            q[cc] /= length;
+        }
+        // v + 2 * (w * c + Cross(u, c)) with u = q.xyz and c = Cross(u, v)
+        double const c[] = {q[1] * v[2] - q[2] * v[1], q[2] * v[0] - q[0] * v[2],
+                            q[0] * v[1] - q[1] * v[0]};
+        double const uc[] = {q[1] * c[2] - q[2] * c[1], q[2] * c[0] - q[0] * c[2],
+                             q[0] * c[1] - q[1] * c[0]};
+        for (size_t cc = 0; cc < 3; ++cc) {
+            out[cc] = v[cc] + 2.0 * (q[3] * c[cc] + uc[cc]);
+        }
+    }
+};
+
+/*****************************************************************************\
+ * Implementations under test                                                 *
+\*****************************************************************************/
+// A variant wraps one implementation of its Ref's function: it's built over the first n inputs,
+// Run() evaluates all of them, and Get() copies item ii's result out as floats.
+template<typename T>
+void ToFloats(T const& value, float* const out)
+{
+    static_assert(sizeof(T) % sizeof(float) == 0, "results are made of floats");
+    memcpy(out, &value, sizeof(T));
+}
+
+// out[ii] = kFn(in[ii])
+template<typename R, typename Out, typename Arg, Out (*kFn)(Arg)>
+class Each
+{
+public:
+    typedef R Ref;
+    Each(typename Ref::Input const* const in, size_t const n) : in_(in), out_(n)
+    {
+    }
+    void Run()
+    {
+        for (size_t ii = 0; ii < out_.count; ++ii) {
+            out_.data[ii] = kFn(in_[ii]);
+        }
+    }
+    void Get(size_t const ii, float* const out) const
+    {
+        ToFloats(out_.data[ii], out);
+    }
+
+private:
+    typename Ref::Input const* in_;
+    Buffer<Out> out_;
+};
+
+// kFn(in, out, n)
+template<typename R, typename T, void (*kFn)(T const*, T*, size_t)>
+class Batch
+{
+public:
+    typedef R Ref;
+    Batch(T const* const in, size_t const n) : in_(in), out_(n)
+    {
+    }
+    void Run()
+    {
+        kFn(in_, out_.data, out_.count);
+    }
+    void Get(size_t const ii, float* const out) const
+    {
+        ToFloats(out_.data[ii], out);
+    }
+
+private:
+    T const* in_;
+    Buffer<T> out_;
+};
+
+template<void (*kFn)(float, float&, float&)>
+class SinCosEach
+{
+public:
+    typedef SinCosRef Ref;
+    SinCosEach(float const* const in, size_t const n) : in_(in), s_(n), c_(n)
+    {
+    }
+    void Run()
+    {
+        for (size_t ii = 0; ii < s_.count; ++ii) {
+            kFn(in_[ii], s_.data[ii], c_.data[ii]);
+        }
+    }
+    void Get(size_t const ii, float* const out) const
+    {
+        out[0] = s_.data[ii];
+        out[1] = c_.data[ii];
+    }
+
+protected:
+    float const* in_;
+    Buffer<float> s_;
+    Buffer<float> c_;
+};
+
+template<void (*kFn)(float const*, float*, float*, size_t)>
+class SinCosBatch : public SinCosEach<ak::SinCos>
+{
+public:
+    SinCosBatch(float const* const in, size_t const n) : SinCosEach<ak::SinCos>(in, n)
+    {
+    }
+    void Run()
+    {
+        kFn(in_, s_.data, c_.data, s_.count);
+    }
+};
+
+// Inputs are transposed once up front; only the kernel is timed
+template<typename Vector, typename SoA, void (*kFn)(SoA const&, SoA&)>
+class NormalizeSoA
+{
+public:
+    typedef NormalizeRef<Vector> Ref;
+    NormalizeSoA(Vector const* const in, size_t const n) : in_(n), out_(n)
+    {
+        for (size_t ii = 0; ii < n; ++ii) {
+            in_.Set(ii, in[ii]);
+        }
+    }
+    void Run()
+    {
+        kFn(in_, out_);
+    }
+    void Get(size_t const ii, float* const out) const
+    {
+        ToFloats(out_.Get(ii), out);
+    }
+
+private:
+    SoA in_;
+    SoA out_;
+};
+
+// kFn(a, b, out, n) on separate operand arrays, split from the pairs up front
+template<typename R, typename T, void (*kFn)(T const*, T const*, T*, size_t)>
+class PairBatch
+{
+public:
+    typedef R Ref;
+    PairBatch(Pair<T> const* const in, size_t const n) : a_(n), b_(n), out_(n)
+    {
+        for (size_t ii = 0; ii < n; ++ii) {
+            a_.data[ii] = in[ii].a;
+            b_.data[ii] = in[ii].b;
+        }
+    }
+    void Run()
+    {
+        kFn(a_.data, b_.data, out_.data, out_.count);
+    }
+    void Get(size_t const ii, float* const out) const
+    {
+        ToFloats(out_.data[ii], out);
+    }
+
+private:
+    Buffer<T> a_;
+    Buffer<T> b_;
+    Buffer<T> out_;
+};
+
+// Dot and Cross on SoA operands, transposed up front like NormalizeSoA
+template<typename Vector, typename SoA, void (*kFn)(SoA const&, SoA const&, float*)>
+class DotSoA
+{
+public:
+    typedef DotRef<Vector> Ref;
+    DotSoA(Pair<Vector> const* const in, size_t const n) : a_(n), b_(n), out_(n)
+    {
+        for (size_t ii = 0; ii < n; ++ii) {
+            a_.Set(ii, in[ii].a);
+            b_.Set(ii, in[ii].b);
+        }
+    }
+    void Run()
+    {
+        kFn(a_, b_, out_.data);
+    }
+    void Get(size_t const ii, float* const out) const
+    {
+        out[0] = out_.data[ii];
+    }
+
+private:
+    SoA a_;
+    SoA b_;
+    Buffer<float> out_;
+};
+
+class CrossSoA
+{
+public:
+    typedef CrossRef Ref;
+    CrossSoA(Pair<ak::Vec3> const* const in, size_t const n) : a_(n), b_(n), out_(n)
+    {
+        for (size_t ii = 0; ii < n; ++ii) {
+            a_.Set(ii, in[ii].a);
+            b_.Set(ii, in[ii].b);
+        }
+    }
+    void Run()
+    {
+        ak::Cross(a_, b_, out_);
+    }
+    void Get(size_t const ii, float* const out) const
+    {
+        ToFloats(out_.Get(ii), out);
+    }
+
+private:
+    ak::Vec3SoA a_;
+    ak::Vec3SoA b_;
+    ak::Vec3SoA out_;
+};
+
+void SinCosLibm(float const x, float& s, float& c)
+{
+    s = sinf(x);
+    c = cosf(x);
+}
+float LengthInvExact(ak::Vec3 const v)
+{
+    return 1.0f / ak::Length(v);
+}
+float LengthInvExact(ak::Vec4 const v)
+{
+    return 1.0f / ak::Length(v);
+}
+ak::Quat SlerpOf(SlerpInput const& in)
+{
+    return ak::Slerp(in.a, in.b, in.t);
+}
+ak::Quat NlerpOf(SlerpInput const& in)
+{
+    return ak::Nlerp(in.a, in.b, in.t);
+}
+template<typename Vector>
+float DotOf(Pair<Vector> const& in)
+{
+    return ak::Dot(in.a, in.b);
+}
+ak::Vec3 CrossOf(Pair<ak::Vec3> const& in)
+{
+    return ak::Cross(in.a, in.b);
+}
+ak::Mat4 MultiplyScalarOf(Pair<ak::Mat4> const& in)
+{
+    return ak::MultiplyScalar(in.a, in.b);
+}
+ak::Mat4 MultiplyOf(Pair<ak::Mat4> const& in)
+{
+    return in.a * in.b;
+}
+ak::Quat MultiplyScalarOf(Pair<ak::Quat> const& in)
+{
+    return ak::MultiplyScalar(in.a, in.b);
+}
+ak::Quat MultiplyOf(Pair<ak::Quat> const& in)
+{
+    return in.a * in.b;
+}
+ak::Vec3 TransformPointOf(ak::Vec3 const p)
+{
+    return ak::TransformPoint(TransformMatrix(), p);
+}
+ak::Vec3 TransformDirectionOf(ak::Vec3 const d)
+{
+    return ak::TransformDirection(TransformMatrix(), d);
+}
+void TransformPointsOf(ak::Vec3 const* const in, ak::Vec3* const out, size_t const n)
+{
+    ak::TransformPoints(TransformMatrix(), in, out, n);
+}
+void TransformDirectionsOf(ak::Vec3 const* const in, ak::Vec3* const out, size_t const n)
+{
+    ak::TransformDirections(TransformMatrix(), in, out, n);
+}
+ak::Vec3 RotateOf(RotateInput const& in)
+{
+    return ak::Rotate(in.q, in.v);
+}
+ak::Vec3 RotateByMatrixOf(RotateInput const& in)
+{
+    return ak::Mat3::Rotation(in.q) * in.v;
+}
+
+/*****************************************************************************\
+ * Harness                                                                    *
+\*****************************************************************************/
+double Ulp(double const magnitude)
+{
+    float const f = static_cast<float>(magnitude);
+    return f < FLT_MIN ? FLT_MIN * FLT_EPSILON : nextafterf(f, INFINITY) - f;
+}
+
+// A reference's Magnitude(input), where it has one, replaces the largest result component as the
+// scale of norm-wise errors
+template<typename Ref>
+auto Magnitude(typename Ref::Input const& in, double, int) -> decltype(Ref::Magnitude(in))
+{
+    return Ref::Magnitude(in);
+}
+template<typename Ref>
+double Magnitude(typename Ref::Input const&, double const largest, long)
+{
+    return largest;
+}
+
+struct Error
+{
+    double max;
+    double mean;
+    double maxAbsolute;
+};
+
+template<typename Variant>
+Error MeasureError()
+{
+    typedef typename Variant::Ref Ref;
+    Buffer<typename Ref::Input> const& inputs = Ref::Inputs();
+    Variant variant(inputs.data, inputs.count);
+    variant.Run();
+    Error error = {0.0, 0.0, 0.0};
+    for (size_t ii = 0; ii < inputs.count; ++ii) {
+        float got[Ref::kOutputs];
+        double exact[Ref::kOutputs];
+        variant.Get(ii, got);
+        Ref::Exact(inputs.data[ii], exact);
+        double scale = 0.0;
+        for (size_t cc = 0; cc < Ref::kOutputs; ++cc) {
+            scale = std::max(scale, fabs(exact[cc]));
+        }
+        scale = Magnitude<Ref>(inputs.data[ii], scale, 0);
+        double worst = 0.0;
+        for (size_t cc = 0; cc < Ref::kOutputs; ++cc) {
+            double const ulp = Ulp(Ref::kNormwise ? scale : fabs(exact[cc]));
+            double const absolute = fabs(got[cc] - exact[cc]);
+            double const e = absolute / ulp;
+            worst = e > worst || e != e ? e : worst;  // nan sticks
+            error.maxAbsolute = absolute > error.maxAbsolute || absolute != absolute
+                                    ? absolute
+                                    : error.maxAbsolute;
+        }
+        error.max = worst > error.max || worst != worst ? worst : error.max;
+        error.mean += worst;
+    }
+    error.mean /= static_cast<double>(inputs.count);
+    return error;
+}
+
+template<typename Variant>
+void Characterize(benchmark::State& state)
+{
+    typedef typename Variant::Ref Ref;
+    static Error const error = MeasureError<Variant>();
+    Buffer<typename Ref::Input> const& inputs = Ref::Inputs();
+    size_t const count = std::min(inputs.count, kTimedItems);
+    Variant variant(inputs.data, count);
+    for (auto _ : state) {
+        variant.Run();
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * count));
+    state.counters["max_ulp"] = error.max;
+    state.counters["mean_ulp"] = error.mean;
+    state.counters["max_abs"] = error.maxAbsolute;
+    state.SetLabel(Ref::Reference());
+}
+
+// Benchmarks are named "<function>/<variant>"; the table groups rows by function
+template<typename Variant>
+void Register(char const* const function, char const* const variant)
+{
+    benchmark::RegisterBenchmark((std::string(function) + "/" + variant).c_str(),
+                                 Characterize<Variant>);
+}
+
+// Prints to the console as usual and keeps the results for the markdown table
+class TableReporter : public benchmark::ConsoleReporter
+{
+public:
+    void ReportRuns(std::vector<Run> const& runs) override
+    {
+        ConsoleReporter::ReportRuns(runs);
+        for (Run const& run : runs) {
+            auto const items = run.counters.find("items_per_second");
+            if (run.error_occurred || run.run_type != Run::RT_Iteration ||
+                items == run.counters.end() || items->second.value <= 0.0) {
+                continue;
+            }
+            std::string const name = run.benchmark_name();
+            size_t const slash = name.find('/');
+            Row const row = {name.substr(0, slash), name.substr(slash + 1), run.report_label,
+                             run.counters.at("max_ulp").value, run.counters.at("mean_ulp").value,
+                             run.counters.at("max_abs").value, 1e9 / items->second.value};
+            // Repetitions keep the fastest time
+            auto const same = std::find_if(rows_.begin(), rows_.end(), [&](Row const& r) {
+                return r.function == row.function && r.variant == row.variant;
+            });
+            if (same == rows_.end()) {
+                rows_.push_back(row);
+            } else {
+                same->ns = std::min(same->ns, row.ns);
+            }
+        }
+    }
+
+    bool Write(char const* const path) const
+    {
+        FILE* const file = fopen(path, "w");
+        if (file == nullptr) {
+            return false;
+        }
+        benchmark::CPUInfo const& cpu = benchmark::CPUInfo::Get();
+        fprintf(file,
+                "# akmath accuracy vs speed\n\n"
+                "Generated by `math-accuracy --accuracy_table` (CMake target `accuracy-table`); "
+                "see benchmark/math-accuracy.cpp for the input sweeps and how errors are "
+                "measured. Errors are in ULPs of the float result against a double precision "
+                "reference, norm-wise for vector and matrix results and against the magnitude of "
+                "their terms for products; max abs is the largest absolute error of any "
+                "component. ns/op is per item, over %zu cache-resident items.\n\n"
+                "SIMD level: `%s`. CPU: %.0f MHz, %d hardware threads.\n\n"
+                "| Function | Reference | Variant | max ULP | mean ULP | max abs | ns/op |\n"
+                "|---|---|---|--:|--:|--:|--:|\n",
+                kTimedItems, ak::SimdLevelName(ak::ActiveSimdLevel()),
+                cpu.cycles_per_second / 1e6, cpu.num_cpus);
+        for (size_t ii = 0; ii < rows_.size(); ++ii) {
+            Row const& row = rows_[ii];
+            bool const first = ii == 0 || rows_[ii - 1].function != row.function;
+            fprintf(file, "| %s | %s | %s | %s | %s | %.2g | %.2f |\n",
+                    first ? row.function.c_str() : "", first ? row.reference.c_str() : "",
+                    row.variant.c_str(), Format(row.maxUlp).c_str(),
+                    Format(row.meanUlp).c_str(), row.maxAbsolute, row.ns);
+        }
+        return fclose(file) == 0;
+    }
+
+private:
+    struct Row
+    {
+        std::string function;
+        std::string variant;
+        std::string reference;
+        double maxUlp;
+        double meanUlp;
+        double maxAbsolute;
+        double ns;
+    };
+
+    // Small errors with two decimals, approximations in scientific notation
+    static std::string Format(double const ulp)
+    {
+        char text[32];
+        snprintf(text, sizeof(text), ulp < 1e4 ? "%.2f" : "%.2g", ulp);
+        return text;
+    }
+
+    std::vector<Row> rows_;
+};
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    // Takes --accuracy_table=FILE out of the arguments before google benchmark sees them
+    char const* table = nullptr;
+    int kept = 1;
+    for (int ii = 1; ii < argc; ++ii) {
+        if (strncmp(argv[ii], "--accuracy_table=", 17) == 0) {
+            table = argv[ii] + 17;
+        } else {
+            argv[kept++] = argv[ii];
+        }
+    }
+    argc = kept;
+
+    using ak::Vec3;
+    using ak::Vec4;
+    Register<Each<LengthRef<Vec3>, float, Vec3, ak::Length>>("Length(Vec3)", "Length");
+    Register<Each<LengthRef<Vec4>, float, Vec4, ak::Length>>("Length(Vec4)", "Length");
+    Register<Each<LengthInvRef<Vec3>, float, Vec3, LengthInvExact>>("LengthInv(Vec3)",
+                                                                    "1 / Length");
+    Register<Each<LengthInvRef<Vec3>, float, Vec3, ak::LengthInvFast>>("LengthInv(Vec3)",
+                                                                       "LengthInvFast");
+    Register<Each<LengthInvRef<Vec4>, float, Vec4, LengthInvExact>>("LengthInv(Vec4)",
+                                                                    "1 / Length");
+    Register<Each<LengthInvRef<Vec4>, float, Vec4, ak::LengthInvFast>>("LengthInv(Vec4)",
+                                                                       "LengthInvFast");
+    Register<Each<NormalizeRef<Vec3>, Vec3, Vec3, ak::Normalize>>("Normalize(Vec3)",
+                                                                  "Normalize");
+    Register<Each<NormalizeRef<Vec3>, Vec3, Vec3, ak::NormalizeFast>>("Normalize(Vec3)",
+                                                                      "NormalizeFast");
+    Register<NormalizeSoA<Vec3, ak::Vec3SoA, ak::Normalize>>("Normalize(Vec3)",
+                                                             "Normalize(Vec3SoA)");
+    Register<NormalizeSoA<Vec3, ak::Vec3SoA, ak::NormalizeFast>>("Normalize(Vec3)",
+                                                                 "NormalizeFast(Vec3SoA)");
+    Register<Each<NormalizeRef<Vec4>, Vec4, Vec4, ak::Normalize>>("Normalize(Vec4)",
+                                                                  "Normalize");
+    Register<Each<NormalizeRef<Vec4>, Vec4, Vec4, ak::NormalizeFast>>("Normalize(Vec4)",
+                                                                      "NormalizeFast");
+    Register<NormalizeSoA<Vec4, ak::Vec4SoA, ak::Normalize>>("Normalize(Vec4)",
+                                                             "Normalize(Vec4SoA)");
+    Register<NormalizeSoA<Vec4, ak::Vec4SoA, ak::NormalizeFast>>("Normalize(Vec4)",
+                                                                 "NormalizeFast(Vec4SoA)");
+    Register<Each<DotRef<Vec3>, float, Pair<Vec3> const&, DotOf<Vec3>>>("Dot(Vec3)", "Dot");
+    Register<DotSoA<Vec3, ak::Vec3SoA, ak::Dot>>("Dot(Vec3)", "Dot(Vec3SoA)");
+    Register<Each<DotRef<Vec4>, float, Pair<Vec4> const&, DotOf<Vec4>>>("Dot(Vec4)", "Dot");
+    Register<DotSoA<Vec4, ak::Vec4SoA, ak::Dot>>("Dot(Vec4)", "Dot(Vec4SoA)");
+    Register<Each<CrossRef, Vec3, Pair<Vec3> const&, CrossOf>>("Cross(Vec3)", "Cross");
+    Register<CrossSoA>("Cross(Vec3)", "Cross(Vec3SoA)");
+
+    Register<SinCosEach<SinCosLibm>>("SinCos", "libm sinf, cosf");
+    Register<SinCosEach<ak::SinCos>>("SinCos", "SinCos");
+    Register<SinCosEach<ak::SinCosFast>>("SinCos", "SinCosFast");
+    Register<SinCosBatch<ak::SinCosManyScalar>>("SinCos", "SinCosManyScalar");
+    Register<SinCosBatch<ak::SinCosMany>>("SinCos", "SinCosMany");
+    Register<SinCosBatch<ak::SinCosFastManyScalar>>("SinCos", "SinCosFastManyScalar");
+    Register<SinCosBatch<ak::SinCosFastMany>>("SinCos", "SinCosFastMany");
+
+    using ak::Mat3;
+    using ak::Mat4;
+    Register<Each<Mat3InverseRef, Mat3, Mat3, ak::Inverse>>("Inverse(Mat3)", "Inverse");
+    Register<Each<Mat4InverseRef, Mat4, Mat4, ak::InverseScalar>>("Inverse(Mat4)",
+                                                                  "InverseScalar");
+    Register<Each<Mat4InverseRef, Mat4, Mat4 const&, ak::Inverse>>("Inverse(Mat4)", "Inverse");
+    Register<Batch<Mat4InverseRef, Mat4, ak::InverseMany>>("Inverse(Mat4)", "InverseMany");
+    Register<Each<AffineInverseRef, Mat4, Mat4, ak::InverseScalar>>("Inverse(affine Mat4)",
+                                                                    "InverseScalar");
+    Register<Each<AffineInverseRef, Mat4, Mat4 const&, ak::Inverse>>("Inverse(affine Mat4)",
+                                                                     "Inverse");
+    Register<Each<AffineInverseRef, Mat4, Mat4 const&, ak::InverseAffine>>(
+        "Inverse(affine Mat4)", "InverseAffine");
+    Register<Batch<AffineInverseRef, Mat4, ak::InverseAffineMany>>("Inverse(affine Mat4)",
+                                                                   "InverseAffineMany");
+    Register<Each<RigidInverseRef, Mat4, Mat4 const&, ak::Inverse>>("Inverse(rigid Mat4)",
+                                                                    "Inverse");
+    Register<Each<RigidInverseRef, Mat4, Mat4 const&, ak::InverseAffine>>(
+        "Inverse(rigid Mat4)", "InverseAffine");
+    Register<Each<RigidInverseRef, Mat4, Mat4 const&, ak::InverseRigid>>("Inverse(rigid Mat4)",
+                                                                         "InverseRigid");
+    Register<Batch<RigidInverseRef, Mat4, ak::InverseRigidMany>>("Inverse(rigid Mat4)",
+                                                                 "InverseRigidMany");
+    Register<Each<Mat4MultiplyRef, Mat4, Pair<Mat4> const&, MultiplyScalarOf>>("Multiply(Mat4)",
+                                                                               "MultiplyScalar");
+    Register<Each<Mat4MultiplyRef, Mat4, Pair<Mat4> const&, MultiplyOf>>("Multiply(Mat4)",
+                                                                         "a * b");
+    Register<PairBatch<Mat4MultiplyRef, Mat4, ak::MultiplyMany>>("Multiply(Mat4)",
+                                                                 "MultiplyMany");
+    Register<Each<TransformRef<1>, Vec3, Vec3, TransformPointOf>>("TransformPoint(Mat4)",
+                                                                  "TransformPoint");
+    Register<Batch<TransformRef<1>, Vec3, TransformPointsOf>>("TransformPoint(Mat4)",
+                                                              "TransformPoints");
+    Register<Each<TransformRef<0>, Vec3, Vec3, TransformDirectionOf>>("TransformDirection(Mat4)",
+                                                                      "TransformDirection");
+    Register<Batch<TransformRef<0>, Vec3, TransformDirectionsOf>>("TransformDirection(Mat4)",
+                                                                  "TransformDirections");
+
+    Register<Each<SlerpRef, ak::Quat, SlerpInput const&, SlerpOf>>("Slerp(Quat)", "Slerp");
+    Register<Each<SlerpRef, ak::Quat, SlerpInput const&, NlerpOf>>("Slerp(Quat)", "Nlerp");
+    using ak::Quat;
+    Register<Each<QuatMultiplyRef, Quat, Pair<Quat> const&, MultiplyScalarOf>>("Multiply(Quat)",
+                                                                               "MultiplyScalar");
+    Register<Each<QuatMultiplyRef, Quat, Pair<Quat> const&, MultiplyOf>>("Multiply(Quat)",
+                                                                         "a * b");
+    Register<PairBatch<QuatMultiplyRef, Quat, ak::MultiplyMany>>("Multiply(Quat)",
+                                                                 "MultiplyMany");
+    Register<Each<RotateRef, Vec3, RotateInput const&, RotateOf>>("Rotate(Quat)", "Rotate");
+    Register<Each<RotateRef, Vec3, RotateInput const&, RotateByMatrixOf>>(
+        "Rotate(Quat)", "Mat3::Rotation(q) * v");
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    TableReporter reporter;
+    benchmark::RunSpecifiedBenchmarks(&reporter);
+    if (table != nullptr && !reporter.Write(table)) {
+        fprintf(stderr, "Couldn't write %s\n", table);
+        return 1;
+    }
+    return 0;
+}
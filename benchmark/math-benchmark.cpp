@@ -1,14 +1,28 @@
 #include "akmath.h"
+#include "akmath-parallel.h"
+#include "perf-counters.h"
+#include "thread-scaling.h"
 #include <benchmark/benchmark.h>
 #include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#if AK_HAS_DIRECTXMATH
 #include <DirectXMath.h>
+#endif
+#if defined(_MSC_VER)
 #pragma warning(disable : 4577)  // 'noexcept' used
+#endif
 #include <Eigen/Core>
 #include <Eigen/Dense>
+#include <new>
+#include <string>
+#include <vector>
 
 namespace {
 
+#if AK_HAS_DIRECTXMATH
 using namespace DirectX;
+#endif
 using namespace ak;
 
 enum {
@@ -24,12 +38,14 @@ float RandFloat(float const min, float const max)
     return f + min;
 }
 
+#if AK_HAS_DIRECTXMATH
 // DX
 void FillVec(DirectX::XMVECTOR& v)
 {
     v = XMVectorSet(RandFloat(-50.0f, 50.0f), RandFloat(-50.0f, 50.0f), RandFloat(-50.0f, 50.0f),
                     RandFloat(-50.0f, 50.0f));
 }
+#endif
 
 // GLM
 void FillVec(glm::vec2& v)
@@ -77,16 +93,40 @@ void FillVec(ak::Vec4& v)
 }
 
 //-----------------------------------------------------------------------------
-#if 0
+// Eigen's operator* and operator/ are matrix products, the others are component-wise already.
+template<class Vector>
+Vector ComponentMultiply(Vector const& a, Vector const& b)
+{
+    return a * b;
+}
+template<int N>
+Eigen::Matrix<float, N, 1> ComponentMultiply(Eigen::Matrix<float, N, 1> const& a,
+                                             Eigen::Matrix<float, N, 1> const& b)
+{
+    return a.cwiseProduct(b);
+}
+template<class Vector>
+Vector ComponentDivide(Vector const& a, Vector const& b)
+{
+    return a / b;
+}
+template<int N>
+Eigen::Matrix<float, N, 1> ComponentDivide(Eigen::Matrix<float, N, 1> const& a,
+                                           Eigen::Matrix<float, N, 1> const& b)
+{
+    return a.cwiseQuotient(b);
+}
+
 template<class Vector>
 void VecAddition(benchmark::State& state)
 {
     Vector a, b;
     FillVec(a);
     FillVec(b);
+    perf::Scope const perfScope(state);
     for (auto _ : state) {
         for (int ii = 0; ii < kLoopCount; ++ii) {
-            benchmark::DoNotOptimize(a + b);
+            benchmark::DoNotOptimize((Vector)(a + b));
         }
     }
 }
@@ -96,9 +136,10 @@ void VecSubtraction(benchmark::State& state)
     Vector a, b;
     FillVec(a);
     FillVec(b);
+    perf::Scope const perfScope(state);
     for (auto _ : state) {
         for (int ii = 0; ii < kLoopCount; ++ii) {
-            benchmark::DoNotOptimize(a - b);
+            benchmark::DoNotOptimize((Vector)(a - b));
         }
     }
 }
@@ -108,9 +149,10 @@ void VecMultiplication(benchmark::State& state)
     Vector a, b;
     FillVec(a);
     FillVec(b);
+    perf::Scope const perfScope(state);
     for (auto _ : state) {
         for (int ii = 0; ii < kLoopCount; ++ii) {
-            benchmark::DoNotOptimize(a * b);
+            benchmark::DoNotOptimize(ComponentMultiply(a, b));
         }
     }
 }
@@ -121,55 +163,182 @@ void VecDivision(benchmark::State& state)
     Vector a, b;
     FillVec(a);
     FillVec(b);
+    perf::Scope const perfScope(state);
     for (auto _ : state) {
         for (int ii = 0; ii < kLoopCount; ++ii) {
-            benchmark::DoNotOptimize(a / b);
+            benchmark::DoNotOptimize(ComponentDivide(a, b));
         }
     }
 }
 
+#if AK_HAS_DIRECTXMATH
 BENCHMARK_TEMPLATE(VecAddition, XMVECTOR)->MinTime(kMinTime);
-BENCHMARK_TEMPLATE(VecAddition, glm::vec2)->MinTime(kMinTime);
-BENCHMARK_TEMPLATE(VecAddition, ak::Vec2)->MinTime(kMinTime);
-
-BENCHMARK_TEMPLATE(VecAddition, glm::vec3)->MinTime(kMinTime);
-BENCHMARK_TEMPLATE(VecAddition, ak::Vec3)->MinTime(kMinTime);
-
-BENCHMARK_TEMPLATE(VecAddition, glm::vec4)->MinTime(kMinTime);
-BENCHMARK_TEMPLATE(VecAddition, ak::Vec4)->MinTime(kMinTime);
-
 BENCHMARK_TEMPLATE(VecSubtraction, XMVECTOR)->MinTime(kMinTime);
-BENCHMARK_TEMPLATE(VecSubtraction, glm::vec2)->MinTime(kMinTime);
-BENCHMARK_TEMPLATE(VecSubtraction, ak::Vec2)->MinTime(kMinTime);
+BENCHMARK_TEMPLATE(VecMultiplication, XMVECTOR)->MinTime(kMinTime);
+BENCHMARK_TEMPLATE(VecDivision, XMVECTOR)->MinTime(kMinTime);
+#endif
 
-BENCHMARK_TEMPLATE(VecSubtraction, glm::vec3)->MinTime(kMinTime);
-BENCHMARK_TEMPLATE(VecSubtraction, ak::Vec3)->MinTime(kMinTime);
+#define AK_BENCHMARK_VEC_FAMILY(func)                                                            \
+    BENCHMARK_TEMPLATE(func, glm::vec2)->MinTime(kMinTime);                                      \
+    BENCHMARK_TEMPLATE(func, Eigen::Vector2f)->MinTime(kMinTime);                                \
+    BENCHMARK_TEMPLATE(func, ak::Vec2)->MinTime(kMinTime);                                       \
+    BENCHMARK_TEMPLATE(func, glm::vec3)->MinTime(kMinTime);                                      \
+    BENCHMARK_TEMPLATE(func, Eigen::Vector3f)->MinTime(kMinTime);                                \
+    BENCHMARK_TEMPLATE(func, ak::Vec3)->MinTime(kMinTime);                                       \
+    BENCHMARK_TEMPLATE(func, glm::vec4)->MinTime(kMinTime);                                      \
+    BENCHMARK_TEMPLATE(func, Eigen::Vector4f)->MinTime(kMinTime);                                \
+    BENCHMARK_TEMPLATE(func, ak::Vec4)->MinTime(kMinTime)
 
-BENCHMARK_TEMPLATE(VecSubtraction, glm::vec4)->MinTime(kMinTime);
-BENCHMARK_TEMPLATE(VecSubtraction, ak::Vec4)->MinTime(kMinTime);
+AK_BENCHMARK_VEC_FAMILY(VecAddition);
+AK_BENCHMARK_VEC_FAMILY(VecSubtraction);
+AK_BENCHMARK_VEC_FAMILY(VecMultiplication);
+AK_BENCHMARK_VEC_FAMILY(VecDivision);
 
-BENCHMARK_TEMPLATE(VecMultiplication, XMVECTOR)->MinTime(kMinTime);
-BENCHMARK_TEMPLATE(VecMultiplication, glm::vec2)->MinTime(kMinTime);
-BENCHMARK_TEMPLATE(VecMultiplication, ak::Vec2)->MinTime(kMinTime);
+//-----------------------------------------------------------------------------
+// Geometric vector ops, routed through one overload set per library.
+float DotOf(glm::vec3 const& a, glm::vec3 const& b)
+{
+    return glm::dot(a, b);
+}
+float DotOf(glm::vec4 const& a, glm::vec4 const& b)
+{
+    return glm::dot(a, b);
+}
+float DotOf(Eigen::Vector3f const& a, Eigen::Vector3f const& b)
+{
+    return a.dot(b);
+}
+float DotOf(Eigen::Vector4f const& a, Eigen::Vector4f const& b)
+{
+    return a.dot(b);
+}
+float DotOf(ak::Vec3 const& a, ak::Vec3 const& b)
+{
+    return ak::Dot(a, b);
+}
+float DotOf(ak::Vec4 const& a, ak::Vec4 const& b)
+{
+    return ak::Dot(a, b);
+}
 
-BENCHMARK_TEMPLATE(VecMultiplication, glm::vec3)->MinTime(kMinTime);
-BENCHMARK_TEMPLATE(VecMultiplication, ak::Vec3)->MinTime(kMinTime);
+glm::vec3 CrossOf(glm::vec3 const& a, glm::vec3 const& b)
+{
+    return glm::cross(a, b);
+}
+Eigen::Vector3f CrossOf(Eigen::Vector3f const& a, Eigen::Vector3f const& b)
+{
+    return a.cross(b);
+}
+ak::Vec3 CrossOf(ak::Vec3 const& a, ak::Vec3 const& b)
+{
+    return ak::Cross(a, b);
+}
 
-BENCHMARK_TEMPLATE(VecMultiplication, glm::vec4)->MinTime(kMinTime);
-BENCHMARK_TEMPLATE(VecMultiplication, ak::Vec4)->MinTime(kMinTime);
+template<class Vector>
+float LengthOf(Vector const& v)
+{
+    return glm::length(v);
+}
+template<int N>
+float LengthOf(Eigen::Matrix<float, N, 1> const& v)
+{
+    return v.norm();
+}
+float LengthOf(ak::Vec3 const& v)
+{
+    return ak::Length(v);
+}
+float LengthOf(ak::Vec4 const& v)
+{
+    return ak::Length(v);
+}
 
-BENCHMARK_TEMPLATE(VecDivision, XMVECTOR)->MinTime(kMinTime);
-BENCHMARK_TEMPLATE(VecDivision, glm::vec2)->MinTime(kMinTime);
-BENCHMARK_TEMPLATE(VecDivision, ak::Vec2)->MinTime(kMinTime);
+template<class Vector>
+Vector NormalizeOf(Vector const& v)
+{
+    return glm::normalize(v);
+}
+template<int N>
+Eigen::Matrix<float, N, 1> NormalizeOf(Eigen::Matrix<float, N, 1> const& v)
+{
+    return v.normalized();
+}
+ak::Vec3 NormalizeOf(ak::Vec3 const& v)
+{
+    return ak::Normalize(v);
+}
+ak::Vec4 NormalizeOf(ak::Vec4 const& v)
+{
+    return ak::Normalize(v);
+}
 
-BENCHMARK_TEMPLATE(VecDivision, glm::vec3)->MinTime(kMinTime);
-BENCHMARK_TEMPLATE(VecDivision, ak::Vec3)->MinTime(kMinTime);
+template<class Vector>
+void VecDot(benchmark::State& state)
+{
+    Vector a, b;
+    FillVec(a);
+    FillVec(b);
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        for (int ii = 0; ii < kLoopCount; ++ii) {
+            benchmark::DoNotOptimize(DotOf(a, b));
+        }
+    }
+}
+template<class Vector>
+void VecCross(benchmark::State& state)
+{
+    Vector a, b;
+    FillVec(a);
+    FillVec(b);
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        for (int ii = 0; ii < kLoopCount; ++ii) {
+            benchmark::DoNotOptimize(CrossOf(a, b));
+        }
+    }
+}
+template<class Vector>
+void VecLength(benchmark::State& state)
+{
+    Vector a;
+    FillVec(a);
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        for (int ii = 0; ii < kLoopCount; ++ii) {
+            benchmark::DoNotOptimize(LengthOf(a));
+        }
+    }
+}
+template<class Vector>
+void VecNormalize(benchmark::State& state)
+{
+    Vector a;
+    FillVec(a);
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        for (int ii = 0; ii < kLoopCount; ++ii) {
+            benchmark::DoNotOptimize(NormalizeOf(a));
+        }
+    }
+}
 
-BENCHMARK_TEMPLATE(VecDivision, glm::vec4)->MinTime(kMinTime);
-BENCHMARK_TEMPLATE(VecDivision, ak::Vec4)->MinTime(kMinTime);
+#define AK_BENCHMARK_VEC34(func)                                                                 \
+    BENCHMARK_TEMPLATE(func, glm::vec3)->MinTime(kMinTime);                                      \
+    BENCHMARK_TEMPLATE(func, Eigen::Vector3f)->MinTime(kMinTime);                                \
+    BENCHMARK_TEMPLATE(func, ak::Vec3)->MinTime(kMinTime);                                       \
+    BENCHMARK_TEMPLATE(func, glm::vec4)->MinTime(kMinTime);                                      \
+    BENCHMARK_TEMPLATE(func, Eigen::Vector4f)->MinTime(kMinTime);                                \
+    BENCHMARK_TEMPLATE(func, ak::Vec4)->MinTime(kMinTime)
 
-#endif
+AK_BENCHMARK_VEC34(VecDot);
+AK_BENCHMARK_VEC34(VecLength);
+AK_BENCHMARK_VEC34(VecNormalize);
+BENCHMARK_TEMPLATE(VecCross, glm::vec3)->MinTime(kMinTime);
+BENCHMARK_TEMPLATE(VecCross, Eigen::Vector3f)->MinTime(kMinTime);
+BENCHMARK_TEMPLATE(VecCross, ak::Vec3)->MinTime(kMinTime);
 
+#if AK_HAS_DIRECTXMATH
 void DxMat3Inverse(benchmark::State& state)
 {
     DirectX::XMMATRIX const m =
@@ -179,6 +348,7 @@ void DxMat3Inverse(benchmark::State& state)
                     RandFloat(-50.0f, 50.0f), RandFloat(-50.0f, 50.0f), RandFloat(-50.0f, 50.0f),
                     RandFloat(-50.0f, 50.0f), RandFloat(-50.0f, 50.0f), RandFloat(-50.0f, 50.0f),
                     RandFloat(-50.0f, 50.0f));
+    perf::Scope const perfScope(state);
     for (auto _ : state) {
         for (int ii = 0; ii < kLoopCount / 4; ++ii) {
             benchmark::DoNotOptimize(XMMatrixInverse(nullptr, m));
@@ -186,6 +356,7 @@ void DxMat3Inverse(benchmark::State& state)
     }
 }
 BENCHMARK(DxMat3Inverse);
+#endif
 
 void GlmMat3Inverse(benchmark::State& state)
 {
@@ -194,6 +365,7 @@ void GlmMat3Inverse(benchmark::State& state)
         {RandFloat(-50.0f, 50.0f), RandFloat(-50.0f, 50.0f), RandFloat(-50.0f, 50.0f)},
         {RandFloat(-50.0f, 50.0f), RandFloat(-50.0f, 50.0f), RandFloat(-50.0f, 50.0f)},
     };
+    perf::Scope const perfScope(state);
     for (auto _ : state) {
         for (int ii = 0; ii < kLoopCount / 4; ++ii) {
             benchmark::DoNotOptimize(glm::inverse(m));
@@ -209,6 +381,7 @@ void Mat3Inverse(benchmark::State& state)
         {RandFloat(-50.0f, 50.0f), RandFloat(-50.0f, 50.0f), RandFloat(-50.0f, 50.0f)},
         {RandFloat(-50.0f, 50.0f), RandFloat(-50.0f, 50.0f), RandFloat(-50.0f, 50.0f)},
     };
+    perf::Scope const perfScope(state);
     for (auto _ : state) {
         for (int ii = 0; ii < kLoopCount / 4; ++ii) {
             benchmark::DoNotOptimize(ak::Inverse(m));
@@ -217,6 +390,80 @@ void Mat3Inverse(benchmark::State& state)
 }
 BENCHMARK(Mat3Inverse);
 
+void EigenMat3Inverse(benchmark::State& state)
+{
+    Eigen::Matrix3f m;
+    m << RandFloat(-50.0f, 50.0f), RandFloat(-50.0f, 50.0f), RandFloat(-50.0f, 50.0f),
+        RandFloat(-50.0f, 50.0f), RandFloat(-50.0f, 50.0f), RandFloat(-50.0f, 50.0f),
+        RandFloat(-50.0f, 50.0f), RandFloat(-50.0f, 50.0f), RandFloat(-50.0f, 50.0f);
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        for (int ii = 0; ii < kLoopCount / 4; ++ii) {
+            benchmark::DoNotOptimize((Eigen::Matrix3f)m.inverse());
+        }
+    }
+}
+BENCHMARK(EigenMat3Inverse);
+
+void FillMatrix(ak::Mat3& m)
+{
+    m = {
+        {RandFloat(-50.0f, 50.0f), RandFloat(-50.0f, 50.0f), RandFloat(-50.0f, 50.0f)},
+        {RandFloat(-50.0f, 50.0f), RandFloat(-50.0f, 50.0f), RandFloat(-50.0f, 50.0f)},
+        {RandFloat(-50.0f, 50.0f), RandFloat(-50.0f, 50.0f), RandFloat(-50.0f, 50.0f)},
+    };
+}
+void FillMatrix(glm::mat3& m)
+{
+    m = {
+        {RandFloat(-50.0f, 50.0f), RandFloat(-50.0f, 50.0f), RandFloat(-50.0f, 50.0f)},
+        {RandFloat(-50.0f, 50.0f), RandFloat(-50.0f, 50.0f), RandFloat(-50.0f, 50.0f)},
+        {RandFloat(-50.0f, 50.0f), RandFloat(-50.0f, 50.0f), RandFloat(-50.0f, 50.0f)},
+    };
+}
+void FillMatrix(Eigen::Matrix3f& m)
+{
+    m << RandFloat(-50.0f, 50.0f), RandFloat(-50.0f, 50.0f), RandFloat(-50.0f, 50.0f),
+        RandFloat(-50.0f, 50.0f), RandFloat(-50.0f, 50.0f), RandFloat(-50.0f, 50.0f),
+        RandFloat(-50.0f, 50.0f), RandFloat(-50.0f, 50.0f), RandFloat(-50.0f, 50.0f);
+}
+
+template<typename Matrix>
+void Mat3Multiplication(benchmark::State& state)
+{
+    Matrix m1, m2;
+    FillMatrix(m1);
+    FillMatrix(m2);
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        for (int ii = 0; ii < kLoopCount; ++ii) {
+            benchmark::DoNotOptimize((Matrix)(m1 * m2));
+        }
+    }
+}
+BENCHMARK_TEMPLATE(Mat3Multiplication, glm::mat3);
+BENCHMARK_TEMPLATE(Mat3Multiplication, Eigen::Matrix3f);
+BENCHMARK_TEMPLATE(Mat3Multiplication, ak::Mat3);
+
+template<typename Matrix, typename Vector>
+void Mat3VecMultiplication(benchmark::State& state)
+{
+    Matrix m;
+    Vector v;
+    FillMatrix(m);
+    FillVec(v);
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        for (int ii = 0; ii < kLoopCount; ++ii) {
+            benchmark::DoNotOptimize((Vector)(m * v));
+        }
+    }
+}
+BENCHMARK_TEMPLATE(Mat3VecMultiplication, glm::mat3, glm::vec3);
+BENCHMARK_TEMPLATE(Mat3VecMultiplication, Eigen::Matrix3f, Eigen::Vector3f);
+BENCHMARK_TEMPLATE(Mat3VecMultiplication, ak::Mat3, ak::Vec3);
+
+#if AK_HAS_DIRECTXMATH
 void FillMatrix(DirectX::XMMATRIX& m)
 {
     m = XMMatrixSet(RandFloat(-50.0f, 50.0f), RandFloat(-50.0f, 50.0f), RandFloat(-50.0f, 50.0f),
@@ -226,6 +473,7 @@ void FillMatrix(DirectX::XMMATRIX& m)
                     RandFloat(-50.0f, 50.0f), RandFloat(-50.0f, 50.0f), RandFloat(-50.0f, 50.0f),
                     RandFloat(-50.0f, 50.0f));
 }
+#endif
 void FillMatrix(ak::Mat4& m)
 {
     m = {
@@ -268,17 +516,239 @@ void Mat4Multiplication(benchmark::State& state)
     Matrix m1, m2;
     FillMatrix(m1);
     FillMatrix(m2);
+    perf::Scope const perfScope(state);
     for (auto _ : state) {
         for (int ii = 0; ii < kLoopCount; ++ii) {
             benchmark::DoNotOptimize((Matrix)(m1 * m2));
         }
     }
 }
+#if AK_HAS_DIRECTXMATH
 BENCHMARK_TEMPLATE(Mat4Multiplication, XMMATRIX);
+#endif
 BENCHMARK_TEMPLATE(Mat4Multiplication, glm::mat4);
 BENCHMARK_TEMPLATE(Mat4Multiplication, Eigen::Matrix4f);
 BENCHMARK_TEMPLATE(Mat4Multiplication, ak::Mat4);
 
+template<typename Vector>
+void Fill(Vector& v)
+{
+    FillVec(v);
+}
+void Fill(glm::mat4& m)
+{
+    FillMatrix(m);
+}
+void Fill(Eigen::Matrix4f& m)
+{
+    FillMatrix(m);
+}
+void Fill(ak::Mat4& m)
+{
+    FillMatrix(m);
+}
+void Fill(ak::Mat4x3& m)
+{
+    ak::Mat4 full;
+    FillMatrix(full);
+    m = {full.c0, full.c1, full.c2};
+}
+void Fill(float& f)
+{
+    f = RandFloat(-50.0f, 50.0f);
+}
+void Fill(uint32_t& u)
+{
+    u = 0;
+}
+ak::Sphere RandSphere()
+{
+    return {{RandFloat(-500.0f, 500.0f), RandFloat(-300.0f, 300.0f), RandFloat(-900.0f, 100.0f)},
+            RandFloat(0.5f, 10.0f)};
+}
+void Fill(ak::Sphere& s)
+{
+    s = RandSphere();
+}
+void Fill(ak::Aabb& box)
+{
+    ak::Sphere const s = RandSphere();
+    ak::Vec3 const e = {RandFloat(0.5f, 10.0f), RandFloat(0.5f, 10.0f), RandFloat(0.5f, 10.0f)};
+    box = {s.center - e, s.center + e};
+}
+void Fill(ak::Containment& c)
+{
+    c = ak::Containment::kOutside;
+}
+void Fill(glm::quat& q)
+{
+    glm::vec3 axis;
+    FillVec(axis);
+    q = glm::angleAxis(RandFloat(-3.0f, 3.0f), glm::normalize(axis));
+}
+void Fill(ak::Quat& q)
+{
+    ak::Vec3 axis;
+    FillVec(axis);
+    q = ak::Quat::RotationAxis(axis, RandFloat(-3.0f, 3.0f));
+}
+void Fill(ak::Transform& t)
+{
+    Fill(t.orientation);
+    FillVec(t.position);
+    t.scale = RandFloat(0.5f, 2.0f);
+}
+void Fill(ak::DualQuat& dq)
+{
+    ak::Transform t;
+    Fill(t);
+    dq = ak::DualQuat::FromTransform(t);
+}
+
+// Heap arrays of Mat4 need explicit alignment until C++17's aligned new.
+template<typename T>
+struct AlignedArray
+{
+    explicit AlignedArray(size_t const n)
+        : data(static_cast<T*>(_mm_malloc(n * sizeof(T), 64)))
+        , count(n)
+    {
+        for (size_t ii = 0; ii < count; ++ii) {
+            new (&data[ii]) T;
+            Fill(data[ii]);
+        }
+    }
+    ~AlignedArray()
+    {
+        _mm_free(data);
+    }
+    AlignedArray(AlignedArray const&) = delete;
+    AlignedArray& operator=(AlignedArray const&) = delete;
+
+    T* data;
+    size_t count;
+};
+
+void MultiplyInto(glm::mat4& out, glm::mat4 const& a, glm::mat4 const& b)
+{
+    out = a * b;
+}
+void MultiplyInto(Eigen::Matrix4f& out, Eigen::Matrix4f const& a, Eigen::Matrix4f const& b)
+{
+    out.noalias() = a * b;
+}
+
+// Smallest data cache level that holds `bytes`, per the CPU info google benchmark collected
+std::string CacheLevel(size_t const bytes)
+{
+    for (benchmark::CPUInfo::CacheInfo const& cache : benchmark::CPUInfo::Get().caches) {
+        if (cache.type != "Instruction" && bytes <= static_cast<size_t>(cache.size)) {
+            return "L" + std::to_string(cache.level);
+        }
+    }
+    return "DRAM";
+}
+
+void SetArrayCounters(benchmark::State& state, size_t const count, size_t const matrixSize,
+                      size_t const streams)
+{
+    size_t const workingSet = count * matrixSize * streams;
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * count));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * workingSet));
+    state.SetLabel(CacheLevel(workingSet));
+}
+
+// Throughput over memory rather than latency on hot registers: array lengths whose combined
+// streams span 16 KiB to 512 MiB in 8x steps, so every series walks from L1 out to DRAM.
+template<typename T, size_t kStreams>
+void WorkingSetArgs(benchmark::internal::Benchmark* b)
+{
+    for (size_t bytes = size_t(16) << 10; bytes <= size_t(512) << 20; bytes *= 8) {
+        b->Arg(static_cast<int64_t>(bytes / (sizeof(T) * kStreams)));
+    }
+}
+
+template<typename Matrix>
+void Mat4MultiplyMany(benchmark::State& state)
+{
+    size_t const count = static_cast<size_t>(state.range(0));
+    AlignedArray<Matrix> const a(count), b(count);
+    AlignedArray<Matrix> out(count);
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        for (size_t ii = 0; ii < count; ++ii) {
+            MultiplyInto(out.data[ii], a.data[ii], b.data[ii]);
+        }
+        benchmark::ClobberMemory();
+    }
+    SetArrayCounters(state, count, sizeof(Matrix), 3);
+}
+template<>
+void Mat4MultiplyMany<ak::Mat4>(benchmark::State& state)
+{
+    size_t const count = static_cast<size_t>(state.range(0));
+    AlignedArray<ak::Mat4> const a(count), b(count);
+    AlignedArray<ak::Mat4> out(count);
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        ak::MultiplyMany(a.data, b.data, out.data, count);
+        benchmark::ClobberMemory();
+    }
+    SetArrayCounters(state, count, sizeof(ak::Mat4), 3);
+}
+// The same affine products with a quarter less memory traffic
+template<>
+void Mat4MultiplyMany<ak::Mat4x3>(benchmark::State& state)
+{
+    size_t const count = static_cast<size_t>(state.range(0));
+    AlignedArray<ak::Mat4x3> const a(count), b(count);
+    AlignedArray<ak::Mat4x3> out(count);
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        ak::MultiplyMany(a.data, b.data, out.data, count);
+        benchmark::ClobberMemory();
+    }
+    SetArrayCounters(state, count, sizeof(ak::Mat4x3), 3);
+}
+BENCHMARK_TEMPLATE(Mat4MultiplyMany, glm::mat4)->Apply(WorkingSetArgs<glm::mat4, 3>);
+BENCHMARK_TEMPLATE(Mat4MultiplyMany, Eigen::Matrix4f)->Apply(WorkingSetArgs<Eigen::Matrix4f, 3>);
+BENCHMARK_TEMPLATE(Mat4MultiplyMany, ak::Mat4)->Apply(WorkingSetArgs<ak::Mat4, 3>);
+BENCHMARK_TEMPLATE(Mat4MultiplyMany, ak::Mat4x3)->Apply(WorkingSetArgs<ak::Mat4x3, 3>);
+
+template<typename Matrix>
+void Mat4MultiplyManyBroadcast(benchmark::State& state)
+{
+    size_t const count = static_cast<size_t>(state.range(0));
+    AlignedArray<Matrix> const parent(1), b(count);
+    AlignedArray<Matrix> out(count);
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        for (size_t ii = 0; ii < count; ++ii) {
+            MultiplyInto(out.data[ii], parent.data[0], b.data[ii]);
+        }
+        benchmark::ClobberMemory();
+    }
+    SetArrayCounters(state, count, sizeof(Matrix), 2);
+}
+template<>
+void Mat4MultiplyManyBroadcast<ak::Mat4>(benchmark::State& state)
+{
+    size_t const count = static_cast<size_t>(state.range(0));
+    AlignedArray<ak::Mat4> const parent(1), b(count);
+    AlignedArray<ak::Mat4> out(count);
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        ak::MultiplyMany(parent.data[0], b.data, out.data, count);
+        benchmark::ClobberMemory();
+    }
+    SetArrayCounters(state, count, sizeof(ak::Mat4), 2);
+}
+BENCHMARK_TEMPLATE(Mat4MultiplyManyBroadcast, glm::mat4)->RangeMultiplier(8)->Range(1, 1 << 20);
+BENCHMARK_TEMPLATE(Mat4MultiplyManyBroadcast, Eigen::Matrix4f)
+    ->RangeMultiplier(8)
+    ->Range(1, 1 << 20);
+BENCHMARK_TEMPLATE(Mat4MultiplyManyBroadcast, ak::Mat4)->RangeMultiplier(8)->Range(1, 1 << 20);
+
 template<typename Matrix, typename Vector>
 void Mat4VecMultiplication(benchmark::State& state)
 {
@@ -288,6 +758,7 @@ void Mat4VecMultiplication(benchmark::State& state)
     FillMatrix(m2);
     FillVec(v1);
     FillVec(v2);
+    perf::Scope const perfScope(state);
     for (auto _ : state) {
         for (int ii = 0; ii < kLoopCount; ++ii) {
             benchmark::DoNotOptimize((Vector)(m1 * v1));
@@ -295,6 +766,7 @@ void Mat4VecMultiplication(benchmark::State& state)
     }
 }
 
+#if AK_HAS_DIRECTXMATH
 template<>
 void Mat4VecMultiplication<XMMATRIX, XMVECTOR>(benchmark::State& state)
 {
@@ -304,6 +776,7 @@ void Mat4VecMultiplication<XMMATRIX, XMVECTOR>(benchmark::State& state)
     FillMatrix(m2);
     FillVec(v1);
     FillVec(v2);
+    perf::Scope const perfScope(state);
     for (auto _ : state) {
         for (int ii = 0; ii < kLoopCount; ++ii) {
             benchmark::DoNotOptimize(XMVector4Transform(v1, m1));
@@ -311,30 +784,117 @@ void Mat4VecMultiplication<XMMATRIX, XMVECTOR>(benchmark::State& state)
     }
 }
 BENCHMARK_TEMPLATE(Mat4VecMultiplication, XMMATRIX, XMVECTOR);
+#endif
 BENCHMARK_TEMPLATE(Mat4VecMultiplication, glm::mat4, glm::vec4);
 BENCHMARK_TEMPLATE(Mat4VecMultiplication, Eigen::Matrix4f, Eigen::Vector4f);
 BENCHMARK_TEMPLATE(Mat4VecMultiplication, ak::Mat4, ak::Vec4);
 
-void DxMat4Inverse(benchmark::State& state)
+void TransformInto(glm::vec4& out, glm::mat4 const& m, glm::vec4 const& v)
 {
-    DirectX::XMMATRIX m;
+    out = m * v;
+}
+void TransformInto(Eigen::Vector4f& out, Eigen::Matrix4f const& m, Eigen::Vector4f const& v)
+{
+    out.noalias() = m * v;
+}
+
+template<typename Matrix, typename Vector>
+void Mat4VecMultiplicationArray(benchmark::State& state)
+{
+    size_t const count = static_cast<size_t>(state.range(0));
+    Matrix m;
     FillMatrix(m);
+    AlignedArray<Vector> const in(count);
+    AlignedArray<Vector> out(count);
+    perf::Scope const perfScope(state);
     for (auto _ : state) {
-        for (int ii = 0; ii < kLoopCount / 4; ++ii) {
-            benchmark::DoNotOptimize(XMMatrixInverse(nullptr, m));
+        for (size_t ii = 0; ii < count; ++ii) {
+            TransformInto(out.data[ii], m, in.data[ii]);
         }
+        benchmark::ClobberMemory();
     }
+    SetArrayCounters(state, count, sizeof(Vector), 2);
 }
-BENCHMARK(DxMat4Inverse);
-
-void GlmMat4Inverse(benchmark::State& state)
+template<>
+void Mat4VecMultiplicationArray<ak::Mat4, ak::Vec4>(benchmark::State& state)
 {
-    glm::mat4 m;
+    size_t const count = static_cast<size_t>(state.range(0));
+    ak::Mat4 m;
     FillMatrix(m);
+    AlignedArray<ak::Vec4> const in(count);
+    AlignedArray<ak::Vec4> out(count);
+    perf::Scope const perfScope(state);
     for (auto _ : state) {
-        for (int ii = 0; ii < kLoopCount / 4; ++ii) {
-            benchmark::DoNotOptimize(glm::inverse(m));
-        }
+        ak::TransformMany(m, in.data, out.data, count);
+        benchmark::ClobberMemory();
+    }
+    SetArrayCounters(state, count, sizeof(ak::Vec4), 2);
+}
+BENCHMARK_TEMPLATE(Mat4VecMultiplicationArray, glm::mat4, glm::vec4)
+    ->Apply(WorkingSetArgs<glm::vec4, 2>);
+BENCHMARK_TEMPLATE(Mat4VecMultiplicationArray, Eigen::Matrix4f, Eigen::Vector4f)
+    ->Apply(WorkingSetArgs<Eigen::Vector4f, 2>);
+BENCHMARK_TEMPLATE(Mat4VecMultiplicationArray, ak::Mat4, ak::Vec4)
+    ->Apply(WorkingSetArgs<ak::Vec4, 2>);
+
+void GlmTransformPoints(benchmark::State& state)
+{
+    size_t const count = static_cast<size_t>(state.range(0));
+    glm::mat4 m;
+    FillMatrix(m);
+    AlignedArray<glm::vec3> const in(count);
+    AlignedArray<glm::vec3> out(count);
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        for (size_t ii = 0; ii < count; ++ii) {
+            out.data[ii] = glm::vec3(m * glm::vec4(in.data[ii], 1.0f));
+        }
+        benchmark::ClobberMemory();
+    }
+    SetArrayCounters(state, count, sizeof(glm::vec3), 2);
+}
+BENCHMARK(GlmTransformPoints)->RangeMultiplier(16)->Range(16, 1 << 24);
+
+void TransformPoints(benchmark::State& state)
+{
+    size_t const count = static_cast<size_t>(state.range(0));
+    ak::Mat4 m;
+    FillMatrix(m);
+    AlignedArray<ak::Vec3> const in(count);
+    AlignedArray<ak::Vec3> out(count);
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        ak::TransformPoints(m, in.data, out.data, count);
+        benchmark::ClobberMemory();
+    }
+    SetArrayCounters(state, count, sizeof(ak::Vec3), 2);
+}
+BENCHMARK(TransformPoints)->RangeMultiplier(16)->Range(16, 1 << 24);
+
+#if AK_HAS_DIRECTXMATH
+void DxMat4Inverse(benchmark::State& state)
+{
+    DirectX::XMMATRIX m;
+    FillMatrix(m);
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        for (int ii = 0; ii < kLoopCount / 4; ++ii) {
+            benchmark::DoNotOptimize(XMMatrixInverse(nullptr, m));
+        }
+    }
+}
+BENCHMARK(DxMat4Inverse);
+#endif
+
+void GlmMat4Inverse(benchmark::State& state)
+{
+    glm::mat4 m;
+    FillMatrix(m);
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        for (int ii = 0; ii < kLoopCount / 4; ++ii) {
+            benchmark::DoNotOptimize(glm::inverse(m));
+        }
     }
 }
 BENCHMARK(GlmMat4Inverse);
@@ -343,6 +903,7 @@ void EigenMat4Inverse(benchmark::State& state)
 {
     Eigen::Matrix4f m;
     FillMatrix(m);
+    perf::Scope const perfScope(state);
     for (auto _ : state) {
         for (int ii = 0; ii < kLoopCount / 4; ++ii) {
             benchmark::DoNotOptimize((Eigen::Matrix4f)m.inverse());
@@ -355,6 +916,7 @@ void Mat4Inverse(benchmark::State& state)
 {
     ak::Mat4 m;
     FillMatrix(m);
+    perf::Scope const perfScope(state);
     for (auto _ : state) {
         for (int ii = 0; ii < kLoopCount / 4; ++ii) {
             benchmark::DoNotOptimize(ak::Inverse(m));
@@ -363,4 +925,1097 @@ void Mat4Inverse(benchmark::State& state)
 }
 BENCHMARK(Mat4Inverse);
 
+void Mat4InverseScalar(benchmark::State& state)
+{
+    ak::Mat4 m;
+    FillMatrix(m);
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        for (int ii = 0; ii < kLoopCount / 4; ++ii) {
+            benchmark::DoNotOptimize(ak::InverseScalar(m));
+        }
+    }
+}
+BENCHMARK(Mat4InverseScalar);
+
+void InverseInto(glm::mat4& out, glm::mat4 const& m)
+{
+    out = glm::inverse(m);
+}
+void InverseInto(Eigen::Matrix4f& out, Eigen::Matrix4f const& m)
+{
+    out = m.inverse();
+}
+
+template<typename Matrix>
+void Mat4InverseMany(benchmark::State& state)
+{
+    size_t const count = static_cast<size_t>(state.range(0));
+    AlignedArray<Matrix> const m(count);
+    AlignedArray<Matrix> out(count);
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        for (size_t ii = 0; ii < count; ++ii) {
+            InverseInto(out.data[ii], m.data[ii]);
+        }
+        benchmark::ClobberMemory();
+    }
+    SetArrayCounters(state, count, sizeof(Matrix), 2);
+}
+template<>
+void Mat4InverseMany<ak::Mat4>(benchmark::State& state)
+{
+    size_t const count = static_cast<size_t>(state.range(0));
+    AlignedArray<ak::Mat4> const m(count);
+    AlignedArray<ak::Mat4> out(count);
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        ak::InverseMany(m.data, out.data, count);
+        benchmark::ClobberMemory();
+    }
+    SetArrayCounters(state, count, sizeof(ak::Mat4), 2);
+}
+BENCHMARK_TEMPLATE(Mat4InverseMany, glm::mat4)->Apply(WorkingSetArgs<glm::mat4, 2>);
+BENCHMARK_TEMPLATE(Mat4InverseMany, Eigen::Matrix4f)->Apply(WorkingSetArgs<Eigen::Matrix4f, 2>);
+BENCHMARK_TEMPLATE(Mat4InverseMany, ak::Mat4)->Apply(WorkingSetArgs<ak::Mat4, 2>);
+
+ak::Mat4 RandRigid()
+{
+    ak::Vec4 const axis = {RandFloat(-1.0f, 1.0f), RandFloat(-1.0f, 1.0f), RandFloat(-1.0f, 1.0f),
+                           0.0f};
+    ak::Mat4 m = ak::Mat4::RotationAxis(axis, RandFloat(-3.0f, 3.0f));
+    m.c3 = {RandFloat(-50.0f, 50.0f), RandFloat(-50.0f, 50.0f), RandFloat(-50.0f, 50.0f), 1.0f};
+    return m;
+}
+ak::Mat4 RandAffine()
+{
+    return RandRigid() *
+           ak::Mat4::Scaling(RandFloat(0.5f, 4.0f), RandFloat(0.5f, 4.0f), RandFloat(0.5f, 4.0f));
+}
+
+void Mat4InverseAffine(benchmark::State& state)
+{
+    ak::Mat4 const m = RandAffine();
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        for (int ii = 0; ii < kLoopCount / 4; ++ii) {
+            benchmark::DoNotOptimize(ak::InverseAffine(m));
+        }
+    }
+}
+BENCHMARK(Mat4InverseAffine);
+
+void Mat4InverseRigid(benchmark::State& state)
+{
+    ak::Mat4 const m = RandRigid();
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        for (int ii = 0; ii < kLoopCount / 4; ++ii) {
+            benchmark::DoNotOptimize(ak::InverseRigid(m));
+        }
+    }
+}
+BENCHMARK(Mat4InverseRigid);
+
+// Batched general vs. affine vs. rigid inverse over the same rigid transforms
+template<void (*kInverse)(ak::Mat4 const*, ak::Mat4*, size_t)>
+void Mat4InverseManyTransforms(benchmark::State& state)
+{
+    size_t const count = static_cast<size_t>(state.range(0));
+    AlignedArray<ak::Mat4> m(count);
+    AlignedArray<ak::Mat4> out(count);
+    for (size_t ii = 0; ii < count; ++ii) {
+        m.data[ii] = RandRigid();
+    }
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        kInverse(m.data, out.data, count);
+        benchmark::ClobberMemory();
+    }
+    SetArrayCounters(state, count, sizeof(ak::Mat4), 2);
+}
+BENCHMARK_TEMPLATE(Mat4InverseManyTransforms, ak::InverseMany)
+    ->RangeMultiplier(8)
+    ->Range(1, 1 << 20);
+BENCHMARK_TEMPLATE(Mat4InverseManyTransforms, ak::InverseAffineMany)
+    ->RangeMultiplier(8)
+    ->Range(1, 1 << 20);
+BENCHMARK_TEMPLATE(Mat4InverseManyTransforms, ak::InverseRigidMany)
+    ->RangeMultiplier(8)
+    ->Range(1, 1 << 20);
+
+
+// Packed Vec3 arrays vs. structure-of-arrays streams, each with the exact and the rsqrt-based
+// normalization
+template<ak::Vec3 (*kNormalize)(ak::Vec3)>
+void Vec3ArrayNormalize(benchmark::State& state)
+{
+    size_t const count = static_cast<size_t>(state.range(0));
+    AlignedArray<ak::Vec3> const in(count);
+    AlignedArray<ak::Vec3> out(count);
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        for (size_t ii = 0; ii < count; ++ii) {
+            out.data[ii] = kNormalize(in.data[ii]);
+        }
+        benchmark::ClobberMemory();
+    }
+    SetArrayCounters(state, count, sizeof(ak::Vec3), 2);
+}
+BENCHMARK_TEMPLATE(Vec3ArrayNormalize, ak::Normalize)->Apply(WorkingSetArgs<ak::Vec3, 2>);
+BENCHMARK_TEMPLATE(Vec3ArrayNormalize, ak::NormalizeFast)->Apply(WorkingSetArgs<ak::Vec3, 2>);
+
+template<void (*kNormalize)(ak::Vec3SoA const&, ak::Vec3SoA&)>
+void Vec3SoANormalize(benchmark::State& state)
+{
+    size_t const count = static_cast<size_t>(state.range(0));
+    AlignedArray<ak::Vec3> const points(count);
+    ak::Vec3SoA in(count);
+    ak::Vec3SoA out(count);
+    // Touch every page up front, so the first iteration doesn't time page faults
+    ak::ToSoA(points.data, in);
+    ak::ToSoA(points.data, out);
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        kNormalize(in, out);
+        benchmark::ClobberMemory();
+    }
+    SetArrayCounters(state, count, sizeof(ak::Vec3), 2);
+}
+BENCHMARK_TEMPLATE(Vec3SoANormalize, ak::Normalize)->Apply(WorkingSetArgs<ak::Vec3, 2>);
+BENCHMARK_TEMPLATE(Vec3SoANormalize, ak::NormalizeFast)->Apply(WorkingSetArgs<ak::Vec3, 2>);
+
+// The same packed-array normalize across libraries
+template<typename Vector>
+void VecNormalizeArray(benchmark::State& state)
+{
+    size_t const count = static_cast<size_t>(state.range(0));
+    AlignedArray<Vector> const in(count);
+    AlignedArray<Vector> out(count);
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        for (size_t ii = 0; ii < count; ++ii) {
+            out.data[ii] = NormalizeOf(in.data[ii]);
+        }
+        benchmark::ClobberMemory();
+    }
+    SetArrayCounters(state, count, sizeof(Vector), 2);
+}
+BENCHMARK_TEMPLATE(VecNormalizeArray, glm::vec3)->Apply(WorkingSetArgs<glm::vec3, 2>);
+BENCHMARK_TEMPLATE(VecNormalizeArray, Eigen::Vector3f)->Apply(WorkingSetArgs<Eigen::Vector3f, 2>);
+BENCHMARK_TEMPLATE(VecNormalizeArray, ak::Vec3)->Apply(WorkingSetArgs<ak::Vec3, 2>);
+BENCHMARK_TEMPLATE(VecNormalizeArray, glm::vec4)->Apply(WorkingSetArgs<glm::vec4, 2>);
+BENCHMARK_TEMPLATE(VecNormalizeArray, Eigen::Vector4f)->Apply(WorkingSetArgs<Eigen::Vector4f, 2>);
+BENCHMARK_TEMPLATE(VecNormalizeArray, ak::Vec4)->Apply(WorkingSetArgs<ak::Vec4, 2>);
+
+void Vec3ArrayCross(benchmark::State& state)
+{
+    size_t const count = static_cast<size_t>(state.range(0));
+    AlignedArray<ak::Vec3> const a(count);
+    AlignedArray<ak::Vec3> const b(count);
+    AlignedArray<ak::Vec3> out(count);
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        for (size_t ii = 0; ii < count; ++ii) {
+            out.data[ii] = ak::Cross(a.data[ii], b.data[ii]);
+        }
+        benchmark::ClobberMemory();
+    }
+    SetArrayCounters(state, count, sizeof(ak::Vec3), 3);
+}
+BENCHMARK(Vec3ArrayCross)->RangeMultiplier(16)->Range(1 << 8, 1 << 24);
+
+void Vec3SoACross(benchmark::State& state)
+{
+    size_t const count = static_cast<size_t>(state.range(0));
+    AlignedArray<ak::Vec3> const points(count);
+    ak::Vec3SoA a(count);
+    ak::Vec3SoA b(count);
+    ak::Vec3SoA out(count);
+    ak::ToSoA(points.data, a);
+    ak::ToSoA(points.data, b);
+    ak::ToSoA(points.data, out);
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        ak::Cross(a, b, out);
+        benchmark::ClobberMemory();
+    }
+    SetArrayCounters(state, count, sizeof(ak::Vec3), 3);
+}
+BENCHMARK(Vec3SoACross)->RangeMultiplier(16)->Range(1 << 8, 1 << 24);
+
+void Vec3SoADot(benchmark::State& state)
+{
+    size_t const count = static_cast<size_t>(state.range(0));
+    AlignedArray<ak::Vec3> const points(count);
+    AlignedArray<float> out(count);
+    ak::Vec3SoA a(count);
+    ak::ToSoA(points.data, a);
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        ak::Dot(a, a, out.data);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * count));
+    state.SetBytesProcessed(
+        static_cast<int64_t>(state.iterations() * count * (sizeof(ak::Vec3) + sizeof(float))));
+}
+BENCHMARK(Vec3SoADot)->RangeMultiplier(16)->Range(1 << 8, 1 << 24);
+
+// AoS -> SoA -> AoS round trip
+void Vec3SoAConvert(benchmark::State& state)
+{
+    size_t const count = static_cast<size_t>(state.range(0));
+    AlignedArray<ak::Vec3> points(count);
+    ak::Vec3SoA soa(count);
+    ak::ToSoA(points.data, soa);
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        ak::ToSoA(points.data, soa);
+        ak::ToAoS(soa, points.data);
+        benchmark::ClobberMemory();
+    }
+    SetArrayCounters(state, count, sizeof(ak::Vec3), 4);
+}
+BENCHMARK(Vec3SoAConvert)->RangeMultiplier(16)->Range(1 << 8, 1 << 24);
+
+
+// Plain Vec4 vs. register-backed Vec4x on the same cache-resident data
+void Vec4LerpNormalize(benchmark::State& state)
+{
+    size_t const count = static_cast<size_t>(state.range(0));
+    AlignedArray<ak::Vec4> const a(count);
+    AlignedArray<ak::Vec4> const b(count);
+    AlignedArray<ak::Vec4> out(count);
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        for (size_t ii = 0; ii < count; ++ii) {
+            out.data[ii] = ak::Normalize(ak::Lerp(a.data[ii], b.data[ii], 0.25f));
+        }
+        benchmark::ClobberMemory();
+    }
+    SetArrayCounters(state, count, sizeof(ak::Vec4), 3);
+}
+BENCHMARK(Vec4LerpNormalize)->RangeMultiplier(16)->Range(16, 1 << 12);
+
+void Vec4xLerpNormalize(benchmark::State& state)
+{
+    size_t const count = static_cast<size_t>(state.range(0));
+    AlignedArray<ak::Vec4> const a(count);
+    AlignedArray<ak::Vec4> const b(count);
+    AlignedArray<ak::Vec4> out(count);
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        for (size_t ii = 0; ii < count; ++ii) {
+            ak::Vec4x const v = ak::Lerp(ak::Load(a.data[ii]), ak::Load(b.data[ii]), 0.25f);
+            out.data[ii] = ak::Store(ak::Normalize(v));
+        }
+        benchmark::ClobberMemory();
+    }
+    SetArrayCounters(state, count, sizeof(ak::Vec4), 3);
+}
+BENCHMARK(Vec4xLerpNormalize)->RangeMultiplier(16)->Range(16, 1 << 12);
+
+// Frustum culling. A third to half of the spheres are visible.
+ak::Frustum BenchmarkFrustum()
+{
+    float const zNear = 1.0f;
+    float const zFar = 1000.0f;
+    float const f = 1.0f / tanf(0.6f);
+    ak::Mat4 const proj = {
+        {f / (16.0f / 9.0f), 0.0f, 0.0f, 0.0f},
+        {0.0f, f, 0.0f, 0.0f},
+        {0.0f, 0.0f, zFar / (zNear - zFar), -1.0f},
+        {0.0f, 0.0f, zNear * zFar / (zNear - zFar), 0.0f},
+    };
+    return ak::Frustum::FromMatrix(proj);
+}
+
+// The per-sphere loop this replaces
+void CullSpheresLoop(benchmark::State& state)
+{
+    size_t const count = static_cast<size_t>(state.range(0));
+    ak::Frustum const frustum = BenchmarkFrustum();
+    AlignedArray<ak::Sphere> spheres(count);
+    AlignedArray<uint32_t> visible(count);
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        size_t visibleCount = 0;
+        for (size_t ii = 0; ii < count; ++ii) {
+            if (ak::Intersects(frustum, spheres.data[ii])) {
+                visible.data[visibleCount++] = static_cast<uint32_t>(ii);
+            }
+        }
+        benchmark::DoNotOptimize(visibleCount);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * count));
+}
+BENCHMARK(CullSpheresLoop)->Arg(10000)->Arg(100000)->Arg(1000000)->Arg(2000000);
+
+template<size_t (*kCull)(ak::Frustum const&, ak::Vec4SoA const&, uint32_t*)>
+void CullSpheres(benchmark::State& state)
+{
+    size_t const count = static_cast<size_t>(state.range(0));
+    ak::Frustum const frustum = BenchmarkFrustum();
+    ak::Vec4SoA spheres(count);
+    AlignedArray<uint32_t> visible(count);
+    for (size_t ii = 0; ii < count; ++ii) {
+        ak::Sphere const s = RandSphere();
+        spheres.Set(ii, {s.center.x, s.center.y, s.center.z, s.radius});
+    }
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(kCull(frustum, spheres, visible.data));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * count));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * count * sizeof(ak::Vec4)));
+}
+BENCHMARK_TEMPLATE(CullSpheres, ak::CullSpheresScalar)
+    ->Arg(10000)
+    ->Arg(100000)
+    ->Arg(1000000)
+    ->Arg(2000000);
+BENCHMARK_TEMPLATE(CullSpheres, ak::CullSpheres)
+    ->Arg(10000)
+    ->Arg(100000)
+    ->Arg(1000000)
+    ->Arg(2000000);
+
+
+// Aabbs
+template<void (*kTransform)(ak::Mat4 const&, ak::Aabb const*, ak::Aabb*, size_t)>
+void TransformAabbs(benchmark::State& state)
+{
+    size_t const count = static_cast<size_t>(state.range(0));
+    ak::Mat4 m;
+    FillMatrix(m);
+    m.c0.w = m.c1.w = m.c2.w = 0.0f;
+    m.c3.w = 1.0f;
+    AlignedArray<ak::Aabb> const in(count);
+    AlignedArray<ak::Aabb> out(count);
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        kTransform(m, in.data, out.data, count);
+        benchmark::ClobberMemory();
+    }
+    SetArrayCounters(state, count, sizeof(ak::Aabb), 2);
+}
+BENCHMARK_TEMPLATE(TransformAabbs, ak::TransformAabbsScalar)
+    ->RangeMultiplier(16)
+    ->Range(16, 1 << 24);
+BENCHMARK_TEMPLATE(TransformAabbs, ak::TransformAabbs)->RangeMultiplier(16)->Range(16, 1 << 24);
+
+template<ak::Aabb (*kBound)(ak::Vec3 const*, size_t)>
+void AabbFromPoints(benchmark::State& state)
+{
+    size_t const count = static_cast<size_t>(state.range(0));
+    AlignedArray<ak::Vec3> const points(count);
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(kBound(points.data, count));
+    }
+    SetArrayCounters(state, count, sizeof(ak::Vec3), 1);
+}
+BENCHMARK_TEMPLATE(AabbFromPoints, ak::AabbFromPointsScalar)
+    ->RangeMultiplier(16)
+    ->Range(16, 1 << 24);
+BENCHMARK_TEMPLATE(AabbFromPoints, ak::AabbFromPoints)->RangeMultiplier(16)->Range(16, 1 << 24);
+
+template<void (*kClassify)(ak::Vec4 const*, size_t, ak::Aabb const*, ak::Containment*, size_t)>
+void ClassifyAabbs(benchmark::State& state)
+{
+    size_t const count = static_cast<size_t>(state.range(0));
+    ak::Frustum const frustum = BenchmarkFrustum();
+    AlignedArray<ak::Aabb> const boxes(count);
+    AlignedArray<ak::Containment> out(count);
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        kClassify(frustum.planes, ak::Frustum::kPlaneCount, boxes.data, out.data, count);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * count));
+}
+BENCHMARK_TEMPLATE(ClassifyAabbs, ak::ClassifyAabbsScalar)
+    ->Arg(10000)
+    ->Arg(100000)
+    ->Arg(1000000);
+BENCHMARK_TEMPLATE(ClassifyAabbs, ak::ClassifyAabbs)->Arg(10000)->Arg(100000)->Arg(1000000);
+
+
+// Quaternions. The glm and ak functions are wrapped so each benchmark is a single template.
+glm::quat QuatNlerp(glm::quat const& a, glm::quat const& b, float const t)
+{
+    return glm::normalize(glm::lerp(a, glm::dot(a, b) < 0.0f ? -b : b, t));
+}
+ak::Quat QuatNlerp(ak::Quat const& a, ak::Quat const& b, float const t)
+{
+    return ak::Nlerp(a, b, t);
+}
+glm::quat QuatSlerp(glm::quat const& a, glm::quat const& b, float const t)
+{
+    return glm::slerp(a, b, t);
+}
+ak::Quat QuatSlerp(ak::Quat const& a, ak::Quat const& b, float const t)
+{
+    return ak::Slerp(a, b, t);
+}
+glm::mat4 QuatToMat4(glm::quat const& q)
+{
+    return glm::mat4_cast(q);
+}
+ak::Mat4 QuatToMat4(ak::Quat const& q)
+{
+    return ak::Mat4::Rotation(q);
+}
+
+template<typename Quat>
+void QuatMultiply(benchmark::State& state)
+{
+    size_t const count = static_cast<size_t>(state.range(0));
+    AlignedArray<Quat> const a(count), b(count);
+    AlignedArray<Quat> out(count);
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        for (size_t ii = 0; ii < count; ++ii) {
+            out.data[ii] = a.data[ii] * b.data[ii];
+        }
+        benchmark::ClobberMemory();
+    }
+    SetArrayCounters(state, count, sizeof(Quat), 3);
+}
+BENCHMARK_TEMPLATE(QuatMultiply, glm::quat)->RangeMultiplier(16)->Range(16, 1 << 12);
+BENCHMARK_TEMPLATE(QuatMultiply, ak::Quat)->RangeMultiplier(16)->Range(16, 1 << 12);
+
+void QuatMultiplyMany(benchmark::State& state)
+{
+    size_t const count = static_cast<size_t>(state.range(0));
+    AlignedArray<ak::Quat> const a(count), b(count);
+    AlignedArray<ak::Quat> out(count);
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        ak::MultiplyMany(a.data, b.data, out.data, count);
+        benchmark::ClobberMemory();
+    }
+    SetArrayCounters(state, count, sizeof(ak::Quat), 3);
+}
+BENCHMARK(QuatMultiplyMany)->RangeMultiplier(16)->Range(16, 1 << 12);
+
+template<typename Quat, typename Vector>
+void QuatRotate(benchmark::State& state)
+{
+    size_t const count = static_cast<size_t>(state.range(0));
+    AlignedArray<Quat> const q(count);
+    AlignedArray<Vector> const v(count);
+    AlignedArray<Vector> out(count);
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        for (size_t ii = 0; ii < count; ++ii) {
+            out.data[ii] = q.data[ii] * v.data[ii];
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * count));
+}
+BENCHMARK_TEMPLATE(QuatRotate, glm::quat, glm::vec3)->RangeMultiplier(16)->Range(16, 1 << 12);
+BENCHMARK_TEMPLATE(QuatRotate, ak::Quat, ak::Vec3)->RangeMultiplier(16)->Range(16, 1 << 12);
+
+template<typename Quat>
+void QuatNlerp(benchmark::State& state)
+{
+    size_t const count = static_cast<size_t>(state.range(0));
+    AlignedArray<Quat> const a(count), b(count);
+    AlignedArray<Quat> out(count);
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        for (size_t ii = 0; ii < count; ++ii) {
+            out.data[ii] = QuatNlerp(a.data[ii], b.data[ii], 0.3f);
+        }
+        benchmark::ClobberMemory();
+    }
+    SetArrayCounters(state, count, sizeof(Quat), 3);
+}
+BENCHMARK_TEMPLATE(QuatNlerp, glm::quat)->RangeMultiplier(16)->Range(16, 1 << 12);
+BENCHMARK_TEMPLATE(QuatNlerp, ak::Quat)->RangeMultiplier(16)->Range(16, 1 << 12);
+
+void QuatNlerpMany(benchmark::State& state)
+{
+    size_t const count = static_cast<size_t>(state.range(0));
+    AlignedArray<ak::Quat> const a(count), b(count);
+    AlignedArray<ak::Quat> out(count);
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        ak::NlerpMany(a.data, b.data, 0.3f, out.data, count);
+        benchmark::ClobberMemory();
+    }
+    SetArrayCounters(state, count, sizeof(ak::Quat), 3);
+}
+BENCHMARK(QuatNlerpMany)->RangeMultiplier(16)->Range(16, 1 << 12);
+
+template<typename Quat>
+void QuatSlerp(benchmark::State& state)
+{
+    size_t const count = static_cast<size_t>(state.range(0));
+    AlignedArray<Quat> const a(count), b(count);
+    AlignedArray<Quat> out(count);
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        for (size_t ii = 0; ii < count; ++ii) {
+            out.data[ii] = QuatSlerp(a.data[ii], b.data[ii], 0.3f);
+        }
+        benchmark::ClobberMemory();
+    }
+    SetArrayCounters(state, count, sizeof(Quat), 3);
+}
+BENCHMARK_TEMPLATE(QuatSlerp, glm::quat)->RangeMultiplier(16)->Range(16, 1 << 12);
+BENCHMARK_TEMPLATE(QuatSlerp, ak::Quat)->RangeMultiplier(16)->Range(16, 1 << 12);
+
+template<typename Quat, typename Matrix>
+void QuatToMat4(benchmark::State& state)
+{
+    size_t const count = static_cast<size_t>(state.range(0));
+    AlignedArray<Quat> const q(count);
+    AlignedArray<Matrix> out(count);
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        for (size_t ii = 0; ii < count; ++ii) {
+            out.data[ii] = QuatToMat4(q.data[ii]);
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * count));
+}
+BENCHMARK_TEMPLATE(QuatToMat4, glm::quat, glm::mat4)->RangeMultiplier(16)->Range(16, 1 << 12);
+BENCHMARK_TEMPLATE(QuatToMat4, ak::Quat, ak::Mat4)->RangeMultiplier(16)->Range(16, 1 << 12);
+
+/*
+ * Pose blending
+ */
+// Per-bone blend of AoS transforms, as vec_math.h's transform_lerp does it
+template<ak::Quat (*kRotation)(ak::Quat, ak::Quat, float)>
+void TransformLerp(benchmark::State& state)
+{
+    size_t const count = static_cast<size_t>(state.range(0));
+    AlignedArray<ak::Transform> const a(count), b(count);
+    AlignedArray<ak::Transform> out(count);
+    std::vector<float> weights(count);
+    for (float& w : weights) {
+        w = RandFloat(0.0f, 1.0f);
+    }
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        for (size_t ii = 0; ii < count; ++ii) {
+            ak::Transform const& ta = a.data[ii];
+            ak::Transform const& tb = b.data[ii];
+            float const t = weights[ii];
+            out.data[ii] = {kRotation(ta.orientation, tb.orientation, t),
+                            ta.position + (tb.position - ta.position) * t,
+                            ta.scale + (tb.scale - ta.scale) * t};
+        }
+        benchmark::ClobberMemory();
+    }
+    SetArrayCounters(state, count, sizeof(ak::Transform), 3);
+}
+BENCHMARK_TEMPLATE(TransformLerp, ak::Nlerp)->RangeMultiplier(8)->Range(64, 1 << 19);
+BENCHMARK_TEMPLATE(TransformLerp, ak::Slerp)->RangeMultiplier(8)->Range(64, 1 << 19);
+
+template<void (*kBlend)(ak::PoseSoA const&, ak::PoseSoA const&, float const*, ak::PoseSoA&)>
+void BlendPoses(benchmark::State& state)
+{
+    size_t const count = static_cast<size_t>(state.range(0));
+    ak::PoseSoA a(count), b(count), out(count);
+    std::vector<float> weights(count);
+    for (size_t ii = 0; ii < count; ++ii) {
+        ak::Transform t;
+        Fill(t);
+        a.Set(ii, t);
+        Fill(t);
+        b.Set(ii, t);
+        weights[ii] = RandFloat(0.0f, 1.0f);
+    }
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        kBlend(a, b, weights.data(), out);
+        benchmark::ClobberMemory();
+    }
+    SetArrayCounters(state, count, sizeof(ak::Transform), 3);
+}
+BENCHMARK_TEMPLATE(BlendPoses, ak::BlendPosesScalar)->RangeMultiplier(8)->Range(64, 1 << 19);
+BENCHMARK_TEMPLATE(BlendPoses, ak::BlendPoses)->RangeMultiplier(8)->Range(64, 1 << 19);
+BENCHMARK_TEMPLATE(BlendPoses, ak::SlerpPosesScalar)->RangeMultiplier(8)->Range(64, 1 << 19);
+BENCHMARK_TEMPLATE(BlendPoses, ak::SlerpPoses)->RangeMultiplier(8)->Range(64, 1 << 19);
+
+// Four-way blend, as for a 2D blend space
+void BlendPosesMany(benchmark::State& state)
+{
+    size_t const count = static_cast<size_t>(state.range(0));
+    ak::PoseSoA poses[4] = {ak::PoseSoA(count), ak::PoseSoA(count), ak::PoseSoA(count),
+                            ak::PoseSoA(count)};
+    std::vector<float> weights[4];
+    for (int pp = 0; pp < 4; ++pp) {
+        weights[pp].resize(count);
+        for (size_t ii = 0; ii < count; ++ii) {
+            ak::Transform t;
+            Fill(t);
+            poses[pp].Set(ii, t);
+            weights[pp][ii] = 0.25f;
+        }
+    }
+    ak::PoseSoA const* const in[] = {&poses[0], &poses[1], &poses[2], &poses[3]};
+    float const* const inWeights[] = {weights[0].data(), weights[1].data(), weights[2].data(),
+                                      weights[3].data()};
+    ak::PoseSoA out(count);
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        ak::BlendPoses(in, inWeights, 4, out);
+        benchmark::ClobberMemory();
+    }
+    SetArrayCounters(state, count, sizeof(ak::Transform), 5);
+}
+BENCHMARK(BlendPosesMany)->RangeMultiplier(8)->Range(64, 1 << 19);
+
+/*
+ * Transform hierarchy
+ *
+ * Args are the root count, the fan-out and the percentage of nodes changed per frame. One root
+ * with fan-out f is a complete f-ary tree; many roots with fan-out 1 are parallel chains.
+ */
+size_t const kHierarchyNodes = 1 << 20;
+
+std::vector<uint32_t> HierarchyParents(benchmark::State const& state)
+{
+    size_t const roots = static_cast<size_t>(state.range(0));
+    size_t const fanout = static_cast<size_t>(state.range(1));
+    std::vector<uint32_t> parents(kHierarchyNodes);
+    for (size_t ii = 0; ii < kHierarchyNodes; ++ii) {
+        parents[ii] = ii < roots ? ak::TransformHierarchy::kNoParent
+                                 : static_cast<uint32_t>((ii - roots) / fanout);
+    }
+    return parents;
+}
+std::vector<size_t> HierarchyChanges(benchmark::State const& state)
+{
+    size_t const percent = static_cast<size_t>(state.range(2));
+    std::vector<size_t> changes;
+    for (size_t ii = 0; ii < kHierarchyNodes; ++ii) {
+        if (static_cast<size_t>(rand()) % 100 < percent) {
+            changes.push_back(ii);
+        }
+    }
+    return changes;
+}
+
+// Flattens the whole hierarchy every frame, as with transform_get_matrix and Mat4 operator*
+void HierarchyNaive(benchmark::State& state)
+{
+    std::vector<uint32_t> const parents = HierarchyParents(state);
+    std::vector<size_t> const changes = HierarchyChanges(state);
+    AlignedArray<ak::Transform> locals(kHierarchyNodes);
+    AlignedArray<ak::Mat4> world(kHierarchyNodes);
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        for (size_t const ii : changes) {
+            locals.data[ii].scale = 1.0f;
+        }
+        for (size_t ii = 0; ii < kHierarchyNodes; ++ii) {
+            ak::Mat4 const local = ak::Mat4::FromTransform(locals.data[ii]);
+            world.data[ii] = parents[ii] == ak::TransformHierarchy::kNoParent
+                                 ? local
+                                 : world.data[parents[ii]] * local;
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kHierarchyNodes));
+}
+
+template<void (*kUpdate)(ak::TransformHierarchy&)>
+void HierarchyUpdate(benchmark::State& state)
+{
+    std::vector<uint32_t> const parents = HierarchyParents(state);
+    std::vector<size_t> const changes = HierarchyChanges(state);
+    ak::TransformHierarchy h(parents.data(), kHierarchyNodes);
+    for (size_t ii = 0; ii < kHierarchyNodes; ++ii) {
+        ak::Transform t;
+        Fill(t);
+        h.SetLocal(ii, t);
+    }
+    kUpdate(h);
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        for (size_t const ii : changes) {
+            ak::Transform t = h.GetLocal(ii);
+            t.scale = 1.0f;
+            h.SetLocal(ii, t);
+        }
+        kUpdate(h);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kHierarchyNodes));
+    state.counters["depth"] = static_cast<double>(h.levelCount);
+}
+
+void HierarchyArgs(benchmark::internal::Benchmark* b)
+{
+    int const shapes[][2] = {{1, 2}, {1, 8}, {1, 64}, {1024, 1}, {16384, 1}};
+    for (auto const& shape : shapes) {
+        for (int const percent : {100, 1}) {
+            b->Args({shape[0], shape[1], percent});
+        }
+    }
+    b->Unit(benchmark::kMillisecond);
+}
+BENCHMARK(HierarchyNaive)->Apply(HierarchyArgs);
+BENCHMARK_TEMPLATE(HierarchyUpdate, ak::UpdateHierarchyScalar)->Apply(HierarchyArgs);
+BENCHMARK_TEMPLATE(HierarchyUpdate, ak::UpdateHierarchy)->Apply(HierarchyArgs);
+
+/*
+ * Thread scaling
+ *
+ * Args are the item count, the pool's thread count and the CPU placement; see thread-scaling.h.
+ * Arrays are first touched by the threads that process them, so on NUMA machines they are local.
+ * Besides throughput each run reports speedup and efficiency over the one-thread run and
+ * bandwidth_saturation against the machine's measured peak. Times are wall clock, since CPU time
+ * only counts the calling thread.
+ */
+template<typename T>
+void FillAll(scaling::Array<T>& array)
+{
+    for (size_t ii = 0; ii < array.count; ++ii) {
+        Fill(array.data[ii]);
+    }
+}
+
+void ParallelMultiplyMany(benchmark::State& state)
+{
+    size_t const count = static_cast<size_t>(state.range(0));
+    scaling::Setup setup(state);
+    scaling::Array<ak::Mat4> a(setup, count), b(setup, count);
+    scaling::Array<ak::Mat4> out(setup, count);
+    FillAll(a);
+    FillAll(b);
+    scaling::Scope const scalingScope(state, __func__, count * 3 * sizeof(ak::Mat4));
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        ak::MultiplyMany(setup.Pool(), a.data, b.data, out.data, count);
+        benchmark::ClobberMemory();
+    }
+    SetArrayCounters(state, count, sizeof(ak::Mat4), 3);
+}
+BENCHMARK(ParallelMultiplyMany)->Apply([](benchmark::internal::Benchmark* b) {
+    scaling::Args(b, 1 << 20);
+});
+
+void ParallelTransformPoints(benchmark::State& state)
+{
+    size_t const count = static_cast<size_t>(state.range(0));
+    scaling::Setup setup(state);
+    ak::Mat4 m;
+    Fill(m);
+    scaling::Array<ak::Vec3> in(setup, count);
+    scaling::Array<ak::Vec3> out(setup, count);
+    FillAll(in);
+    scaling::Scope const scalingScope(state, __func__, count * 2 * sizeof(ak::Vec3));
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        ak::TransformPoints(setup.Pool(), m, in.data, out.data, count);
+        benchmark::ClobberMemory();
+    }
+    SetArrayCounters(state, count, sizeof(ak::Vec3), 2);
+}
+BENCHMARK(ParallelTransformPoints)->Apply([](benchmark::internal::Benchmark* b) {
+    scaling::Args(b, 1 << 24);
+});
+
+void ParallelClassifyAabbs(benchmark::State& state)
+{
+    size_t const count = static_cast<size_t>(state.range(0));
+    scaling::Setup setup(state);
+    ak::Frustum const f = BenchmarkFrustum();
+    scaling::Array<ak::Aabb> boxes(setup, count);
+    scaling::Array<ak::Containment> out(setup, count);
+    FillAll(boxes);
+    scaling::Scope const scalingScope(state, __func__,
+                                      count * (sizeof(ak::Aabb) + sizeof(ak::Containment)));
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        ak::ClassifyAabbs(setup.Pool(), f, boxes.data, out.data, count);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * count));
+}
+BENCHMARK(ParallelClassifyAabbs)->Apply([](benchmark::internal::Benchmark* b) {
+    scaling::Args(b, 1 << 22);
+});
+
+// Vec3SoA allocates its own lanes, so they are first touched by the calling thread
+void ParallelNormalize(benchmark::State& state)
+{
+    size_t const count = static_cast<size_t>(state.range(0));
+    scaling::Setup setup(state);
+    AlignedArray<ak::Vec3> const points(count);
+    ak::Vec3SoA in(count);
+    ak::Vec3SoA out(count);
+    ak::ToSoA(points.data, in);
+    scaling::Scope const scalingScope(state, __func__, count * 2 * sizeof(ak::Vec3));
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        ak::Normalize(setup.Pool(), in, out);
+        benchmark::ClobberMemory();
+    }
+    SetArrayCounters(state, count, sizeof(ak::Vec3), 2);
+}
+BENCHMARK(ParallelNormalize)->Apply([](benchmark::internal::Benchmark* b) {
+    scaling::Args(b, 1 << 24);
+});
+
+void ParallelAabbFromPoints(benchmark::State& state)
+{
+    size_t const count = static_cast<size_t>(state.range(0));
+    scaling::Setup setup(state);
+    scaling::Array<ak::Vec3> points(setup, count);
+    FillAll(points);
+    scaling::Scope const scalingScope(state, __func__, count * sizeof(ak::Vec3));
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(ak::AabbFromPoints(setup.Pool(), points.data, count));
+    }
+    SetArrayCounters(state, count, sizeof(ak::Vec3), 1);
+}
+BENCHMARK(ParallelAabbFromPoints)->Apply([](benchmark::internal::Benchmark* b) {
+    scaling::Args(b, 1 << 24);
+});
+
+/*
+ * Skinning
+ *
+ * Args are the vertex count, the influences per vertex and the palette's bone count, skinning
+ * positions and normals. The naive loop transforms each AoS vertex by every influence's matrix
+ * and blends the results. A dual quaternion palette is half the size of a Mat4 one, so 1024 bones
+ * fit in a 48 KiB L1 as dual quaternions but not as matrices; palette_bytes reports the size.
+ */
+struct SkinnedVertex
+{
+    ak::Vec3 position;
+    ak::Vec3 normal;
+    uint32_t bones[8];
+    float weights[8];
+};
+
+void FillSkinnedVertex(SkinnedVertex& v, int const influences, size_t const bones)
+{
+    v.position = {RandFloat(-1.0f, 1.0f), RandFloat(-1.0f, 1.0f), RandFloat(-1.0f, 1.0f)};
+    v.normal = ak::Normalize(v.position);
+    for (int kk = 0; kk < 8; ++kk) {
+        v.bones[kk] = static_cast<uint32_t>(static_cast<size_t>(rand()) % bones);
+        v.weights[kk] = kk < influences ? 1.0f / influences : 0.0f;
+    }
+}
+
+void SkinningNaive(benchmark::State& state)
+{
+    size_t const count = static_cast<size_t>(state.range(0));
+    int const influences = static_cast<int>(state.range(1));
+    size_t const bones = static_cast<size_t>(state.range(2));
+    AlignedArray<ak::Mat4> const palette(bones);
+    std::vector<SkinnedVertex> vertices(count);
+    for (SkinnedVertex& v : vertices) {
+        FillSkinnedVertex(v, influences, bones);
+    }
+    std::vector<ak::Vec3> positions(count), normals(count);
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        for (size_t ii = 0; ii < count; ++ii) {
+            SkinnedVertex const& v = vertices[ii];
+            ak::Vec4 const p = {v.position.x, v.position.y, v.position.z, 1.0f};
+            ak::Vec4 const n = {v.normal.x, v.normal.y, v.normal.z, 0.0f};
+            ak::Vec4 position = {0, 0, 0, 0};
+            ak::Vec4 normal = {0, 0, 0, 0};
+            for (int kk = 0; kk < influences; ++kk) {
+                ak::Mat4 const& m = palette.data[v.bones[kk]];
+                position = position + (m * p) * v.weights[kk];
+                normal = normal + (m * n) * v.weights[kk];
+            }
+            positions[ii] = {position.x, position.y, position.z};
+            normals[ii] = {normal.x, normal.y, normal.z};
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * count));
+    state.counters["palette_bytes"] = static_cast<double>(bones * sizeof(ak::Mat4));
+}
+
+template<typename Bone, void (*kSkin)(Bone const*, ak::SkinInfluences const&, ak::Vec3SoA const&,
+                                      ak::Vec3SoA const&, ak::Vec3SoA&, ak::Vec3SoA&)>
+void Skinning(benchmark::State& state)
+{
+    size_t const count = static_cast<size_t>(state.range(0));
+    int const influences = static_cast<int>(state.range(1));
+    size_t const bones = static_cast<size_t>(state.range(2));
+    AlignedArray<Bone> const palette(bones);
+    ak::SkinInfluences skin(count, influences);
+    ak::Vec3SoA positions(count), normals(count), outPositions(count), outNormals(count);
+    for (size_t ii = 0; ii < count; ++ii) {
+        SkinnedVertex v;
+        FillSkinnedVertex(v, influences, bones);
+        positions.Set(ii, v.position);
+        normals.Set(ii, v.normal);
+        for (int kk = 0; kk < influences; ++kk) {
+            skin.Set(ii, kk, v.bones[kk], v.weights[kk]);
+        }
+    }
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        kSkin(palette.data, skin, positions, normals, outPositions, outNormals);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * count));
+    state.counters["palette_bytes"] = static_cast<double>(bones * sizeof(Bone));
+}
+
+void SkinningArgs(benchmark::internal::Benchmark* b)
+{
+    for (int64_t const count : {1 << 12, 1 << 16, 1 << 20}) {
+        for (int64_t const bones : {64, 1024}) {
+            b->Args({count, 4, bones});
+            b->Args({count, 8, bones});
+        }
+    }
+}
+BENCHMARK(SkinningNaive)->Apply(SkinningArgs);
+BENCHMARK_TEMPLATE(Skinning, ak::Mat4, ak::SkinLinearScalar)->Apply(SkinningArgs);
+BENCHMARK_TEMPLATE(Skinning, ak::Mat4, ak::SkinLinear)->Apply(SkinningArgs);
+BENCHMARK_TEMPLATE(Skinning, ak::Mat4x3, ak::SkinLinear)->Apply(SkinningArgs);
+BENCHMARK_TEMPLATE(Skinning, ak::DualQuat, ak::SkinDualQuatScalar)->Apply(SkinningArgs);
+BENCHMARK_TEMPLATE(Skinning, ak::DualQuat, ak::SkinDualQuat)->Apply(SkinningArgs);
+
+
+/*
+ * Sine and cosine
+ *
+ * The arg is the angle count. Angles span [-2pi, 2pi]. RotationBuild compares building Mat4
+ * rotations about arbitrary axes one at a time with libm, with glm, and with the batched builder.
+ */
+void SinCosLibm(benchmark::State& state)
+{
+    size_t const count = static_cast<size_t>(state.range(0));
+    std::vector<float> x(count), s(count), c(count);
+    for (float& f : x) {
+        f = RandFloat(-6.3f, 6.3f);
+    }
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        for (size_t ii = 0; ii < count; ++ii) {
+            s[ii] = sinf(x[ii]);
+            c[ii] = cosf(x[ii]);
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * count));
+}
+template<void (*kSinCos)(float const*, float*, float*, size_t)>
+void SinCos(benchmark::State& state)
+{
+    size_t const count = static_cast<size_t>(state.range(0));
+    std::vector<float> x(count), s(count), c(count);
+    for (float& f : x) {
+        f = RandFloat(-6.3f, 6.3f);
+    }
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        kSinCos(x.data(), s.data(), c.data(), count);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * count));
+}
+BENCHMARK(SinCosLibm)->Arg(1024)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(SinCos, ak::SinCosManyScalar)->Arg(1024)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(SinCos, ak::SinCosMany)->Arg(1024)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(SinCos, ak::SinCosFastMany)->Arg(1024)->Arg(1 << 16);
+
+// Mat4::RotationAxis before it used SinCos
+ak::Mat4 RotationAxisLibm(ak::Vec3 const axis, float const rad)
+{
+    ak::Vec3 const a = ak::Normalize(axis);
+    return ak::_RotationAxis(a.x, a.y, a.z, sinf(rad), cosf(rad));
+}
+struct RotationInputs
+{
+    explicit RotationInputs(size_t const count)
+        : axes(count)
+        , angles(count)
+    {
+        for (size_t ii = 0; ii < count; ++ii) {
+            FillVec(axes[ii]);
+            angles[ii] = RandFloat(-6.3f, 6.3f);
+        }
+    }
+
+    std::vector<ak::Vec3> axes;
+    std::vector<float> angles;
+};
+void RotationBuildLibm(benchmark::State& state)
+{
+    size_t const count = static_cast<size_t>(state.range(0));
+    RotationInputs const in(count);
+    AlignedArray<ak::Mat4> out(count);
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        for (size_t ii = 0; ii < count; ++ii) {
+            out.data[ii] = RotationAxisLibm(in.axes[ii], in.angles[ii]);
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * count));
+}
+void RotationBuildGlm(benchmark::State& state)
+{
+    size_t const count = static_cast<size_t>(state.range(0));
+    RotationInputs const in(count);
+    std::vector<glm::vec3> axes(count);
+    for (size_t ii = 0; ii < count; ++ii) {
+        axes[ii] = {in.axes[ii].x, in.axes[ii].y, in.axes[ii].z};
+    }
+    AlignedArray<glm::mat4> out(count);
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        for (size_t ii = 0; ii < count; ++ii) {
+            out.data[ii] = glm::rotate(glm::mat4(1.0f), in.angles[ii], axes[ii]);
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * count));
+}
+void RotationBuild(benchmark::State& state)
+{
+    size_t const count = static_cast<size_t>(state.range(0));
+    RotationInputs const in(count);
+    AlignedArray<ak::Mat4> out(count);
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        for (size_t ii = 0; ii < count; ++ii) {
+            ak::Vec3 const a = in.axes[ii];
+            out.data[ii] = ak::Mat4::RotationAxis({a.x, a.y, a.z, 0.0f}, in.angles[ii]);
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * count));
+}
+void RotationBuildMany(benchmark::State& state)
+{
+    size_t const count = static_cast<size_t>(state.range(0));
+    RotationInputs const in(count);
+    AlignedArray<ak::Mat4> out(count);
+    perf::Scope const perfScope(state);
+    for (auto _ : state) {
+        ak::RotationAxisMany(in.axes.data(), in.angles.data(), out.data, count);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * count));
+}
+BENCHMARK(RotationBuildLibm)->Arg(1024);
+BENCHMARK(RotationBuildGlm)->Arg(1024);
+BENCHMARK(RotationBuild)->Arg(1024);
+BENCHMARK(RotationBuildMany)->Arg(1024);
+
 }  // namespace
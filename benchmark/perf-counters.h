@@ -0,0 +1,218 @@
+#pragma once
+// Optional hardware performance counters for math-benchmark.
+//
+// With AK_PERF_COUNTERS=1 (CMake option AKMATH_BENCHMARK_PERF_COUNTERS, Linux only) every benchmark
+// that opens a perf::Scope around its timed loop reports, per iteration:
+//   cycles, instructions, ipc, l1d_misses, llc_misses
+// and, on CPUs with a known event encoding, avx512_l1_transitions and avx512_l2_transitions: the
+// number of times the core entered the AVX-512 light (license 1) or heavy (license 2) frequency
+// level. Counting is user-space only and per thread, so ThreadPool benchmarks show the submitting
+// thread's share of the work.
+//
+// Events the kernel or CPU can't provide (no PMU in a VM, perf_event_paranoid > 2, ...) are dropped
+// from the report rather than failing the run. If the PMU is oversubscribed the kernel multiplexes
+// the events, and the counts are scaled by the fraction of time each one was scheduled.
+//
+// Without AK_PERF_COUNTERS, perf::Scope is empty and costs nothing.
+#include <benchmark/benchmark.h>
+
+#if !defined(AK_PERF_COUNTERS)
+#    define AK_PERF_COUNTERS 0
+#endif
+
+#if AK_PERF_COUNTERS
+#    include <cpuid.h>
+#    include <errno.h>
+#    include <linux/perf_event.h>
+#    include <stdint.h>
+#    include <stdio.h>
+#    include <string.h>
+#    include <sys/syscall.h>
+#    include <unistd.h>
+#endif
+
+namespace perf {
+
+#if AK_PERF_COUNTERS
+
+enum : size_t {
+    kMaxEvents = 6,
+};
+
+struct Reading
+{
+    uint64_t value;
+    uint64_t timeEnabled;
+    uint64_t timeRunning;
+};
+
+struct Sample
+{
+    Reading events[kMaxEvents];
+};
+
+class Counters
+{
+public:
+    static Counters& Get()
+    {
+        static Counters counters;
+        return counters;
+    }
+
+    void Read(Sample& sample) const
+    {
+        for (size_t ii = 0; ii < count_; ++ii) {
+            if (read(fds_[ii], &sample.events[ii], sizeof(Reading)) != sizeof(Reading)) {
+                sample.events[ii] = {};
+            }
+        }
+    }
+
+    void Report(benchmark::State& state, Sample const& begin, Sample const& end) const
+    {
+        double cycles = 0.0;
+        double instructions = 0.0;
+        for (size_t ii = 0; ii < count_; ++ii) {
+            Reading const& b = begin.events[ii];
+            Reading const& e = end.events[ii];
+            uint64_t const running = e.timeRunning - b.timeRunning;
+            if (running == 0) {
+                continue;  // never scheduled, no estimate possible
+            }
+            double const scale = static_cast<double>(e.timeEnabled - b.timeEnabled) / running;
+            double const value = static_cast<double>(e.value - b.value) * scale;
+            state.counters[names_[ii]] =
+                benchmark::Counter(value, benchmark::Counter::kAvgIterations);
+            if (ii == cyclesIndex_) {
+                cycles = value;
+            } else if (ii == instructionsIndex_) {
+                instructions = value;
+            }
+        }
+        if (cycles > 0.0 && instructions > 0.0) {
+            state.counters["ipc"] = instructions / cycles;
+        }
+    }
+
+private:
+    Counters()
+    {
+        int error = 0;
+        cyclesIndex_ = Open("cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, error);
+        instructionsIndex_ =
+            Open("instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, error);
+        Open("l1d_misses", PERF_TYPE_HW_CACHE,
+             PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                 (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+             error);
+        Open("llc_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, error);
+
+        uint64_t l1License = 0;
+        uint64_t l2License = 0;
+        if (LicenseEvents(l1License, l2License)) {
+            Open("avx512_l1_transitions", PERF_TYPE_RAW, l1License, error);
+            Open("avx512_l2_transitions", PERF_TYPE_RAW, l2License, error);
+        }
+
+        if (count_ == 0) {
+            fprintf(stderr, "perf counters unavailable: %s\n", strerror(error));
+        }
+    }
+    ~Counters()
+    {
+        for (size_t ii = 0; ii < count_; ++ii) {
+            close(fds_[ii]);
+        }
+    }
+    Counters(Counters const&) = delete;
+    Counters& operator=(Counters const&) = delete;
+
+    // Returns the slot of the opened event, or kMaxEvents if it isn't available.
+    size_t Open(char const* const name, uint32_t const type, uint64_t const config, int& error)
+    {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        // The events free-run for the life of the process; Scope reports begin/end deltas.
+        int const fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+        if (fd < 0) {
+            error = errno;
+            return kMaxEvents;
+        }
+        fds_[count_] = fd;
+        names_[count_] = name;
+        return count_++;
+    }
+
+    // CORE_POWER.LVL1/LVL2_TURBO_LICENSE count cycles spent at each license level. With edge
+    // detect and a counter mask of 1 they count entries into the level instead. The encoding is
+    // only documented for Skylake-SP and Cascade Lake; other CPUs skip these two counters.
+    static bool LicenseEvents(uint64_t& l1, uint64_t& l2)
+    {
+        unsigned eax, ebx, ecx, edx;
+        if (!__get_cpuid(0, &eax, &ebx, &ecx, &edx) || ebx != 0x756e6547 /* "Genu" */) {
+            return false;
+        }
+        __get_cpuid(1, &eax, &ebx, &ecx, &edx);
+        unsigned const family = (eax >> 8) & 0xf;
+        unsigned const model = ((eax >> 4) & 0xf) | ((eax >> 12) & 0xf0);
+        if (family != 6 || model != 0x55) {
+            return false;
+        }
+        uint64_t const edgeOnce = (1ull << 18) | (1ull << 24);
+        l1 = 0x28 | (0x18 << 8) | edgeOnce;
+        l2 = 0x28 | (0x20 << 8) | edgeOnce;
+        return true;
+    }
+
+    int fds_[kMaxEvents];
+    char const* names_[kMaxEvents];
+    size_t count_ = 0;
+    size_t cyclesIndex_ = kMaxEvents;
+    size_t instructionsIndex_ = kMaxEvents;
+};
+
+// Counts the events between construction and destruction and attaches them to the benchmark as
+// per-iteration counters. Construct it after setup, immediately before the timed loop.
+class Scope
+{
+public:
+    explicit Scope(benchmark::State& state)
+        : state_(state)
+    {
+        Counters::Get().Read(begin_);
+    }
+    ~Scope()
+    {
+        Sample end;
+        Counters::Get().Read(end);
+        Counters::Get().Report(state_, begin_, end);
+    }
+    Scope(Scope const&) = delete;
+    Scope& operator=(Scope const&) = delete;
+
+private:
+    benchmark::State& state_;
+    Sample begin_;
+};
+
+#else
+
+class Scope
+{
+public:
+    explicit Scope(benchmark::State&)
+    {
+    }
+};
+
+#endif  // AK_PERF_COUNTERS
+
+}  // namespace perf
@@ -0,0 +1,417 @@
+#pragma once
+// Thread scaling harness for the ThreadPool benchmarks in math-benchmark.
+//
+// scaling::Args registers each benchmark at 1, 2, 4, ... threads up to the CPUs the process may
+// use, with args {count, threads, placement}. Every pool thread is pinned to its own CPU:
+//   compact (0): the physical cores of NUMA node 0, then their SMT siblings, then node 1, ...
+//   spread (1):  round-robin over the nodes, physical cores first; only registered on NUMA machines
+// scaling::Array maps fresh pages and has each thread first touch its initial share of the work,
+// so under Linux's first-touch policy the data sits on the node of the thread that processes it.
+// Work stealing still moves some chunks to other threads; that traffic is part of the measurement.
+//
+// scaling::Scope reports, besides google benchmark's own timings,
+//   speedup:              time at one thread / time at this thread count
+//   efficiency:           speedup / threads
+//   bandwidth_saturation: bytes read and written per second / the machine's peak, measured by a
+//                         copy over all CPUs when the first scaling benchmark builds its Setup
+// Speedup and efficiency need the one-thread run of the same benchmark and count earlier in the
+// same process, so they're missing from filtered or randomly interleaved runs that skip it.
+//
+// The topology comes from sysfs on Linux. Elsewhere all CPUs form one node, threads aren't pinned
+// and arrays are touched by the calling thread.
+#include "akmath-parallel.h"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#    include <pthread.h>
+#    include <sched.h>
+#    include <sys/mman.h>
+#endif
+
+namespace scaling {
+
+enum Placement : int64_t {
+    kCompact = 0,
+    kSpread = 1,
+};
+
+// The CPUs the process may run on, with their NUMA node and SMT sibling index
+class Topology
+{
+public:
+    static Topology const& Get()
+    {
+        static Topology const topology;
+        return topology;
+    }
+
+    size_t CpuCount() const
+    {
+        return cpus_.size();
+    }
+    size_t NodeCount() const
+    {
+        return nodeCount_;
+    }
+
+    // The first `threads` CPUs in placement order, repeating if there are fewer CPUs
+    std::vector<int> Cpus(Placement const placement, size_t const threads) const
+    {
+        std::vector<_Cpu> order = cpus_;
+        std::sort(order.begin(), order.end(), [placement](_Cpu const& a, _Cpu const& b) {
+            int const ka[] = {a.node, a.smt, a.id};
+            int const kb[] = {b.node, b.smt, b.id};
+            int const sa[] = {a.smt, a.rank, a.node};
+            int const sb[] = {b.smt, b.rank, b.node};
+            return placement == kSpread ? std::lexicographical_compare(sa, sa + 3, sb, sb + 3)
+                                        : std::lexicographical_compare(ka, ka + 3, kb, kb + 3);
+        });
+        std::vector<int> cpus(threads);
+        for (size_t tt = 0; tt < threads; ++tt) {
+            cpus[tt] = order[tt % order.size()].id;
+        }
+        return cpus;
+    }
+
+private:
+    struct _Cpu
+    {
+        int id;
+        int node;  // dense index over the nodes with allowed CPUs
+        int smt;   // index among its core's hardware threads, 0 for the first
+        int rank;  // index among the CPUs of its node with the same smt
+    };
+
+    Topology()
+    {
+        std::vector<int> allowed;
+#if defined(__linux__)
+        cpu_set_t set;
+        if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+            for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+                if (CPU_ISSET(cpu, &set)) {
+                    allowed.push_back(cpu);
+                }
+            }
+        }
+        for (int const node : ReadList("/sys/devices/system/node/online")) {
+            std::string const path = "/sys/devices/system/node/node" + std::to_string(node);
+            size_t const before = cpus_.size();
+            for (int const cpu : ReadList(path + "/cpulist")) {
+                if (std::find(allowed.begin(), allowed.end(), cpu) != allowed.end()) {
+                    cpus_.push_back({cpu, static_cast<int>(nodeCount_), SmtIndex(cpu), 0});
+                }
+            }
+            nodeCount_ += cpus_.size() > before ? 1 : 0;
+        }
+#endif
+        if (cpus_.empty()) {
+            if (allowed.empty()) {
+                unsigned const hardware = std::thread::hardware_concurrency();
+                for (unsigned cpu = 0; cpu < (hardware != 0 ? hardware : 1); ++cpu) {
+                    allowed.push_back(static_cast<int>(cpu));
+                }
+            }
+            for (int const cpu : allowed) {
+                cpus_.push_back({cpu, 0, 0, 0});
+            }
+            nodeCount_ = 1;
+        }
+        for (_Cpu& cpu : cpus_) {
+            for (_Cpu const& other : cpus_) {
+                cpu.rank += other.node == cpu.node && other.smt == cpu.smt && other.id < cpu.id;
+            }
+        }
+    }
+
+#if defined(__linux__)
+    // Parses a sysfs CPU or node list such as "0-3,8-11"; empty if the file can't be read
+    static std::vector<int> ReadList(std::string const& path)
+    {
+        std::vector<int> values;
+        FILE* const file = fopen(path.c_str(), "r");
+        if (file == nullptr) {
+            return values;
+        }
+        char line[4096];
+        if (fgets(line, sizeof(line), file) != nullptr) {
+            char* p = line;
+            while (*p >= '0' && *p <= '9') {
+                long const first = strtol(p, &p, 10);
+                long const last = *p == '-' ? strtol(p + 1, &p, 10) : first;
+                for (long value = first; value <= last; ++value) {
+                    values.push_back(static_cast<int>(value));
+                }
+                p += *p == ',' ? 1 : 0;
+            }
+        }
+        fclose(file);
+        return values;
+    }
+    static int SmtIndex(int const cpu)
+    {
+        std::vector<int> const siblings = ReadList("/sys/devices/system/cpu/cpu" +
+                                                   std::to_string(cpu) +
+                                                   "/topology/thread_siblings_list");
+        auto const found = std::find(siblings.begin(), siblings.end(), cpu);
+        return found != siblings.end() ? static_cast<int>(found - siblings.begin()) : 0;
+    }
+#endif
+
+    std::vector<_Cpu> cpus_;
+    size_t nodeCount_ = 0;
+};
+
+// Pins the calling thread to one CPU; false where that isn't supported
+inline bool PinCurrentThread(int const cpu)
+{
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+// Pins pool thread tt (0 is the calling thread) to cpus[tt]; false if any thread couldn't be
+// pinned. Each thread pins itself from a job of one chunk per thread. A chunk waits until every
+// thread holds one, so no thread runs two and none is left out.
+inline bool PinThreads(ak::ThreadPool& pool, int const* const cpus)
+{
+    std::atomic<size_t> arrived(0);
+    std::atomic<bool> pinned(true);
+    size_t const threads = pool.ThreadCount();
+    pool.Run(threads, [&](size_t, size_t const thread) {
+        if (!PinCurrentThread(cpus[thread])) {
+            pinned = false;
+        }
+        ++arrived;
+        while (arrived.load() < threads) {
+            std::this_thread::yield();
+        }
+    });
+    return pinned;
+}
+
+inline double PeakBandwidth();
+
+// A pool of `threads` threads pinned in `placement` order. The calling thread's affinity is
+// restored when the Setup is destroyed; the workers' affinity ends with the pool.
+class Setup
+{
+public:
+    Setup(size_t const threads, Placement const placement)
+        : cpus_(Topology::Get().Cpus(placement, threads))
+        , pool_(threads)
+    {
+#if defined(__linux__)
+        pthread_getaffinity_np(pthread_self(), sizeof(saved_), &saved_);
+#endif
+        // Unpinned runs still work, just with noisier and less local results
+        PinThreads(pool_, cpus_.data());
+    }
+    // From the benchmark args {count, threads, placement}. The first one also measures the peak
+    // bandwidth, before the benchmark allocates its arrays or starts timing, so runs that select
+    // no scaling benchmark never pay for the 512 MiB copy.
+    explicit Setup(benchmark::State const& state)
+        : Setup(static_cast<size_t>(state.range(1)), static_cast<Placement>(state.range(2)))
+    {
+        PeakBandwidth();
+    }
+    ~Setup()
+    {
+#if defined(__linux__)
+        pthread_setaffinity_np(pthread_self(), sizeof(saved_), &saved_);
+#endif
+    }
+    Setup(Setup const&) = delete;
+    Setup& operator=(Setup const&) = delete;
+
+    ak::ThreadPool& Pool()
+    {
+        return pool_;
+    }
+    std::vector<int> const& Cpus() const
+    {
+        return cpus_;
+    }
+
+private:
+    std::vector<int> cpus_;
+    ak::ThreadPool pool_;
+#if defined(__linux__)
+    cpu_set_t saved_;
+#endif
+};
+
+/*
+ * T[count] on fresh pages. Thread tt of the setup first touches [count * tt / threads,
+ * count * (tt + 1) / threads), the items ParallelFor initially queues on it, up to the rounding of
+ * chunk boundaries. Elements are default constructed afterwards; fill them before the timed loop.
+ */
+template<typename T>
+class Array
+{
+public:
+    Array(Setup const& setup, size_t const n) : count(n)
+    {
+        size_t const bytes = n * sizeof(T) != 0 ? n * sizeof(T) : 1;
+#if defined(__linux__)
+        void* const pages =
+            mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        data = static_cast<T*>(pages != MAP_FAILED ? pages : nullptr);
+        bytes_ = bytes;
+#else
+        data = static_cast<T*>(_mm_malloc(bytes, 64));
+#endif
+        if (data == nullptr) {
+            fprintf(stderr, "scaling::Array: can't allocate %zu bytes\n", bytes);
+            abort();
+        }
+        std::vector<int> const& cpus = setup.Cpus();
+        std::vector<std::thread> touchers;
+        for (size_t tt = 0; tt < cpus.size(); ++tt) {
+            touchers.emplace_back([&, tt]() {
+                PinCurrentThread(cpus[tt]);
+                char* const base = reinterpret_cast<char*>(data);
+                size_t const end = bytes * (tt + 1) / cpus.size();
+                for (size_t offset = bytes * tt / cpus.size(); offset < end; offset += 4096) {
+                    base[offset] = 0;
+                }
+            });
+        }
+        for (std::thread& toucher : touchers) {
+            toucher.join();
+        }
+        for (size_t ii = 0; ii < count; ++ii) {
+            new (&data[ii]) T;
+        }
+    }
+    ~Array()
+    {
+#if defined(__linux__)
+        munmap(data, bytes_);
+#else
+        _mm_free(data);
+#endif
+    }
+    Array(Array const&) = delete;
+    Array& operator=(Array const&) = delete;
+
+    T* data;
+    size_t count;
+
+private:
+#if defined(__linux__)
+    size_t bytes_;
+#endif
+};
+
+// Peak memory bandwidth in bytes/s: the best of five parallel copies between two 256 MiB arrays,
+// on every allowed CPU. Bytes read and written count, like in the benchmarks' bytes_per_second.
+inline double MeasurePeakBandwidth()
+{
+    size_t const count = size_t(64) << 20;
+    Setup setup(Topology::Get().CpuCount(), kSpread);
+    Array<float> const in(setup, count);
+    Array<float> out(setup, count);
+    size_t const chunk = ak::ChunkSize(setup.Pool(), count, 2 * sizeof(float));
+    double best = 0.0;
+    for (int pass = 0; pass < 5; ++pass) {
+        auto const start = std::chrono::steady_clock::now();
+        ak::ParallelFor(setup.Pool(), count, chunk,
+                        [&](size_t const begin, size_t const end, size_t) {
+                            memcpy(out.data + begin, in.data + begin,
+                                   (end - begin) * sizeof(float));
+                        });
+        benchmark::DoNotOptimize(out.data);
+        double const seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        best = std::max(best, 2.0 * count * sizeof(float) / seconds);
+    }
+    return best;
+}
+inline double PeakBandwidth()
+{
+    static double const peak = MeasurePeakBandwidth();
+    return peak;
+}
+
+// Registers {count, threads, placement} for 1, 2, 4, ... threads and all allowed CPUs. Times are
+// wall clock, since CPU time only counts the calling thread.
+inline void Args(benchmark::internal::Benchmark* const b, int64_t const count)
+{
+    Topology const& topology = Topology::Get();
+    int64_t const cpus = static_cast<int64_t>(topology.CpuCount());
+    b->Args({count, 1, kCompact});
+    for (Placement const placement : {kCompact, kSpread}) {
+        if (placement == kSpread && topology.NodeCount() < 2) {
+            continue;
+        }
+        for (int64_t threads = 2; threads < cpus; threads *= 2) {
+            b->Args({count, threads, placement});
+        }
+        if (cpus > 1) {
+            b->Args({count, cpus, placement});
+        }
+    }
+    b->UseRealTime();
+}
+
+// Times the loop between construction and destruction and attaches speedup, efficiency and
+// bandwidth_saturation. `name` keys the one-thread time, so pass the benchmark function's name;
+// bytesPerIteration is what one iteration reads plus writes. Construct it right before the timed
+// loop.
+class Scope
+{
+public:
+    Scope(benchmark::State& state, char const* const name, size_t const bytesPerIteration)
+        : state_(state)
+        , key_(std::string(name) + "/" + std::to_string(state.range(0)))
+        , bytes_(static_cast<double>(bytesPerIteration))
+        , start_(std::chrono::steady_clock::now())
+    {
+    }
+    ~Scope()
+    {
+        std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - start_;
+        if (state_.iterations() == 0) {
+            return;
+        }
+        double const seconds = elapsed.count() / static_cast<double>(state_.iterations());
+        double const threads = static_cast<double>(state_.range(1));
+        static std::map<std::string, double> serialSeconds;
+        if (state_.range(1) == 1) {
+            serialSeconds[key_] = seconds;
+        }
+        auto const serial = serialSeconds.find(key_);
+        if (serial != serialSeconds.end()) {
+            state_.counters["speedup"] = serial->second / seconds;
+            state_.counters["efficiency"] = serial->second / seconds / threads;
+        }
+        state_.counters["bandwidth_saturation"] = bytes_ / seconds / PeakBandwidth();
+    }
+    Scope(Scope const&) = delete;
+    Scope& operator=(Scope const&) = delete;
+
+private:
+    benchmark::State& state_;
+    std::string key_;
+    double bytes_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+}  // namespace scaling
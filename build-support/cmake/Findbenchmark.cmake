@@ -1,14 +1,31 @@
 set(BENCHMARK_PATH "${CMAKE_SOURCE_DIR}/3rd-party/benchmark")
 
-option(BENCHMARK_ENABLE_TESTING "Enable testing of the benchmark library." OFF)
-option(BENCHMARK_ENABLE_EXCEPTIONS "Enable the use of exceptions in the benchmark library." OFF)
-option(BENCHMARK_ENABLE_LTO "Enable link time optimisation of the benchmark library." ON)
-option(BENCHMARK_USE_LIBCXX "Build and test using libc++ as the standard library." OFF)
-option(BENCHMARK_BUILD_32_BITS "Build a 32 bit version of the library" OFF)
+if(EXISTS ${BENCHMARK_PATH}/CMakeLists.txt)
+    option(BENCHMARK_ENABLE_TESTING "Enable testing of the benchmark library." OFF)
+    option(BENCHMARK_ENABLE_EXCEPTIONS "Enable the use of exceptions in the benchmark library." OFF)
+    option(BENCHMARK_ENABLE_LTO "Enable link time optimisation of the benchmark library." ON)
+    option(BENCHMARK_USE_LIBCXX "Build and test using libc++ as the standard library." OFF)
+    option(BENCHMARK_BUILD_32_BITS "Build a 32 bit version of the library" OFF)
 
-add_subdirectory(${BENCHMARK_PATH})
-target_compile_options(benchmark
-    PUBLIC
-        /wd4141 # MSVC: 'inline' used more than once
-        /MP
-)
+    add_subdirectory(${BENCHMARK_PATH})
+    if(MSVC)
+        target_compile_options(benchmark
+            PUBLIC
+                /wd4141 # MSVC: 'inline' used more than once
+                /MP
+        )
+    endif()
+    if(NOT TARGET benchmark::benchmark)
+        add_library(benchmark::benchmark ALIAS benchmark)
+    endif()
+else()
+    # Fall back to a system install (e.g. libbenchmark-dev)
+    find_package(benchmark CONFIG QUIET)
+endif()
+
+if(TARGET benchmark::benchmark)
+    set(benchmark_FOUND TRUE)
+else()
+    set(benchmark_FOUND FALSE)
+    message(STATUS "google benchmark not found, math-benchmark will not be built")
+endif()
@@ -3,6 +3,13 @@ set(CATCH_PATH "${CMAKE_SOURCE_DIR}/3rd-party/catch-2.0.0-d5")
 # Prepare "Catch" library for other executables
 add_library(Catch STATIC ${CATCH_PATH}/main.cpp)
 target_include_directories(Catch PUBLIC ${CATCH_PATH})
+if(${CMAKE_CXX_COMPILER_ID} MATCHES GNU OR ${CMAKE_CXX_COMPILER_ID} MATCHES Clang)
+    # The global flags disable RTTI and exceptions, Catch needs both. Options given here come
+    # after CMAKE_CXX_FLAGS* on the command line, so they win for every configuration.
+    target_compile_options(Catch PUBLIC -frtti -fexceptions)
+    # SIGSTKSZ is no longer a constant expression in recent glibc
+    target_compile_definitions(Catch PUBLIC CATCH_CONFIG_NO_POSIX_SIGNALS)
+endif()
 
 function(ak_add_catchtest target)
     if(MSVC)
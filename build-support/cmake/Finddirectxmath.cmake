@@ -0,0 +1,11 @@
+# DirectXMath is optional: it ships with the Windows SDK and is only used as an extra point of
+# comparison. Targets linking "directxmath" get AK_HAS_DIRECTXMATH defined to 0 or 1.
+include(CheckIncludeFileCXX)
+check_include_file_cxx(DirectXMath.h AK_HAS_DIRECTXMATH)
+
+add_library(directxmath INTERFACE)
+if(AK_HAS_DIRECTXMATH)
+    target_compile_definitions(directxmath INTERFACE AK_HAS_DIRECTXMATH=1)
+else()
+    target_compile_definitions(directxmath INTERFACE AK_HAS_DIRECTXMATH=0)
+endif()
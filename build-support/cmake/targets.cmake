@@ -18,7 +18,7 @@ if(${CMAKE_CXX_COMPILER_ID} MATCHES GNU OR ${CMAKE_CXX_COMPILER_ID} MATCHES Clan
     foreach(flag_var ${ALL_CXX_FLAGS})
         # -fno-rtti         Disable RTTI
         # -fno-exceptions   Disable exceptions
-        set(${flag_var} "${${flag_var}} -std=c++11  -fno-rtti -fno-exceptions")
+        set(${flag_var} "${${flag_var}} -std=c++14 -fno-rtti -fno-exceptions")
     endforeach()
     foreach(flag_var ${ALL_C_FLAGS})
         # -std=c99          MSVC only supports c99
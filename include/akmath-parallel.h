@@ -0,0 +1,455 @@
+#pragma once
+#include "akmath.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+// Optional multithreaded layer over akmath's batch kernels: a work-stealing ThreadPool,
+// ParallelFor, and overloads of the batch functions that take a pool first.
+
+namespace ak {
+
+// Per-thread data padded to this size never shares a cache line with another thread's
+constexpr size_t kCacheLineSize = 64;
+
+/*****************************************************************************\
+ * Cache sizes                                                                *
+\*****************************************************************************/
+// Size in bytes of one instance of the data or unified cache at `level` (1-3), from CPUID's
+// deterministic cache parameters (leaf 4 on Intel, 0x8000001d on AMD), or 0 if it isn't reported.
+inline size_t DetectCacheSize(unsigned const level)
+{
+    unsigned regs[4];
+    _cpuid(0, 0, regs);
+    unsigned leaf = regs[0] >= 4 ? 4 : 0;
+    _cpuid(0x80000000, 0, regs);
+    if (regs[0] >= 0x8000001d) {
+        _cpuid(0x80000001, 0, regs);
+        bool const topologyExtensions = (regs[2] & (1u << 22)) != 0;
+        leaf = topologyExtensions ? 0x8000001d : leaf;
+    }
+    if (leaf == 0) {
+        return 0;
+    }
+    for (unsigned index = 0; index < 16; ++index) {
+        _cpuid(leaf, index, regs);
+        unsigned const type = regs[0] & 0x1f;  // 0 = no more caches, 1 = data, 3 = unified
+        if (type == 0) {
+            break;
+        }
+        if (((regs[0] >> 5) & 0x7) == level && (type == 1 || type == 3)) {
+            size_t const ways = ((regs[1] >> 22) & 0x3ff) + 1;
+            size_t const partitions = ((regs[1] >> 12) & 0x3ff) + 1;
+            size_t const lineSize = (regs[1] & 0xfff) + 1;
+            size_t const sets = static_cast<size_t>(regs[2]) + 1;
+            return ways * partitions * lineSize * sets;
+        }
+    }
+    return 0;
+}
+
+// The per-core L2 size, or 256 KiB if CPUID doesn't report one
+inline size_t L2CacheSize()
+{
+    static size_t const size = DetectCacheSize(2) != 0 ? DetectCacheSize(2) : 256 * 1024;
+    return size;
+}
+
+/*****************************************************************************\
+ * Thread pool                                                                *
+\*****************************************************************************/
+/*
+ * ThreadPool runs a job of numbered chunks on its worker threads and the calling thread, which
+ * counts as thread 0. Each thread starts with a contiguous share of the chunks in its own queue
+ * and takes them from the front; a thread whose queue is empty steals the back half of another
+ * thread's remaining chunks. A queue is one atomic word holding [begin, end), so taking and
+ * stealing are single compare-exchanges.
+ *
+ * Run blocks until every chunk is done. Only one thread may call Run at a time, and jobs must not
+ * call Run on the pool running them.
+ */
+class ThreadPool
+{
+public:
+    // threadCount includes the calling thread; 0 means one per hardware thread
+    inline explicit ThreadPool(size_t threadCount = 0);
+    inline ~ThreadPool();
+    ThreadPool(ThreadPool const&) = delete;
+    ThreadPool& operator=(ThreadPool const&) = delete;
+
+    size_t ThreadCount() const
+    {
+        return threadCount_;
+    }
+
+    // Calls fn(chunk, thread) once for each chunk in [0, chunkCount)
+    template<typename Fn>
+    void Run(size_t const chunkCount, Fn const& fn)
+    {
+        _Run(chunkCount, &fn, [](void const* const job, size_t const chunk, size_t const thread) {
+            (*static_cast<Fn const*>(job))(chunk, thread);
+        });
+    }
+
+private:
+    typedef void (*_Job)(void const* job, size_t chunk, size_t thread);
+
+    struct alignas(kCacheLineSize) _Queue
+    {
+        std::atomic<uint64_t> range;  // begin in the low half, end in the high half
+    };
+    static uint64_t _Range(uint64_t const begin, uint64_t const end)
+    {
+        return begin | (end << 32);
+    }
+
+    inline void _Run(size_t const chunkCount, void const* const job, _Job const run);
+    inline bool _Take(size_t const thread, size_t& chunk);
+    inline bool _Steal(size_t const thread, size_t& chunk);
+    inline void _Work(size_t const thread);
+    inline void _WorkerMain(size_t const thread);
+
+    size_t threadCount_;
+    _Queue* queues_;
+    std::vector<std::thread> workers_;
+
+    void const* job_ = nullptr;
+    _Job run_ = nullptr;
+    std::mutex mutex_;
+    std::condition_variable start_;
+    std::condition_variable done_;
+    uint64_t generation_ = 0;  // bumped for each job
+    size_t busy_ = 0;          // workers still in the current job
+    bool stop_ = false;
+};
+
+inline ThreadPool::ThreadPool(size_t threadCount)
+{
+    threadCount = threadCount != 0 ? threadCount : std::thread::hardware_concurrency();
+    threadCount_ = threadCount != 0 ? threadCount : 1;
+    queues_ = static_cast<_Queue*>(_mm_malloc(threadCount_ * sizeof(_Queue), kCacheLineSize));
+    for (size_t tt = 0; tt < threadCount_; ++tt) {
+        new (&queues_[tt]) _Queue;
+        queues_[tt].range.store(0, std::memory_order_relaxed);
+    }
+    workers_.reserve(threadCount_ - 1);
+    for (size_t tt = 1; tt < threadCount_; ++tt) {
+        workers_.emplace_back(&ThreadPool::_WorkerMain, this, tt);
+    }
+}
+inline ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    start_.notify_all();
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
+    _mm_free(queues_);
+}
+
+inline void ThreadPool::_Run(size_t const chunkCount, void const* const job, _Job const run)
+{
+    assert(chunkCount <= UINT32_MAX);
+    if (threadCount_ == 1 || chunkCount <= 1) {
+        for (size_t cc = 0; cc < chunkCount; ++cc) {
+            run(job, cc, 0);
+        }
+        return;
+    }
+    for (size_t tt = 0; tt < threadCount_; ++tt) {
+        queues_[tt].range.store(_Range(chunkCount * tt / threadCount_,
+                                       chunkCount * (tt + 1) / threadCount_),
+                                std::memory_order_relaxed);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        assert(busy_ == 0);
+        job_ = job;
+        run_ = run;
+        busy_ = workers_.size();
+        ++generation_;
+    }
+    start_.notify_all();
+    _Work(0);
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this]() { return busy_ == 0; });
+}
+
+inline bool ThreadPool::_Take(size_t const thread, size_t& chunk)
+{
+    std::atomic<uint64_t>& queue = queues_[thread].range;
+    uint64_t range = queue.load(std::memory_order_relaxed);
+    for (;;) {
+        uint64_t const begin = range & UINT32_MAX;
+        uint64_t const end = range >> 32;
+        if (begin >= end) {
+            return false;
+        }
+        if (queue.compare_exchange_weak(range, _Range(begin + 1, end),
+                                        std::memory_order_relaxed)) {
+            chunk = static_cast<size_t>(begin);
+            return true;
+        }
+    }
+}
+inline bool ThreadPool::_Steal(size_t const thread, size_t& chunk)
+{
+    for (size_t offset = 1; offset < threadCount_; ++offset) {
+        std::atomic<uint64_t>& victim = queues_[(thread + offset) % threadCount_].range;
+        uint64_t range = victim.load(std::memory_order_relaxed);
+        for (;;) {
+            uint64_t const begin = range & UINT32_MAX;
+            uint64_t const end = range >> 32;
+            if (begin >= end) {
+                break;
+            }
+            uint64_t const middle = begin + (end - begin) / 2;
+            if (victim.compare_exchange_weak(range, _Range(begin, middle),
+                                             std::memory_order_relaxed)) {
+                // This thread's queue is empty, so nothing else writes it until it's refilled
+                chunk = static_cast<size_t>(middle);
+                queues_[thread].range.store(_Range(middle + 1, end), std::memory_order_relaxed);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+inline void ThreadPool::_Work(size_t const thread)
+{
+    size_t chunk;
+    while (_Take(thread, chunk) || _Steal(thread, chunk)) {
+        run_(job_, chunk, thread);
+    }
+}
+inline void ThreadPool::_WorkerMain(size_t const thread)
+{
+    uint64_t seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            start_.wait(lock, [&]() { return stop_ || generation_ != seen; });
+            if (stop_) {
+                return;
+            }
+            seen = generation_;
+        }
+        _Work(thread);
+        bool last;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            last = --busy_ == 0;
+        }
+        if (last) {
+            done_.notify_one();
+        }
+    }
+}
+
+/*****************************************************************************\
+ * Parallel loops                                                             *
+\*****************************************************************************/
+/*
+ * ChunkSize picks how many items of an n-item batch go in one chunk from the bytes each item reads
+ * and writes. A chunk's data fills half the L2, so a chunk stays cached while it's processed, but
+ * chunks shrink until each thread has at least four to balance the load. Chunks are multiples of
+ * 64 items: with outputs of one byte or more per item on 64-byte aligned arrays, no two threads
+ * write the same cache line.
+ */
+inline size_t ChunkSize(ThreadPool const& pool, size_t const n, size_t const bytesPerItem)
+{
+    size_t const granule = 64;
+    size_t chunk = L2CacheSize() / 2 / (bytesPerItem != 0 ? bytesPerItem : 1);
+    size_t const balanced = (n + 4 * pool.ThreadCount() - 1) / (4 * pool.ThreadCount());
+    chunk = balanced < chunk ? balanced : chunk;
+    return chunk > granule ? (chunk + granule - 1) / granule * granule : granule;
+}
+
+// Calls fn(begin, end, thread) over [0, n) in chunks of chunkSize items
+template<typename Fn>
+void ParallelFor(ThreadPool& pool, size_t const n, size_t const chunkSize, Fn const& fn)
+{
+    assert(chunkSize > 0);
+    size_t const chunkCount = (n + chunkSize - 1) / chunkSize;
+    pool.Run(chunkCount, [&](size_t const chunk, size_t const thread) {
+        size_t const begin = chunk * chunkSize;
+        size_t const end = n - begin < chunkSize ? n : begin + chunkSize;
+        fn(begin, end, thread);
+    });
+}
+
+/*
+ * PerThread holds one T per pool thread, each on its own cache lines, for jobs that accumulate
+ * results per thread and combine them afterwards.
+ */
+template<typename T>
+class PerThread
+{
+public:
+    PerThread(ThreadPool const& pool, T const& value) : count_(pool.ThreadCount())
+    {
+        slots_ = static_cast<_Slot*>(_mm_malloc(count_ * sizeof(_Slot), alignof(_Slot)));
+        for (size_t tt = 0; tt < count_; ++tt) {
+            new (&slots_[tt]) _Slot{value};
+        }
+    }
+    ~PerThread()
+    {
+        for (size_t tt = 0; tt < count_; ++tt) {
+            slots_[tt].~_Slot();
+        }
+        _mm_free(slots_);
+    }
+    PerThread(PerThread const&) = delete;
+    PerThread& operator=(PerThread const&) = delete;
+
+    size_t Count() const
+    {
+        return count_;
+    }
+    T& operator[](size_t const thread)
+    {
+        assert(thread < count_);
+        return slots_[thread].value;
+    }
+    T const& operator[](size_t const thread) const
+    {
+        assert(thread < count_);
+        return slots_[thread].value;
+    }
+
+private:
+    struct alignas(kCacheLineSize) _Slot
+    {
+        T value;
+    };
+    _Slot* slots_;
+    size_t count_;
+};
+
+/*****************************************************************************\
+ * Parallel batch kernels                                                     *
+\*****************************************************************************/
+// Each splits its batch with ChunkSize and runs the dispatching kernel on every chunk.
+inline void MultiplyMany(ThreadPool& pool, Mat4 const* const a, Mat4 const* const b,
+                         Mat4* const out, size_t const n)
+{
+    ParallelFor(pool, n, ChunkSize(pool, n, 3 * sizeof(Mat4)),
+                [=](size_t const begin, size_t const end, size_t) {
+                    MultiplyMany(a + begin, b + begin, out + begin, end - begin);
+                });
+}
+inline void TransformMany(ThreadPool& pool, Mat4 const& m, Vec4 const* const in,
+                          Vec4* const out, size_t const n)
+{
+    ParallelFor(pool, n, ChunkSize(pool, n, 2 * sizeof(Vec4)),
+                [&](size_t const begin, size_t const end, size_t) {
+                    TransformMany(m, in + begin, out + begin, end - begin);
+                });
+}
+inline void TransformPoints(ThreadPool& pool, Mat4 const& m, Vec3 const* const in,
+                            Vec3* const out, size_t const n)
+{
+    ParallelFor(pool, n, ChunkSize(pool, n, 2 * sizeof(Vec3)),
+                [&](size_t const begin, size_t const end, size_t) {
+                    TransformPoints(m, in + begin, out + begin, end - begin);
+                });
+}
+inline void TransformDirections(ThreadPool& pool, Mat4 const& m, Vec3 const* const in,
+                                Vec3* const out, size_t const n)
+{
+    ParallelFor(pool, n, ChunkSize(pool, n, 2 * sizeof(Vec3)),
+                [&](size_t const begin, size_t const end, size_t) {
+                    TransformDirections(m, in + begin, out + begin, end - begin);
+                });
+}
+inline void TransformAabbs(ThreadPool& pool, Mat4 const& m, Aabb const* const in,
+                           Aabb* const out, size_t const n)
+{
+    ParallelFor(pool, n, ChunkSize(pool, n, 2 * sizeof(Aabb)),
+                [&](size_t const begin, size_t const end, size_t) {
+                    TransformAabbs(m, in + begin, out + begin, end - begin);
+                });
+}
+inline void ClassifyAabbs(ThreadPool& pool, Vec4 const* const planes, size_t const planeCount,
+                          Aabb const* const boxes, Containment* const out, size_t const n)
+{
+    ParallelFor(pool, n, ChunkSize(pool, n, sizeof(Aabb) + sizeof(Containment)),
+                [=](size_t const begin, size_t const end, size_t) {
+                    ClassifyAabbs(planes, planeCount, boxes + begin, out + begin, end - begin);
+                });
+}
+inline void ClassifyAabbs(ThreadPool& pool, Frustum const& f, Aabb const* const boxes,
+                          Containment* const out, size_t const n)
+{
+    ClassifyAabbs(pool, f.planes, Frustum::kPlaneCount, boxes, out, n);
+}
+
+// Normalizes SoA lanes, which the chunks split at the same offsets
+template<int kLanes, bool kFast>
+inline void _NormalizeSoA(ThreadPool& pool, float const* const* const a, float* const* const out,
+                          size_t const n)
+{
+    ParallelFor(pool, n, ChunkSize(pool, n, 2 * kLanes * sizeof(float)),
+                [=](size_t const begin, size_t const end, size_t) {
+                    float const* aChunk[kLanes];
+                    float* outChunk[kLanes];
+                    for (int kk = 0; kk < kLanes; ++kk) {
+                        aChunk[kk] = a[kk] + begin;
+                        outChunk[kk] = out[kk] + begin;
+                    }
+                    _NormalizeSoA<kLanes, kFast>(aChunk, outChunk, end - begin);
+                });
+}
+inline void Normalize(ThreadPool& pool, Vec3SoA const& a, Vec3SoA& out)
+{
+    assert(a.count == out.count);
+    float const* const lanes[] = {a.x, a.y, a.z};
+    float* const outLanes[] = {out.x, out.y, out.z};
+    _NormalizeSoA<3, false>(pool, lanes, outLanes, a.count);
+}
+inline void NormalizeFast(ThreadPool& pool, Vec3SoA const& a, Vec3SoA& out)
+{
+    assert(a.count == out.count);
+    float const* const lanes[] = {a.x, a.y, a.z};
+    float* const outLanes[] = {out.x, out.y, out.z};
+    _NormalizeSoA<3, true>(pool, lanes, outLanes, a.count);
+}
+inline void Normalize(ThreadPool& pool, Vec4SoA const& a, Vec4SoA& out)
+{
+    assert(a.count == out.count);
+    float const* const lanes[] = {a.x, a.y, a.z, a.w};
+    float* const outLanes[] = {out.x, out.y, out.z, out.w};
+    _NormalizeSoA<4, false>(pool, lanes, outLanes, a.count);
+}
+inline void NormalizeFast(ThreadPool& pool, Vec4SoA const& a, Vec4SoA& out)
+{
+    assert(a.count == out.count);
+    float const* const lanes[] = {a.x, a.y, a.z, a.w};
+    float* const outLanes[] = {out.x, out.y, out.z, out.w};
+    _NormalizeSoA<4, true>(pool, lanes, outLanes, a.count);
+}
+
+// Each thread bounds its chunks into its own PerThread slot, then the slots are merged
+inline Aabb AabbFromPoints(ThreadPool& pool, Vec3 const* const points, size_t const n)
+{
+    PerThread<Aabb> bounds(pool, Aabb::Empty());
+    ParallelFor(pool, n, ChunkSize(pool, n, sizeof(Vec3)),
+                [&](size_t const begin, size_t const end, size_t const thread) {
+                    Aabb const chunk = AabbFromPoints(points + begin, end - begin);
+                    bounds[thread] = Union(bounds[thread], chunk);
+                });
+    Aabb result = Aabb::Empty();
+    for (size_t tt = 0; tt < bounds.Count(); ++tt) {
+        result = Union(result, bounds[tt]);
+    }
+    return result;
+}
+
+}  // namespace ak
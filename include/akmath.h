@@ -1,8 +1,44 @@
 #pragma once
+#include <assert.h>
+#include <float.h>
 #include <math.h>
-#include <immintrin.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#if defined(__GNUC__) && !defined(__clang__)
+// GCC 12's avx512fintrin.h seeds results with a self-initialized __Y (GCC PR 105593), which trips
+// -Wuninitialized wherever those intrinsics are inlined. Diagnostics follow the header's location.
+#    pragma GCC diagnostic push
+#    pragma GCC diagnostic ignored "-Wuninitialized"
+#    pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#    include <immintrin.h>
+#    pragma GCC diagnostic pop
+#else
+#    include <immintrin.h>
+#endif
 #include <cstdalign>
 
+#if defined(_MSC_VER)
+#    include <intrin.h>
+#    define AK_FORCEINLINE __forceinline
+// MSVC allows any intrinsic in any function, so ISA kernels are just inlined.
+#    define AK_TARGET_INLINE(isa) __forceinline
+#else
+#    include <cpuid.h>
+#    define AK_FORCEINLINE inline __attribute__((always_inline))
+// GCC/Clang only allow ISA-specific intrinsics in functions compiled for that ISA. These kernels
+// can't be force-inlined into generic callers, so the dispatcher calls them out of line.
+#    define AK_TARGET_INLINE(isa) inline __attribute__((target(isa)))
+#endif
+
+// Shuffle immediate that moves source lanes x, y, z and w into lanes 0..3. Unlike _MM_SHUFFLE, the
+// arguments are in lane order. A macro rather than a constexpr function so that unoptimized GCC
+// builds still see an integer constant when the intrinsic is itself a macro.
+#define AK_SWIZZLE(x, y, z, w) ((x) | ((y) << 2) | ((z) << 4) | ((w) << 6))
+
+// Define AK_SIMD_LEVEL to one of the SimdLevel values (0 = scalar ... 3 = AVX-512) to skip CPUID
+// and hard-wire the kernels used by the dispatching functions.
+
 namespace ak {
 
 struct Vec2
@@ -24,6 +60,45 @@ struct alignas(16) Vec4
     float w;
 };
 
+struct Mat3;
+struct Mat4;
+struct Mat4x3;
+
+// Rotation quaternion (x, y, z) * sin(angle / 2), cos(angle / 2). Rotations are unit quaternions;
+// only Normalize, Nlerp and Slerp accept others.
+struct alignas(16) Quat
+{
+    float x;
+    float y;
+    float z;
+    float w;
+
+    constexpr inline static Quat Identity();
+    inline static Quat RotationAxis(Vec3 const axis, float const rad);
+    inline static Quat FromMatrix(Mat3 const& m);
+    inline static Quat FromMatrix(Mat4 const& m);
+};
+
+// Node or bone transform with the layout of vec_math.h's Transform: scale, then rotate, then
+// translate
+struct Transform
+{
+    Quat orientation;
+    Vec3 position;
+    float scale;
+};
+
+// Rigid transform as a unit dual quaternion real + dual * e: the real part is the rotation and
+// the dual part is half the translation times it. Eight floats, half a Mat4.
+struct alignas(32) DualQuat
+{
+    Quat real;
+    Quat dual;
+
+    constexpr inline static DualQuat Identity();
+    inline static DualQuat FromTransform(Transform const& t);
+};
+
 struct Mat3
 {
     Vec3 c0;
@@ -36,6 +111,7 @@ struct Mat3
     inline static Mat3 RotationY(float const rad);
     inline static Mat3 RotationZ(float const rad);
     inline static Mat3 RotationAxis(Vec3 const axis, float const rad);
+    inline static Mat3 Rotation(Quat const q);
 };
 
 struct alignas(64) Mat4
@@ -51,6 +127,23 @@ struct alignas(64) Mat4
     inline static Mat4 RotationY(float const rad);
     inline static Mat4 RotationZ(float const rad);
     inline static Mat4 RotationAxis(Vec4 const axis, float const rad);
+    inline static Mat4 Rotation(Quat const q);
+    inline static Mat4 FromTransform(Transform const& t);
+    inline static Mat4 FromMat4x3(Mat4x3 const& m);
+};
+
+// Affine transform as the top three rows of a Mat4, whose bottom row is implicitly (0, 0, 0, 1).
+// Stored by rows in 48 bytes: row i holds a Mat4's c0[i], c1[i], c2[i] and c3[i], so the
+// translation is the rows' w.
+struct alignas(16) Mat4x3
+{
+    Vec4 r0;
+    Vec4 r1;
+    Vec4 r2;
+
+    constexpr inline static Mat4x3 Identity();
+    inline static Mat4x3 FromMat4(Mat4 const& m);
+    inline static Mat4x3 FromTransform(Transform const& t);
 };
 
 inline void _swapf(float& a, float& b)
@@ -60,6 +153,113 @@ inline void _swapf(float& a, float& b)
     b = t;
 }
 
+// Mask selecting the first `n` of 16 lanes
+constexpr __mmask16 _TailMask(size_t const n)
+{
+    return static_cast<__mmask16>((1u << n) - 1);
+}
+
+/*****************************************************************************\
+ * CPU features                                                               *
+\*****************************************************************************/
+enum class SimdLevel : int {
+    kScalar = 0,
+    kSse = 1,     // SSE3
+    kAvx = 2,     // AVX2 + FMA
+    kAvx512 = 3,  // AVX-512F
+};
+
+inline char const* SimdLevelName(SimdLevel const level)
+{
+    switch (level) {
+        case SimdLevel::kAvx512:
+            return "avx512";
+        case SimdLevel::kAvx:
+            return "avx2";
+        case SimdLevel::kSse:
+            return "sse";
+        case SimdLevel::kScalar:
+            break;
+    }
+    return "scalar";
+}
+
+inline void _cpuid(unsigned const leaf, unsigned const subleaf, unsigned (&regs)[4])
+{
+#if defined(_MSC_VER)
+    int r[4];
+    __cpuidex(r, static_cast<int>(leaf), static_cast<int>(subleaf));
+    for (int ii = 0; ii < 4; ++ii) {
+        regs[ii] = static_cast<unsigned>(r[ii]);
+    }
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+inline unsigned long long _xgetbv0()
+{
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    unsigned lo, hi;
+    __asm__ __volatile__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return (static_cast<unsigned long long>(hi) << 32) | lo;
+#endif
+}
+
+// Queries CPUID (and XCR0, so registers the OS doesn't save are ignored) for the widest path the
+// Mat4 kernels can use on this machine.
+inline SimdLevel DetectSimdLevel()
+{
+    unsigned regs[4];
+    _cpuid(0, 0, regs);
+    unsigned const maxLeaf = regs[0];
+    if (maxLeaf < 1) {
+        return SimdLevel::kScalar;
+    }
+
+    _cpuid(1, 0, regs);
+    bool const sse3 = (regs[2] & (1u << 0)) != 0;
+    bool const fma = (regs[2] & (1u << 12)) != 0;
+    bool const osxsave = (regs[2] & (1u << 27)) != 0;
+    bool const avx = (regs[2] & (1u << 28)) != 0;
+    if (!sse3) {
+        return SimdLevel::kScalar;
+    }
+    if (!osxsave || !avx || !fma || maxLeaf < 7) {
+        return SimdLevel::kSse;
+    }
+
+    unsigned long long const xcr0 = _xgetbv0();
+    bool const ymmState = (xcr0 & 0x06) == 0x06;
+    bool const zmmState = (xcr0 & 0xe6) == 0xe6;
+
+    _cpuid(7, 0, regs);
+    bool const avx2 = (regs[1] & (1u << 5)) != 0;
+    bool const avx512f = (regs[1] & (1u << 16)) != 0;
+
+    if (avx512f && zmmState) {
+        return SimdLevel::kAvx512;
+    }
+    if (avx2 && ymmState) {
+        return SimdLevel::kAvx;
+    }
+    return SimdLevel::kSse;
+}
+
+// The path used by the dispatching functions. Detected on first use and cached for the lifetime of
+// the process, unless AK_SIMD_LEVEL fixes it at compile time.
+inline SimdLevel ActiveSimdLevel()
+{
+#if defined(AK_SIMD_LEVEL)
+    return static_cast<SimdLevel>(AK_SIMD_LEVEL);
+#else
+    static SimdLevel const level = DetectSimdLevel();
+    return level;
+#endif
+}
+
 /*****************************************************************************\
  * Vec2                                                                       *
 \*****************************************************************************/
@@ -289,11 +489,534 @@ constexpr inline Vec4 operator-(Vec4 const v)
     return {-v.x, -v.y, -v.z, -v.w};
 }
 
+constexpr inline float Dot(Vec4 const a, Vec4 const b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+}
 constexpr inline float Hadd(Vec4 const v)
 {
     return v.x + v.y + v.z + v.w;
 }
 
+/*****************************************************************************\
+ * Vec4x                                                                      *
+\*****************************************************************************/
+// A Vec4 held in an SSE register. Every operation is a short fixed sequence of intrinsics, so the
+// generated code doesn't depend on the auto-vectorizer surviving inlining. SSE2 is part of x86-64,
+// so no dispatch is involved; Lerp uses FMA when the build enables it. Load and Store convert
+// to and from Vec4 with one aligned move. Compile-time math still uses the constexpr Vec4 API.
+struct Vec4x
+{
+    __m128 v;
+};
+
+AK_FORCEINLINE Vec4x Load(Vec4 const& v)
+{
+    return {_mm_load_ps(&v.x)};
+}
+AK_FORCEINLINE Vec4 Store(Vec4x const v)
+{
+    Vec4 result;
+    _mm_store_ps(&result.x, v.v);
+    return result;
+}
+AK_FORCEINLINE Vec4x Splat(float const f)
+{
+    return {_mm_set1_ps(f)};
+}
+
+AK_FORCEINLINE Vec4x operator+(Vec4x const a, Vec4x const b)
+{
+    return {_mm_add_ps(a.v, b.v)};
+}
+AK_FORCEINLINE Vec4x operator-(Vec4x const a, Vec4x const b)
+{
+    return {_mm_sub_ps(a.v, b.v)};
+}
+AK_FORCEINLINE Vec4x operator*(Vec4x const a, Vec4x const b)
+{
+    return {_mm_mul_ps(a.v, b.v)};
+}
+AK_FORCEINLINE Vec4x operator/(Vec4x const a, Vec4x const b)
+{
+    return {_mm_div_ps(a.v, b.v)};
+}
+
+AK_FORCEINLINE Vec4x operator*(Vec4x const a, float const f)
+{
+    return {_mm_mul_ps(a.v, _mm_set1_ps(f))};
+}
+AK_FORCEINLINE Vec4x operator/(Vec4x const a, float const f)
+{
+    return {_mm_div_ps(a.v, _mm_set1_ps(f))};
+}
+
+AK_FORCEINLINE Vec4x operator-(Vec4x const v)
+{
+    return {_mm_xor_ps(v.v, _mm_set1_ps(-0.0f))};
+}
+
+// a * b + c
+AK_FORCEINLINE __m128 _MulAddSse(__m128 const a, __m128 const b, __m128 const c)
+{
+#if defined(__FMA__) || (defined(_MSC_VER) && defined(__AVX2__))
+    return _mm_fmadd_ps(a, b, c);
+#else
+    return _mm_add_ps(_mm_mul_ps(a, b), c);
+#endif
+}
+// Sum of all four lanes, in every lane
+AK_FORCEINLINE __m128 _HaddSplatSse(__m128 const v)
+{
+    __m128 const s = _mm_add_ps(v, _mm_shuffle_ps(v, v, AK_SWIZZLE(1, 0, 3, 2)));
+    return _mm_add_ps(s, _mm_shuffle_ps(s, s, AK_SWIZZLE(2, 3, 0, 1)));
+}
+
+// Vec4x misc
+AK_FORCEINLINE float Hadd(Vec4x const v)
+{
+    return _mm_cvtss_f32(_HaddSplatSse(v.v));
+}
+AK_FORCEINLINE float Dot(Vec4x const a, Vec4x const b)
+{
+    return _mm_cvtss_f32(_HaddSplatSse(_mm_mul_ps(a.v, b.v)));
+}
+AK_FORCEINLINE float LengthSq(Vec4x const a)
+{
+    return Dot(a, a);
+}
+AK_FORCEINLINE float Length(Vec4x const a)
+{
+    return _mm_cvtss_f32(_mm_sqrt_ss(_HaddSplatSse(_mm_mul_ps(a.v, a.v))));
+}
+AK_FORCEINLINE float DistanceSq(Vec4x const a, Vec4x const b)
+{
+    return LengthSq(a - b);
+}
+AK_FORCEINLINE float Distance(Vec4x const a, Vec4x const b)
+{
+    return Length(a - b);
+}
+AK_FORCEINLINE Vec4x Normalize(Vec4x const v)
+{
+    return {_mm_div_ps(v.v, _mm_sqrt_ps(_HaddSplatSse(_mm_mul_ps(v.v, v.v))))};
+}
+AK_FORCEINLINE Vec4x Min(Vec4x const a, Vec4x const b)
+{
+    return {_mm_min_ps(a.v, b.v)};
+}
+AK_FORCEINLINE Vec4x Max(Vec4x const a, Vec4x const b)
+{
+    return {_mm_max_ps(a.v, b.v)};
+}
+AK_FORCEINLINE Vec4x Lerp(Vec4x const a, Vec4x const b, float const t)
+{
+    return {_MulAddSse(_mm_sub_ps(b.v, a.v), _mm_set1_ps(t), a.v)};
+}
+
+/*****************************************************************************\
+ * Fast normalization                                                         *
+\*****************************************************************************/
+// LengthInvFast returns 1 / Length(v) from the hardware reciprocal square root estimate refined by
+// one Newton-Raphson step, and NormalizeFast scales by it, replacing a square root and a divide.
+// The relative error is below 4e-7 with the SSE and AVX2 estimates, whose exact
+// values differ between CPU vendors, and below 2e-7 with AVX-512's more precise one, so results
+// aren't bit-identical across machines. Squared lengths are clamped to FLT_MIN first, without a
+// branch: zero vectors normalize to zero instead of nan, and lengths below about 1e-19 aren't
+// normalized exactly.
+
+// y * (1.5 - 0.5 * x * y * y) for an estimate y of 1 / sqrt(x)
+AK_FORCEINLINE __m128 _RsqrtNewtonSse(__m128 const x, __m128 const y)
+{
+    __m128 const halfXY = _mm_mul_ps(_mm_mul_ps(x, _mm_set1_ps(0.5f)), y);
+    return _mm_mul_ps(y, _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(halfXY, y)));
+}
+AK_FORCEINLINE __m128 _RsqrtFastSse(__m128 x)
+{
+    x = _mm_max_ps(x, _mm_set1_ps(FLT_MIN));
+    return _RsqrtNewtonSse(x, _mm_rsqrt_ps(x));
+}
+// Only the estimate needs a register; broadcasting x avoids zeroing its upper lanes
+AK_FORCEINLINE float _RsqrtFastScalar(float x)
+{
+    x = x > FLT_MIN ? x : FLT_MIN;
+    float const y = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set1_ps(x)));
+    return y * (1.5f - 0.5f * x * y * y);
+}
+AK_TARGET_INLINE("avx2,fma") __m256 _RsqrtFastAvx(__m256 x)
+{
+    x = _mm256_max_ps(x, _mm256_set1_ps(FLT_MIN));
+    __m256 const y = _mm256_rsqrt_ps(x);
+    __m256 const halfXY = _mm256_mul_ps(_mm256_mul_ps(x, _mm256_set1_ps(0.5f)), y);
+    return _mm256_mul_ps(y, _mm256_fnmadd_ps(halfXY, y, _mm256_set1_ps(1.5f)));
+}
+AK_TARGET_INLINE("avx512f") __m512 _RsqrtFastAvx512(__m512 x)
+{
+    x = _mm512_max_ps(x, _mm512_set1_ps(FLT_MIN));
+    __m512 const y = _mm512_rsqrt14_ps(x);
+    __m512 const halfXY = _mm512_mul_ps(_mm512_mul_ps(x, _mm512_set1_ps(0.5f)), y);
+    return _mm512_mul_ps(y, _mm512_fnmadd_ps(halfXY, y, _mm512_set1_ps(1.5f)));
+}
+
+inline float LengthInvFast(Vec2 const v)
+{
+    return _RsqrtFastScalar(LengthSq(v));
+}
+inline float LengthInvFast(Vec3 const v)
+{
+    return _RsqrtFastScalar(LengthSq(v));
+}
+inline float LengthInvFast(Vec4 const v)
+{
+    return _RsqrtFastScalar(LengthSq(v));
+}
+inline Vec2 NormalizeFast(Vec2 const v)
+{
+    return v * LengthInvFast(v);
+}
+inline Vec3 NormalizeFast(Vec3 const v)
+{
+    return v * LengthInvFast(v);
+}
+inline Vec4 NormalizeFast(Vec4 const v)
+{
+    return v * LengthInvFast(v);
+}
+AK_FORCEINLINE float LengthInvFast(Vec4x const v)
+{
+    return _mm_cvtss_f32(_RsqrtFastSse(_HaddSplatSse(_mm_mul_ps(v.v, v.v))));
+}
+AK_FORCEINLINE Vec4x NormalizeFast(Vec4x const v)
+{
+    return {_mm_mul_ps(v.v, _RsqrtFastSse(_HaddSplatSse(_mm_mul_ps(v.v, v.v))))};
+}
+
+/*****************************************************************************\
+ * Trigonometry                                                               *
+\*****************************************************************************/
+// SinCos computes sin(x) and cos(x), x in radians, from one range reduction. x is reduced by the
+// nearest multiple of pi/2 to r in [-pi/4, pi/4], where minimax polynomials give sin r and cos r,
+// and the quadrant swaps and negates them. There are two tiers:
+//   SinCos      within 1.5 ULP of the exact result for |x| <= 1024 and 2.5 ULP for |x| <= 8192,
+//               zeros included. pi/2 is split in four parts (Cody-Waite) so the reduction keeps
+//               full relative precision near multiples of pi/2.
+//   SinCosFast  within 2e-5 absolute for |x| <= 8192, with a two-part reduction and two fewer
+//               polynomial terms each, for visuals and animation where 1e-4 is plenty.
+// Larger |x| lose accuracy gradually. nan gives nan, and so does inf except in SinCosFast, which
+// doesn't spend instructions on it. The float, Vec4x (SSE2), __m256 (AVX2) and __m512 (AVX-512)
+// forms evaluate the same polynomials, so lanes only differ from the scalar results by FMA
+// rounding.
+// vec_math.h's quat_from_axis_angle, quat_from_euler and mat4_perspective_fov keep sinf, cosf and
+// tanf: that header is kept C-compatible, so it can't call SinCos. GCC already turns each of their
+// sinf/cosf pairs into one sincosf call at -O2.
+constexpr float _kTwoOverPi = 0.636619772f;
+constexpr float _kPiOver2Hi = 1.5703125f;
+constexpr float _kPiOver2Mid = 4.837512969970703125e-4f;
+constexpr float _kPiOver2Lo = 7.549533620476723e-8f;
+constexpr float _kPiOver2Tiny = 2.5633441e-12f;
+// pi/2 - _kPiOver2Hi, for the fast tier
+constexpr float _kPiOver2Tail = 4.83826792e-4f;
+// sin r = r + r^3 * S(r^2), cos r = 1 - r^2 / 2 + r^4 * C(r^2)
+constexpr float _kSin0 = -1.6666654611e-1f;
+constexpr float _kSin1 = 8.3321608736e-3f;
+constexpr float _kSin2 = -1.9515295891e-4f;
+constexpr float _kCos0 = 4.166664568298827e-2f;
+constexpr float _kCos1 = -1.388731625493765e-3f;
+constexpr float _kCos2 = 2.443315711809948e-5f;
+// Fast tier: sin r = r + r^3 * S(r^2), cos r = 1 + r^2 * C(r^2)
+constexpr float _kSinFast0 = -1.66628338e-1f;
+constexpr float _kSinFast1 = 8.15299234e-3f;
+constexpr float _kCosFast0 = -4.99776307e-1f;
+constexpr float _kCosFast1 = 4.04889358e-2f;
+
+template<bool kAccurate>
+inline void _SinCosScalar(float const x, float& s, float& c)
+{
+    int const q = _mm_cvtss_si32(_mm_set_ss(x * _kTwoOverPi));
+    float const j = static_cast<float>(q);
+    float r = x - j * _kPiOver2Hi;
+    float sr, cr;
+    if (kAccurate) {
+        r = ((r - j * _kPiOver2Mid) - j * _kPiOver2Lo) - j * _kPiOver2Tiny;
+        float const u = r * r;
+        sr = r + r * u * ((_kSin2 * u + _kSin1) * u + _kSin0);
+        cr = (u * u * ((_kCos2 * u + _kCos1) * u + _kCos0) - 0.5f * u) + 1.0f;
+    } else {
+        r = r - j * _kPiOver2Tail;
+        float const u = r * r;
+        sr = r + r * u * (_kSinFast1 * u + _kSinFast0);
+        cr = 1.0f + u * (_kCosFast1 * u + _kCosFast0);
+    }
+    // Random angles make the quadrant unpredictable, so it selects and negates with bit masks
+    uint32_t sinBits, cosBits;
+    memcpy(&sinBits, &sr, sizeof(sr));
+    memcpy(&cosBits, &cr, sizeof(cr));
+    uint32_t const swap = (sinBits ^ cosBits) & (0u - (static_cast<uint32_t>(q) & 1u));
+    sinBits ^= swap ^ (static_cast<uint32_t>(q) >> 1 << 31);
+    cosBits ^= swap ^ (static_cast<uint32_t>(q + 1) >> 1 << 31);
+    memcpy(&s, &sinBits, sizeof(s));
+    memcpy(&c, &cosBits, sizeof(c));
+}
+inline void SinCos(float const x, float& s, float& c)
+{
+    _SinCosScalar<true>(x, s, c);
+}
+inline void SinCosFast(float const x, float& s, float& c)
+{
+    _SinCosScalar<false>(x, s, c);
+}
+
+// The SIMD forms swap sin and cos where quadrant bit 0 is set, and move quadrant bit 1 of q for
+// sin, and of q + 1 for cos, into the sign bit.
+template<bool kAccurate>
+AK_FORCEINLINE void _SinCosSse(__m128 const x, __m128& s, __m128& c)
+{
+    __m128i const q = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(_kTwoOverPi)));
+    __m128 const j = _mm_cvtepi32_ps(q);
+    __m128 r = _mm_sub_ps(x, _mm_mul_ps(j, _mm_set1_ps(_kPiOver2Hi)));
+    __m128 sr, cr;
+    if (kAccurate) {
+        r = _mm_sub_ps(r, _mm_mul_ps(j, _mm_set1_ps(_kPiOver2Mid)));
+        r = _mm_sub_ps(r, _mm_mul_ps(j, _mm_set1_ps(_kPiOver2Lo)));
+        r = _mm_sub_ps(r, _mm_mul_ps(j, _mm_set1_ps(_kPiOver2Tiny)));
+        __m128 const u = _mm_mul_ps(r, r);
+        __m128 const ps = _MulAddSse(_MulAddSse(_mm_set1_ps(_kSin2), u, _mm_set1_ps(_kSin1)), u,
+                                     _mm_set1_ps(_kSin0));
+        sr = _MulAddSse(_mm_mul_ps(r, u), ps, r);
+        __m128 const pc = _MulAddSse(_MulAddSse(_mm_set1_ps(_kCos2), u, _mm_set1_ps(_kCos1)), u,
+                                     _mm_set1_ps(_kCos0));
+        cr = _mm_add_ps(
+            _mm_sub_ps(_mm_mul_ps(_mm_mul_ps(u, u), pc), _mm_mul_ps(u, _mm_set1_ps(0.5f))),
+            _mm_set1_ps(1.0f));
+    } else {
+        r = _mm_sub_ps(r, _mm_mul_ps(j, _mm_set1_ps(_kPiOver2Tail)));
+        __m128 const u = _mm_mul_ps(r, r);
+        sr = _MulAddSse(_mm_mul_ps(r, u), _MulAddSse(_mm_set1_ps(_kSinFast1), u,
+                                                     _mm_set1_ps(_kSinFast0)), r);
+        cr = _MulAddSse(u, _MulAddSse(_mm_set1_ps(_kCosFast1), u, _mm_set1_ps(_kCosFast0)),
+                        _mm_set1_ps(1.0f));
+    }
+    __m128 const swap = _mm_castsi128_ps(_mm_srai_epi32(_mm_slli_epi32(q, 31), 31));
+    __m128 const sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_srli_epi32(q, 1), 31));
+    __m128 const cosSign = _mm_castsi128_ps(
+        _mm_slli_epi32(_mm_srli_epi32(_mm_add_epi32(q, _mm_set1_epi32(1)), 1), 31));
+    s = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, cr), _mm_andnot_ps(swap, sr)), sinSign);
+    c = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, sr), _mm_andnot_ps(swap, cr)), cosSign);
+}
+AK_FORCEINLINE void SinCos(Vec4x const x, Vec4x& s, Vec4x& c)
+{
+    _SinCosSse<true>(x.v, s.v, c.v);
+}
+AK_FORCEINLINE void SinCosFast(Vec4x const x, Vec4x& s, Vec4x& c)
+{
+    _SinCosSse<false>(x.v, s.v, c.v);
+}
+
+template<bool kAccurate>
+AK_TARGET_INLINE("avx2,fma")
+void _SinCosAvx(__m256 const x, __m256& s, __m256& c)
+{
+    __m256i const q = _mm256_cvtps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(_kTwoOverPi)));
+    __m256 const j = _mm256_cvtepi32_ps(q);
+    __m256 r = _mm256_fnmadd_ps(j, _mm256_set1_ps(_kPiOver2Hi), x);
+    __m256 sr, cr;
+    if (kAccurate) {
+        r = _mm256_fnmadd_ps(j, _mm256_set1_ps(_kPiOver2Mid), r);
+        r = _mm256_fnmadd_ps(j, _mm256_set1_ps(_kPiOver2Lo), r);
+        r = _mm256_fnmadd_ps(j, _mm256_set1_ps(_kPiOver2Tiny), r);
+        __m256 const u = _mm256_mul_ps(r, r);
+        __m256 const ps = _mm256_fmadd_ps(
+            _mm256_fmadd_ps(_mm256_set1_ps(_kSin2), u, _mm256_set1_ps(_kSin1)), u,
+            _mm256_set1_ps(_kSin0));
+        sr = _mm256_fmadd_ps(_mm256_mul_ps(r, u), ps, r);
+        __m256 const pc = _mm256_fmadd_ps(
+            _mm256_fmadd_ps(_mm256_set1_ps(_kCos2), u, _mm256_set1_ps(_kCos1)), u,
+            _mm256_set1_ps(_kCos0));
+        cr = _mm256_add_ps(
+            _mm256_fmsub_ps(_mm256_mul_ps(u, u), pc, _mm256_mul_ps(u, _mm256_set1_ps(0.5f))),
+            _mm256_set1_ps(1.0f));
+    } else {
+        r = _mm256_fnmadd_ps(j, _mm256_set1_ps(_kPiOver2Tail), r);
+        __m256 const u = _mm256_mul_ps(r, r);
+        sr = _mm256_fmadd_ps(
+            _mm256_mul_ps(r, u),
+            _mm256_fmadd_ps(_mm256_set1_ps(_kSinFast1), u, _mm256_set1_ps(_kSinFast0)), r);
+        cr = _mm256_fmadd_ps(
+            u, _mm256_fmadd_ps(_mm256_set1_ps(_kCosFast1), u, _mm256_set1_ps(_kCosFast0)),
+            _mm256_set1_ps(1.0f));
+    }
+    __m256 const swap = _mm256_castsi256_ps(_mm256_slli_epi32(q, 31));
+    __m256 const sinSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_srli_epi32(q, 1), 31));
+    __m256 const cosSign = _mm256_castsi256_ps(
+        _mm256_slli_epi32(_mm256_srli_epi32(_mm256_add_epi32(q, _mm256_set1_epi32(1)), 1), 31));
+    s = _mm256_xor_ps(_mm256_blendv_ps(sr, cr, swap), sinSign);
+    c = _mm256_xor_ps(_mm256_blendv_ps(cr, sr, swap), cosSign);
+}
+AK_TARGET_INLINE("avx2,fma") void SinCos(__m256 const x, __m256& s, __m256& c)
+{
+    _SinCosAvx<true>(x, s, c);
+}
+AK_TARGET_INLINE("avx2,fma") void SinCosFast(__m256 const x, __m256& s, __m256& c)
+{
+    _SinCosAvx<false>(x, s, c);
+}
+
+template<bool kAccurate>
+AK_TARGET_INLINE("avx512f")
+void _SinCosAvx512(__m512 const x, __m512& s, __m512& c)
+{
+    __m512i const q = _mm512_cvtps_epi32(_mm512_mul_ps(x, _mm512_set1_ps(_kTwoOverPi)));
+    __m512 const j = _mm512_cvtepi32_ps(q);
+    __m512 r = _mm512_fnmadd_ps(j, _mm512_set1_ps(_kPiOver2Hi), x);
+    __m512 sr, cr;
+    if (kAccurate) {
+        r = _mm512_fnmadd_ps(j, _mm512_set1_ps(_kPiOver2Mid), r);
+        r = _mm512_fnmadd_ps(j, _mm512_set1_ps(_kPiOver2Lo), r);
+        r = _mm512_fnmadd_ps(j, _mm512_set1_ps(_kPiOver2Tiny), r);
+        __m512 const u = _mm512_mul_ps(r, r);
+        __m512 const ps = _mm512_fmadd_ps(
+            _mm512_fmadd_ps(_mm512_set1_ps(_kSin2), u, _mm512_set1_ps(_kSin1)), u,
+            _mm512_set1_ps(_kSin0));
+        sr = _mm512_fmadd_ps(_mm512_mul_ps(r, u), ps, r);
+        __m512 const pc = _mm512_fmadd_ps(
+            _mm512_fmadd_ps(_mm512_set1_ps(_kCos2), u, _mm512_set1_ps(_kCos1)), u,
+            _mm512_set1_ps(_kCos0));
+        cr = _mm512_add_ps(
+            _mm512_fmsub_ps(_mm512_mul_ps(u, u), pc, _mm512_mul_ps(u, _mm512_set1_ps(0.5f))),
+            _mm512_set1_ps(1.0f));
+    } else {
+        r = _mm512_fnmadd_ps(j, _mm512_set1_ps(_kPiOver2Tail), r);
+        __m512 const u = _mm512_mul_ps(r, r);
+        sr = _mm512_fmadd_ps(
+            _mm512_mul_ps(r, u),
+            _mm512_fmadd_ps(_mm512_set1_ps(_kSinFast1), u, _mm512_set1_ps(_kSinFast0)), r);
+        cr = _mm512_fmadd_ps(
+            u, _mm512_fmadd_ps(_mm512_set1_ps(_kCosFast1), u, _mm512_set1_ps(_kCosFast0)),
+            _mm512_set1_ps(1.0f));
+    }
+    __mmask16 const swap = _mm512_test_epi32_mask(q, _mm512_set1_epi32(1));
+    __m512i const sinSign = _mm512_slli_epi32(_mm512_srli_epi32(q, 1), 31);
+    __m512i const cosSign =
+        _mm512_slli_epi32(_mm512_srli_epi32(_mm512_add_epi32(q, _mm512_set1_epi32(1)), 1), 31);
+    s = _mm512_castsi512_ps(
+        _mm512_xor_si512(_mm512_castps_si512(_mm512_mask_blend_ps(swap, sr, cr)), sinSign));
+    c = _mm512_castsi512_ps(
+        _mm512_xor_si512(_mm512_castps_si512(_mm512_mask_blend_ps(swap, cr, sr)), cosSign));
+}
+AK_TARGET_INLINE("avx512f") void SinCos(__m512 const x, __m512& s, __m512& c)
+{
+    _SinCosAvx512<true>(x, s, c);
+}
+AK_TARGET_INLINE("avx512f") void SinCosFast(__m512 const x, __m512& s, __m512& c)
+{
+    _SinCosAvx512<false>(x, s, c);
+}
+
+// Batched forms: s[i], c[i] = sin(x[i]), cos(x[i]). The arrays need no particular alignment.
+template<bool kAccurate>
+inline void _SinCosManyScalar(float const* const x, float* const s, float* const c,
+                              size_t const begin, size_t const n)
+{
+    for (size_t ii = begin; ii < n; ++ii) {
+        _SinCosScalar<kAccurate>(x[ii], s[ii], c[ii]);
+    }
+}
+template<bool kAccurate>
+inline void _SinCosManySse(float const* const x, float* const s, float* const c, size_t const n)
+{
+    size_t ii = 0;
+    for (; ii + 4 <= n; ii += 4) {
+        __m128 sv, cv;
+        _SinCosSse<kAccurate>(_mm_loadu_ps(x + ii), sv, cv);
+        _mm_storeu_ps(s + ii, sv);
+        _mm_storeu_ps(c + ii, cv);
+    }
+    _SinCosManyScalar<kAccurate>(x, s, c, ii, n);
+}
+template<bool kAccurate>
+AK_TARGET_INLINE("avx2,fma")
+void _SinCosManyAvx(float const* const x, float* const s, float* const c, size_t const n)
+{
+    size_t ii = 0;
+    for (; ii + 8 <= n; ii += 8) {
+        __m256 sv, cv;
+        _SinCosAvx<kAccurate>(_mm256_loadu_ps(x + ii), sv, cv);
+        _mm256_storeu_ps(s + ii, sv);
+        _mm256_storeu_ps(c + ii, cv);
+    }
+    _SinCosManyScalar<kAccurate>(x, s, c, ii, n);
+}
+template<bool kAccurate>
+AK_TARGET_INLINE("avx512f")
+void _SinCosManyAvx512(float const* const x, float* const s, float* const c, size_t const n)
+{
+    for (size_t ii = 0; ii < n; ii += 16) {
+        __mmask16 const mask = n - ii >= 16 ? 0xffff : _TailMask(n - ii);
+        __m512 sv, cv;
+        _SinCosAvx512<kAccurate>(_mm512_maskz_loadu_ps(mask, x + ii), sv, cv);
+        _mm512_mask_storeu_ps(s + ii, mask, sv);
+        _mm512_mask_storeu_ps(c + ii, mask, cv);
+    }
+}
+template<bool kAccurate>
+inline void _SinCosMany(SimdLevel const level, float const* const x, float* const s,
+                        float* const c, size_t const n)
+{
+    switch (level) {
+        case SimdLevel::kAvx512:
+            return _SinCosManyAvx512<kAccurate>(x, s, c, n);
+        case SimdLevel::kAvx:
+            return _SinCosManyAvx<kAccurate>(x, s, c, n);
+        case SimdLevel::kSse:
+            return _SinCosManySse<kAccurate>(x, s, c, n);
+        case SimdLevel::kScalar:
+            break;
+    }
+    _SinCosManyScalar<kAccurate>(x, s, c, 0, n);
+}
+inline void SinCosManyScalar(float const* const x, float* const s, float* const c, size_t const n)
+{
+    _SinCosMany<true>(SimdLevel::kScalar, x, s, c, n);
+}
+inline void SinCosManySse(float const* const x, float* const s, float* const c, size_t const n)
+{
+    _SinCosMany<true>(SimdLevel::kSse, x, s, c, n);
+}
+inline void SinCosManyAvx(float const* const x, float* const s, float* const c, size_t const n)
+{
+    _SinCosMany<true>(SimdLevel::kAvx, x, s, c, n);
+}
+inline void SinCosManyAvx512(float const* const x, float* const s, float* const c, size_t const n)
+{
+    _SinCosMany<true>(SimdLevel::kAvx512, x, s, c, n);
+}
+inline void SinCosMany(float const* const x, float* const s, float* const c, size_t const n)
+{
+    _SinCosMany<true>(ActiveSimdLevel(), x, s, c, n);
+}
+inline void SinCosFastManyScalar(float const* const x, float* const s, float* const c,
+                                 size_t const n)
+{
+    _SinCosMany<false>(SimdLevel::kScalar, x, s, c, n);
+}
+inline void SinCosFastManySse(float const* const x, float* const s, float* const c, size_t const n)
+{
+    _SinCosMany<false>(SimdLevel::kSse, x, s, c, n);
+}
+inline void SinCosFastManyAvx(float const* const x, float* const s, float* const c, size_t const n)
+{
+    _SinCosMany<false>(SimdLevel::kAvx, x, s, c, n);
+}
+inline void SinCosFastManyAvx512(float const* const x, float* const s, float* const c,
+                                 size_t const n)
+{
+    _SinCosMany<false>(SimdLevel::kAvx512, x, s, c, n);
+}
+inline void SinCosFastMany(float const* const x, float* const s, float* const c, size_t const n)
+{
+    _SinCosMany<false>(ActiveSimdLevel(), x, s, c, n);
+}
+
 /*****************************************************************************\
  * Mat3                                                                       *
 \*****************************************************************************/
@@ -315,8 +1038,8 @@ constexpr inline Mat3 Mat3::Scaling(float const x, float const y, float const z)
 }
 inline Mat3 Mat3::RotationX(float const rad)
 {
-    float const c = cosf(rad);
-    float const s = sinf(rad);
+    float s, c;
+    SinCos(rad, s, c);
     return {
         {1, 0, 0},
         {0, c, s},
@@ -325,8 +1048,8 @@ inline Mat3 Mat3::RotationX(float const rad)
 }
 inline Mat3 Mat3::RotationY(float const rad)
 {
-    float const c = cosf(rad);
-    float const s = sinf(rad);
+    float s, c;
+    SinCos(rad, s, c);
     return {
         {c, 0, -s},
         {0, 1, 0},
@@ -335,8 +1058,8 @@ inline Mat3 Mat3::RotationY(float const rad)
 }
 inline Mat3 Mat3::RotationZ(float const rad)
 {
-    float const c = cosf(rad);
-    float const s = sinf(rad);
+    float s, c;
+    SinCos(rad, s, c);
     return {
         {c, s, 0},
         {-s, c, 0},
@@ -346,8 +1069,8 @@ inline Mat3 Mat3::RotationZ(float const rad)
 inline Mat3 Mat3::RotationAxis(Vec3 const axis, float const rad)
 {
     Vec3 const normAxis = Normalize(axis);
-    float const c = cosf(rad);
-    float const s = sinf(rad);
+    float s, c;
+    SinCos(rad, s, c);
     float const t = 1.0f - c;
 
     float const x = normAxis.x;
@@ -473,8 +1196,8 @@ constexpr inline Mat4 Mat4::Scaling(float const x, float const y, float const z)
 }
 inline Mat4 Mat4::RotationX(float const rad)
 {
-    float const c = cosf(rad);
-    float const s = sinf(rad);
+    float s, c;
+    SinCos(rad, s, c);
     return {
         {1, 0, 0, 0},
         {0, c, s, 0},
@@ -484,8 +1207,8 @@ inline Mat4 Mat4::RotationX(float const rad)
 }
 inline Mat4 Mat4::RotationY(float const rad)
 {
-    float const c = cosf(rad);
-    float const s = sinf(rad);
+    float s, c;
+    SinCos(rad, s, c);
     return {
         {c, 0, -s, 0},
         {0, 1, 0, 0},
@@ -495,8 +1218,8 @@ inline Mat4 Mat4::RotationY(float const rad)
 }
 inline Mat4 Mat4::RotationZ(float const rad)
 {
-    float const c = cosf(rad);
-    float const s = sinf(rad);
+    float s, c;
+    SinCos(rad, s, c);
     return {
         {c, s, 0, 0},
         {-s, c, 0, 0},
@@ -504,17 +1227,12 @@ inline Mat4 Mat4::RotationZ(float const rad)
         {0, 0, 0, 1},
     };
 }
-inline Mat4 Mat4::RotationAxis(Vec4 const axis, float const rad)
+// Rotation about the unit axis (x, y, z) by the angle with sine s and cosine c
+inline Mat4 _RotationAxis(float const x, float const y, float const z, float const s,
+                          float const c)
 {
-    Vec4 const normAxis = Normalize(axis);
-    float const c = cosf(rad);
-    float const s = sinf(rad);
     float const t = 1.0f - c;
 
-    float const x = normAxis.x;
-    float const y = normAxis.y;
-    float const z = normAxis.z;
-
     return {
         {
             (t * x * x) + c,
@@ -537,6 +1255,60 @@ inline Mat4 Mat4::RotationAxis(Vec4 const axis, float const rad)
         {0, 0, 0, 1},
     };
 }
+inline Mat4 Mat4::RotationAxis(Vec4 const axis, float const rad)
+{
+    Vec4 const normAxis = Normalize(axis);
+    float s, c;
+    SinCos(rad, s, c);
+    return _RotationAxis(normAxis.x, normAxis.y, normAxis.z, s, c);
+}
+
+// Batched builders: out[i] = Mat4::RotationX(rad[i]) and so on. The sines and cosines come from
+// SinCosMany a stack buffer at a time, so they match the single forms up to FMA rounding.
+constexpr size_t _kSinCosChunk = 256;
+// Calls build(i, sin(rad[i] * scale), cos(rad[i] * scale)) for i in [0, n)
+template<typename Build>
+inline void _ForEachSinCos(float const* const rad, float const scale, size_t const n,
+                           Build const& build)
+{
+    float x[_kSinCosChunk], s[_kSinCosChunk], c[_kSinCosChunk];
+    for (size_t begin = 0; begin < n; begin += _kSinCosChunk) {
+        size_t const count = n - begin < _kSinCosChunk ? n - begin : _kSinCosChunk;
+        for (size_t ii = 0; ii < count; ++ii) {
+            x[ii] = rad[begin + ii] * scale;
+        }
+        SinCosMany(x, s, c, count);
+        for (size_t ii = 0; ii < count; ++ii) {
+            build(begin + ii, s[ii], c[ii]);
+        }
+    }
+}
+inline void RotationXMany(float const* const rad, Mat4* const out, size_t const n)
+{
+    _ForEachSinCos(rad, 1.0f, n, [out](size_t const ii, float const s, float const c) {
+        out[ii] = {{1, 0, 0, 0}, {0, c, s, 0}, {0, -s, c, 0}, {0, 0, 0, 1}};
+    });
+}
+inline void RotationYMany(float const* const rad, Mat4* const out, size_t const n)
+{
+    _ForEachSinCos(rad, 1.0f, n, [out](size_t const ii, float const s, float const c) {
+        out[ii] = {{c, 0, -s, 0}, {0, 1, 0, 0}, {s, 0, c, 0}, {0, 0, 0, 1}};
+    });
+}
+inline void RotationZMany(float const* const rad, Mat4* const out, size_t const n)
+{
+    _ForEachSinCos(rad, 1.0f, n, [out](size_t const ii, float const s, float const c) {
+        out[ii] = {{c, s, 0, 0}, {-s, c, 0, 0}, {0, 0, 1, 0}, {0, 0, 0, 1}};
+    });
+}
+inline void RotationAxisMany(Vec3 const* const axes, float const* const rad, Mat4* const out,
+                             size_t const n)
+{
+    _ForEachSinCos(rad, 1.0f, n, [axes, out](size_t const ii, float const s, float const c) {
+        Vec3 const a = Normalize(axes[ii]);
+        out[ii] = _RotationAxis(a.x, a.y, a.z, s, c);
+    });
+}
 constexpr inline Mat4 MultiplyScalar(Mat4 const a, Mat4 const b)
 {
     Mat4 m{};
@@ -556,7 +1328,7 @@ constexpr inline Mat4 MultiplyScalar(Mat4 const a, Mat4 const b)
     }
     return m;
 }
-inline Mat4 MultiplySse(Mat4 const a, Mat4 const b)
+AK_TARGET_INLINE("sse3") Mat4 MultiplySse(Mat4 const a, Mat4 const b)
 {
     __m128 a_r0 = _mm_load_ps(&a.c0.x);
     __m128 a_r1 = _mm_load_ps(&a.c1.x);
@@ -621,7 +1393,7 @@ inline Mat4 MultiplySse(Mat4 const a, Mat4 const b)
 
     return result;
 }
-__forceinline Mat4 MultiplyAvx(Mat4 const& a, Mat4 const& b)
+AK_TARGET_INLINE("avx2,fma") Mat4 MultiplyAvx(Mat4 const& a, Mat4 const& b)
 {
     __m256 const a_r0r1 = _mm256_setr_ps(a.c0.x, a.c1.x, a.c2.x, a.c3.x,  //
                                          a.c0.y, a.c1.y, a.c2.y, a.c3.y);
@@ -680,7 +1452,7 @@ __forceinline Mat4 MultiplyAvx(Mat4 const& a, Mat4 const& b)
 
     return result;
 }
-__forceinline static Mat4 MultiplyAvx512(Mat4 const& in_a, Mat4 const& in_b)
+AK_TARGET_INLINE("avx512f") Mat4 MultiplyAvx512(Mat4 const& in_a, Mat4 const& in_b)
 {
 #define MAKE_A_MASK(offset)                                                                   \
     _mm512_setr_epi32(0 + (4 * offset), 1 + (4 * offset), 2 + (4 * offset), 3 + (4 * offset), \
@@ -726,13 +1498,312 @@ __forceinline static Mat4 MultiplyAvx512(Mat4 const& in_a, Mat4 const& in_b)
 
     return result;
 }
-__forceinline Mat4 operator*(Mat4 const& a, Mat4 const& b)
+inline Mat4 Multiply(Mat4 const& a, Mat4 const& b)
 {
-    return MultiplyAvx512(a, b);
+    switch (ActiveSimdLevel()) {
+        case SimdLevel::kAvx512:
+            return MultiplyAvx512(a, b);
+        case SimdLevel::kAvx:
+            return MultiplyAvx(a, b);
+        case SimdLevel::kSse:
+            return MultiplySse(a, b);
+        case SimdLevel::kScalar:
+            break;
+    }
+    return MultiplyScalar(a, b);
 }
-inline void TransposeInPlace(Mat4& m)
+AK_FORCEINLINE Mat4 operator*(Mat4 const& a, Mat4 const& b)
 {
-    _swapf(m.c0.y, m.c1.x);
+    return Multiply(a, b);
+}
+
+// Batched multiplies. All arrays must honour Mat4's 64-byte alignment. `out` may be the same array
+// as `a` or `b`, but must not partially overlap either. A broadcast `a` may be an element of `out`
+// or `b`: every kernel reads it once, before storing any result.
+//
+// Each kernel computes out column j as sum_k(a.ck * b.cj[k]): the a columns are broadcast from
+// memory and the b elements are splatted with in-lane immediate shuffles, so no permutation
+// constants are loaded per matrix. Outputs larger than kStreamingStoreBytes bypass the cache.
+constexpr size_t kStreamingStoreBytes = 4 * 1024 * 1024;
+
+inline bool _UseStreamingStores(size_t const n)
+{
+    return n * sizeof(Mat4) >= kStreamingStoreBytes;
+}
+
+inline void MultiplyManyScalar(Mat4 const* const a, Mat4 const* const b, Mat4* const out,
+                               size_t const n)
+{
+    for (size_t ii = 0; ii < n; ++ii) {
+        out[ii] = MultiplyScalar(a[ii], b[ii]);
+    }
+}
+inline void MultiplyManyScalar(Mat4 const& a, Mat4 const* const b, Mat4* const out, size_t const n)
+{
+    Mat4 const m = a;
+    for (size_t ii = 0; ii < n; ++ii) {
+        out[ii] = MultiplyScalar(m, b[ii]);
+    }
+}
+
+// SSE
+AK_TARGET_INLINE("sse3") __m128 _MulColumnSse(__m128 const a0, __m128 const a1, __m128 const a2,
+                                              __m128 const a3, __m128 const b)
+{
+    __m128 r = _mm_mul_ps(a0, _mm_shuffle_ps(b, b, 0x00));
+    r = _mm_add_ps(r, _mm_mul_ps(a1, _mm_shuffle_ps(b, b, 0x55)));
+    r = _mm_add_ps(r, _mm_mul_ps(a2, _mm_shuffle_ps(b, b, 0xaa)));
+    r = _mm_add_ps(r, _mm_mul_ps(a3, _mm_shuffle_ps(b, b, 0xff)));
+    return r;
+}
+AK_TARGET_INLINE("sse3") void _StoreSse(float* const p, __m128 const v, bool const stream)
+{
+    if (stream) {
+        _mm_stream_ps(p, v);
+    } else {
+        _mm_store_ps(p, v);
+    }
+}
+AK_TARGET_INLINE("sse3") void _MultiplyStoreSse(__m128 const a0, __m128 const a1, __m128 const a2,
+                                                __m128 const a3, Mat4 const& b, Mat4& out,
+                                                bool const stream)
+{
+    __m128 const r0 = _MulColumnSse(a0, a1, a2, a3, _mm_load_ps(&b.c0.x));
+    __m128 const r1 = _MulColumnSse(a0, a1, a2, a3, _mm_load_ps(&b.c1.x));
+    __m128 const r2 = _MulColumnSse(a0, a1, a2, a3, _mm_load_ps(&b.c2.x));
+    __m128 const r3 = _MulColumnSse(a0, a1, a2, a3, _mm_load_ps(&b.c3.x));
+    _StoreSse(&out.c0.x, r0, stream);
+    _StoreSse(&out.c1.x, r1, stream);
+    _StoreSse(&out.c2.x, r2, stream);
+    _StoreSse(&out.c3.x, r3, stream);
+}
+AK_TARGET_INLINE("sse3")
+void MultiplyManySse(Mat4 const* const a, Mat4 const* const b, Mat4* const out, size_t const n)
+{
+    bool const stream = _UseStreamingStores(n);
+    for (size_t ii = 0; ii < n; ++ii) {
+        _MultiplyStoreSse(_mm_load_ps(&a[ii].c0.x), _mm_load_ps(&a[ii].c1.x),
+                          _mm_load_ps(&a[ii].c2.x), _mm_load_ps(&a[ii].c3.x), b[ii], out[ii],
+                          stream);
+    }
+    if (stream) {
+        _mm_sfence();
+    }
+}
+AK_TARGET_INLINE("sse3")
+void MultiplyManySse(Mat4 const& a, Mat4 const* const b, Mat4* const out, size_t const n)
+{
+    bool const stream = _UseStreamingStores(n);
+    __m128 const a0 = _mm_load_ps(&a.c0.x);
+    __m128 const a1 = _mm_load_ps(&a.c1.x);
+    __m128 const a2 = _mm_load_ps(&a.c2.x);
+    __m128 const a3 = _mm_load_ps(&a.c3.x);
+    for (size_t ii = 0; ii < n; ++ii) {
+        _MultiplyStoreSse(a0, a1, a2, a3, b[ii], out[ii], stream);
+    }
+    if (stream) {
+        _mm_sfence();
+    }
+}
+
+// AVX2. Each register holds two output columns, so the a columns are duplicated in both halves.
+AK_TARGET_INLINE("avx2,fma") __m256 _MulColumnPairAvx(__m256 const a0, __m256 const a1,
+                                                      __m256 const a2, __m256 const a3,
+                                                      __m256 const b)
+{
+    __m256 r = _mm256_mul_ps(a0, _mm256_permute_ps(b, 0x00));
+    r = _mm256_fmadd_ps(a1, _mm256_permute_ps(b, 0x55), r);
+    r = _mm256_fmadd_ps(a2, _mm256_permute_ps(b, 0xaa), r);
+    r = _mm256_fmadd_ps(a3, _mm256_permute_ps(b, 0xff), r);
+    return r;
+}
+AK_TARGET_INLINE("avx2,fma") void _StoreAvx(float* const p, __m256 const v, bool const stream)
+{
+    if (stream) {
+        _mm256_stream_ps(p, v);
+    } else {
+        _mm256_store_ps(p, v);
+    }
+}
+AK_TARGET_INLINE("avx2,fma")
+void MultiplyManyAvx(Mat4 const* const a, Mat4 const* const b, Mat4* const out, size_t const n)
+{
+    bool const stream = _UseStreamingStores(n);
+    size_t ii = 0;
+    for (; ii + 2 <= n; ii += 2) {
+        Mat4 const& a0 = a[ii + 0];
+        Mat4 const& a1 = a[ii + 1];
+        __m256 const x0 = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(&a0.c0.x));
+        __m256 const y0 = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(&a0.c1.x));
+        __m256 const z0 = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(&a0.c2.x));
+        __m256 const w0 = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(&a0.c3.x));
+        __m256 const x1 = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(&a1.c0.x));
+        __m256 const y1 = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(&a1.c1.x));
+        __m256 const z1 = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(&a1.c2.x));
+        __m256 const w1 = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(&a1.c3.x));
+
+        __m256 const r00 = _MulColumnPairAvx(x0, y0, z0, w0, _mm256_load_ps(&b[ii].c0.x));
+        __m256 const r01 = _MulColumnPairAvx(x0, y0, z0, w0, _mm256_load_ps(&b[ii].c2.x));
+        __m256 const r10 = _MulColumnPairAvx(x1, y1, z1, w1, _mm256_load_ps(&b[ii + 1].c0.x));
+        __m256 const r11 = _MulColumnPairAvx(x1, y1, z1, w1, _mm256_load_ps(&b[ii + 1].c2.x));
+
+        _StoreAvx(&out[ii].c0.x, r00, stream);
+        _StoreAvx(&out[ii].c2.x, r01, stream);
+        _StoreAvx(&out[ii + 1].c0.x, r10, stream);
+        _StoreAvx(&out[ii + 1].c2.x, r11, stream);
+    }
+    for (; ii < n; ++ii) {
+        __m256 const x = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(&a[ii].c0.x));
+        __m256 const y = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(&a[ii].c1.x));
+        __m256 const z = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(&a[ii].c2.x));
+        __m256 const w = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(&a[ii].c3.x));
+        __m256 const r0 = _MulColumnPairAvx(x, y, z, w, _mm256_load_ps(&b[ii].c0.x));
+        __m256 const r1 = _MulColumnPairAvx(x, y, z, w, _mm256_load_ps(&b[ii].c2.x));
+        _StoreAvx(&out[ii].c0.x, r0, stream);
+        _StoreAvx(&out[ii].c2.x, r1, stream);
+    }
+    if (stream) {
+        _mm_sfence();
+    }
+}
+AK_TARGET_INLINE("avx2,fma")
+void MultiplyManyAvx(Mat4 const& a, Mat4 const* const b, Mat4* const out, size_t const n)
+{
+    bool const stream = _UseStreamingStores(n);
+    __m256 const x = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(&a.c0.x));
+    __m256 const y = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(&a.c1.x));
+    __m256 const z = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(&a.c2.x));
+    __m256 const w = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(&a.c3.x));
+    size_t ii = 0;
+    for (; ii + 2 <= n; ii += 2) {
+        __m256 const r00 = _MulColumnPairAvx(x, y, z, w, _mm256_load_ps(&b[ii].c0.x));
+        __m256 const r01 = _MulColumnPairAvx(x, y, z, w, _mm256_load_ps(&b[ii].c2.x));
+        __m256 const r10 = _MulColumnPairAvx(x, y, z, w, _mm256_load_ps(&b[ii + 1].c0.x));
+        __m256 const r11 = _MulColumnPairAvx(x, y, z, w, _mm256_load_ps(&b[ii + 1].c2.x));
+        _StoreAvx(&out[ii].c0.x, r00, stream);
+        _StoreAvx(&out[ii].c2.x, r01, stream);
+        _StoreAvx(&out[ii + 1].c0.x, r10, stream);
+        _StoreAvx(&out[ii + 1].c2.x, r11, stream);
+    }
+    for (; ii < n; ++ii) {
+        __m256 const r0 = _MulColumnPairAvx(x, y, z, w, _mm256_load_ps(&b[ii].c0.x));
+        __m256 const r1 = _MulColumnPairAvx(x, y, z, w, _mm256_load_ps(&b[ii].c2.x));
+        _StoreAvx(&out[ii].c0.x, r0, stream);
+        _StoreAvx(&out[ii].c2.x, r1, stream);
+    }
+    if (stream) {
+        _mm_sfence();
+    }
+}
+
+// AVX-512. One register holds the whole matrix; the a columns are broadcast to all four lanes.
+AK_TARGET_INLINE("avx512f") __m512 _MulColumnsAvx512(__m512 const a0, __m512 const a1,
+                                                     __m512 const a2, __m512 const a3,
+                                                     __m512 const b)
+{
+    __m512 r = _mm512_mul_ps(a0, _mm512_permute_ps(b, 0x00));
+    r = _mm512_fmadd_ps(a1, _mm512_permute_ps(b, 0x55), r);
+    r = _mm512_fmadd_ps(a2, _mm512_permute_ps(b, 0xaa), r);
+    r = _mm512_fmadd_ps(a3, _mm512_permute_ps(b, 0xff), r);
+    return r;
+}
+AK_TARGET_INLINE("avx512f") __m512 _BroadcastColumnAvx512(Vec4 const& c)
+{
+    return _mm512_broadcast_f32x4(_mm_load_ps(&c.x));
+}
+AK_TARGET_INLINE("avx512f") void _StoreAvx512(float* const p, __m512 const v, bool const stream)
+{
+    if (stream) {
+        _mm512_stream_ps(p, v);
+    } else {
+        _mm512_store_ps(p, v);
+    }
+}
+AK_TARGET_INLINE("avx512f")
+void MultiplyManyAvx512(Mat4 const* const a, Mat4 const* const b, Mat4* const out, size_t const n)
+{
+    bool const stream = _UseStreamingStores(n);
+    size_t ii = 0;
+    for (; ii + 2 <= n; ii += 2) {
+        __m512 const r0 = _MulColumnsAvx512(
+            _BroadcastColumnAvx512(a[ii].c0), _BroadcastColumnAvx512(a[ii].c1),
+            _BroadcastColumnAvx512(a[ii].c2), _BroadcastColumnAvx512(a[ii].c3),
+            _mm512_load_ps(&b[ii].c0.x));
+        __m512 const r1 = _MulColumnsAvx512(
+            _BroadcastColumnAvx512(a[ii + 1].c0), _BroadcastColumnAvx512(a[ii + 1].c1),
+            _BroadcastColumnAvx512(a[ii + 1].c2), _BroadcastColumnAvx512(a[ii + 1].c3),
+            _mm512_load_ps(&b[ii + 1].c0.x));
+        _StoreAvx512(&out[ii].c0.x, r0, stream);
+        _StoreAvx512(&out[ii + 1].c0.x, r1, stream);
+    }
+    for (; ii < n; ++ii) {
+        __m512 const r = _MulColumnsAvx512(
+            _BroadcastColumnAvx512(a[ii].c0), _BroadcastColumnAvx512(a[ii].c1),
+            _BroadcastColumnAvx512(a[ii].c2), _BroadcastColumnAvx512(a[ii].c3),
+            _mm512_load_ps(&b[ii].c0.x));
+        _StoreAvx512(&out[ii].c0.x, r, stream);
+    }
+    if (stream) {
+        _mm_sfence();
+    }
+}
+AK_TARGET_INLINE("avx512f")
+void MultiplyManyAvx512(Mat4 const& a, Mat4 const* const b, Mat4* const out, size_t const n)
+{
+    bool const stream = _UseStreamingStores(n);
+    __m512 const x = _BroadcastColumnAvx512(a.c0);
+    __m512 const y = _BroadcastColumnAvx512(a.c1);
+    __m512 const z = _BroadcastColumnAvx512(a.c2);
+    __m512 const w = _BroadcastColumnAvx512(a.c3);
+    size_t ii = 0;
+    for (; ii + 2 <= n; ii += 2) {
+        __m512 const r0 = _MulColumnsAvx512(x, y, z, w, _mm512_load_ps(&b[ii].c0.x));
+        __m512 const r1 = _MulColumnsAvx512(x, y, z, w, _mm512_load_ps(&b[ii + 1].c0.x));
+        _StoreAvx512(&out[ii].c0.x, r0, stream);
+        _StoreAvx512(&out[ii + 1].c0.x, r1, stream);
+    }
+    for (; ii < n; ++ii) {
+        __m512 const r = _MulColumnsAvx512(x, y, z, w, _mm512_load_ps(&b[ii].c0.x));
+        _StoreAvx512(&out[ii].c0.x, r, stream);
+    }
+    if (stream) {
+        _mm_sfence();
+    }
+}
+
+// out[i] = a[i] * b[i]
+inline void MultiplyMany(Mat4 const* const a, Mat4 const* const b, Mat4* const out, size_t const n)
+{
+    switch (ActiveSimdLevel()) {
+        case SimdLevel::kAvx512:
+            return MultiplyManyAvx512(a, b, out, n);
+        case SimdLevel::kAvx:
+            return MultiplyManyAvx(a, b, out, n);
+        case SimdLevel::kSse:
+            return MultiplyManySse(a, b, out, n);
+        case SimdLevel::kScalar:
+            break;
+    }
+    MultiplyManyScalar(a, b, out, n);
+}
+// out[i] = a * b[i]
+inline void MultiplyMany(Mat4 const& a, Mat4 const* const b, Mat4* const out, size_t const n)
+{
+    switch (ActiveSimdLevel()) {
+        case SimdLevel::kAvx512:
+            return MultiplyManyAvx512(a, b, out, n);
+        case SimdLevel::kAvx:
+            return MultiplyManyAvx(a, b, out, n);
+        case SimdLevel::kSse:
+            return MultiplyManySse(a, b, out, n);
+        case SimdLevel::kScalar:
+            break;
+    }
+    MultiplyManyScalar(a, b, out, n);
+}
+inline void TransposeInPlace(Mat4& m)
+{
+    _swapf(m.c0.y, m.c1.x);
     _swapf(m.c0.z, m.c2.x);
     _swapf(m.c0.w, m.c3.x);
     _swapf(m.c1.z, m.c2.y);
@@ -820,141 +1891,5927 @@ inline Mat4 InverseScalar(Mat4 const mat)
     return ret;
 }
 
-inline Mat4 InverseAvx(Mat4 const mat)
+// Shuffle-based inverse using the 2x2 block method. The matrix is split into 2x2 blocks
+//     | A B |
+// M = | C D |
+// and the inverse is assembled from block adjugates and determinants, so every step is an in-lane
+// shuffle. The wider kernels run the same steps on two (AVX2) or four (AVX-512) matrices at once,
+// one per 128-bit lane. The blocks are taken from the columns, which inverts M^T; its inverse
+// stored back as columns is M^-1. Like InverseScalar, singular matrices produce inf/nan.
+
+// SSE
+// 2x2 blocks are stored row-major in a register: (m00, m01, m10, m11)
+AK_TARGET_INLINE("sse3") __m128 _Mat2MulSse(__m128 const a, __m128 const b)  // a * b
 {
-    float const* const m = &mat.c0.x;
+    return _mm_add_ps(_mm_mul_ps(a, _mm_shuffle_ps(b, b, AK_SWIZZLE(0, 3, 0, 3))),
+                      _mm_mul_ps(_mm_shuffle_ps(a, a, AK_SWIZZLE(1, 0, 3, 2)),
+                                 _mm_shuffle_ps(b, b, AK_SWIZZLE(2, 1, 2, 1))));
+}
+AK_TARGET_INLINE("sse3") __m128 _Mat2AdjMulSse(__m128 const a, __m128 const b)  // adj(a) * b
+{
+    return _mm_sub_ps(_mm_mul_ps(_mm_shuffle_ps(a, a, AK_SWIZZLE(3, 3, 0, 0)), b),
+                      _mm_mul_ps(_mm_shuffle_ps(a, a, AK_SWIZZLE(1, 1, 2, 2)),
+                                 _mm_shuffle_ps(b, b, AK_SWIZZLE(2, 3, 0, 1))));
+}
+AK_TARGET_INLINE("sse3") __m128 _Mat2MulAdjSse(__m128 const a, __m128 const b)  // a * adj(b)
+{
+    return _mm_sub_ps(_mm_mul_ps(a, _mm_shuffle_ps(b, b, AK_SWIZZLE(3, 0, 3, 0))),
+                      _mm_mul_ps(_mm_shuffle_ps(a, a, AK_SWIZZLE(1, 0, 3, 2)),
+                                 _mm_shuffle_ps(b, b, AK_SWIZZLE(2, 1, 2, 1))));
+}
+AK_TARGET_INLINE("sse3") void _InverseSse(Mat4 const& m, Mat4& out)
+{
+    __m128 const c0 = _mm_load_ps(&m.c0.x);
+    __m128 const c1 = _mm_load_ps(&m.c1.x);
+    __m128 const c2 = _mm_load_ps(&m.c2.x);
+    __m128 const c3 = _mm_load_ps(&m.c3.x);
 
-    // build 2x2 determinants
-    float const dets[] = {
-        // s
-        m[0] * m[5] - m[4] * m[1],  //
-        m[0] * m[6] - m[4] * m[2],  //
-        m[0] * m[7] - m[4] * m[3],  //
-        m[1] * m[6] - m[5] * m[2],  //
-        m[1] * m[7] - m[5] * m[3],  //
-        m[2] * m[7] - m[6] * m[3],  //
+    __m128 const a = _mm_shuffle_ps(c0, c1, AK_SWIZZLE(0, 1, 0, 1));
+    __m128 const b = _mm_shuffle_ps(c0, c1, AK_SWIZZLE(2, 3, 2, 3));
+    __m128 const c = _mm_shuffle_ps(c2, c3, AK_SWIZZLE(0, 1, 0, 1));
+    __m128 const d = _mm_shuffle_ps(c2, c3, AK_SWIZZLE(2, 3, 2, 3));
 
-        // c
-        m[8] * m[13] - m[12] * m[9],    //
-        m[8] * m[14] - m[12] * m[10],   //
-        m[8] * m[15] - m[12] * m[11],   //
-        m[9] * m[14] - m[13] * m[10],   //
-        m[9] * m[15] - m[13] * m[11],   //
-        m[10] * m[15] - m[14] * m[11],  //
-    };
+    // (|A|, |B|, |C|, |D|)
+    __m128 const dets =
+        _mm_sub_ps(_mm_mul_ps(_mm_shuffle_ps(c0, c2, AK_SWIZZLE(0, 2, 0, 2)),
+                              _mm_shuffle_ps(c1, c3, AK_SWIZZLE(1, 3, 1, 3))),
+                   _mm_mul_ps(_mm_shuffle_ps(c0, c2, AK_SWIZZLE(1, 3, 1, 3)),
+                              _mm_shuffle_ps(c1, c3, AK_SWIZZLE(0, 2, 0, 2))));
+    __m128 const detA = _mm_shuffle_ps(dets, dets, AK_SWIZZLE(0, 0, 0, 0));
+    __m128 const detB = _mm_shuffle_ps(dets, dets, AK_SWIZZLE(1, 1, 1, 1));
+    __m128 const detC = _mm_shuffle_ps(dets, dets, AK_SWIZZLE(2, 2, 2, 2));
+    __m128 const detD = _mm_shuffle_ps(dets, dets, AK_SWIZZLE(3, 3, 3, 3));
 
-    // Should check for 0 determinant
-    float const det = (dets[0] * dets[11] - dets[1] * dets[10] + dets[2] * dets[9] +
-                       dets[3] * dets[8] - dets[4] * dets[7] + dets[5] * dets[6]);
-    float const invdet = 1.0f / det;
+    __m128 const dc = _Mat2AdjMulSse(d, c);
+    __m128 const ab = _Mat2AdjMulSse(a, b);
 
-    // clang-format off
-    #if 0
-    float* const r = &ret.c0.x;
-    r[0] = (+m[5]  * dets[11] - m[6]  * dets[10] + m[7]  * dets[9]) * invdet;
-    r[1] = (-m[1]  * dets[11] + m[2]  * dets[10] - m[3]  * dets[9]) * invdet;
-    r[2] = (+m[13] * dets[5] - m[14] * dets[4] + m[15] * dets[3]) * invdet;
-    r[3] = (-m[9]  * dets[5] + m[10] * dets[4] - m[11] * dets[3]) * invdet;
-    r[4] = (-m[4]  * dets[11] + m[6]  * dets[8] - m[7]  * dets[7]) * invdet;
-    r[5] = (+m[0]  * dets[11] - m[2]  * dets[8] + m[3]  * dets[7]) * invdet;
-    r[6] = (-m[12] * dets[5] + m[14] * dets[2] - m[15] * dets[1]) * invdet;
-    r[7] = (+m[8]  * dets[5] - m[10] * dets[2] + m[11] * dets[1]) * invdet;
-
-    r[8]  = (+m[4]  * dets[10] - m[5]  * dets[8] + m[7]  * dets[6]) * invdet;
-    r[9]  = (-m[0]  * dets[10] + m[1]  * dets[8] - m[3]  * dets[6]) * invdet;
-    r[10] = (+m[12] * dets[4] - m[13] * dets[2] + m[15] * dets[0]) * invdet;
-    r[11] = (-m[8]  * dets[4] + m[9]  * dets[2] - m[11] * dets[0]) * invdet;
-    r[12] = (-m[4]  * dets[9] + m[5]  * dets[7] - m[6]  * dets[6]) * invdet;
-    r[13] = (+m[0]  * dets[9] - m[1]  * dets[7] + m[2]  * dets[6]) * invdet;
-    r[14] = (-m[12] * dets[3] + m[13] * dets[1] - m[14] * dets[0]) * invdet;
-    r[15] = (+m[8]  * dets[3] - m[9]  * dets[1] + m[10] * dets[0]) * invdet;
-    #endif
-    // clang-format on
+    // adjugates of the inverse's blocks
+    __m128 x = _mm_sub_ps(_mm_mul_ps(detD, a), _Mat2MulSse(b, dc));
+    __m128 w = _mm_sub_ps(_mm_mul_ps(detA, d), _Mat2MulSse(c, ab));
+    __m128 y = _mm_sub_ps(_mm_mul_ps(detB, c), _Mat2MulAdjSse(d, ab));
+    __m128 z = _mm_sub_ps(_mm_mul_ps(detC, b), _Mat2MulAdjSse(a, dc));
 
-    Mat4 ret;
+    // |M| = |A||D| + |B||C| - tr(adj(A)B adj(D)C)
+    __m128 tr = _mm_mul_ps(ab, _mm_shuffle_ps(dc, dc, AK_SWIZZLE(0, 2, 1, 3)));
+    tr = _mm_add_ps(tr, _mm_shuffle_ps(tr, tr, AK_SWIZZLE(1, 0, 3, 2)));
+    tr = _mm_add_ps(tr, _mm_shuffle_ps(tr, tr, AK_SWIZZLE(2, 3, 0, 1)));
+    __m128 const det =
+        _mm_sub_ps(_mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC)), tr);
 
-    __m256 const invdetAvx = _mm256_set1_ps(invdet);
-    __m256 const plusMinus = _mm256_setr_ps(0.0f, -0.0f, 0.0f, -0.0f, -0.0f, 0.0f, -0.0f, 0.0f);
-    __m256 const minusPlus = _mm256_setr_ps(-0.0f, 0.0f, -0.0f, 0.0f, 0.0f, -0.0f, 0.0f, -0.0f);
+    __m128 const invdet = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), det);
+    x = _mm_mul_ps(x, invdet);
+    y = _mm_mul_ps(y, invdet);
+    z = _mm_mul_ps(z, invdet);
+    w = _mm_mul_ps(w, invdet);
 
-    {
-        __m256i const aMask = _mm256_setr_epi32(5, 1, 13, 9, 4, 0, 12, 8);
-        __m256 a = _mm256_i32gather_ps(m, aMask, 4);
-        a = _mm256_xor_ps(plusMinus, a);
+    // the final shuffles apply the block adjugates and reassemble the columns
+    _mm_store_ps(&out.c0.x, _mm_shuffle_ps(x, y, AK_SWIZZLE(3, 1, 3, 1)));
+    _mm_store_ps(&out.c1.x, _mm_shuffle_ps(x, y, AK_SWIZZLE(2, 0, 2, 0)));
+    _mm_store_ps(&out.c2.x, _mm_shuffle_ps(z, w, AK_SWIZZLE(3, 1, 3, 1)));
+    _mm_store_ps(&out.c3.x, _mm_shuffle_ps(z, w, AK_SWIZZLE(2, 0, 2, 0)));
+}
+AK_TARGET_INLINE("sse3") Mat4 InverseSse(Mat4 const& m)
+{
+    Mat4 result;
+    _InverseSse(m, result);
+    return result;
+}
+
+// AVX2, two matrices per register
+AK_TARGET_INLINE("avx2,fma") __m256 _Mat2MulAvx(__m256 const a, __m256 const b)
+{
+    return _mm256_fmadd_ps(a, _mm256_permute_ps(b, AK_SWIZZLE(0, 3, 0, 3)),
+                           _mm256_mul_ps(_mm256_permute_ps(a, AK_SWIZZLE(1, 0, 3, 2)),
+                                         _mm256_permute_ps(b, AK_SWIZZLE(2, 1, 2, 1))));
+}
+AK_TARGET_INLINE("avx2,fma") __m256 _Mat2AdjMulAvx(__m256 const a, __m256 const b)
+{
+    return _mm256_fmsub_ps(_mm256_permute_ps(a, AK_SWIZZLE(3, 3, 0, 0)), b,
+                           _mm256_mul_ps(_mm256_permute_ps(a, AK_SWIZZLE(1, 1, 2, 2)),
+                                         _mm256_permute_ps(b, AK_SWIZZLE(2, 3, 0, 1))));
+}
+AK_TARGET_INLINE("avx2,fma") __m256 _Mat2MulAdjAvx(__m256 const a, __m256 const b)
+{
+    return _mm256_fmsub_ps(a, _mm256_permute_ps(b, AK_SWIZZLE(3, 0, 3, 0)),
+                           _mm256_mul_ps(_mm256_permute_ps(a, AK_SWIZZLE(1, 0, 3, 2)),
+                                         _mm256_permute_ps(b, AK_SWIZZLE(2, 1, 2, 1))));
+}
+AK_TARGET_INLINE("avx2,fma") __m256 _LoadColumnPairAvx(Vec4 const& lo, Vec4 const& hi)
+{
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_load_ps(&lo.x)), _mm_load_ps(&hi.x), 1);
+}
+AK_TARGET_INLINE("avx2,fma") void _StoreColumnPairAvx(Vec4& lo, Vec4& hi, __m256 const v)
+{
+    _mm_store_ps(&lo.x, _mm256_castps256_ps128(v));
+    _mm_store_ps(&hi.x, _mm256_extractf128_ps(v, 1));
+}
+AK_TARGET_INLINE("avx2,fma") void _InverseAvx(Mat4 const& m0, Mat4 const& m1, Mat4& out0,
+                                              Mat4& out1)
+{
+    __m256 const c0 = _LoadColumnPairAvx(m0.c0, m1.c0);
+    __m256 const c1 = _LoadColumnPairAvx(m0.c1, m1.c1);
+    __m256 const c2 = _LoadColumnPairAvx(m0.c2, m1.c2);
+    __m256 const c3 = _LoadColumnPairAvx(m0.c3, m1.c3);
 
-        __m256i const bMask = _mm256_setr_epi32(6, 2, 14, 10, 6, 2, 14, 10);
-        __m256 b = _mm256_i32gather_ps(m, bMask, 4);
-        b = _mm256_xor_ps(minusPlus, b);
+    __m256 const a = _mm256_shuffle_ps(c0, c1, AK_SWIZZLE(0, 1, 0, 1));
+    __m256 const b = _mm256_shuffle_ps(c0, c1, AK_SWIZZLE(2, 3, 2, 3));
+    __m256 const c = _mm256_shuffle_ps(c2, c3, AK_SWIZZLE(0, 1, 0, 1));
+    __m256 const d = _mm256_shuffle_ps(c2, c3, AK_SWIZZLE(2, 3, 2, 3));
 
-        __m256i const cMask = _mm256_setr_epi32(7, 3, 15, 11, 7, 3, 15, 11);
-        __m256 c = _mm256_i32gather_ps(m, cMask, 4);
-        c = _mm256_xor_ps(plusMinus, c);
+    __m256 const dets =
+        _mm256_fmsub_ps(_mm256_shuffle_ps(c0, c2, AK_SWIZZLE(0, 2, 0, 2)),
+                        _mm256_shuffle_ps(c1, c3, AK_SWIZZLE(1, 3, 1, 3)),
+                        _mm256_mul_ps(_mm256_shuffle_ps(c0, c2, AK_SWIZZLE(1, 3, 1, 3)),
+                                      _mm256_shuffle_ps(c1, c3, AK_SWIZZLE(0, 2, 0, 2))));
+    __m256 const detA = _mm256_permute_ps(dets, AK_SWIZZLE(0, 0, 0, 0));
+    __m256 const detB = _mm256_permute_ps(dets, AK_SWIZZLE(1, 1, 1, 1));
+    __m256 const detC = _mm256_permute_ps(dets, AK_SWIZZLE(2, 2, 2, 2));
+    __m256 const detD = _mm256_permute_ps(dets, AK_SWIZZLE(3, 3, 3, 3));
 
-        __m256i const daMask = _mm256_setr_epi32(11, 11, 5, 5, 11, 11, 5, 5);
-        __m256 da = _mm256_i32gather_ps(dets, daMask, 4);
-        __m256i const dbMask = _mm256_setr_epi32(10, 10, 4, 4, 8, 8, 2, 2);
-        __m256 db = _mm256_i32gather_ps(dets, dbMask, 4);
-        __m256i const dcMask = _mm256_setr_epi32(9, 9, 3, 3, 7, 7, 1, 1);
-        __m256 dc = _mm256_i32gather_ps(dets, dcMask, 4);
+    __m256 const dc = _Mat2AdjMulAvx(d, c);
+    __m256 const ab = _Mat2AdjMulAvx(a, b);
 
-        __m256 c0c1 = _mm256_mul_ps(a, da);
-        c0c1 = _mm256_add_ps(c0c1, _mm256_mul_ps(b, db));
-        c0c1 = _mm256_add_ps(c0c1, _mm256_mul_ps(c, dc));
+    __m256 x = _mm256_fmsub_ps(detD, a, _Mat2MulAvx(b, dc));
+    __m256 w = _mm256_fmsub_ps(detA, d, _Mat2MulAvx(c, ab));
+    __m256 y = _mm256_fmsub_ps(detB, c, _Mat2MulAdjAvx(d, ab));
+    __m256 z = _mm256_fmsub_ps(detC, b, _Mat2MulAdjAvx(a, dc));
 
-        c0c1 = _mm256_mul_ps(_mm256_set1_ps(invdet), c0c1);
-        _mm256_store_ps(&ret.c0.x, c0c1);
-    }
+    __m256 tr = _mm256_mul_ps(ab, _mm256_permute_ps(dc, AK_SWIZZLE(0, 2, 1, 3)));
+    tr = _mm256_add_ps(tr, _mm256_permute_ps(tr, AK_SWIZZLE(1, 0, 3, 2)));
+    tr = _mm256_add_ps(tr, _mm256_permute_ps(tr, AK_SWIZZLE(2, 3, 0, 1)));
+    __m256 const det = _mm256_sub_ps(_mm256_fmadd_ps(detA, detD, _mm256_mul_ps(detB, detC)), tr);
 
-    {
-        __m256i const aMask = _mm256_setr_epi32(4, 0, 12, 8, 4, 0, 12, 8);
-        __m256 a = _mm256_i32gather_ps(m, aMask, 4);
-        a = _mm256_xor_ps(plusMinus, a);
+    __m256 const sign = _mm256_setr_ps(1.0f, -1.0f, -1.0f, 1.0f, 1.0f, -1.0f, -1.0f, 1.0f);
+    __m256 const invdet = _mm256_div_ps(sign, det);
+    x = _mm256_mul_ps(x, invdet);
+    y = _mm256_mul_ps(y, invdet);
+    z = _mm256_mul_ps(z, invdet);
+    w = _mm256_mul_ps(w, invdet);
+
+    _StoreColumnPairAvx(out0.c0, out1.c0, _mm256_shuffle_ps(x, y, AK_SWIZZLE(3, 1, 3, 1)));
+    _StoreColumnPairAvx(out0.c1, out1.c1, _mm256_shuffle_ps(x, y, AK_SWIZZLE(2, 0, 2, 0)));
+    _StoreColumnPairAvx(out0.c2, out1.c2, _mm256_shuffle_ps(z, w, AK_SWIZZLE(3, 1, 3, 1)));
+    _StoreColumnPairAvx(out0.c3, out1.c3, _mm256_shuffle_ps(z, w, AK_SWIZZLE(2, 0, 2, 0)));
+}
+
+// AVX-512, four matrices per register
+AK_TARGET_INLINE("avx512f") __m512 _Mat2MulAvx512(__m512 const a, __m512 const b)
+{
+    return _mm512_fmadd_ps(a, _mm512_permute_ps(b, AK_SWIZZLE(0, 3, 0, 3)),
+                           _mm512_mul_ps(_mm512_permute_ps(a, AK_SWIZZLE(1, 0, 3, 2)),
+                                         _mm512_permute_ps(b, AK_SWIZZLE(2, 1, 2, 1))));
+}
+AK_TARGET_INLINE("avx512f") __m512 _Mat2AdjMulAvx512(__m512 const a, __m512 const b)
+{
+    return _mm512_fmsub_ps(_mm512_permute_ps(a, AK_SWIZZLE(3, 3, 0, 0)), b,
+                           _mm512_mul_ps(_mm512_permute_ps(a, AK_SWIZZLE(1, 1, 2, 2)),
+                                         _mm512_permute_ps(b, AK_SWIZZLE(2, 3, 0, 1))));
+}
+AK_TARGET_INLINE("avx512f") __m512 _Mat2MulAdjAvx512(__m512 const a, __m512 const b)
+{
+    return _mm512_fmsub_ps(a, _mm512_permute_ps(b, AK_SWIZZLE(3, 0, 3, 0)),
+                           _mm512_mul_ps(_mm512_permute_ps(a, AK_SWIZZLE(1, 0, 3, 2)),
+                                         _mm512_permute_ps(b, AK_SWIZZLE(2, 1, 2, 1))));
+}
+// Gathers column `column` of four consecutive matrices into one register.
+AK_TARGET_INLINE("avx512f") __m512 _LoadColumnQuadAvx512(Mat4 const* const m, int const column)
+{
+    __m512 v = _mm512_castps128_ps512(_mm_load_ps(&m[0].c0.x + 4 * column));
+    v = _mm512_insertf32x4(v, _mm_load_ps(&m[1].c0.x + 4 * column), 1);
+    v = _mm512_insertf32x4(v, _mm_load_ps(&m[2].c0.x + 4 * column), 2);
+    v = _mm512_insertf32x4(v, _mm_load_ps(&m[3].c0.x + 4 * column), 3);
+    return v;
+}
+AK_TARGET_INLINE("avx512f") void _StoreColumnQuadAvx512(Mat4* const m, int const column,
+                                                        __m512 const v)
+{
+    _mm_store_ps(&m[0].c0.x + 4 * column, _mm512_castps512_ps128(v));
+    _mm_store_ps(&m[1].c0.x + 4 * column, _mm512_extractf32x4_ps(v, 1));
+    _mm_store_ps(&m[2].c0.x + 4 * column, _mm512_extractf32x4_ps(v, 2));
+    _mm_store_ps(&m[3].c0.x + 4 * column, _mm512_extractf32x4_ps(v, 3));
+}
+AK_TARGET_INLINE("avx512f") void _InverseAvx512(Mat4 const* const m, Mat4* const out)
+{
+    __m512 const c0 = _LoadColumnQuadAvx512(m, 0);
+    __m512 const c1 = _LoadColumnQuadAvx512(m, 1);
+    __m512 const c2 = _LoadColumnQuadAvx512(m, 2);
+    __m512 const c3 = _LoadColumnQuadAvx512(m, 3);
 
-        __m256i const bMask = _mm256_setr_epi32(5, 1, 13, 9, 5, 1, 13, 9);
-        __m256 b = _mm256_i32gather_ps(m, bMask, 4);
-        b = _mm256_xor_ps(minusPlus, b);
+    __m512 const a = _mm512_shuffle_ps(c0, c1, AK_SWIZZLE(0, 1, 0, 1));
+    __m512 const b = _mm512_shuffle_ps(c0, c1, AK_SWIZZLE(2, 3, 2, 3));
+    __m512 const c = _mm512_shuffle_ps(c2, c3, AK_SWIZZLE(0, 1, 0, 1));
+    __m512 const d = _mm512_shuffle_ps(c2, c3, AK_SWIZZLE(2, 3, 2, 3));
 
-        __m256i const cMask = _mm256_setr_epi32(7, 3, 15, 11, 6, 2, 14, 10);
-        __m256 c = _mm256_i32gather_ps(m, cMask, 4);
-        c = _mm256_xor_ps(plusMinus, c);
+    __m512 const dets =
+        _mm512_fmsub_ps(_mm512_shuffle_ps(c0, c2, AK_SWIZZLE(0, 2, 0, 2)),
+                        _mm512_shuffle_ps(c1, c3, AK_SWIZZLE(1, 3, 1, 3)),
+                        _mm512_mul_ps(_mm512_shuffle_ps(c0, c2, AK_SWIZZLE(1, 3, 1, 3)),
+                                      _mm512_shuffle_ps(c1, c3, AK_SWIZZLE(0, 2, 0, 2))));
+    __m512 const detA = _mm512_permute_ps(dets, AK_SWIZZLE(0, 0, 0, 0));
+    __m512 const detB = _mm512_permute_ps(dets, AK_SWIZZLE(1, 1, 1, 1));
+    __m512 const detC = _mm512_permute_ps(dets, AK_SWIZZLE(2, 2, 2, 2));
+    __m512 const detD = _mm512_permute_ps(dets, AK_SWIZZLE(3, 3, 3, 3));
 
-        __m256i const daMask = _mm256_setr_epi32(10, 10, 4, 4, 9, 9, 3, 3);
-        __m256 da = _mm256_i32gather_ps(dets, daMask, 4);
-        __m256i const dbMask = _mm256_setr_epi32(8, 8, 2, 2, 7, 7, 1, 1);
-        __m256 db = _mm256_i32gather_ps(dets, dbMask, 4);
-        __m256i const dcMask = _mm256_setr_epi32(6, 6, 0, 0, 6, 6, 0, 0);
-        __m256 dc = _mm256_i32gather_ps(dets, dcMask, 4);
+    __m512 const dc = _Mat2AdjMulAvx512(d, c);
+    __m512 const ab = _Mat2AdjMulAvx512(a, b);
 
-        __m256 c2c3 = _mm256_mul_ps(a, da);
-        c2c3 = _mm256_add_ps(c2c3, _mm256_mul_ps(b, db));
-        c2c3 = _mm256_add_ps(c2c3, _mm256_mul_ps(c, dc));
-        c2c3 = _mm256_mul_ps(invdetAvx, c2c3);
+    __m512 x = _mm512_fmsub_ps(detD, a, _Mat2MulAvx512(b, dc));
+    __m512 w = _mm512_fmsub_ps(detA, d, _Mat2MulAvx512(c, ab));
+    __m512 y = _mm512_fmsub_ps(detB, c, _Mat2MulAdjAvx512(d, ab));
+    __m512 z = _mm512_fmsub_ps(detC, b, _Mat2MulAdjAvx512(a, dc));
 
-        _mm256_store_ps(&ret.c2.x, c2c3);
-    }
+    __m512 tr = _mm512_mul_ps(ab, _mm512_permute_ps(dc, AK_SWIZZLE(0, 2, 1, 3)));
+    tr = _mm512_add_ps(tr, _mm512_permute_ps(tr, AK_SWIZZLE(1, 0, 3, 2)));
+    tr = _mm512_add_ps(tr, _mm512_permute_ps(tr, AK_SWIZZLE(2, 3, 0, 1)));
+    __m512 const det = _mm512_sub_ps(_mm512_fmadd_ps(detA, detD, _mm512_mul_ps(detB, detC)), tr);
 
-    return ret;
+    __m512 const sign = _mm512_broadcast_f32x4(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f));
+    __m512 const invdet = _mm512_div_ps(sign, det);
+    x = _mm512_mul_ps(x, invdet);
+    y = _mm512_mul_ps(y, invdet);
+    z = _mm512_mul_ps(z, invdet);
+    w = _mm512_mul_ps(w, invdet);
+
+    _StoreColumnQuadAvx512(out, 0, _mm512_shuffle_ps(x, y, AK_SWIZZLE(3, 1, 3, 1)));
+    _StoreColumnQuadAvx512(out, 1, _mm512_shuffle_ps(x, y, AK_SWIZZLE(2, 0, 2, 0)));
+    _StoreColumnQuadAvx512(out, 2, _mm512_shuffle_ps(z, w, AK_SWIZZLE(3, 1, 3, 1)));
+    _StoreColumnQuadAvx512(out, 3, _mm512_shuffle_ps(z, w, AK_SWIZZLE(2, 0, 2, 0)));
 }
 
-inline Mat4 Inverse(Mat4 const m)
+inline Mat4 Inverse(Mat4 const& m)
 {
-#if 1
+    if (ActiveSimdLevel() >= SimdLevel::kSse) {
+        return InverseSse(m);
+    }
     return InverseScalar(m);
-#else
-    // TODO: AVX works in Debug, but not in Release
-    return InverseAvx(m);
-#endif
 }
 
-inline Vec4 operator*(Mat4 m, Vec4 const v)
+// Batched inverses: out[i] = Inverse(m[i]). `out` may be the same array as `m`, but must not
+// partially overlap it.
+inline void InverseManyScalar(Mat4 const* const m, Mat4* const out, size_t const n)
 {
-    TransposeInPlace(m);
+    for (size_t ii = 0; ii < n; ++ii) {
+        out[ii] = InverseScalar(m[ii]);
+    }
+}
+AK_TARGET_INLINE("sse3") void InverseManySse(Mat4 const* const m, Mat4* const out, size_t const n)
+{
+    for (size_t ii = 0; ii < n; ++ii) {
+        _InverseSse(m[ii], out[ii]);
+    }
+}
+AK_TARGET_INLINE("avx2,fma")
+void InverseManyAvx(Mat4 const* const m, Mat4* const out, size_t const n)
+{
+    size_t ii = 0;
+    for (; ii + 2 <= n; ii += 2) {
+        _InverseAvx(m[ii], m[ii + 1], out[ii], out[ii + 1]);
+    }
+    if (ii < n) {
+        _InverseSse(m[ii], out[ii]);
+    }
+}
+AK_TARGET_INLINE("avx512f") void InverseManyAvx512(Mat4 const* const m, Mat4* const out,
+                                                   size_t const n)
+{
+    size_t ii = 0;
+    for (; ii + 4 <= n; ii += 4) {
+        _InverseAvx512(&m[ii], &out[ii]);
+    }
+    for (; ii < n; ++ii) {
+        _InverseSse(m[ii], out[ii]);
+    }
+}
+inline void InverseMany(Mat4 const* const m, Mat4* const out, size_t const n)
+{
+    switch (ActiveSimdLevel()) {
+        case SimdLevel::kAvx512:
+            return InverseManyAvx512(m, out, n);
+        case SimdLevel::kAvx:
+            return InverseManyAvx(m, out, n);
+        case SimdLevel::kSse:
+            return InverseManySse(m, out, n);
+        case SimdLevel::kScalar:
+            break;
+    }
+    InverseManyScalar(m, out, n);
+}
+
+// Fast paths for transforms with a (0, 0, 0, 1) bottom row. InverseAffine inverts the upper 3x3
+// and back-transforms the translation; InverseRigid additionally requires an orthonormal 3x3 and
+// inverts it with a transpose. Debug builds assert the precondition.
+inline bool IsAffine(Mat4 const& m, float const tolerance = 1.0e-5f)
+{
+    return fabsf(m.c0.w) <= tolerance && fabsf(m.c1.w) <= tolerance &&
+           fabsf(m.c2.w) <= tolerance && fabsf(m.c3.w - 1.0f) <= tolerance;
+}
+inline bool IsRigid(Mat4 const& m, float const tolerance = 1.0e-3f)
+{
+    Vec3 const x = {m.c0.x, m.c0.y, m.c0.z};
+    Vec3 const y = {m.c1.x, m.c1.y, m.c1.z};
+    Vec3 const z = {m.c2.x, m.c2.y, m.c2.z};
+    return IsAffine(m) && fabsf(Dot(x, x) - 1.0f) <= tolerance &&
+           fabsf(Dot(y, y) - 1.0f) <= tolerance && fabsf(Dot(z, z) - 1.0f) <= tolerance &&
+           fabsf(Dot(x, y)) <= tolerance && fabsf(Dot(x, z)) <= tolerance &&
+           fabsf(Dot(y, z)) <= tolerance;
+}
+
+inline Mat4 InverseAffineScalar(Mat4 const& m)
+{
+    assert(IsAffine(m));
+    Mat3 const l = Inverse(Mat3{
+        {m.c0.x, m.c0.y, m.c0.z},
+        {m.c1.x, m.c1.y, m.c1.z},
+        {m.c2.x, m.c2.y, m.c2.z},
+    });
+    Vec3 const t = -(l * Vec3{m.c3.x, m.c3.y, m.c3.z});
     return {
-        Hadd(m.c0 * v),
-        Hadd(m.c1 * v),
-        Hadd(m.c2 * v),
-        Hadd(m.c3 * v),
+        {l.c0.x, l.c0.y, l.c0.z, 0},
+        {l.c1.x, l.c1.y, l.c1.z, 0},
+        {l.c2.x, l.c2.y, l.c2.z, 0},
+        {t.x, t.y, t.z, 1},
+    };
+}
+inline Mat4 InverseRigidScalar(Mat4 const& m)
+{
+    assert(IsRigid(m));
+    Vec3 const x = {m.c0.x, m.c0.y, m.c0.z};
+    Vec3 const y = {m.c1.x, m.c1.y, m.c1.z};
+    Vec3 const z = {m.c2.x, m.c2.y, m.c2.z};
+    Vec3 const t = {m.c3.x, m.c3.y, m.c3.z};
+    return {
+        {x.x, y.x, z.x, 0},
+        {x.y, y.y, z.y, 0},
+        {x.z, y.z, z.z, 0},
+        {-Dot(x, t), -Dot(y, t), -Dot(z, t), 1},
     };
 }
 
+// SSE. Both kernels build the rows of the 3x3 inverse, transpose them into columns and transform
+// the translation by the result.
+AK_FORCEINLINE __m128 _Cross3Sse(__m128 const a, __m128 const b)
+{
+    __m128 const aYzx = _mm_shuffle_ps(a, a, AK_SWIZZLE(1, 2, 0, 3));
+    __m128 const bYzx = _mm_shuffle_ps(b, b, AK_SWIZZLE(1, 2, 0, 3));
+    __m128 const c = _mm_sub_ps(_mm_mul_ps(a, bYzx), _mm_mul_ps(aYzx, b));
+    return _mm_shuffle_ps(c, c, AK_SWIZZLE(1, 2, 0, 3));
+}
+AK_TARGET_INLINE("sse3") void _StoreAffineInverseSse(__m128 r0, __m128 r1, __m128 r2,
+                                                     __m128 const t, Mat4& out)
+{
+    __m128 r3 = _mm_setzero_ps();
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    __m128 tr = _mm_mul_ps(r0, _mm_shuffle_ps(t, t, AK_SWIZZLE(0, 0, 0, 0)));
+    tr = _mm_add_ps(tr, _mm_mul_ps(r1, _mm_shuffle_ps(t, t, AK_SWIZZLE(1, 1, 1, 1))));
+    tr = _mm_add_ps(tr, _mm_mul_ps(r2, _mm_shuffle_ps(t, t, AK_SWIZZLE(2, 2, 2, 2))));
+    tr = _mm_sub_ps(_mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f), tr);
+    _mm_store_ps(&out.c0.x, r0);
+    _mm_store_ps(&out.c1.x, r1);
+    _mm_store_ps(&out.c2.x, r2);
+    _mm_store_ps(&out.c3.x, tr);
+}
+AK_TARGET_INLINE("sse3") void _InverseAffineSse(Mat4 const& m, Mat4& out)
+{
+    __m128 const a = _mm_load_ps(&m.c0.x);
+    __m128 const b = _mm_load_ps(&m.c1.x);
+    __m128 const c = _mm_load_ps(&m.c2.x);
+    __m128 const t = _mm_load_ps(&m.c3.x);
+
+    // rows of the adjugate; w is 0 because the columns' w is 0
+    __m128 r0 = _Cross3Sse(b, c);
+    __m128 r1 = _Cross3Sse(c, a);
+    __m128 r2 = _Cross3Sse(a, b);
+
+    __m128 det = _mm_mul_ps(a, r0);
+    det = _mm_add_ps(det, _mm_shuffle_ps(det, det, AK_SWIZZLE(1, 0, 3, 2)));
+    det = _mm_add_ps(det, _mm_shuffle_ps(det, det, AK_SWIZZLE(2, 3, 0, 1)));
+    __m128 const invdet = _mm_div_ps(_mm_set1_ps(1.0f), det);
+    r0 = _mm_mul_ps(r0, invdet);
+    r1 = _mm_mul_ps(r1, invdet);
+    r2 = _mm_mul_ps(r2, invdet);
+
+    _StoreAffineInverseSse(r0, r1, r2, t, out);
+}
+AK_TARGET_INLINE("sse3") void _InverseRigidSse(Mat4 const& m, Mat4& out)
+{
+    _StoreAffineInverseSse(_mm_load_ps(&m.c0.x), _mm_load_ps(&m.c1.x), _mm_load_ps(&m.c2.x),
+                           _mm_load_ps(&m.c3.x), out);
+}
+AK_TARGET_INLINE("sse3") Mat4 InverseAffineSse(Mat4 const& m)
+{
+    assert(IsAffine(m));
+    Mat4 result;
+    _InverseAffineSse(m, result);
+    return result;
+}
+AK_TARGET_INLINE("sse3") Mat4 InverseRigidSse(Mat4 const& m)
+{
+    assert(IsRigid(m));
+    Mat4 result;
+    _InverseRigidSse(m, result);
+    return result;
+}
+
+// AVX2, two matrices per register
+AK_TARGET_INLINE("avx2,fma") __m256 _Cross3Avx(__m256 const a, __m256 const b)
+{
+    __m256 const aYzx = _mm256_permute_ps(a, AK_SWIZZLE(1, 2, 0, 3));
+    __m256 const bYzx = _mm256_permute_ps(b, AK_SWIZZLE(1, 2, 0, 3));
+    __m256 const c = _mm256_fmsub_ps(a, bYzx, _mm256_mul_ps(aYzx, b));
+    return _mm256_permute_ps(c, AK_SWIZZLE(1, 2, 0, 3));
+}
+AK_TARGET_INLINE("avx2,fma") void _StoreAffineInversePairAvx(__m256 const r0, __m256 const r1,
+                                                             __m256 const r2, __m256 const t,
+                                                             Mat4& out0, Mat4& out1)
+{
+    __m256 const zero = _mm256_setzero_ps();
+    __m256 const t0 = _mm256_unpacklo_ps(r0, r1);
+    __m256 const t1 = _mm256_unpacklo_ps(r2, zero);
+    __m256 const t2 = _mm256_unpackhi_ps(r0, r1);
+    __m256 const t3 = _mm256_unpackhi_ps(r2, zero);
+    __m256 const c0 = _mm256_shuffle_ps(t0, t1, AK_SWIZZLE(0, 1, 0, 1));
+    __m256 const c1 = _mm256_shuffle_ps(t0, t1, AK_SWIZZLE(2, 3, 2, 3));
+    __m256 const c2 = _mm256_shuffle_ps(t2, t3, AK_SWIZZLE(0, 1, 0, 1));
+
+    __m256 tr = _mm256_mul_ps(c0, _mm256_permute_ps(t, AK_SWIZZLE(0, 0, 0, 0)));
+    tr = _mm256_fmadd_ps(c1, _mm256_permute_ps(t, AK_SWIZZLE(1, 1, 1, 1)), tr);
+    tr = _mm256_fmadd_ps(c2, _mm256_permute_ps(t, AK_SWIZZLE(2, 2, 2, 2)), tr);
+    tr = _mm256_sub_ps(_mm256_setr_ps(0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f), tr);
+
+    _StoreColumnPairAvx(out0.c0, out1.c0, c0);
+    _StoreColumnPairAvx(out0.c1, out1.c1, c1);
+    _StoreColumnPairAvx(out0.c2, out1.c2, c2);
+    _StoreColumnPairAvx(out0.c3, out1.c3, tr);
+}
+AK_TARGET_INLINE("avx2,fma") void _InverseAffineAvx(Mat4 const& m0, Mat4 const& m1, Mat4& out0,
+                                                    Mat4& out1)
+{
+    __m256 const a = _LoadColumnPairAvx(m0.c0, m1.c0);
+    __m256 const b = _LoadColumnPairAvx(m0.c1, m1.c1);
+    __m256 const c = _LoadColumnPairAvx(m0.c2, m1.c2);
+    __m256 const t = _LoadColumnPairAvx(m0.c3, m1.c3);
+
+    __m256 r0 = _Cross3Avx(b, c);
+    __m256 r1 = _Cross3Avx(c, a);
+    __m256 r2 = _Cross3Avx(a, b);
+
+    __m256 det = _mm256_mul_ps(a, r0);
+    det = _mm256_add_ps(det, _mm256_permute_ps(det, AK_SWIZZLE(1, 0, 3, 2)));
+    det = _mm256_add_ps(det, _mm256_permute_ps(det, AK_SWIZZLE(2, 3, 0, 1)));
+    __m256 const invdet = _mm256_div_ps(_mm256_set1_ps(1.0f), det);
+    r0 = _mm256_mul_ps(r0, invdet);
+    r1 = _mm256_mul_ps(r1, invdet);
+    r2 = _mm256_mul_ps(r2, invdet);
+
+    _StoreAffineInversePairAvx(r0, r1, r2, t, out0, out1);
+}
+AK_TARGET_INLINE("avx2,fma") void _InverseRigidAvx(Mat4 const& m0, Mat4 const& m1, Mat4& out0,
+                                                   Mat4& out1)
+{
+    _StoreAffineInversePairAvx(_LoadColumnPairAvx(m0.c0, m1.c0), _LoadColumnPairAvx(m0.c1, m1.c1),
+                               _LoadColumnPairAvx(m0.c2, m1.c2), _LoadColumnPairAvx(m0.c3, m1.c3),
+                               out0, out1);
+}
+
+inline Mat4 InverseAffine(Mat4 const& m)
+{
+    if (ActiveSimdLevel() >= SimdLevel::kSse) {
+        return InverseAffineSse(m);
+    }
+    return InverseAffineScalar(m);
+}
+inline Mat4 InverseRigid(Mat4 const& m)
+{
+    if (ActiveSimdLevel() >= SimdLevel::kSse) {
+        return InverseRigidSse(m);
+    }
+    return InverseRigidScalar(m);
+}
+
+// Batched forms, with the same aliasing rules as InverseMany. AVX-512 hosts use the AVX2 kernels.
+inline void InverseAffineManyScalar(Mat4 const* const m, Mat4* const out, size_t const n)
+{
+    for (size_t ii = 0; ii < n; ++ii) {
+        out[ii] = InverseAffineScalar(m[ii]);
+    }
+}
+AK_TARGET_INLINE("sse3")
+void InverseAffineManySse(Mat4 const* const m, Mat4* const out, size_t const n)
+{
+    for (size_t ii = 0; ii < n; ++ii) {
+        assert(IsAffine(m[ii]));
+        _InverseAffineSse(m[ii], out[ii]);
+    }
+}
+AK_TARGET_INLINE("avx2,fma")
+void InverseAffineManyAvx(Mat4 const* const m, Mat4* const out, size_t const n)
+{
+    size_t ii = 0;
+    for (; ii + 2 <= n; ii += 2) {
+        assert(IsAffine(m[ii]) && IsAffine(m[ii + 1]));
+        _InverseAffineAvx(m[ii], m[ii + 1], out[ii], out[ii + 1]);
+    }
+    if (ii < n) {
+        assert(IsAffine(m[ii]));
+        _InverseAffineSse(m[ii], out[ii]);
+    }
+}
+inline void InverseAffineMany(Mat4 const* const m, Mat4* const out, size_t const n)
+{
+    switch (ActiveSimdLevel()) {
+        case SimdLevel::kAvx512:
+        case SimdLevel::kAvx:
+            return InverseAffineManyAvx(m, out, n);
+        case SimdLevel::kSse:
+            return InverseAffineManySse(m, out, n);
+        case SimdLevel::kScalar:
+            break;
+    }
+    InverseAffineManyScalar(m, out, n);
+}
+
+inline void InverseRigidManyScalar(Mat4 const* const m, Mat4* const out, size_t const n)
+{
+    for (size_t ii = 0; ii < n; ++ii) {
+        out[ii] = InverseRigidScalar(m[ii]);
+    }
+}
+AK_TARGET_INLINE("sse3")
+void InverseRigidManySse(Mat4 const* const m, Mat4* const out, size_t const n)
+{
+    for (size_t ii = 0; ii < n; ++ii) {
+        assert(IsRigid(m[ii]));
+        _InverseRigidSse(m[ii], out[ii]);
+    }
+}
+AK_TARGET_INLINE("avx2,fma")
+void InverseRigidManyAvx(Mat4 const* const m, Mat4* const out, size_t const n)
+{
+    size_t ii = 0;
+    for (; ii + 2 <= n; ii += 2) {
+        assert(IsRigid(m[ii]) && IsRigid(m[ii + 1]));
+        _InverseRigidAvx(m[ii], m[ii + 1], out[ii], out[ii + 1]);
+    }
+    if (ii < n) {
+        assert(IsRigid(m[ii]));
+        _InverseRigidSse(m[ii], out[ii]);
+    }
+}
+inline void InverseRigidMany(Mat4 const* const m, Mat4* const out, size_t const n)
+{
+    switch (ActiveSimdLevel()) {
+        case SimdLevel::kAvx512:
+        case SimdLevel::kAvx:
+            return InverseRigidManyAvx(m, out, n);
+        case SimdLevel::kSse:
+            return InverseRigidManySse(m, out, n);
+        case SimdLevel::kScalar:
+            break;
+    }
+    InverseRigidManyScalar(m, out, n);
+}
+
+// Matrix-vector products broadcast each vector component against a matrix column, so the matrix is
+// never transposed. SSE2 is part of x86-64, so the single-vector forms use it unconditionally.
+AK_FORCEINLINE __m128 _TransformSse(Mat4 const& m, __m128 const x, __m128 const y, __m128 const z)
+{
+    __m128 r = _mm_mul_ps(_mm_load_ps(&m.c0.x), x);
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_load_ps(&m.c1.x), y));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_load_ps(&m.c2.x), z));
+    return r;
+}
+AK_FORCEINLINE Vec4 operator*(Mat4 const& m, Vec4 const v)
+{
+    __m128 const r =
+        _mm_add_ps(_TransformSse(m, _mm_set1_ps(v.x), _mm_set1_ps(v.y), _mm_set1_ps(v.z)),
+                   _mm_mul_ps(_mm_load_ps(&m.c3.x), _mm_set1_ps(v.w)));
+    Vec4 result;
+    _mm_store_ps(&result.x, r);
+    return result;
+}
+AK_FORCEINLINE Vec4x operator*(Mat4 const& m, Vec4x const v)
+{
+    __m128 const r = _TransformSse(m, _mm_shuffle_ps(v.v, v.v, AK_SWIZZLE(0, 0, 0, 0)),
+                                   _mm_shuffle_ps(v.v, v.v, AK_SWIZZLE(1, 1, 1, 1)),
+                                   _mm_shuffle_ps(v.v, v.v, AK_SWIZZLE(2, 2, 2, 2)));
+    return {_mm_add_ps(r, _mm_mul_ps(_mm_load_ps(&m.c3.x),
+                                     _mm_shuffle_ps(v.v, v.v, AK_SWIZZLE(3, 3, 3, 3))))};
+}
+// m * (p, 1)
+AK_FORCEINLINE Vec3 TransformPoint(Mat4 const& m, Vec3 const p)
+{
+    __m128 const r = _mm_add_ps(
+        _TransformSse(m, _mm_set1_ps(p.x), _mm_set1_ps(p.y), _mm_set1_ps(p.z)),
+        _mm_load_ps(&m.c3.x));
+    Vec4 result;
+    _mm_store_ps(&result.x, r);
+    return {result.x, result.y, result.z};
+}
+// m * (d, 0)
+AK_FORCEINLINE Vec3 TransformDirection(Mat4 const& m, Vec3 const d)
+{
+    __m128 const r = _TransformSse(m, _mm_set1_ps(d.x), _mm_set1_ps(d.y), _mm_set1_ps(d.z));
+    Vec4 result;
+    _mm_store_ps(&result.x, r);
+    return {result.x, result.y, result.z};
+}
+
+// Batched transforms. `out` may be the same array as `in`, but must not partially overlap it.
+//
+// Vec4 arrays use the column-broadcast form with several vectors per register. Vec3 arrays are
+// transposed to x/y/z registers four (SSE) or eight (AVX2) points at a time, transformed with one
+// multiply-add per matrix element and transposed back.
+inline void TransformManyScalar(Mat4 const& m, Vec4 const* const in, Vec4* const out,
+                                size_t const n)
+{
+    for (size_t ii = 0; ii < n; ++ii) {
+        Vec4 const v = in[ii];
+        out[ii] = m.c0 * v.x + m.c1 * v.y + m.c2 * v.z + m.c3 * v.w;
+    }
+}
+inline void TransformManySse(Mat4 const& m, Vec4 const* const in, Vec4* const out, size_t const n)
+{
+    __m128 const c0 = _mm_load_ps(&m.c0.x);
+    __m128 const c1 = _mm_load_ps(&m.c1.x);
+    __m128 const c2 = _mm_load_ps(&m.c2.x);
+    __m128 const c3 = _mm_load_ps(&m.c3.x);
+    for (size_t ii = 0; ii < n; ++ii) {
+        __m128 const v = _mm_load_ps(&in[ii].x);
+        __m128 r = _mm_mul_ps(c0, _mm_shuffle_ps(v, v, AK_SWIZZLE(0, 0, 0, 0)));
+        r = _mm_add_ps(r, _mm_mul_ps(c1, _mm_shuffle_ps(v, v, AK_SWIZZLE(1, 1, 1, 1))));
+        r = _mm_add_ps(r, _mm_mul_ps(c2, _mm_shuffle_ps(v, v, AK_SWIZZLE(2, 2, 2, 2))));
+        r = _mm_add_ps(r, _mm_mul_ps(c3, _mm_shuffle_ps(v, v, AK_SWIZZLE(3, 3, 3, 3))));
+        _mm_store_ps(&out[ii].x, r);
+    }
+}
+AK_TARGET_INLINE("avx2,fma")
+void TransformManyAvx(Mat4 const& m, Vec4 const* const in, Vec4* const out, size_t const n)
+{
+    __m256 const c0 = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(&m.c0.x));
+    __m256 const c1 = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(&m.c1.x));
+    __m256 const c2 = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(&m.c2.x));
+    __m256 const c3 = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(&m.c3.x));
+    size_t ii = 0;
+    for (; ii + 2 <= n; ii += 2) {
+        __m256 const v = _mm256_loadu_ps(&in[ii].x);
+        __m256 r = _mm256_mul_ps(c0, _mm256_permute_ps(v, AK_SWIZZLE(0, 0, 0, 0)));
+        r = _mm256_fmadd_ps(c1, _mm256_permute_ps(v, AK_SWIZZLE(1, 1, 1, 1)), r);
+        r = _mm256_fmadd_ps(c2, _mm256_permute_ps(v, AK_SWIZZLE(2, 2, 2, 2)), r);
+        r = _mm256_fmadd_ps(c3, _mm256_permute_ps(v, AK_SWIZZLE(3, 3, 3, 3)), r);
+        _mm256_storeu_ps(&out[ii].x, r);
+    }
+    if (ii < n) {
+        TransformManySse(m, in + ii, out + ii, n - ii);
+    }
+}
+AK_TARGET_INLINE("avx512f")
+void TransformManyAvx512(Mat4 const& m, Vec4 const* const in, Vec4* const out, size_t const n)
+{
+    __m512 const c0 = _BroadcastColumnAvx512(m.c0);
+    __m512 const c1 = _BroadcastColumnAvx512(m.c1);
+    __m512 const c2 = _BroadcastColumnAvx512(m.c2);
+    __m512 const c3 = _BroadcastColumnAvx512(m.c3);
+    size_t ii = 0;
+    for (; ii + 4 <= n; ii += 4) {
+        __m512 const v = _mm512_loadu_ps(&in[ii].x);
+        __m512 r = _mm512_mul_ps(c0, _mm512_permute_ps(v, AK_SWIZZLE(0, 0, 0, 0)));
+        r = _mm512_fmadd_ps(c1, _mm512_permute_ps(v, AK_SWIZZLE(1, 1, 1, 1)), r);
+        r = _mm512_fmadd_ps(c2, _mm512_permute_ps(v, AK_SWIZZLE(2, 2, 2, 2)), r);
+        r = _mm512_fmadd_ps(c3, _mm512_permute_ps(v, AK_SWIZZLE(3, 3, 3, 3)), r);
+        _mm512_storeu_ps(&out[ii].x, r);
+    }
+    if (ii < n) {
+        TransformManySse(m, in + ii, out + ii, n - ii);
+    }
+}
+// out[i] = m * in[i]
+inline void TransformMany(Mat4 const& m, Vec4 const* const in, Vec4* const out, size_t const n)
+{
+    switch (ActiveSimdLevel()) {
+        case SimdLevel::kAvx512:
+            return TransformManyAvx512(m, in, out, n);
+        case SimdLevel::kAvx:
+            return TransformManyAvx(m, in, out, n);
+        case SimdLevel::kSse:
+            return TransformManySse(m, in, out, n);
+        case SimdLevel::kScalar:
+            break;
+    }
+    TransformManyScalar(m, in, out, n);
+}
+
+/*****************************************************************************\
+ * Vec3 packets                                                               *
+\*****************************************************************************/
+// Four packed Vec3s (12 floats) <-> x, y and z registers
+inline void _LoadVec3x4Sse(Vec3 const* const p, __m128& x, __m128& y, __m128& z)
+{
+    __m128 const a = _mm_loadu_ps(&p[0].x);  // x0 y0 z0 x1
+    __m128 const b = _mm_loadu_ps(&p[1].y);  // y1 z1 x2 y2
+    __m128 const c = _mm_loadu_ps(&p[2].z);  // z2 x3 y3 z3
+    x = _mm_shuffle_ps(_mm_shuffle_ps(a, a, AK_SWIZZLE(0, 3, 0, 3)),
+                       _mm_shuffle_ps(b, c, AK_SWIZZLE(2, 2, 1, 1)), AK_SWIZZLE(0, 1, 0, 2));
+    y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, AK_SWIZZLE(1, 1, 0, 3)),
+                       _mm_shuffle_ps(b, c, AK_SWIZZLE(3, 3, 2, 2)), AK_SWIZZLE(0, 2, 0, 2));
+    z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, AK_SWIZZLE(2, 2, 1, 1)),
+                       _mm_shuffle_ps(c, c, AK_SWIZZLE(0, 0, 3, 3)), AK_SWIZZLE(0, 2, 0, 2));
+}
+inline void _StoreVec3x4Sse(Vec3* const p, __m128 const x, __m128 const y, __m128 const z)
+{
+    __m128 const a = _mm_shuffle_ps(_mm_shuffle_ps(x, y, AK_SWIZZLE(0, 0, 0, 0)),
+                                    _mm_shuffle_ps(z, x, AK_SWIZZLE(0, 0, 1, 1)),
+                                    AK_SWIZZLE(0, 2, 0, 2));
+    __m128 const b = _mm_shuffle_ps(_mm_shuffle_ps(y, z, AK_SWIZZLE(1, 1, 1, 1)),
+                                    _mm_shuffle_ps(x, y, AK_SWIZZLE(2, 2, 2, 2)),
+                                    AK_SWIZZLE(0, 2, 0, 2));
+    __m128 const c = _mm_shuffle_ps(_mm_shuffle_ps(z, x, AK_SWIZZLE(2, 2, 3, 3)),
+                                    _mm_shuffle_ps(y, z, AK_SWIZZLE(3, 3, 3, 3)),
+                                    AK_SWIZZLE(0, 2, 0, 2));
+    _mm_storeu_ps(&p[0].x, a);
+    _mm_storeu_ps(&p[1].y, b);
+    _mm_storeu_ps(&p[2].z, c);
+}
+
+// Eight packed Vec3s (24 floats) <-> x, y and z registers
+AK_TARGET_INLINE("avx2,fma")
+void _LoadVec3x8Avx(Vec3 const* const p, __m256& x, __m256& y, __m256& z)
+{
+    float const* const f = &p[0].x;
+    __m256 const m03 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(f + 0)),
+                                            _mm_loadu_ps(f + 12), 1);
+    __m256 const m14 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(f + 4)),
+                                            _mm_loadu_ps(f + 16), 1);
+    __m256 const m25 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(f + 8)),
+                                            _mm_loadu_ps(f + 20), 1);
+    __m256 const xy = _mm256_shuffle_ps(m14, m25, AK_SWIZZLE(2, 3, 1, 2));
+    __m256 const yz = _mm256_shuffle_ps(m03, m14, AK_SWIZZLE(1, 2, 0, 1));
+    x = _mm256_shuffle_ps(m03, xy, AK_SWIZZLE(0, 3, 0, 2));
+    y = _mm256_shuffle_ps(yz, xy, AK_SWIZZLE(0, 2, 1, 3));
+    z = _mm256_shuffle_ps(yz, m25, AK_SWIZZLE(1, 3, 0, 3));
+}
+AK_TARGET_INLINE("avx2,fma")
+void _StoreVec3x8Avx(Vec3* const p, __m256 const x, __m256 const y, __m256 const z)
+{
+    float* const f = &p[0].x;
+    __m256 const xy = _mm256_shuffle_ps(x, y, AK_SWIZZLE(0, 2, 0, 2));
+    __m256 const yz = _mm256_shuffle_ps(y, z, AK_SWIZZLE(1, 3, 1, 3));
+    __m256 const zx = _mm256_shuffle_ps(z, x, AK_SWIZZLE(0, 2, 1, 3));
+    __m256 const m03 = _mm256_shuffle_ps(xy, zx, AK_SWIZZLE(0, 2, 0, 2));
+    __m256 const m14 = _mm256_shuffle_ps(yz, xy, AK_SWIZZLE(0, 2, 1, 3));
+    __m256 const m25 = _mm256_shuffle_ps(zx, yz, AK_SWIZZLE(1, 3, 1, 3));
+    _mm_storeu_ps(f + 0, _mm256_castps256_ps128(m03));
+    _mm_storeu_ps(f + 4, _mm256_castps256_ps128(m14));
+    _mm_storeu_ps(f + 8, _mm256_castps256_ps128(m25));
+    _mm_storeu_ps(f + 12, _mm256_extractf128_ps(m03, 1));
+    _mm_storeu_ps(f + 16, _mm256_extractf128_ps(m14, 1));
+    _mm_storeu_ps(f + 20, _mm256_extractf128_ps(m25, 1));
+}
+
+// Sixteen packed Vec3s (48 floats) <-> x, y and z registers. Each component takes two two-source
+// permutes: one over the first 32 floats, one merging in the last 16.
+AK_TARGET_INLINE("avx512f")
+void _LoadVec3x16Avx512(Vec3 const* const p, __m512& x, __m512& y, __m512& z)
+{
+    float const* const f = &p[0].x;
+    __m512 const a = _mm512_loadu_ps(f + 0);
+    __m512 const b = _mm512_loadu_ps(f + 16);
+    __m512 const c = _mm512_loadu_ps(f + 32);
+    __m512i const x0 = _mm512_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21, 24, 27, 30, 0, 0, 0, 0, 0);
+    __m512i const y0 = _mm512_setr_epi32(1, 4, 7, 10, 13, 16, 19, 22, 25, 28, 31, 0, 0, 0, 0, 0);
+    __m512i const z0 = _mm512_setr_epi32(2, 5, 8, 11, 14, 17, 20, 23, 26, 29, 0, 0, 0, 0, 0, 0);
+    __m512i const x1 = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 17, 20, 23, 26, 29);
+    __m512i const y1 = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 18, 21, 24, 27, 30);
+    __m512i const z1 = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 16, 19, 22, 25, 28, 31);
+    x = _mm512_permutex2var_ps(_mm512_permutex2var_ps(a, x0, b), x1, c);
+    y = _mm512_permutex2var_ps(_mm512_permutex2var_ps(a, y0, b), y1, c);
+    z = _mm512_permutex2var_ps(_mm512_permutex2var_ps(a, z0, b), z1, c);
+}
+// The first permute interleaves x and y, the second fills in z
+AK_TARGET_INLINE("avx512f")
+void _StoreVec3x16Avx512(Vec3* const p, __m512 const x, __m512 const y, __m512 const z)
+{
+    float* const f = &p[0].x;
+    __m512i const a0 = _mm512_setr_epi32(0, 16, 0, 1, 17, 0, 2, 18, 0, 3, 19, 0, 4, 20, 0, 5);
+    __m512i const b0 = _mm512_setr_epi32(21, 0, 6, 22, 0, 7, 23, 0, 8, 24, 0, 9, 25, 0, 10, 26);
+    __m512i const c0 = _mm512_setr_epi32(0, 11, 27, 0, 12, 28, 0, 13, 29, 0, 14, 30, 0, 15, 31, 0);
+    __m512i const a1 = _mm512_setr_epi32(0, 1, 16, 3, 4, 17, 6, 7, 18, 9, 10, 19, 12, 13, 20, 15);
+    __m512i const b1 = _mm512_setr_epi32(0, 21, 2, 3, 22, 5, 6, 23, 8, 9, 24, 11, 12, 25, 14, 15);
+    __m512i const c1 = _mm512_setr_epi32(26, 1, 2, 27, 4, 5, 28, 7, 8, 29, 10, 11, 30, 13, 14, 31);
+    _mm512_storeu_ps(f + 0, _mm512_permutex2var_ps(_mm512_permutex2var_ps(x, a0, y), a1, z));
+    _mm512_storeu_ps(f + 16, _mm512_permutex2var_ps(_mm512_permutex2var_ps(x, b0, y), b1, z));
+    _mm512_storeu_ps(f + 32, _mm512_permutex2var_ps(_mm512_permutex2var_ps(x, c0, y), c1, z));
+}
+
+// Vec3x8 and Vec3x16 hold eight (AVX2) or sixteen (AVX-512) Vec3s as x, y and z registers, for
+// kernels that process many vectors in lock-step. Their operations mirror the Vec3 API, with
+// per-vector scalars (Dot, Length) returned as registers. They compile to the named ISA only. Use
+// them inside AK_TARGET_INLINE kernels of the same ISA, since a bare register is returned with that
+// ISA's calling convention, and give the dispatcher a scalar path built on Vec3, as the batched
+// transforms below do.
+struct Vec3x8
+{
+    __m256 x;
+    __m256 y;
+    __m256 z;
+
+    AK_TARGET_INLINE("avx2,fma") static Vec3x8 Splat(Vec3 const v);
+    // Eight packed Vec3s
+    AK_TARGET_INLINE("avx2,fma") static Vec3x8 Load(Vec3 const* const p);
+    // Eight consecutive elements of x, y and z lanes, such as a Vec3SoA's
+    AK_TARGET_INLINE("avx2,fma")
+    static Vec3x8 LoadLanes(float const* const x, float const* const y, float const* const z);
+};
+struct Vec3x16
+{
+    __m512 x;
+    __m512 y;
+    __m512 z;
+
+    AK_TARGET_INLINE("avx512f") static Vec3x16 Splat(Vec3 const v);
+    AK_TARGET_INLINE("avx512f") static Vec3x16 Load(Vec3 const* const p);
+    AK_TARGET_INLINE("avx512f")
+    static Vec3x16 LoadLanes(float const* const x, float const* const y, float const* const z);
+};
+
+AK_TARGET_INLINE("avx2,fma") Vec3x8 Vec3x8::Splat(Vec3 const v)
+{
+    return {_mm256_set1_ps(v.x), _mm256_set1_ps(v.y), _mm256_set1_ps(v.z)};
+}
+AK_TARGET_INLINE("avx2,fma") Vec3x8 Vec3x8::Load(Vec3 const* const p)
+{
+    Vec3x8 r;
+    _LoadVec3x8Avx(p, r.x, r.y, r.z);
+    return r;
+}
+AK_TARGET_INLINE("avx2,fma")
+Vec3x8 Vec3x8::LoadLanes(float const* const x, float const* const y, float const* const z)
+{
+    return {_mm256_loadu_ps(x), _mm256_loadu_ps(y), _mm256_loadu_ps(z)};
+}
+AK_TARGET_INLINE("avx2,fma") void Store(Vec3x8 const v, Vec3* const p)
+{
+    _StoreVec3x8Avx(p, v.x, v.y, v.z);
+}
+AK_TARGET_INLINE("avx2,fma")
+void StoreLanes(Vec3x8 const v, float* const x, float* const y, float* const z)
+{
+    _mm256_storeu_ps(x, v.x);
+    _mm256_storeu_ps(y, v.y);
+    _mm256_storeu_ps(z, v.z);
+}
+
+AK_TARGET_INLINE("avx2,fma") Vec3x8 operator+(Vec3x8 const a, Vec3x8 const b)
+{
+    return {_mm256_add_ps(a.x, b.x), _mm256_add_ps(a.y, b.y), _mm256_add_ps(a.z, b.z)};
+}
+AK_TARGET_INLINE("avx2,fma") Vec3x8 operator-(Vec3x8 const a, Vec3x8 const b)
+{
+    return {_mm256_sub_ps(a.x, b.x), _mm256_sub_ps(a.y, b.y), _mm256_sub_ps(a.z, b.z)};
+}
+AK_TARGET_INLINE("avx2,fma") Vec3x8 operator*(Vec3x8 const a, Vec3x8 const b)
+{
+    return {_mm256_mul_ps(a.x, b.x), _mm256_mul_ps(a.y, b.y), _mm256_mul_ps(a.z, b.z)};
+}
+AK_TARGET_INLINE("avx2,fma") Vec3x8 operator/(Vec3x8 const a, Vec3x8 const b)
+{
+    return {_mm256_div_ps(a.x, b.x), _mm256_div_ps(a.y, b.y), _mm256_div_ps(a.z, b.z)};
+}
+
+// Per-vector scale
+AK_TARGET_INLINE("avx2,fma") Vec3x8 operator*(Vec3x8 const a, __m256 const f)
+{
+    return {_mm256_mul_ps(a.x, f), _mm256_mul_ps(a.y, f), _mm256_mul_ps(a.z, f)};
+}
+AK_TARGET_INLINE("avx2,fma") Vec3x8 operator*(Vec3x8 const a, float const f)
+{
+    return a * _mm256_set1_ps(f);
+}
+AK_TARGET_INLINE("avx2,fma") Vec3x8 operator/(Vec3x8 const a, float const f)
+{
+    __m256 const d = _mm256_set1_ps(f);
+    return {_mm256_div_ps(a.x, d), _mm256_div_ps(a.y, d), _mm256_div_ps(a.z, d)};
+}
+AK_TARGET_INLINE("avx2,fma") Vec3x8 operator-(Vec3x8 const v)
+{
+    __m256 const zero = _mm256_setzero_ps();
+    return {_mm256_sub_ps(zero, v.x), _mm256_sub_ps(zero, v.y), _mm256_sub_ps(zero, v.z)};
+}
+
+// Vec3x8 misc
+AK_TARGET_INLINE("avx2,fma") __m256 Dot(Vec3x8 const a, Vec3x8 const b)
+{
+    return _mm256_fmadd_ps(a.z, b.z, _mm256_fmadd_ps(a.y, b.y, _mm256_mul_ps(a.x, b.x)));
+}
+AK_TARGET_INLINE("avx2,fma") Vec3x8 Cross(Vec3x8 const a, Vec3x8 const b)
+{
+    return {
+        _mm256_fmsub_ps(a.y, b.z, _mm256_mul_ps(a.z, b.y)),
+        _mm256_fmsub_ps(a.z, b.x, _mm256_mul_ps(a.x, b.z)),
+        _mm256_fmsub_ps(a.x, b.y, _mm256_mul_ps(a.y, b.x)),
+    };
+}
+AK_TARGET_INLINE("avx2,fma") __m256 LengthSq(Vec3x8 const a)
+{
+    return Dot(a, a);
+}
+AK_TARGET_INLINE("avx2,fma") __m256 Length(Vec3x8 const a)
+{
+    return _mm256_sqrt_ps(Dot(a, a));
+}
+AK_TARGET_INLINE("avx2,fma") Vec3x8 Normalize(Vec3x8 const v)
+{
+    return v * _mm256_div_ps(_mm256_set1_ps(1.0f), Length(v));
+}
+AK_TARGET_INLINE("avx2,fma") __m256 LengthInvFast(Vec3x8 const v)
+{
+    return _RsqrtFastAvx(Dot(v, v));
+}
+AK_TARGET_INLINE("avx2,fma") Vec3x8 NormalizeFast(Vec3x8 const v)
+{
+    return v * LengthInvFast(v);
+}
+AK_TARGET_INLINE("avx2,fma") Vec3x8 Min(Vec3x8 const a, Vec3x8 const b)
+{
+    return {_mm256_min_ps(a.x, b.x), _mm256_min_ps(a.y, b.y), _mm256_min_ps(a.z, b.z)};
+}
+AK_TARGET_INLINE("avx2,fma") Vec3x8 Max(Vec3x8 const a, Vec3x8 const b)
+{
+    return {_mm256_max_ps(a.x, b.x), _mm256_max_ps(a.y, b.y), _mm256_max_ps(a.z, b.z)};
+}
+AK_TARGET_INLINE("avx2,fma") Vec3x8 Lerp(Vec3x8 const a, Vec3x8 const b, float const t)
+{
+    __m256 const tt = _mm256_set1_ps(t);
+    return {
+        _mm256_fmadd_ps(_mm256_sub_ps(b.x, a.x), tt, a.x),
+        _mm256_fmadd_ps(_mm256_sub_ps(b.y, a.y), tt, a.y),
+        _mm256_fmadd_ps(_mm256_sub_ps(b.z, a.z), tt, a.z),
+    };
+}
+
+// kW is the implicit w: 1 for points, 0 for directions
+template<int kW>
+AK_TARGET_INLINE("avx2,fma") Vec3x8 _TransformVec3x8(Mat4 const& m, Vec3x8 const v)
+{
+    __m256 x = _mm256_fmadd_ps(_mm256_set1_ps(m.c2.x), v.z, _mm256_set1_ps(m.c3.x * kW));
+    __m256 y = _mm256_fmadd_ps(_mm256_set1_ps(m.c2.y), v.z, _mm256_set1_ps(m.c3.y * kW));
+    __m256 z = _mm256_fmadd_ps(_mm256_set1_ps(m.c2.z), v.z, _mm256_set1_ps(m.c3.z * kW));
+    x = _mm256_fmadd_ps(_mm256_set1_ps(m.c1.x), v.y, x);
+    y = _mm256_fmadd_ps(_mm256_set1_ps(m.c1.y), v.y, y);
+    z = _mm256_fmadd_ps(_mm256_set1_ps(m.c1.z), v.y, z);
+    x = _mm256_fmadd_ps(_mm256_set1_ps(m.c0.x), v.x, x);
+    y = _mm256_fmadd_ps(_mm256_set1_ps(m.c0.y), v.x, y);
+    z = _mm256_fmadd_ps(_mm256_set1_ps(m.c0.z), v.x, z);
+    return {x, y, z};
+}
+AK_TARGET_INLINE("avx2,fma") Vec3x8 TransformPoint(Mat4 const& m, Vec3x8 const p)
+{
+    return _TransformVec3x8<1>(m, p);
+}
+AK_TARGET_INLINE("avx2,fma") Vec3x8 TransformDirection(Mat4 const& m, Vec3x8 const d)
+{
+    return _TransformVec3x8<0>(m, d);
+}
+
+AK_TARGET_INLINE("avx512f") Vec3x16 Vec3x16::Splat(Vec3 const v)
+{
+    return {_mm512_set1_ps(v.x), _mm512_set1_ps(v.y), _mm512_set1_ps(v.z)};
+}
+AK_TARGET_INLINE("avx512f") Vec3x16 Vec3x16::Load(Vec3 const* const p)
+{
+    Vec3x16 r;
+    _LoadVec3x16Avx512(p, r.x, r.y, r.z);
+    return r;
+}
+AK_TARGET_INLINE("avx512f")
+Vec3x16 Vec3x16::LoadLanes(float const* const x, float const* const y, float const* const z)
+{
+    return {_mm512_loadu_ps(x), _mm512_loadu_ps(y), _mm512_loadu_ps(z)};
+}
+AK_TARGET_INLINE("avx512f") void Store(Vec3x16 const v, Vec3* const p)
+{
+    _StoreVec3x16Avx512(p, v.x, v.y, v.z);
+}
+AK_TARGET_INLINE("avx512f")
+void StoreLanes(Vec3x16 const v, float* const x, float* const y, float* const z)
+{
+    _mm512_storeu_ps(x, v.x);
+    _mm512_storeu_ps(y, v.y);
+    _mm512_storeu_ps(z, v.z);
+}
+
+AK_TARGET_INLINE("avx512f") Vec3x16 operator+(Vec3x16 const a, Vec3x16 const b)
+{
+    return {_mm512_add_ps(a.x, b.x), _mm512_add_ps(a.y, b.y), _mm512_add_ps(a.z, b.z)};
+}
+AK_TARGET_INLINE("avx512f") Vec3x16 operator-(Vec3x16 const a, Vec3x16 const b)
+{
+    return {_mm512_sub_ps(a.x, b.x), _mm512_sub_ps(a.y, b.y), _mm512_sub_ps(a.z, b.z)};
+}
+AK_TARGET_INLINE("avx512f") Vec3x16 operator*(Vec3x16 const a, Vec3x16 const b)
+{
+    return {_mm512_mul_ps(a.x, b.x), _mm512_mul_ps(a.y, b.y), _mm512_mul_ps(a.z, b.z)};
+}
+AK_TARGET_INLINE("avx512f") Vec3x16 operator/(Vec3x16 const a, Vec3x16 const b)
+{
+    return {_mm512_div_ps(a.x, b.x), _mm512_div_ps(a.y, b.y), _mm512_div_ps(a.z, b.z)};
+}
+
+// Per-vector scale
+AK_TARGET_INLINE("avx512f") Vec3x16 operator*(Vec3x16 const a, __m512 const f)
+{
+    return {_mm512_mul_ps(a.x, f), _mm512_mul_ps(a.y, f), _mm512_mul_ps(a.z, f)};
+}
+AK_TARGET_INLINE("avx512f") Vec3x16 operator*(Vec3x16 const a, float const f)
+{
+    return a * _mm512_set1_ps(f);
+}
+AK_TARGET_INLINE("avx512f") Vec3x16 operator/(Vec3x16 const a, float const f)
+{
+    __m512 const d = _mm512_set1_ps(f);
+    return {_mm512_div_ps(a.x, d), _mm512_div_ps(a.y, d), _mm512_div_ps(a.z, d)};
+}
+AK_TARGET_INLINE("avx512f") Vec3x16 operator-(Vec3x16 const v)
+{
+    __m512 const zero = _mm512_setzero_ps();
+    return {_mm512_sub_ps(zero, v.x), _mm512_sub_ps(zero, v.y), _mm512_sub_ps(zero, v.z)};
+}
+
+// Vec3x16 misc
+AK_TARGET_INLINE("avx512f") __m512 Dot(Vec3x16 const a, Vec3x16 const b)
+{
+    return _mm512_fmadd_ps(a.z, b.z, _mm512_fmadd_ps(a.y, b.y, _mm512_mul_ps(a.x, b.x)));
+}
+AK_TARGET_INLINE("avx512f") Vec3x16 Cross(Vec3x16 const a, Vec3x16 const b)
+{
+    return {
+        _mm512_fmsub_ps(a.y, b.z, _mm512_mul_ps(a.z, b.y)),
+        _mm512_fmsub_ps(a.z, b.x, _mm512_mul_ps(a.x, b.z)),
+        _mm512_fmsub_ps(a.x, b.y, _mm512_mul_ps(a.y, b.x)),
+    };
+}
+AK_TARGET_INLINE("avx512f") __m512 LengthSq(Vec3x16 const a)
+{
+    return Dot(a, a);
+}
+AK_TARGET_INLINE("avx512f") __m512 Length(Vec3x16 const a)
+{
+    return _mm512_sqrt_ps(Dot(a, a));
+}
+AK_TARGET_INLINE("avx512f") Vec3x16 Normalize(Vec3x16 const v)
+{
+    return v * _mm512_div_ps(_mm512_set1_ps(1.0f), Length(v));
+}
+AK_TARGET_INLINE("avx512f") __m512 LengthInvFast(Vec3x16 const v)
+{
+    return _RsqrtFastAvx512(Dot(v, v));
+}
+AK_TARGET_INLINE("avx512f") Vec3x16 NormalizeFast(Vec3x16 const v)
+{
+    return v * LengthInvFast(v);
+}
+AK_TARGET_INLINE("avx512f") Vec3x16 Min(Vec3x16 const a, Vec3x16 const b)
+{
+    return {_mm512_min_ps(a.x, b.x), _mm512_min_ps(a.y, b.y), _mm512_min_ps(a.z, b.z)};
+}
+AK_TARGET_INLINE("avx512f") Vec3x16 Max(Vec3x16 const a, Vec3x16 const b)
+{
+    return {_mm512_max_ps(a.x, b.x), _mm512_max_ps(a.y, b.y), _mm512_max_ps(a.z, b.z)};
+}
+AK_TARGET_INLINE("avx512f") Vec3x16 Lerp(Vec3x16 const a, Vec3x16 const b, float const t)
+{
+    __m512 const tt = _mm512_set1_ps(t);
+    return {
+        _mm512_fmadd_ps(_mm512_sub_ps(b.x, a.x), tt, a.x),
+        _mm512_fmadd_ps(_mm512_sub_ps(b.y, a.y), tt, a.y),
+        _mm512_fmadd_ps(_mm512_sub_ps(b.z, a.z), tt, a.z),
+    };
+}
+
+// kW is the implicit w: 1 for points, 0 for directions
+template<int kW>
+AK_TARGET_INLINE("avx512f") Vec3x16 _TransformVec3x16(Mat4 const& m, Vec3x16 const v)
+{
+    __m512 x = _mm512_fmadd_ps(_mm512_set1_ps(m.c2.x), v.z, _mm512_set1_ps(m.c3.x * kW));
+    __m512 y = _mm512_fmadd_ps(_mm512_set1_ps(m.c2.y), v.z, _mm512_set1_ps(m.c3.y * kW));
+    __m512 z = _mm512_fmadd_ps(_mm512_set1_ps(m.c2.z), v.z, _mm512_set1_ps(m.c3.z * kW));
+    x = _mm512_fmadd_ps(_mm512_set1_ps(m.c1.x), v.y, x);
+    y = _mm512_fmadd_ps(_mm512_set1_ps(m.c1.y), v.y, y);
+    z = _mm512_fmadd_ps(_mm512_set1_ps(m.c1.z), v.y, z);
+    x = _mm512_fmadd_ps(_mm512_set1_ps(m.c0.x), v.x, x);
+    y = _mm512_fmadd_ps(_mm512_set1_ps(m.c0.y), v.x, y);
+    z = _mm512_fmadd_ps(_mm512_set1_ps(m.c0.z), v.x, z);
+    return {x, y, z};
+}
+AK_TARGET_INLINE("avx512f") Vec3x16 TransformPoint(Mat4 const& m, Vec3x16 const p)
+{
+    return _TransformVec3x16<1>(m, p);
+}
+AK_TARGET_INLINE("avx512f") Vec3x16 TransformDirection(Mat4 const& m, Vec3x16 const d)
+{
+    return _TransformVec3x16<0>(m, d);
+}
+
+// Batched Vec3 transforms. kW is the implicit w of the input: 1 for points, 0 for directions.
+template<int kW>
+inline void _TransformVec3ManyScalar(Mat4 const& m, Vec3 const* const in, Vec3* const out,
+                                     size_t const n)
+{
+    for (size_t ii = 0; ii < n; ++ii) {
+        Vec3 const v = in[ii];
+        out[ii] = {
+            m.c0.x * v.x + m.c1.x * v.y + m.c2.x * v.z + m.c3.x * kW,
+            m.c0.y * v.x + m.c1.y * v.y + m.c2.y * v.z + m.c3.y * kW,
+            m.c0.z * v.x + m.c1.z * v.y + m.c2.z * v.z + m.c3.z * kW,
+        };
+    }
+}
+template<int kW>
+inline void _TransformVec3ManySse(Mat4 const& m, Vec3 const* const in, Vec3* const out,
+                                  size_t const n)
+{
+    size_t ii = 0;
+    for (; ii + 4 <= n; ii += 4) {
+        __m128 x, y, z;
+        _LoadVec3x4Sse(in + ii, x, y, z);
+        __m128 ox = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(m.c0.x), x),
+                               _mm_mul_ps(_mm_set1_ps(m.c1.x), y));
+        __m128 oy = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(m.c0.y), x),
+                               _mm_mul_ps(_mm_set1_ps(m.c1.y), y));
+        __m128 oz = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(m.c0.z), x),
+                               _mm_mul_ps(_mm_set1_ps(m.c1.z), y));
+        ox = _mm_add_ps(ox, _mm_add_ps(_mm_mul_ps(_mm_set1_ps(m.c2.x), z),
+                                       _mm_set1_ps(m.c3.x * kW)));
+        oy = _mm_add_ps(oy, _mm_add_ps(_mm_mul_ps(_mm_set1_ps(m.c2.y), z),
+                                       _mm_set1_ps(m.c3.y * kW)));
+        oz = _mm_add_ps(oz, _mm_add_ps(_mm_mul_ps(_mm_set1_ps(m.c2.z), z),
+                                       _mm_set1_ps(m.c3.z * kW)));
+        _StoreVec3x4Sse(out + ii, ox, oy, oz);
+    }
+    _TransformVec3ManyScalar<kW>(m, in + ii, out + ii, n - ii);
+}
+// The packet kernels transform a local copy of the matrix. Stores to `out` can't alias it, so its
+// broadcasts stay in registers across the loop.
+template<int kW>
+AK_TARGET_INLINE("avx2,fma")
+void _TransformVec3ManyAvx(Mat4 const& m, Vec3 const* const in, Vec3* const out, size_t const n)
+{
+    Mat4 const local = m;
+    size_t ii = 0;
+    for (; ii + 8 <= n; ii += 8) {
+        Store(_TransformVec3x8<kW>(local, Vec3x8::Load(in + ii)), out + ii);
+    }
+    _TransformVec3ManySse<kW>(m, in + ii, out + ii, n - ii);
+}
+template<int kW>
+AK_TARGET_INLINE("avx512f")
+void _TransformVec3ManyAvx512(Mat4 const& m, Vec3 const* const in, Vec3* const out,
+                              size_t const n)
+{
+    Mat4 const local = m;
+    size_t ii = 0;
+    for (; ii + 16 <= n; ii += 16) {
+        Store(_TransformVec3x16<kW>(local, Vec3x16::Load(in + ii)), out + ii);
+    }
+    _TransformVec3ManyAvx<kW>(m, in + ii, out + ii, n - ii);
+}
+
+inline void TransformPointsScalar(Mat4 const& m, Vec3 const* const in, Vec3* const out,
+                                  size_t const n)
+{
+    _TransformVec3ManyScalar<1>(m, in, out, n);
+}
+inline void TransformPointsSse(Mat4 const& m, Vec3 const* const in, Vec3* const out, size_t const n)
+{
+    _TransformVec3ManySse<1>(m, in, out, n);
+}
+AK_TARGET_INLINE("avx2,fma")
+void TransformPointsAvx(Mat4 const& m, Vec3 const* const in, Vec3* const out, size_t const n)
+{
+    _TransformVec3ManyAvx<1>(m, in, out, n);
+}
+AK_TARGET_INLINE("avx512f")
+void TransformPointsAvx512(Mat4 const& m, Vec3 const* const in, Vec3* const out, size_t const n)
+{
+    _TransformVec3ManyAvx512<1>(m, in, out, n);
+}
+inline void TransformDirectionsScalar(Mat4 const& m, Vec3 const* const in, Vec3* const out,
+                                      size_t const n)
+{
+    _TransformVec3ManyScalar<0>(m, in, out, n);
+}
+inline void TransformDirectionsSse(Mat4 const& m, Vec3 const* const in, Vec3* const out,
+                                   size_t const n)
+{
+    _TransformVec3ManySse<0>(m, in, out, n);
+}
+AK_TARGET_INLINE("avx2,fma")
+void TransformDirectionsAvx(Mat4 const& m, Vec3 const* const in, Vec3* const out, size_t const n)
+{
+    _TransformVec3ManyAvx<0>(m, in, out, n);
+}
+AK_TARGET_INLINE("avx512f")
+void TransformDirectionsAvx512(Mat4 const& m, Vec3 const* const in, Vec3* const out,
+                               size_t const n)
+{
+    _TransformVec3ManyAvx512<0>(m, in, out, n);
+}
+
+// out[i] = TransformPoint(m, in[i])
+inline void TransformPoints(Mat4 const& m, Vec3 const* const in, Vec3* const out, size_t const n)
+{
+    switch (ActiveSimdLevel()) {
+        case SimdLevel::kAvx512:
+            return TransformPointsAvx512(m, in, out, n);
+        case SimdLevel::kAvx:
+            return TransformPointsAvx(m, in, out, n);
+        case SimdLevel::kSse:
+            return TransformPointsSse(m, in, out, n);
+        case SimdLevel::kScalar:
+            break;
+    }
+    TransformPointsScalar(m, in, out, n);
+}
+// out[i] = TransformDirection(m, in[i])
+inline void TransformDirections(Mat4 const& m, Vec3 const* const in, Vec3* const out,
+                                size_t const n)
+{
+    switch (ActiveSimdLevel()) {
+        case SimdLevel::kAvx512:
+            return TransformDirectionsAvx512(m, in, out, n);
+        case SimdLevel::kAvx:
+            return TransformDirectionsAvx(m, in, out, n);
+        case SimdLevel::kSse:
+            return TransformDirectionsSse(m, in, out, n);
+        case SimdLevel::kScalar:
+            break;
+    }
+    TransformDirectionsScalar(m, in, out, n);
+}
+
+/*****************************************************************************\
+ * Mat4x3                                                                     *
+\*****************************************************************************/
+constexpr inline Mat4x3 Mat4x3::Identity()
+{
+    return {{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}};
+}
+inline Mat4x3 Mat4x3::FromMat4(Mat4 const& m)
+{
+    assert(IsAffine(m));
+    return {
+        {m.c0.x, m.c1.x, m.c2.x, m.c3.x},
+        {m.c0.y, m.c1.y, m.c2.y, m.c3.y},
+        {m.c0.z, m.c1.z, m.c2.z, m.c3.z},
+    };
+}
+inline Mat4x3 Mat4x3::FromTransform(Transform const& t)
+{
+    Mat3 const m = Mat3::Rotation(t.orientation);
+    float const s = t.scale;
+    return {
+        {m.c0.x * s, m.c1.x * s, m.c2.x * s, t.position.x},
+        {m.c0.y * s, m.c1.y * s, m.c2.y * s, t.position.y},
+        {m.c0.z * s, m.c1.z * s, m.c2.z * s, t.position.z},
+    };
+}
+inline Mat4 Mat4::FromMat4x3(Mat4x3 const& m)
+{
+    return {
+        {m.r0.x, m.r1.x, m.r2.x, 0},
+        {m.r0.y, m.r1.y, m.r2.y, 0},
+        {m.r0.z, m.r1.z, m.r2.z, 0},
+        {m.r0.w, m.r1.w, m.r2.w, 1},
+    };
+}
+// The inverse of FromTransform, for a rotation with uniform scale
+inline Transform ToTransform(Mat4x3 const& m)
+{
+    Vec3 const c0 = {m.r0.x, m.r1.x, m.r2.x};
+    float const scale = Length(c0);
+    float const inv = 1.0f / scale;
+    Mat3 const rotation = {
+        c0 * inv,
+        Vec3{m.r0.y, m.r1.y, m.r2.y} * inv,
+        Vec3{m.r0.z, m.r1.z, m.r2.z} * inv,
+    };
+    return {Quat::FromMatrix(rotation), {m.r0.w, m.r1.w, m.r2.w}, scale};
+}
+
+/*
+ * Multiply
+ *
+ * Row i of a * b is a[i][0] * b.r0 + a[i][1] * b.r1 + a[i][2] * b.r2 + (0, 0, 0, a[i][3]): the
+ * implicit bottom rows only carry a's translation through. A product is 9 multiply-adds of
+ * rows against Mat4's 16 of columns, from 6 registers of input against 8. As with Quat, the
+ * single product always uses SSE; MultiplyMany dispatches.
+ */
+constexpr inline Vec4 _MultiplyRowScalar(Vec4 const a, Mat4x3 const& b)
+{
+    return b.r0 * a.x + b.r1 * a.y + b.r2 * a.z + Vec4{0, 0, 0, a.w};
+}
+constexpr inline Mat4x3 MultiplyScalar(Mat4x3 const& a, Mat4x3 const& b)
+{
+    return {_MultiplyRowScalar(a.r0, b), _MultiplyRowScalar(a.r1, b), _MultiplyRowScalar(a.r2, b)};
+}
+AK_FORCEINLINE __m128 _MultiplyRowSse(__m128 const a, __m128 const b0, __m128 const b1,
+                                      __m128 const b2)
+{
+    __m128 r = _mm_and_ps(a, _mm_castsi128_ps(_mm_setr_epi32(0, 0, 0, -1)));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(a, a, AK_SWIZZLE(0, 0, 0, 0)), b0));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(a, a, AK_SWIZZLE(1, 1, 1, 1)), b1));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(a, a, AK_SWIZZLE(2, 2, 2, 2)), b2));
+    return r;
+}
+AK_FORCEINLINE Mat4x3 MultiplySse(Mat4x3 const& a, Mat4x3 const& b)
+{
+    __m128 const b0 = _mm_load_ps(&b.r0.x);
+    __m128 const b1 = _mm_load_ps(&b.r1.x);
+    __m128 const b2 = _mm_load_ps(&b.r2.x);
+    Mat4x3 result;
+    _mm_store_ps(&result.r0.x, _MultiplyRowSse(_mm_load_ps(&a.r0.x), b0, b1, b2));
+    _mm_store_ps(&result.r1.x, _MultiplyRowSse(_mm_load_ps(&a.r1.x), b0, b1, b2));
+    _mm_store_ps(&result.r2.x, _MultiplyRowSse(_mm_load_ps(&a.r2.x), b0, b1, b2));
+    return result;
+}
+AK_FORCEINLINE Mat4x3 operator*(Mat4x3 const& a, Mat4x3 const& b)
+{
+    return MultiplySse(a, b);
+}
+
+// Batched multiplies, with MultiplyMany's aliasing rules for Mat4. Outputs larger than
+// kStreamingStoreBytes are streamed 16 bytes at a time, which the write-combining buffers merge
+// into whole lines.
+inline bool _UseStreamingStores4x3(size_t const n)
+{
+    return n * sizeof(Mat4x3) >= kStreamingStoreBytes;
+}
+
+inline void MultiplyManyScalar(Mat4x3 const* const a, Mat4x3 const* const b, Mat4x3* const out,
+                               size_t const n)
+{
+    for (size_t ii = 0; ii < n; ++ii) {
+        out[ii] = MultiplyScalar(a[ii], b[ii]);
+    }
+}
+inline void MultiplyManySse(Mat4x3 const* const a, Mat4x3 const* const b, Mat4x3* const out,
+                            size_t const n)
+{
+    bool const stream = _UseStreamingStores4x3(n);
+    for (size_t ii = 0; ii < n; ++ii) {
+        __m128 const b0 = _mm_load_ps(&b[ii].r0.x);
+        __m128 const b1 = _mm_load_ps(&b[ii].r1.x);
+        __m128 const b2 = _mm_load_ps(&b[ii].r2.x);
+        __m128 const r0 = _MultiplyRowSse(_mm_load_ps(&a[ii].r0.x), b0, b1, b2);
+        __m128 const r1 = _MultiplyRowSse(_mm_load_ps(&a[ii].r1.x), b0, b1, b2);
+        __m128 const r2 = _MultiplyRowSse(_mm_load_ps(&a[ii].r2.x), b0, b1, b2);
+        _StoreSse(&out[ii].r0.x, r0, stream);
+        _StoreSse(&out[ii].r1.x, r1, stream);
+        _StoreSse(&out[ii].r2.x, r2, stream);
+    }
+    if (stream) {
+        _mm_sfence();
+    }
+}
+// AVX2: rows 0 and 1 of a share a register, against b's rows broadcast to both halves
+AK_TARGET_INLINE("avx2,fma")
+void MultiplyManyAvx(Mat4x3 const* const a, Mat4x3 const* const b, Mat4x3* const out,
+                     size_t const n)
+{
+    bool const stream = _UseStreamingStores4x3(n);
+    __m128 const w = _mm_castsi128_ps(_mm_setr_epi32(0, 0, 0, -1));
+    __m256 const w2 = _mm256_set_m128(w, w);
+    for (size_t ii = 0; ii < n; ++ii) {
+        __m128 const b0 = _mm_load_ps(&b[ii].r0.x);
+        __m128 const b1 = _mm_load_ps(&b[ii].r1.x);
+        __m128 const b2 = _mm_load_ps(&b[ii].r2.x);
+        __m256 const a01 = _mm256_loadu_ps(&a[ii].r0.x);
+        __m128 const a2 = _mm_load_ps(&a[ii].r2.x);
+
+        __m256 r01 = _mm256_and_ps(a01, w2);
+        r01 = _mm256_fmadd_ps(_mm256_permute_ps(a01, AK_SWIZZLE(0, 0, 0, 0)),
+                              _mm256_set_m128(b0, b0), r01);
+        r01 = _mm256_fmadd_ps(_mm256_permute_ps(a01, AK_SWIZZLE(1, 1, 1, 1)),
+                              _mm256_set_m128(b1, b1), r01);
+        r01 = _mm256_fmadd_ps(_mm256_permute_ps(a01, AK_SWIZZLE(2, 2, 2, 2)),
+                              _mm256_set_m128(b2, b2), r01);
+        __m128 r2 = _mm_and_ps(a2, w);
+        r2 = _mm_fmadd_ps(_mm_permute_ps(a2, AK_SWIZZLE(0, 0, 0, 0)), b0, r2);
+        r2 = _mm_fmadd_ps(_mm_permute_ps(a2, AK_SWIZZLE(1, 1, 1, 1)), b1, r2);
+        r2 = _mm_fmadd_ps(_mm_permute_ps(a2, AK_SWIZZLE(2, 2, 2, 2)), b2, r2);
+
+        _StoreSse(&out[ii].r0.x, _mm256_castps256_ps128(r01), stream);
+        _StoreSse(&out[ii].r1.x, _mm256_extractf128_ps(r01, 1), stream);
+        _StoreSse(&out[ii].r2.x, r2, stream);
+    }
+    if (stream) {
+        _mm_sfence();
+    }
+}
+// AVX-512: a whole matrix is the low twelve lanes of a register, against b's rows broadcast to
+// every quarter
+AK_TARGET_INLINE("avx512f")
+void MultiplyManyAvx512(Mat4x3 const* const a, Mat4x3 const* const b, Mat4x3* const out,
+                        size_t const n)
+{
+    bool const stream = _UseStreamingStores4x3(n);
+    __mmask16 const rows = 0x0fff;
+    __mmask16 const w = 0x0888;
+    for (size_t ii = 0; ii < n; ++ii) {
+        __m512 const av = _mm512_maskz_loadu_ps(rows, &a[ii].r0.x);
+        __m512 r = _mm512_maskz_mov_ps(w, av);
+        r = _mm512_fmadd_ps(_mm512_permute_ps(av, AK_SWIZZLE(0, 0, 0, 0)),
+                            _mm512_broadcast_f32x4(_mm_load_ps(&b[ii].r0.x)), r);
+        r = _mm512_fmadd_ps(_mm512_permute_ps(av, AK_SWIZZLE(1, 1, 1, 1)),
+                            _mm512_broadcast_f32x4(_mm_load_ps(&b[ii].r1.x)), r);
+        r = _mm512_fmadd_ps(_mm512_permute_ps(av, AK_SWIZZLE(2, 2, 2, 2)),
+                            _mm512_broadcast_f32x4(_mm_load_ps(&b[ii].r2.x)), r);
+        if (stream) {
+            _mm_stream_ps(&out[ii].r0.x, _mm512_castps512_ps128(r));
+            _mm_stream_ps(&out[ii].r1.x, _mm512_extractf32x4_ps(r, 1));
+            _mm_stream_ps(&out[ii].r2.x, _mm512_extractf32x4_ps(r, 2));
+        } else {
+            _mm512_mask_storeu_ps(&out[ii].r0.x, rows, r);
+        }
+    }
+    if (stream) {
+        _mm_sfence();
+    }
+}
+
+// out[i] = a[i] * b[i]
+inline void MultiplyMany(Mat4x3 const* const a, Mat4x3 const* const b, Mat4x3* const out,
+                         size_t const n)
+{
+    switch (ActiveSimdLevel()) {
+        case SimdLevel::kAvx512:
+            return MultiplyManyAvx512(a, b, out, n);
+        case SimdLevel::kAvx:
+            return MultiplyManyAvx(a, b, out, n);
+        case SimdLevel::kSse:
+            return MultiplyManySse(a, b, out, n);
+        case SimdLevel::kScalar:
+            break;
+    }
+    MultiplyManyScalar(a, b, out, n);
+}
+
+/*
+ * Inverse
+ *
+ * Every Mat4x3 is affine, so Inverse is InverseAffine's method: the 3x3 inverse's columns are the
+ * cross products of its rows over the determinant, and the translation is back-transformed.
+ * InverseRigid requires an orthonormal 3x3, whose inverse is its transpose. The SSE forms
+ * transpose the 3x3 columns and the new translation into rows in one step.
+ */
+inline Mat4x3 InverseScalar(Mat4x3 const& m)
+{
+    Mat4 const inverse = InverseAffineScalar(Mat4::FromMat4x3(m));
+    return Mat4x3::FromMat4(inverse);
+}
+inline Mat4x3 InverseRigidScalar(Mat4x3 const& m)
+{
+    assert(IsRigid(Mat4::FromMat4x3(m)));
+    Vec3 const t = {m.r0.w, m.r1.w, m.r2.w};
+    Vec3 const x = {m.r0.x, m.r1.x, m.r2.x};
+    Vec3 const y = {m.r0.y, m.r1.y, m.r2.y};
+    Vec3 const z = {m.r0.z, m.r1.z, m.r2.z};
+    return {
+        {x.x, x.y, x.z, -Dot(x, t)},
+        {y.x, y.y, y.z, -Dot(y, t)},
+        {z.x, z.y, z.z, -Dot(z, t)},
+    };
+}
+// c0, c1 and c2 are the inverse's 3x3 columns, with w 0; t holds m's translation in each row's w
+inline Mat4x3 _StoreInverseSse(__m128 c0, __m128 c1, __m128 c2, __m128 const r0, __m128 const r1,
+                               __m128 const r2)
+{
+    __m128 t = _mm_mul_ps(c0, _mm_shuffle_ps(r0, r0, AK_SWIZZLE(3, 3, 3, 3)));
+    t = _mm_add_ps(t, _mm_mul_ps(c1, _mm_shuffle_ps(r1, r1, AK_SWIZZLE(3, 3, 3, 3))));
+    t = _mm_add_ps(t, _mm_mul_ps(c2, _mm_shuffle_ps(r2, r2, AK_SWIZZLE(3, 3, 3, 3))));
+    t = _mm_sub_ps(_mm_setzero_ps(), t);
+    _MM_TRANSPOSE4_PS(c0, c1, c2, t);
+    Mat4x3 result;
+    _mm_store_ps(&result.r0.x, c0);
+    _mm_store_ps(&result.r1.x, c1);
+    _mm_store_ps(&result.r2.x, c2);
+    return result;
+}
+inline Mat4x3 InverseSse(Mat4x3 const& m)
+{
+    __m128 const r0 = _mm_load_ps(&m.r0.x);
+    __m128 const r1 = _mm_load_ps(&m.r1.x);
+    __m128 const r2 = _mm_load_ps(&m.r2.x);
+    __m128 const xyz = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+    __m128 const a = _mm_and_ps(r0, xyz);
+    __m128 const b = _mm_and_ps(r1, xyz);
+    __m128 const c = _mm_and_ps(r2, xyz);
+
+    __m128 c0 = _Cross3Sse(b, c);
+    __m128 c1 = _Cross3Sse(c, a);
+    __m128 c2 = _Cross3Sse(a, b);
+    __m128 det = _mm_mul_ps(a, c0);
+    det = _mm_add_ps(det, _mm_shuffle_ps(det, det, AK_SWIZZLE(1, 0, 3, 2)));
+    det = _mm_add_ps(det, _mm_shuffle_ps(det, det, AK_SWIZZLE(2, 3, 0, 1)));
+    __m128 const invdet = _mm_div_ps(_mm_set1_ps(1.0f), det);
+    c0 = _mm_mul_ps(c0, invdet);
+    c1 = _mm_mul_ps(c1, invdet);
+    c2 = _mm_mul_ps(c2, invdet);
+    return _StoreInverseSse(c0, c1, c2, r0, r1, r2);
+}
+inline Mat4x3 InverseRigidSse(Mat4x3 const& m)
+{
+    assert(IsRigid(Mat4::FromMat4x3(m)));
+    __m128 const r0 = _mm_load_ps(&m.r0.x);
+    __m128 const r1 = _mm_load_ps(&m.r1.x);
+    __m128 const r2 = _mm_load_ps(&m.r2.x);
+    __m128 const xyz = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+    // The transpose's columns are m's rows
+    return _StoreInverseSse(_mm_and_ps(r0, xyz), _mm_and_ps(r1, xyz), _mm_and_ps(r2, xyz), r0, r1,
+                            r2);
+}
+inline Mat4x3 Inverse(Mat4x3 const& m)
+{
+    if (ActiveSimdLevel() >= SimdLevel::kSse) {
+        return InverseSse(m);
+    }
+    return InverseScalar(m);
+}
+inline Mat4x3 InverseRigid(Mat4x3 const& m)
+{
+    if (ActiveSimdLevel() >= SimdLevel::kSse) {
+        return InverseRigidSse(m);
+    }
+    return InverseRigidScalar(m);
+}
+
+/*
+ * Transform
+ *
+ * Each output component is a row's dot product with (v, 1) or (v, 0). The single-vector forms
+ * multiply the rows by the vector and sum the products' transpose. For arrays, TransformPoints
+ * and TransformDirections expand the matrix to a Mat4 once and use its kernels, which already skip
+ * the bottom row for Vec3s.
+ */
+AK_FORCEINLINE __m128 _TransformSse(Mat4x3 const& m, __m128 const v)
+{
+    __m128 x = _mm_mul_ps(_mm_load_ps(&m.r0.x), v);
+    __m128 y = _mm_mul_ps(_mm_load_ps(&m.r1.x), v);
+    __m128 z = _mm_mul_ps(_mm_load_ps(&m.r2.x), v);
+    __m128 w = _mm_setzero_ps();
+    _MM_TRANSPOSE4_PS(x, y, z, w);
+    return _mm_add_ps(_mm_add_ps(x, y), _mm_add_ps(z, w));
+}
+// m * (p, 1)
+AK_FORCEINLINE Vec3 TransformPoint(Mat4x3 const& m, Vec3 const p)
+{
+    Vec4 result;
+    _mm_store_ps(&result.x, _TransformSse(m, _mm_setr_ps(p.x, p.y, p.z, 1.0f)));
+    return {result.x, result.y, result.z};
+}
+// m * (d, 0)
+AK_FORCEINLINE Vec3 TransformDirection(Mat4x3 const& m, Vec3 const d)
+{
+    Vec4 result;
+    _mm_store_ps(&result.x, _TransformSse(m, _mm_setr_ps(d.x, d.y, d.z, 0.0f)));
+    return {result.x, result.y, result.z};
+}
+inline void TransformPoints(Mat4x3 const& m, Vec3 const* const in, Vec3* const out, size_t const n)
+{
+    TransformPoints(Mat4::FromMat4x3(m), in, out, n);
+}
+inline void TransformDirections(Mat4x3 const& m, Vec3 const* const in, Vec3* const out,
+                                size_t const n)
+{
+    TransformDirections(Mat4::FromMat4x3(m), in, out, n);
+}
+
+/*****************************************************************************\
+ * Structure of arrays                                                        *
+\*****************************************************************************/
+// Vec3SoA and Vec4SoA store `count` vectors as one float array ("lane") per component. The lanes
+// share one allocation and are each padded to whole cache lines, so every lane is 64-byte aligned
+// and the next lane starts _SoAStride(count) floats later. The padding is zeroed.
+constexpr size_t _SoAStride(size_t const count)
+{
+    return (count + 15) & ~static_cast<size_t>(15);
+}
+
+struct Vec3SoA
+{
+    Vec3SoA() = default;
+    inline explicit Vec3SoA(size_t const n);
+    inline Vec3SoA(Vec3SoA&& other);
+    inline Vec3SoA& operator=(Vec3SoA&& other);
+    Vec3SoA(Vec3SoA const&) = delete;
+    Vec3SoA& operator=(Vec3SoA const&) = delete;
+    inline ~Vec3SoA();
+
+    inline Vec3 Get(size_t const ii) const;
+    inline void Set(size_t const ii, Vec3 const v);
+
+    float* x = nullptr;
+    float* y = nullptr;
+    float* z = nullptr;
+    size_t count = 0;
+};
+struct Vec4SoA
+{
+    Vec4SoA() = default;
+    inline explicit Vec4SoA(size_t const n);
+    inline Vec4SoA(Vec4SoA&& other);
+    inline Vec4SoA& operator=(Vec4SoA&& other);
+    Vec4SoA(Vec4SoA const&) = delete;
+    Vec4SoA& operator=(Vec4SoA const&) = delete;
+    inline ~Vec4SoA();
+
+    inline Vec4 Get(size_t const ii) const;
+    inline void Set(size_t const ii, Vec4 const v);
+
+    float* x = nullptr;
+    float* y = nullptr;
+    float* z = nullptr;
+    float* w = nullptr;
+    size_t count = 0;
+};
+
+inline float* _AllocateLanes(size_t const count, int const lanes)
+{
+    if (count == 0) {
+        return nullptr;
+    }
+    size_t const stride = _SoAStride(count);
+    float* const data = static_cast<float*>(_mm_malloc(stride * lanes * sizeof(float), 64));
+    assert(data);
+    for (int ll = 0; ll < lanes; ++ll) {
+        memset(data + ll * stride + count, 0, (stride - count) * sizeof(float));
+    }
+    return data;
+}
+
+inline Vec3SoA::Vec3SoA(size_t const n) : x(_AllocateLanes(n, 3)), count(n)
+{
+    y = x + _SoAStride(n);
+    z = y + _SoAStride(n);
+}
+inline Vec3SoA::Vec3SoA(Vec3SoA&& other)
+    : x(other.x), y(other.y), z(other.z), count(other.count)
+{
+    other.x = other.y = other.z = nullptr;
+    other.count = 0;
+}
+inline Vec3SoA& Vec3SoA::operator=(Vec3SoA&& other)
+{
+    if (this != &other) {
+        _mm_free(x);
+        x = other.x;
+        y = other.y;
+        z = other.z;
+        count = other.count;
+        other.x = other.y = other.z = nullptr;
+        other.count = 0;
+    }
+    return *this;
+}
+inline Vec3SoA::~Vec3SoA()
+{
+    _mm_free(x);
+}
+inline Vec3 Vec3SoA::Get(size_t const ii) const
+{
+    assert(ii < count);
+    return {x[ii], y[ii], z[ii]};
+}
+inline void Vec3SoA::Set(size_t const ii, Vec3 const v)
+{
+    assert(ii < count);
+    x[ii] = v.x;
+    y[ii] = v.y;
+    z[ii] = v.z;
+}
+
+inline Vec4SoA::Vec4SoA(size_t const n) : x(_AllocateLanes(n, 4)), count(n)
+{
+    y = x + _SoAStride(n);
+    z = y + _SoAStride(n);
+    w = z + _SoAStride(n);
+}
+inline Vec4SoA::Vec4SoA(Vec4SoA&& other)
+    : x(other.x), y(other.y), z(other.z), w(other.w), count(other.count)
+{
+    other.x = other.y = other.z = other.w = nullptr;
+    other.count = 0;
+}
+inline Vec4SoA& Vec4SoA::operator=(Vec4SoA&& other)
+{
+    if (this != &other) {
+        _mm_free(x);
+        x = other.x;
+        y = other.y;
+        z = other.z;
+        w = other.w;
+        count = other.count;
+        other.x = other.y = other.z = other.w = nullptr;
+        other.count = 0;
+    }
+    return *this;
+}
+inline Vec4SoA::~Vec4SoA()
+{
+    _mm_free(x);
+}
+inline Vec4 Vec4SoA::Get(size_t const ii) const
+{
+    assert(ii < count);
+    return {x[ii], y[ii], z[ii], w[ii]};
+}
+inline void Vec4SoA::Set(size_t const ii, Vec4 const v)
+{
+    assert(ii < count);
+    x[ii] = v.x;
+    y[ii] = v.y;
+    z[ii] = v.z;
+    w[ii] = v.w;
+}
+
+// Element-wise lane ops. Each provides a scalar form and one per ISA, and _BinaryLanes applies it
+// across whole float arrays 4, 8 or 16 lanes at a time. AVX-512 handles the tail with masks.
+struct _AddOp
+{
+    float Scalar(float const a, float const b) const { return a + b; }
+    __m128 Sse(__m128 const a, __m128 const b) const { return _mm_add_ps(a, b); }
+    AK_TARGET_INLINE("avx2,fma") __m256 Avx(__m256 const a, __m256 const b) const
+    {
+        return _mm256_add_ps(a, b);
+    }
+    AK_TARGET_INLINE("avx512f") __m512 Avx512(__m512 const a, __m512 const b) const
+    {
+        return _mm512_add_ps(a, b);
+    }
+};
+struct _SubtractOp
+{
+    float Scalar(float const a, float const b) const { return a - b; }
+    __m128 Sse(__m128 const a, __m128 const b) const { return _mm_sub_ps(a, b); }
+    AK_TARGET_INLINE("avx2,fma") __m256 Avx(__m256 const a, __m256 const b) const
+    {
+        return _mm256_sub_ps(a, b);
+    }
+    AK_TARGET_INLINE("avx512f") __m512 Avx512(__m512 const a, __m512 const b) const
+    {
+        return _mm512_sub_ps(a, b);
+    }
+};
+struct _MultiplyOp
+{
+    float Scalar(float const a, float const b) const { return a * b; }
+    __m128 Sse(__m128 const a, __m128 const b) const { return _mm_mul_ps(a, b); }
+    AK_TARGET_INLINE("avx2,fma") __m256 Avx(__m256 const a, __m256 const b) const
+    {
+        return _mm256_mul_ps(a, b);
+    }
+    AK_TARGET_INLINE("avx512f") __m512 Avx512(__m512 const a, __m512 const b) const
+    {
+        return _mm512_mul_ps(a, b);
+    }
+};
+struct _DivideOp
+{
+    float Scalar(float const a, float const b) const { return a / b; }
+    __m128 Sse(__m128 const a, __m128 const b) const { return _mm_div_ps(a, b); }
+    AK_TARGET_INLINE("avx2,fma") __m256 Avx(__m256 const a, __m256 const b) const
+    {
+        return _mm256_div_ps(a, b);
+    }
+    AK_TARGET_INLINE("avx512f") __m512 Avx512(__m512 const a, __m512 const b) const
+    {
+        return _mm512_div_ps(a, b);
+    }
+};
+// minps/maxps return the second operand when the comparison is false, like Min/Max above
+struct _MinOp
+{
+    float Scalar(float const a, float const b) const { return a < b ? a : b; }
+    __m128 Sse(__m128 const a, __m128 const b) const { return _mm_min_ps(a, b); }
+    AK_TARGET_INLINE("avx2,fma") __m256 Avx(__m256 const a, __m256 const b) const
+    {
+        return _mm256_min_ps(a, b);
+    }
+    AK_TARGET_INLINE("avx512f") __m512 Avx512(__m512 const a, __m512 const b) const
+    {
+        return _mm512_min_ps(a, b);
+    }
+};
+struct _MaxOp
+{
+    float Scalar(float const a, float const b) const { return a > b ? a : b; }
+    __m128 Sse(__m128 const a, __m128 const b) const { return _mm_max_ps(a, b); }
+    AK_TARGET_INLINE("avx2,fma") __m256 Avx(__m256 const a, __m256 const b) const
+    {
+        return _mm256_max_ps(a, b);
+    }
+    AK_TARGET_INLINE("avx512f") __m512 Avx512(__m512 const a, __m512 const b) const
+    {
+        return _mm512_max_ps(a, b);
+    }
+};
+struct _LerpOp
+{
+    float Scalar(float const a, float const b) const { return a + (b - a) * t; }
+    __m128 Sse(__m128 const a, __m128 const b) const
+    {
+        return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), _mm_set1_ps(t)));
+    }
+    AK_TARGET_INLINE("avx2,fma") __m256 Avx(__m256 const a, __m256 const b) const
+    {
+        return _mm256_fmadd_ps(_mm256_sub_ps(b, a), _mm256_set1_ps(t), a);
+    }
+    AK_TARGET_INLINE("avx512f") __m512 Avx512(__m512 const a, __m512 const b) const
+    {
+        return _mm512_fmadd_ps(_mm512_sub_ps(b, a), _mm512_set1_ps(t), a);
+    }
+
+    float t;
+};
+
+template<typename Op>
+inline void _BinaryLanesScalar(Op const op, float const* const a, float const* const b,
+                               float* const out, size_t const n)
+{
+    for (size_t ii = 0; ii < n; ++ii) {
+        out[ii] = op.Scalar(a[ii], b[ii]);
+    }
+}
+template<typename Op>
+inline void _BinaryLanesSse(Op const op, float const* const a, float const* const b,
+                            float* const out, size_t const n)
+{
+    size_t ii = 0;
+    for (; ii + 4 <= n; ii += 4) {
+        _mm_storeu_ps(out + ii, op.Sse(_mm_loadu_ps(a + ii), _mm_loadu_ps(b + ii)));
+    }
+    _BinaryLanesScalar(op, a + ii, b + ii, out + ii, n - ii);
+}
+template<typename Op>
+AK_TARGET_INLINE("avx2,fma")
+void _BinaryLanesAvx(Op const op, float const* const a, float const* const b, float* const out,
+                     size_t const n)
+{
+    size_t ii = 0;
+    for (; ii + 8 <= n; ii += 8) {
+        _mm256_storeu_ps(out + ii, op.Avx(_mm256_loadu_ps(a + ii), _mm256_loadu_ps(b + ii)));
+    }
+    _BinaryLanesSse(op, a + ii, b + ii, out + ii, n - ii);
+}
+template<typename Op>
+AK_TARGET_INLINE("avx512f")
+void _BinaryLanesAvx512(Op const op, float const* const a, float const* const b, float* const out,
+                        size_t const n)
+{
+    size_t ii = 0;
+    for (; ii + 16 <= n; ii += 16) {
+        _mm512_storeu_ps(out + ii, op.Avx512(_mm512_loadu_ps(a + ii), _mm512_loadu_ps(b + ii)));
+    }
+    if (ii < n) {
+        __mmask16 const mask = _TailMask(n - ii);
+        __m512 const r =
+            op.Avx512(_mm512_maskz_loadu_ps(mask, a + ii), _mm512_maskz_loadu_ps(mask, b + ii));
+        _mm512_mask_storeu_ps(out + ii, mask, r);
+    }
+}
+template<typename Op>
+inline void _BinaryLanes(Op const op, float const* const a, float const* const b,
+                         float* const out, size_t const n)
+{
+    switch (ActiveSimdLevel()) {
+        case SimdLevel::kAvx512:
+            return _BinaryLanesAvx512(op, a, b, out, n);
+        case SimdLevel::kAvx:
+            return _BinaryLanesAvx(op, a, b, out, n);
+        case SimdLevel::kSse:
+            return _BinaryLanesSse(op, a, b, out, n);
+        case SimdLevel::kScalar:
+            break;
+    }
+    _BinaryLanesScalar(op, a, b, out, n);
+}
+// Applies `op` to the first `count` floats of each lane, with lanes _SoAStride(count) apart
+template<typename Op>
+inline void _BinarySoA(Op const op, float const* const a, float const* const b, float* const out,
+                       size_t const count, int const lanes)
+{
+    size_t const stride = _SoAStride(count);
+    for (int ll = 0; ll < lanes; ++ll) {
+        _BinaryLanes(op, a + ll * stride, b + ll * stride, out + ll * stride, count);
+    }
+}
+
+// Lane-combining kernels take the lane pointers of a Vec3SoA (kLanes = 3) or Vec4SoA (kLanes = 4)
+template<int kLanes>
+inline float _DotLanesScalar(float const* const* const a, float const* const* const b,
+                             size_t const ii)
+{
+    float r = a[0][ii] * b[0][ii];
+    for (int ll = 1; ll < kLanes; ++ll) {
+        r += a[ll][ii] * b[ll][ii];
+    }
+    return r;
+}
+template<int kLanes>
+inline __m128 _DotLanesSse(float const* const* const a, float const* const* const b,
+                           size_t const ii)
+{
+    __m128 r = _mm_mul_ps(_mm_loadu_ps(a[0] + ii), _mm_loadu_ps(b[0] + ii));
+    for (int ll = 1; ll < kLanes; ++ll) {
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(a[ll] + ii), _mm_loadu_ps(b[ll] + ii)));
+    }
+    return r;
+}
+template<int kLanes>
+AK_TARGET_INLINE("avx2,fma")
+__m256 _DotLanesAvx(float const* const* const a, float const* const* const b, size_t const ii)
+{
+    __m256 r = _mm256_mul_ps(_mm256_loadu_ps(a[0] + ii), _mm256_loadu_ps(b[0] + ii));
+    for (int ll = 1; ll < kLanes; ++ll) {
+        r = _mm256_fmadd_ps(_mm256_loadu_ps(a[ll] + ii), _mm256_loadu_ps(b[ll] + ii), r);
+    }
+    return r;
+}
+template<int kLanes>
+AK_TARGET_INLINE("avx512f")
+__m512 _DotLanesAvx512(float const* const* const a, float const* const* const b, size_t const ii,
+                       __mmask16 const mask)
+{
+    __m512 r = _mm512_mul_ps(_mm512_maskz_loadu_ps(mask, a[0] + ii),
+                             _mm512_maskz_loadu_ps(mask, b[0] + ii));
+    for (int ll = 1; ll < kLanes; ++ll) {
+        r = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, a[ll] + ii),
+                            _mm512_maskz_loadu_ps(mask, b[ll] + ii), r);
+    }
+    return r;
+}
+
+// out[i] = Dot(a[i], b[i])
+template<int kLanes>
+inline void _DotSoAScalar(float const* const* const a, float const* const* const b,
+                          float* const out, size_t const n)
+{
+    for (size_t ii = 0; ii < n; ++ii) {
+        out[ii] = _DotLanesScalar<kLanes>(a, b, ii);
+    }
+}
+template<int kLanes>
+inline void _DotSoASse(float const* const* const a, float const* const* const b, float* const out,
+                       size_t const n)
+{
+    size_t ii = 0;
+    for (; ii + 4 <= n; ii += 4) {
+        _mm_storeu_ps(out + ii, _DotLanesSse<kLanes>(a, b, ii));
+    }
+    for (; ii < n; ++ii) {
+        out[ii] = _DotLanesScalar<kLanes>(a, b, ii);
+    }
+}
+template<int kLanes>
+AK_TARGET_INLINE("avx2,fma")
+void _DotSoAAvx(float const* const* const a, float const* const* const b, float* const out,
+                size_t const n)
+{
+    size_t ii = 0;
+    for (; ii + 8 <= n; ii += 8) {
+        _mm256_storeu_ps(out + ii, _DotLanesAvx<kLanes>(a, b, ii));
+    }
+    for (; ii < n; ++ii) {
+        out[ii] = _DotLanesScalar<kLanes>(a, b, ii);
+    }
+}
+template<int kLanes>
+AK_TARGET_INLINE("avx512f")
+void _DotSoAAvx512(float const* const* const a, float const* const* const b, float* const out,
+                   size_t const n)
+{
+    for (size_t ii = 0; ii < n; ii += 16) {
+        __mmask16 const mask = n - ii >= 16 ? 0xffff : _TailMask(n - ii);
+        _mm512_mask_storeu_ps(out + ii, mask, _DotLanesAvx512<kLanes>(a, b, ii, mask));
+    }
+}
+template<int kLanes>
+inline void _DotSoA(float const* const* const a, float const* const* const b, float* const out,
+                    size_t const n)
+{
+    switch (ActiveSimdLevel()) {
+        case SimdLevel::kAvx512:
+            return _DotSoAAvx512<kLanes>(a, b, out, n);
+        case SimdLevel::kAvx:
+            return _DotSoAAvx<kLanes>(a, b, out, n);
+        case SimdLevel::kSse:
+            return _DotSoASse<kLanes>(a, b, out, n);
+        case SimdLevel::kScalar:
+            break;
+    }
+    _DotSoAScalar<kLanes>(a, b, out, n);
+}
+
+// out[i] = Length(a[i])
+template<int kLanes>
+inline void _LengthSoAScalar(float const* const* const a, float* const out, size_t const n)
+{
+    for (size_t ii = 0; ii < n; ++ii) {
+        out[ii] = sqrtf(_DotLanesScalar<kLanes>(a, a, ii));
+    }
+}
+template<int kLanes>
+inline void _LengthSoASse(float const* const* const a, float* const out, size_t const n)
+{
+    size_t ii = 0;
+    for (; ii + 4 <= n; ii += 4) {
+        _mm_storeu_ps(out + ii, _mm_sqrt_ps(_DotLanesSse<kLanes>(a, a, ii)));
+    }
+    for (; ii < n; ++ii) {
+        out[ii] = sqrtf(_DotLanesScalar<kLanes>(a, a, ii));
+    }
+}
+template<int kLanes>
+AK_TARGET_INLINE("avx2,fma")
+void _LengthSoAAvx(float const* const* const a, float* const out, size_t const n)
+{
+    size_t ii = 0;
+    for (; ii + 8 <= n; ii += 8) {
+        _mm256_storeu_ps(out + ii, _mm256_sqrt_ps(_DotLanesAvx<kLanes>(a, a, ii)));
+    }
+    for (; ii < n; ++ii) {
+        out[ii] = sqrtf(_DotLanesScalar<kLanes>(a, a, ii));
+    }
+}
+template<int kLanes>
+AK_TARGET_INLINE("avx512f")
+void _LengthSoAAvx512(float const* const* const a, float* const out, size_t const n)
+{
+    for (size_t ii = 0; ii < n; ii += 16) {
+        __mmask16 const mask = n - ii >= 16 ? 0xffff : _TailMask(n - ii);
+        _mm512_mask_storeu_ps(out + ii, mask,
+                              _mm512_sqrt_ps(_DotLanesAvx512<kLanes>(a, a, ii, mask)));
+    }
+}
+template<int kLanes>
+inline void _LengthSoA(float const* const* const a, float* const out, size_t const n)
+{
+    switch (ActiveSimdLevel()) {
+        case SimdLevel::kAvx512:
+            return _LengthSoAAvx512<kLanes>(a, out, n);
+        case SimdLevel::kAvx:
+            return _LengthSoAAvx<kLanes>(a, out, n);
+        case SimdLevel::kSse:
+            return _LengthSoASse<kLanes>(a, out, n);
+        case SimdLevel::kScalar:
+            break;
+    }
+    _LengthSoAScalar<kLanes>(a, out, n);
+}
+
+// out[i] = 1 / Length(a[i]), with LengthInvFast's error and zero handling
+template<int kLanes>
+inline void _LengthInvFastSoAScalar(float const* const* const a, float* const out,
+                                    size_t const begin, size_t const n)
+{
+    for (size_t ii = begin; ii < n; ++ii) {
+        out[ii] = _RsqrtFastScalar(_DotLanesScalar<kLanes>(a, a, ii));
+    }
+}
+template<int kLanes>
+inline void _LengthInvFastSoASse(float const* const* const a, float* const out, size_t const n)
+{
+    size_t ii = 0;
+    for (; ii + 4 <= n; ii += 4) {
+        _mm_storeu_ps(out + ii, _RsqrtFastSse(_DotLanesSse<kLanes>(a, a, ii)));
+    }
+    _LengthInvFastSoAScalar<kLanes>(a, out, ii, n);
+}
+template<int kLanes>
+AK_TARGET_INLINE("avx2,fma")
+void _LengthInvFastSoAAvx(float const* const* const a, float* const out, size_t const n)
+{
+    size_t ii = 0;
+    for (; ii + 8 <= n; ii += 8) {
+        _mm256_storeu_ps(out + ii, _RsqrtFastAvx(_DotLanesAvx<kLanes>(a, a, ii)));
+    }
+    _LengthInvFastSoAScalar<kLanes>(a, out, ii, n);
+}
+template<int kLanes>
+AK_TARGET_INLINE("avx512f")
+void _LengthInvFastSoAAvx512(float const* const* const a, float* const out, size_t const n)
+{
+    for (size_t ii = 0; ii < n; ii += 16) {
+        __mmask16 const mask = n - ii >= 16 ? 0xffff : _TailMask(n - ii);
+        _mm512_mask_storeu_ps(out + ii, mask,
+                              _RsqrtFastAvx512(_DotLanesAvx512<kLanes>(a, a, ii, mask)));
+    }
+}
+template<int kLanes>
+inline void _LengthInvFastSoA(float const* const* const a, float* const out, size_t const n)
+{
+    switch (ActiveSimdLevel()) {
+        case SimdLevel::kAvx512:
+            return _LengthInvFastSoAAvx512<kLanes>(a, out, n);
+        case SimdLevel::kAvx:
+            return _LengthInvFastSoAAvx<kLanes>(a, out, n);
+        case SimdLevel::kSse:
+            return _LengthInvFastSoASse<kLanes>(a, out, n);
+        case SimdLevel::kScalar:
+            break;
+    }
+    _LengthInvFastSoAScalar<kLanes>(a, out, 0, n);
+}
+
+// out[i] = Normalize(a[i]). Scales by one reciprocal per vector, so results may differ from
+// Normalize by an ulp. The kFast kernels scale by LengthInvFast instead.
+template<int kLanes, bool kFast>
+inline void _NormalizeLanesScalar(float const* const* const a, float* const* const out,
+                                  size_t const ii)
+{
+    float const dot = _DotLanesScalar<kLanes>(a, a, ii);
+    float const inv = kFast ? _RsqrtFastScalar(dot) : 1.0f / sqrtf(dot);
+    for (int ll = 0; ll < kLanes; ++ll) {
+        out[ll][ii] = a[ll][ii] * inv;
+    }
+}
+template<int kLanes, bool kFast>
+inline void _NormalizeSoAScalar(float const* const* const a, float* const* const out,
+                                size_t const n)
+{
+    for (size_t ii = 0; ii < n; ++ii) {
+        _NormalizeLanesScalar<kLanes, kFast>(a, out, ii);
+    }
+}
+template<int kLanes, bool kFast>
+inline void _NormalizeSoASse(float const* const* const a, float* const* const out, size_t const n)
+{
+    size_t ii = 0;
+    for (; ii + 4 <= n; ii += 4) {
+        __m128 const dot = _DotLanesSse<kLanes>(a, a, ii);
+        __m128 const inv =
+            kFast ? _RsqrtFastSse(dot) : _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(dot));
+        for (int ll = 0; ll < kLanes; ++ll) {
+            _mm_storeu_ps(out[ll] + ii, _mm_mul_ps(_mm_loadu_ps(a[ll] + ii), inv));
+        }
+    }
+    for (; ii < n; ++ii) {
+        _NormalizeLanesScalar<kLanes, kFast>(a, out, ii);
+    }
+}
+template<int kLanes, bool kFast>
+AK_TARGET_INLINE("avx2,fma")
+void _NormalizeSoAAvx(float const* const* const a, float* const* const out, size_t const n)
+{
+    size_t ii = 0;
+    for (; ii + 8 <= n; ii += 8) {
+        __m256 const dot = _DotLanesAvx<kLanes>(a, a, ii);
+        __m256 const inv = kFast ? _RsqrtFastAvx(dot)
+                                 : _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_sqrt_ps(dot));
+        for (int ll = 0; ll < kLanes; ++ll) {
+            _mm256_storeu_ps(out[ll] + ii, _mm256_mul_ps(_mm256_loadu_ps(a[ll] + ii), inv));
+        }
+    }
+    for (; ii < n; ++ii) {
+        _NormalizeLanesScalar<kLanes, kFast>(a, out, ii);
+    }
+}
+template<int kLanes, bool kFast>
+AK_TARGET_INLINE("avx512f")
+void _NormalizeSoAAvx512(float const* const* const a, float* const* const out, size_t const n)
+{
+    for (size_t ii = 0; ii < n; ii += 16) {
+        __mmask16 const mask = n - ii >= 16 ? 0xffff : _TailMask(n - ii);
+        __m512 const dot = _DotLanesAvx512<kLanes>(a, a, ii, mask);
+        __m512 const inv = kFast ? _RsqrtFastAvx512(dot)
+                                 : _mm512_div_ps(_mm512_set1_ps(1.0f), _mm512_sqrt_ps(dot));
+        for (int ll = 0; ll < kLanes; ++ll) {
+            __m512 const v = _mm512_maskz_loadu_ps(mask, a[ll] + ii);
+            _mm512_mask_storeu_ps(out[ll] + ii, mask, _mm512_mul_ps(v, inv));
+        }
+    }
+}
+template<int kLanes, bool kFast>
+inline void _NormalizeSoA(float const* const* const a, float* const* const out, size_t const n)
+{
+    switch (ActiveSimdLevel()) {
+        case SimdLevel::kAvx512:
+            return _NormalizeSoAAvx512<kLanes, kFast>(a, out, n);
+        case SimdLevel::kAvx:
+            return _NormalizeSoAAvx<kLanes, kFast>(a, out, n);
+        case SimdLevel::kSse:
+            return _NormalizeSoASse<kLanes, kFast>(a, out, n);
+        case SimdLevel::kScalar:
+            break;
+    }
+    _NormalizeSoAScalar<kLanes, kFast>(a, out, n);
+}
+
+// out[i] = Cross(a[i], b[i])
+inline void _CrossLanesScalar(float const* const* const a, float const* const* const b,
+                              float* const* const out, size_t const ii)
+{
+    Vec3 const c = Cross({a[0][ii], a[1][ii], a[2][ii]}, {b[0][ii], b[1][ii], b[2][ii]});
+    out[0][ii] = c.x;
+    out[1][ii] = c.y;
+    out[2][ii] = c.z;
+}
+inline void _CrossSoAScalar(float const* const* const a, float const* const* const b,
+                            float* const* const out, size_t const n)
+{
+    for (size_t ii = 0; ii < n; ++ii) {
+        _CrossLanesScalar(a, b, out, ii);
+    }
+}
+inline void _CrossSoASse(float const* const* const a, float const* const* const b,
+                         float* const* const out, size_t const n)
+{
+    size_t ii = 0;
+    for (; ii + 4 <= n; ii += 4) {
+        __m128 const ax = _mm_loadu_ps(a[0] + ii), ay = _mm_loadu_ps(a[1] + ii),
+                     az = _mm_loadu_ps(a[2] + ii);
+        __m128 const bx = _mm_loadu_ps(b[0] + ii), by = _mm_loadu_ps(b[1] + ii),
+                     bz = _mm_loadu_ps(b[2] + ii);
+        _mm_storeu_ps(out[0] + ii, _mm_sub_ps(_mm_mul_ps(ay, bz), _mm_mul_ps(az, by)));
+        _mm_storeu_ps(out[1] + ii, _mm_sub_ps(_mm_mul_ps(az, bx), _mm_mul_ps(ax, bz)));
+        _mm_storeu_ps(out[2] + ii, _mm_sub_ps(_mm_mul_ps(ax, by), _mm_mul_ps(ay, bx)));
+    }
+    for (; ii < n; ++ii) {
+        _CrossLanesScalar(a, b, out, ii);
+    }
+}
+AK_TARGET_INLINE("avx2,fma")
+void _CrossSoAAvx(float const* const* const a, float const* const* const b,
+                  float* const* const out, size_t const n)
+{
+    size_t ii = 0;
+    for (; ii + 8 <= n; ii += 8) {
+        Vec3x8 const c = Cross(Vec3x8::LoadLanes(a[0] + ii, a[1] + ii, a[2] + ii),
+                               Vec3x8::LoadLanes(b[0] + ii, b[1] + ii, b[2] + ii));
+        StoreLanes(c, out[0] + ii, out[1] + ii, out[2] + ii);
+    }
+    for (; ii < n; ++ii) {
+        _CrossLanesScalar(a, b, out, ii);
+    }
+}
+AK_TARGET_INLINE("avx512f")
+void _CrossSoAAvx512(float const* const* const a, float const* const* const b,
+                     float* const* const out, size_t const n)
+{
+    size_t ii = 0;
+    for (; ii + 16 <= n; ii += 16) {
+        Vec3x16 const c = Cross(Vec3x16::LoadLanes(a[0] + ii, a[1] + ii, a[2] + ii),
+                                Vec3x16::LoadLanes(b[0] + ii, b[1] + ii, b[2] + ii));
+        StoreLanes(c, out[0] + ii, out[1] + ii, out[2] + ii);
+    }
+    for (; ii < n; ++ii) {
+        _CrossLanesScalar(a, b, out, ii);
+    }
+}
+inline void _CrossSoA(float const* const* const a, float const* const* const b,
+                      float* const* const out, size_t const n)
+{
+    switch (ActiveSimdLevel()) {
+        case SimdLevel::kAvx512:
+            return _CrossSoAAvx512(a, b, out, n);
+        case SimdLevel::kAvx:
+            return _CrossSoAAvx(a, b, out, n);
+        case SimdLevel::kSse:
+            return _CrossSoASse(a, b, out, n);
+        case SimdLevel::kScalar:
+            break;
+    }
+    _CrossSoAScalar(a, b, out, n);
+}
+
+// Element-wise SoA kernels. All arguments must have the same count; `out` may be one of the inputs.
+// The lane-by-lane ops stop at `count` in every lane, so the padding of `out` stays zeroed.
+inline void Add(Vec3SoA const& a, Vec3SoA const& b, Vec3SoA& out)
+{
+    assert(a.count == b.count && a.count == out.count);
+    _BinarySoA(_AddOp(), a.x, b.x, out.x, a.count, 3);
+}
+inline void Subtract(Vec3SoA const& a, Vec3SoA const& b, Vec3SoA& out)
+{
+    assert(a.count == b.count && a.count == out.count);
+    _BinarySoA(_SubtractOp(), a.x, b.x, out.x, a.count, 3);
+}
+inline void Multiply(Vec3SoA const& a, Vec3SoA const& b, Vec3SoA& out)
+{
+    assert(a.count == b.count && a.count == out.count);
+    _BinarySoA(_MultiplyOp(), a.x, b.x, out.x, a.count, 3);
+}
+inline void Divide(Vec3SoA const& a, Vec3SoA const& b, Vec3SoA& out)
+{
+    assert(a.count == b.count && a.count == out.count);
+    _BinarySoA(_DivideOp(), a.x, b.x, out.x, a.count, 3);
+}
+inline void Min(Vec3SoA const& a, Vec3SoA const& b, Vec3SoA& out)
+{
+    assert(a.count == b.count && a.count == out.count);
+    _BinarySoA(_MinOp(), a.x, b.x, out.x, a.count, 3);
+}
+inline void Max(Vec3SoA const& a, Vec3SoA const& b, Vec3SoA& out)
+{
+    assert(a.count == b.count && a.count == out.count);
+    _BinarySoA(_MaxOp(), a.x, b.x, out.x, a.count, 3);
+}
+inline void Lerp(Vec3SoA const& a, Vec3SoA const& b, float const t, Vec3SoA& out)
+{
+    assert(a.count == b.count && a.count == out.count);
+    _BinarySoA(_LerpOp{t}, a.x, b.x, out.x, a.count, 3);
+}
+// `out` holds a.count floats
+inline void Dot(Vec3SoA const& a, Vec3SoA const& b, float* const out)
+{
+    assert(a.count == b.count);
+    float const* const aLanes[] = {a.x, a.y, a.z};
+    float const* const bLanes[] = {b.x, b.y, b.z};
+    _DotSoA<3>(aLanes, bLanes, out, a.count);
+}
+inline void Length(Vec3SoA const& a, float* const out)
+{
+    float const* const lanes[] = {a.x, a.y, a.z};
+    _LengthSoA<3>(lanes, out, a.count);
+}
+inline void Normalize(Vec3SoA const& a, Vec3SoA& out)
+{
+    assert(a.count == out.count);
+    float const* const lanes[] = {a.x, a.y, a.z};
+    float* const outLanes[] = {out.x, out.y, out.z};
+    _NormalizeSoA<3, false>(lanes, outLanes, a.count);
+}
+inline void NormalizeFast(Vec3SoA const& a, Vec3SoA& out)
+{
+    assert(a.count == out.count);
+    float const* const lanes[] = {a.x, a.y, a.z};
+    float* const outLanes[] = {out.x, out.y, out.z};
+    _NormalizeSoA<3, true>(lanes, outLanes, a.count);
+}
+// `out` holds a.count floats
+inline void LengthInvFast(Vec3SoA const& a, float* const out)
+{
+    float const* const lanes[] = {a.x, a.y, a.z};
+    _LengthInvFastSoA<3>(lanes, out, a.count);
+}
+inline void Cross(Vec3SoA const& a, Vec3SoA const& b, Vec3SoA& out)
+{
+    assert(a.count == b.count && a.count == out.count);
+    float const* const aLanes[] = {a.x, a.y, a.z};
+    float const* const bLanes[] = {b.x, b.y, b.z};
+    float* const outLanes[] = {out.x, out.y, out.z};
+    _CrossSoA(aLanes, bLanes, outLanes, a.count);
+}
+
+inline void Add(Vec4SoA const& a, Vec4SoA const& b, Vec4SoA& out)
+{
+    assert(a.count == b.count && a.count == out.count);
+    _BinarySoA(_AddOp(), a.x, b.x, out.x, a.count, 4);
+}
+inline void Subtract(Vec4SoA const& a, Vec4SoA const& b, Vec4SoA& out)
+{
+    assert(a.count == b.count && a.count == out.count);
+    _BinarySoA(_SubtractOp(), a.x, b.x, out.x, a.count, 4);
+}
+inline void Multiply(Vec4SoA const& a, Vec4SoA const& b, Vec4SoA& out)
+{
+    assert(a.count == b.count && a.count == out.count);
+    _BinarySoA(_MultiplyOp(), a.x, b.x, out.x, a.count, 4);
+}
+inline void Divide(Vec4SoA const& a, Vec4SoA const& b, Vec4SoA& out)
+{
+    assert(a.count == b.count && a.count == out.count);
+    _BinarySoA(_DivideOp(), a.x, b.x, out.x, a.count, 4);
+}
+inline void Min(Vec4SoA const& a, Vec4SoA const& b, Vec4SoA& out)
+{
+    assert(a.count == b.count && a.count == out.count);
+    _BinarySoA(_MinOp(), a.x, b.x, out.x, a.count, 4);
+}
+inline void Max(Vec4SoA const& a, Vec4SoA const& b, Vec4SoA& out)
+{
+    assert(a.count == b.count && a.count == out.count);
+    _BinarySoA(_MaxOp(), a.x, b.x, out.x, a.count, 4);
+}
+inline void Lerp(Vec4SoA const& a, Vec4SoA const& b, float const t, Vec4SoA& out)
+{
+    assert(a.count == b.count && a.count == out.count);
+    _BinarySoA(_LerpOp{t}, a.x, b.x, out.x, a.count, 4);
+}
+inline void Dot(Vec4SoA const& a, Vec4SoA const& b, float* const out)
+{
+    assert(a.count == b.count);
+    float const* const aLanes[] = {a.x, a.y, a.z, a.w};
+    float const* const bLanes[] = {b.x, b.y, b.z, b.w};
+    _DotSoA<4>(aLanes, bLanes, out, a.count);
+}
+inline void Length(Vec4SoA const& a, float* const out)
+{
+    float const* const lanes[] = {a.x, a.y, a.z, a.w};
+    _LengthSoA<4>(lanes, out, a.count);
+}
+inline void Normalize(Vec4SoA const& a, Vec4SoA& out)
+{
+    assert(a.count == out.count);
+    float const* const lanes[] = {a.x, a.y, a.z, a.w};
+    float* const outLanes[] = {out.x, out.y, out.z, out.w};
+    _NormalizeSoA<4, false>(lanes, outLanes, a.count);
+}
+inline void NormalizeFast(Vec4SoA const& a, Vec4SoA& out)
+{
+    assert(a.count == out.count);
+    float const* const lanes[] = {a.x, a.y, a.z, a.w};
+    float* const outLanes[] = {out.x, out.y, out.z, out.w};
+    _NormalizeSoA<4, true>(lanes, outLanes, a.count);
+}
+// `out` holds a.count floats
+inline void LengthInvFast(Vec4SoA const& a, float* const out)
+{
+    float const* const lanes[] = {a.x, a.y, a.z, a.w};
+    _LengthInvFastSoA<4>(lanes, out, a.count);
+}
+
+// AoS <-> SoA conversion. ToSoA fills all `out.count` vectors from `in`; ToAoS writes `in.count`
+// vectors to `out`. AVX-512 hosts use the AVX2 kernels, which already run at memory speed.
+inline void _ToSoAScalar(Vec3 const* const in, Vec3SoA& out, size_t const begin)
+{
+    for (size_t ii = begin; ii < out.count; ++ii) {
+        out.Set(ii, in[ii]);
+    }
+}
+inline void _ToSoASse(Vec3 const* const in, Vec3SoA& out, size_t begin)
+{
+    for (; begin + 4 <= out.count; begin += 4) {
+        __m128 x, y, z;
+        _LoadVec3x4Sse(in + begin, x, y, z);
+        _mm_store_ps(out.x + begin, x);
+        _mm_store_ps(out.y + begin, y);
+        _mm_store_ps(out.z + begin, z);
+    }
+    _ToSoAScalar(in, out, begin);
+}
+AK_TARGET_INLINE("avx2,fma") void _ToSoAAvx(Vec3 const* const in, Vec3SoA& out, size_t begin)
+{
+    for (; begin + 8 <= out.count; begin += 8) {
+        __m256 x, y, z;
+        _LoadVec3x8Avx(in + begin, x, y, z);
+        _mm256_store_ps(out.x + begin, x);
+        _mm256_store_ps(out.y + begin, y);
+        _mm256_store_ps(out.z + begin, z);
+    }
+    _ToSoASse(in, out, begin);
+}
+inline void _ToAoSScalar(Vec3SoA const& in, Vec3* const out, size_t const begin)
+{
+    for (size_t ii = begin; ii < in.count; ++ii) {
+        out[ii] = in.Get(ii);
+    }
+}
+inline void _ToAoSSse(Vec3SoA const& in, Vec3* const out, size_t begin)
+{
+    for (; begin + 4 <= in.count; begin += 4) {
+        _StoreVec3x4Sse(out + begin, _mm_load_ps(in.x + begin), _mm_load_ps(in.y + begin),
+                        _mm_load_ps(in.z + begin));
+    }
+    _ToAoSScalar(in, out, begin);
+}
+AK_TARGET_INLINE("avx2,fma") void _ToAoSAvx(Vec3SoA const& in, Vec3* const out, size_t begin)
+{
+    for (; begin + 8 <= in.count; begin += 8) {
+        _StoreVec3x8Avx(out + begin, _mm256_load_ps(in.x + begin), _mm256_load_ps(in.y + begin),
+                        _mm256_load_ps(in.z + begin));
+    }
+    _ToAoSSse(in, out, begin);
+}
+
+// Transposes the 4x4 block in each 128-bit lane
+AK_TARGET_INLINE("avx2,fma")
+void _Transpose4x4Avx(__m256& r0, __m256& r1, __m256& r2, __m256& r3)
+{
+    __m256 const t0 = _mm256_unpacklo_ps(r0, r1);
+    __m256 const t1 = _mm256_unpacklo_ps(r2, r3);
+    __m256 const t2 = _mm256_unpackhi_ps(r0, r1);
+    __m256 const t3 = _mm256_unpackhi_ps(r2, r3);
+    r0 = _mm256_shuffle_ps(t0, t1, AK_SWIZZLE(0, 1, 0, 1));
+    r1 = _mm256_shuffle_ps(t0, t1, AK_SWIZZLE(2, 3, 2, 3));
+    r2 = _mm256_shuffle_ps(t2, t3, AK_SWIZZLE(0, 1, 0, 1));
+    r3 = _mm256_shuffle_ps(t2, t3, AK_SWIZZLE(2, 3, 2, 3));
+}
+inline void _ToSoAScalar(Vec4 const* const in, Vec4SoA& out, size_t const begin)
+{
+    for (size_t ii = begin; ii < out.count; ++ii) {
+        out.Set(ii, in[ii]);
+    }
+}
+inline void _ToSoASse(Vec4 const* const in, Vec4SoA& out, size_t begin)
+{
+    for (; begin + 4 <= out.count; begin += 4) {
+        __m128 x = _mm_load_ps(&in[begin + 0].x);
+        __m128 y = _mm_load_ps(&in[begin + 1].x);
+        __m128 z = _mm_load_ps(&in[begin + 2].x);
+        __m128 w = _mm_load_ps(&in[begin + 3].x);
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+        _mm_store_ps(out.x + begin, x);
+        _mm_store_ps(out.y + begin, y);
+        _mm_store_ps(out.z + begin, z);
+        _mm_store_ps(out.w + begin, w);
+    }
+    _ToSoAScalar(in, out, begin);
+}
+AK_TARGET_INLINE("avx2,fma") void _ToSoAAvx(Vec4 const* const in, Vec4SoA& out, size_t begin)
+{
+    for (; begin + 8 <= out.count; begin += 8) {
+        Vec4 const* const v = in + begin;
+        __m256 x = _LoadColumnPairAvx(v[0], v[4]);
+        __m256 y = _LoadColumnPairAvx(v[1], v[5]);
+        __m256 z = _LoadColumnPairAvx(v[2], v[6]);
+        __m256 w = _LoadColumnPairAvx(v[3], v[7]);
+        _Transpose4x4Avx(x, y, z, w);
+        _mm256_store_ps(out.x + begin, x);
+        _mm256_store_ps(out.y + begin, y);
+        _mm256_store_ps(out.z + begin, z);
+        _mm256_store_ps(out.w + begin, w);
+    }
+    _ToSoASse(in, out, begin);
+}
+inline void _ToAoSScalar(Vec4SoA const& in, Vec4* const out, size_t const begin)
+{
+    for (size_t ii = begin; ii < in.count; ++ii) {
+        out[ii] = in.Get(ii);
+    }
+}
+inline void _ToAoSSse(Vec4SoA const& in, Vec4* const out, size_t begin)
+{
+    for (; begin + 4 <= in.count; begin += 4) {
+        __m128 x = _mm_load_ps(in.x + begin);
+        __m128 y = _mm_load_ps(in.y + begin);
+        __m128 z = _mm_load_ps(in.z + begin);
+        __m128 w = _mm_load_ps(in.w + begin);
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+        _mm_store_ps(&out[begin + 0].x, x);
+        _mm_store_ps(&out[begin + 1].x, y);
+        _mm_store_ps(&out[begin + 2].x, z);
+        _mm_store_ps(&out[begin + 3].x, w);
+    }
+    _ToAoSScalar(in, out, begin);
+}
+AK_TARGET_INLINE("avx2,fma") void _ToAoSAvx(Vec4SoA const& in, Vec4* const out, size_t begin)
+{
+    for (; begin + 8 <= in.count; begin += 8) {
+        __m256 x = _mm256_load_ps(in.x + begin);
+        __m256 y = _mm256_load_ps(in.y + begin);
+        __m256 z = _mm256_load_ps(in.z + begin);
+        __m256 w = _mm256_load_ps(in.w + begin);
+        _Transpose4x4Avx(x, y, z, w);
+        Vec4* const v = out + begin;
+        _StoreColumnPairAvx(v[0], v[4], x);
+        _StoreColumnPairAvx(v[1], v[5], y);
+        _StoreColumnPairAvx(v[2], v[6], z);
+        _StoreColumnPairAvx(v[3], v[7], w);
+    }
+    _ToAoSSse(in, out, begin);
+}
+
+inline void ToSoA(Vec3 const* const in, Vec3SoA& out)
+{
+    switch (ActiveSimdLevel()) {
+        case SimdLevel::kAvx512:
+        case SimdLevel::kAvx:
+            return _ToSoAAvx(in, out, 0);
+        case SimdLevel::kSse:
+            return _ToSoASse(in, out, 0);
+        case SimdLevel::kScalar:
+            break;
+    }
+    _ToSoAScalar(in, out, 0);
+}
+inline void ToSoA(Vec4 const* const in, Vec4SoA& out)
+{
+    switch (ActiveSimdLevel()) {
+        case SimdLevel::kAvx512:
+        case SimdLevel::kAvx:
+            return _ToSoAAvx(in, out, 0);
+        case SimdLevel::kSse:
+            return _ToSoASse(in, out, 0);
+        case SimdLevel::kScalar:
+            break;
+    }
+    _ToSoAScalar(in, out, 0);
+}
+inline void ToAoS(Vec3SoA const& in, Vec3* const out)
+{
+    switch (ActiveSimdLevel()) {
+        case SimdLevel::kAvx512:
+        case SimdLevel::kAvx:
+            return _ToAoSAvx(in, out, 0);
+        case SimdLevel::kSse:
+            return _ToAoSSse(in, out, 0);
+        case SimdLevel::kScalar:
+            break;
+    }
+    _ToAoSScalar(in, out, 0);
+}
+inline void ToAoS(Vec4SoA const& in, Vec4* const out)
+{
+    switch (ActiveSimdLevel()) {
+        case SimdLevel::kAvx512:
+        case SimdLevel::kAvx:
+            return _ToAoSAvx(in, out, 0);
+        case SimdLevel::kSse:
+            return _ToAoSSse(in, out, 0);
+        case SimdLevel::kScalar:
+            break;
+    }
+    _ToAoSScalar(in, out, 0);
+}
+
+
+/*****************************************************************************\
+ * Frustum                                                                    *
+\*****************************************************************************/
+struct Sphere
+{
+    Vec3 center;
+    float radius;
+};
+
+// Clip-space depth range of the projection a frustum is extracted from
+enum class ClipDepth : int {
+    kZeroToOne = 0,     // D3D, Vulkan, Metal
+    kMinusOneToOne = 1  // OpenGL
+};
+
+// Planes are stored as (normal, d) with unit normals pointing into the frustum, so
+// Dot(normal, p) + d is the signed distance from the plane, positive inside.
+struct Frustum
+{
+    enum {
+        kLeft = 0,
+        kRight,
+        kBottom,
+        kTop,
+        kNear,
+        kFar,
+        kPlaneCount
+    };
+    Vec4 planes[kPlaneCount];
+
+    inline static Frustum FromMatrix(Mat4 const& viewProj,
+                                     ClipDepth const depth = ClipDepth::kZeroToOne);
+};
+
+constexpr inline float PlaneDistance(Vec4 const plane, Vec3 const p)
+{
+    return plane.x * p.x + plane.y * p.y + plane.z * p.z + plane.w;
+}
+inline Vec4 NormalizePlane(Vec4 const plane)
+{
+    return plane / Length(Vec3{plane.x, plane.y, plane.z});
+}
+
+// Gribb/Hartmann extraction: each plane is a sum or difference of rows of the matrix
+inline Frustum Frustum::FromMatrix(Mat4 const& m, ClipDepth const depth)
+{
+    Vec4 const r0 = {m.c0.x, m.c1.x, m.c2.x, m.c3.x};
+    Vec4 const r1 = {m.c0.y, m.c1.y, m.c2.y, m.c3.y};
+    Vec4 const r2 = {m.c0.z, m.c1.z, m.c2.z, m.c3.z};
+    Vec4 const r3 = {m.c0.w, m.c1.w, m.c2.w, m.c3.w};
+    Frustum f;
+    f.planes[kLeft] = NormalizePlane(r3 + r0);
+    f.planes[kRight] = NormalizePlane(r3 - r0);
+    f.planes[kBottom] = NormalizePlane(r3 + r1);
+    f.planes[kTop] = NormalizePlane(r3 - r1);
+    f.planes[kNear] = NormalizePlane(depth == ClipDepth::kZeroToOne ? r2 : r3 + r2);
+    f.planes[kFar] = NormalizePlane(r3 - r2);
+    return f;
+}
+
+// Conservative: spheres that are outside but straddle two planes near a frustum edge pass too.
+// NaN distances fail, as in the SIMD culling kernels.
+inline bool Intersects(Frustum const& f, Sphere const& s)
+{
+    for (int ii = 0; ii < Frustum::kPlaneCount; ++ii) {
+        if (!(PlaneDistance(f.planes[ii], s.center) + s.radius >= 0.0f)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+inline unsigned _Popcount(unsigned const v)
+{
+#if defined(_MSC_VER)
+    return __popcnt(v);
+#else
+    return static_cast<unsigned>(__builtin_popcount(v));
+#endif
+}
+
+// Sphere culling over a Vec4SoA with centers in x, y and z and radii in w. The indices of
+// spheres that pass Intersects are written to `visible` in increasing order, and their count is
+// returned. `visible` must have room for spheres.count indices.
+//
+// The SIMD kernels test every plane for 4, 8 or 16 spheres at once. SSE and AVX2 compact the
+// indices with branchless scalar stores; AVX-512 compresses them in a register.
+inline size_t CullSpheresScalar(Frustum const& f, Vec4SoA const& spheres, uint32_t* const visible)
+{
+    size_t count = 0;
+    for (size_t ii = 0; ii < spheres.count; ++ii) {
+        Sphere const s = {{spheres.x[ii], spheres.y[ii], spheres.z[ii]}, spheres.w[ii]};
+        visible[count] = static_cast<uint32_t>(ii);
+        count += Intersects(f, s);
+    }
+    return count;
+}
+inline size_t CullSpheresSse(Frustum const& f, Vec4SoA const& spheres, uint32_t* const visible)
+{
+    size_t count = 0;
+    size_t ii = 0;
+    for (; ii + 4 <= spheres.count; ii += 4) {
+        __m128 const x = _mm_load_ps(spheres.x + ii);
+        __m128 const y = _mm_load_ps(spheres.y + ii);
+        __m128 const z = _mm_load_ps(spheres.z + ii);
+        __m128 const r = _mm_load_ps(spheres.w + ii);
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int pp = 0; pp < Frustum::kPlaneCount; ++pp) {
+            Vec4 const plane = f.planes[pp];
+            __m128 d = _mm_add_ps(r, _mm_set1_ps(plane.w));
+            d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(plane.z), z));
+            d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(plane.y), y));
+            d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(plane.x), x));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(d, _mm_setzero_ps()));
+        }
+        unsigned const mask = static_cast<unsigned>(_mm_movemask_ps(inside));
+        for (unsigned jj = 0; jj < 4; ++jj) {
+            visible[count] = static_cast<uint32_t>(ii + jj);
+            count += (mask >> jj) & 1;
+        }
+    }
+    for (; ii < spheres.count; ++ii) {
+        Sphere const s = {{spheres.x[ii], spheres.y[ii], spheres.z[ii]}, spheres.w[ii]};
+        visible[count] = static_cast<uint32_t>(ii);
+        count += Intersects(f, s);
+    }
+    return count;
+}
+AK_TARGET_INLINE("avx2,fma")
+size_t CullSpheresAvx(Frustum const& f, Vec4SoA const& spheres, uint32_t* const visible)
+{
+    size_t count = 0;
+    size_t ii = 0;
+    for (; ii + 8 <= spheres.count; ii += 8) {
+        __m256 const x = _mm256_load_ps(spheres.x + ii);
+        __m256 const y = _mm256_load_ps(spheres.y + ii);
+        __m256 const z = _mm256_load_ps(spheres.z + ii);
+        __m256 const r = _mm256_load_ps(spheres.w + ii);
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int pp = 0; pp < Frustum::kPlaneCount; ++pp) {
+            Vec4 const plane = f.planes[pp];
+            __m256 d = _mm256_add_ps(r, _mm256_set1_ps(plane.w));
+            d = _mm256_fmadd_ps(_mm256_set1_ps(plane.z), z, d);
+            d = _mm256_fmadd_ps(_mm256_set1_ps(plane.y), y, d);
+            d = _mm256_fmadd_ps(_mm256_set1_ps(plane.x), x, d);
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, _mm256_setzero_ps(), _CMP_GE_OQ));
+        }
+        unsigned const mask = static_cast<unsigned>(_mm256_movemask_ps(inside));
+        for (unsigned jj = 0; jj < 8; ++jj) {
+            visible[count] = static_cast<uint32_t>(ii + jj);
+            count += (mask >> jj) & 1;
+        }
+    }
+    for (; ii < spheres.count; ++ii) {
+        Sphere const s = {{spheres.x[ii], spheres.y[ii], spheres.z[ii]}, spheres.w[ii]};
+        visible[count] = static_cast<uint32_t>(ii);
+        count += Intersects(f, s);
+    }
+    return count;
+}
+// Compresses into a register and stores all 16 lanes, which is faster than a compress-store to
+// memory on current cores. The extra lanes stay inside `visible`, as count <= ii.
+AK_TARGET_INLINE("avx512f")
+size_t CullSpheresAvx512(Frustum const& f, Vec4SoA const& spheres, uint32_t* const visible)
+{
+    __m512 planes[Frustum::kPlaneCount][4];
+    for (int pp = 0; pp < Frustum::kPlaneCount; ++pp) {
+        planes[pp][0] = _mm512_set1_ps(f.planes[pp].x);
+        planes[pp][1] = _mm512_set1_ps(f.planes[pp].y);
+        planes[pp][2] = _mm512_set1_ps(f.planes[pp].z);
+        planes[pp][3] = _mm512_set1_ps(f.planes[pp].w);
+    }
+    __m512i index = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    __m512i const step = _mm512_set1_epi32(16);
+    size_t count = 0;
+    for (size_t ii = 0; ii < spheres.count; ii += 16) {
+        __mmask16 inside = spheres.count - ii >= 16 ? 0xffff : _TailMask(spheres.count - ii);
+        __m512 const x = _mm512_maskz_load_ps(inside, spheres.x + ii);
+        __m512 const y = _mm512_maskz_load_ps(inside, spheres.y + ii);
+        __m512 const z = _mm512_maskz_load_ps(inside, spheres.z + ii);
+        __m512 const r = _mm512_maskz_load_ps(inside, spheres.w + ii);
+        for (int pp = 0; pp < Frustum::kPlaneCount; ++pp) {
+            __m512 d = _mm512_add_ps(r, planes[pp][3]);
+            d = _mm512_fmadd_ps(planes[pp][2], z, d);
+            d = _mm512_fmadd_ps(planes[pp][1], y, d);
+            d = _mm512_fmadd_ps(planes[pp][0], x, d);
+            inside = _mm512_mask_cmp_ps_mask(inside, d, _mm512_setzero_ps(), _CMP_GE_OQ);
+        }
+        if (spheres.count - ii >= 16) {
+            _mm512_storeu_si512(visible + count, _mm512_maskz_compress_epi32(inside, index));
+        } else {
+            _mm512_mask_compressstoreu_epi32(visible + count, inside, index);
+        }
+        count += _Popcount(inside);
+        index = _mm512_add_epi32(index, step);
+    }
+    return count;
+}
+inline size_t CullSpheres(Frustum const& f, Vec4SoA const& spheres, uint32_t* const visible)
+{
+    switch (ActiveSimdLevel()) {
+        case SimdLevel::kAvx512:
+            return CullSpheresAvx512(f, spheres, visible);
+        case SimdLevel::kAvx:
+            return CullSpheresAvx(f, spheres, visible);
+        case SimdLevel::kSse:
+            return CullSpheresSse(f, spheres, visible);
+        case SimdLevel::kScalar:
+            break;
+    }
+    return CullSpheresScalar(f, spheres, visible);
+}
+
+
+/*****************************************************************************\
+ * Aabb                                                                       *
+\*****************************************************************************/
+// Axis-aligned bounding box. Empty() has min > max and is the identity of Union.
+struct Aabb
+{
+    Vec3 min;
+    Vec3 max;
+
+    constexpr inline static Aabb Empty();
+};
+static_assert(sizeof(Aabb) == 6 * sizeof(float), "Aabb arrays are loaded as packed Vec3s");
+
+constexpr inline Aabb Aabb::Empty()
+{
+    return {{FLT_MAX, FLT_MAX, FLT_MAX}, {-FLT_MAX, -FLT_MAX, -FLT_MAX}};
+}
+
+constexpr inline Vec3 Center(Aabb const& box)
+{
+    return (box.min + box.max) * 0.5f;
+}
+constexpr inline Vec3 Extents(Aabb const& box)
+{
+    return (box.max - box.min) * 0.5f;
+}
+constexpr inline bool IsEmpty(Aabb const& box)
+{
+    return box.min.x > box.max.x || box.min.y > box.max.y || box.min.z > box.max.z;
+}
+constexpr inline Aabb Union(Aabb const& a, Aabb const& b)
+{
+    return {Min(a.min, b.min), Max(a.max, b.max)};
+}
+constexpr inline Aabb Union(Aabb const& box, Vec3 const p)
+{
+    return {Min(box.min, p), Max(box.max, p)};
+}
+constexpr inline bool Contains(Aabb const& box, Vec3 const p)
+{
+    return p.x >= box.min.x && p.x <= box.max.x && p.y >= box.min.y && p.y <= box.max.y &&
+           p.z >= box.min.z && p.z <= box.max.z;
+}
+constexpr inline bool Overlaps(Aabb const& a, Aabb const& b)
+{
+    return a.min.x <= b.max.x && a.max.x >= b.min.x && a.min.y <= b.max.y &&
+           a.max.y >= b.min.y && a.min.z <= b.max.z && a.max.z >= b.min.z;
+}
+
+/*
+ * Transforms
+ *
+ * Arvo's method in center/extents form: the center is transformed as a point and the extents by
+ * the absolute value of the upper 3x3, which gives the tightest box around the transformed box.
+ * `m` must be affine and the boxes non-empty.
+ */
+inline Mat4 _AbsLinear(Mat4 const& m)
+{
+    return {
+        {fabsf(m.c0.x), fabsf(m.c0.y), fabsf(m.c0.z), 0.0f},
+        {fabsf(m.c1.x), fabsf(m.c1.y), fabsf(m.c1.z), 0.0f},
+        {fabsf(m.c2.x), fabsf(m.c2.y), fabsf(m.c2.z), 0.0f},
+        {0.0f, 0.0f, 0.0f, 1.0f},
+    };
+}
+inline Aabb TransformAabb(Mat4 const& m, Aabb const& box)
+{
+    Vec3 const c = Center(box);
+    Vec3 const e = Extents(box);
+    Vec3 const tc = {
+        m.c0.x * c.x + m.c1.x * c.y + m.c2.x * c.z + m.c3.x,
+        m.c0.y * c.x + m.c1.y * c.y + m.c2.y * c.z + m.c3.y,
+        m.c0.z * c.x + m.c1.z * c.y + m.c2.z * c.z + m.c3.z,
+    };
+    Vec3 const te = {
+        fabsf(m.c0.x) * e.x + fabsf(m.c1.x) * e.y + fabsf(m.c2.x) * e.z,
+        fabsf(m.c0.y) * e.x + fabsf(m.c1.y) * e.y + fabsf(m.c2.y) * e.z,
+        fabsf(m.c0.z) * e.x + fabsf(m.c1.z) * e.y + fabsf(m.c2.z) * e.z,
+    };
+    return {tc - te, tc + te};
+}
+
+// Four, eight or sixteen packed Aabbs <-> min and max lanes. Packed boxes are alternating min and
+// max Vec3s, so they load as Vec3 packets whose even lanes are mins and odd lanes are maxes.
+inline void _LoadAabbx4Sse(Aabb const* const p, __m128 (&min)[3], __m128 (&max)[3])
+{
+    __m128 a[3], b[3];
+    _LoadVec3x4Sse(&p[0].min, a[0], a[1], a[2]);
+    _LoadVec3x4Sse(&p[2].min, b[0], b[1], b[2]);
+    for (int ii = 0; ii < 3; ++ii) {
+        min[ii] = _mm_shuffle_ps(a[ii], b[ii], AK_SWIZZLE(0, 2, 0, 2));
+        max[ii] = _mm_shuffle_ps(a[ii], b[ii], AK_SWIZZLE(1, 3, 1, 3));
+    }
+}
+inline void _StoreAabbx4Sse(Aabb* const p, __m128 const (&min)[3], __m128 const (&max)[3])
+{
+    _StoreVec3x4Sse(&p[0].min, _mm_unpacklo_ps(min[0], max[0]), _mm_unpacklo_ps(min[1], max[1]),
+                    _mm_unpacklo_ps(min[2], max[2]));
+    _StoreVec3x4Sse(&p[2].min, _mm_unpackhi_ps(min[0], max[0]), _mm_unpackhi_ps(min[1], max[1]),
+                    _mm_unpackhi_ps(min[2], max[2]));
+}
+AK_TARGET_INLINE("avx2,fma") __m256 _EvenLanesAvx(__m256 const a, __m256 const b)
+{
+    __m256d const v = _mm256_castps_pd(_mm256_shuffle_ps(a, b, AK_SWIZZLE(0, 2, 0, 2)));
+    return _mm256_castpd_ps(_mm256_permute4x64_pd(v, AK_SWIZZLE(0, 2, 1, 3)));
+}
+AK_TARGET_INLINE("avx2,fma") __m256 _OddLanesAvx(__m256 const a, __m256 const b)
+{
+    __m256d const v = _mm256_castps_pd(_mm256_shuffle_ps(a, b, AK_SWIZZLE(1, 3, 1, 3)));
+    return _mm256_castpd_ps(_mm256_permute4x64_pd(v, AK_SWIZZLE(0, 2, 1, 3)));
+}
+AK_TARGET_INLINE("avx2,fma") void _LoadAabbx8Avx(Aabb const* const p, Vec3x8& min, Vec3x8& max)
+{
+    Vec3x8 const a = Vec3x8::Load(&p[0].min);
+    Vec3x8 const b = Vec3x8::Load(&p[4].min);
+    min = {_EvenLanesAvx(a.x, b.x), _EvenLanesAvx(a.y, b.y), _EvenLanesAvx(a.z, b.z)};
+    max = {_OddLanesAvx(a.x, b.x), _OddLanesAvx(a.y, b.y), _OddLanesAvx(a.z, b.z)};
+}
+AK_TARGET_INLINE("avx2,fma") void _StoreAabbx8Avx(Aabb* const p, Vec3x8 const min, Vec3x8 const max)
+{
+    __m256 const lx = _mm256_unpacklo_ps(min.x, max.x);
+    __m256 const ly = _mm256_unpacklo_ps(min.y, max.y);
+    __m256 const lz = _mm256_unpacklo_ps(min.z, max.z);
+    __m256 const hx = _mm256_unpackhi_ps(min.x, max.x);
+    __m256 const hy = _mm256_unpackhi_ps(min.y, max.y);
+    __m256 const hz = _mm256_unpackhi_ps(min.z, max.z);
+    _StoreVec3x8Avx(&p[0].min, _mm256_permute2f128_ps(lx, hx, 0x20),
+                    _mm256_permute2f128_ps(ly, hy, 0x20), _mm256_permute2f128_ps(lz, hz, 0x20));
+    _StoreVec3x8Avx(&p[4].min, _mm256_permute2f128_ps(lx, hx, 0x31),
+                    _mm256_permute2f128_ps(ly, hy, 0x31), _mm256_permute2f128_ps(lz, hz, 0x31));
+}
+AK_TARGET_INLINE("avx512f")
+void _LoadAabbx16Avx512(Aabb const* const p, Vec3x16& min, Vec3x16& max)
+{
+    __m512i const even =
+        _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+    __m512i const odd =
+        _mm512_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31);
+    Vec3x16 const a = Vec3x16::Load(&p[0].min);
+    Vec3x16 const b = Vec3x16::Load(&p[8].min);
+    min = {_mm512_permutex2var_ps(a.x, even, b.x), _mm512_permutex2var_ps(a.y, even, b.y),
+           _mm512_permutex2var_ps(a.z, even, b.z)};
+    max = {_mm512_permutex2var_ps(a.x, odd, b.x), _mm512_permutex2var_ps(a.y, odd, b.y),
+           _mm512_permutex2var_ps(a.z, odd, b.z)};
+}
+AK_TARGET_INLINE("avx512f")
+void _StoreAabbx16Avx512(Aabb* const p, Vec3x16 const min, Vec3x16 const max)
+{
+    __m512i const lo = _mm512_setr_epi32(0, 16, 1, 17, 2, 18, 3, 19, 4, 20, 5, 21, 6, 22, 7, 23);
+    __m512i const hi =
+        _mm512_setr_epi32(8, 24, 9, 25, 10, 26, 11, 27, 12, 28, 13, 29, 14, 30, 15, 31);
+    Store(Vec3x16{_mm512_permutex2var_ps(min.x, lo, max.x),
+                  _mm512_permutex2var_ps(min.y, lo, max.y),
+                  _mm512_permutex2var_ps(min.z, lo, max.z)},
+          &p[0].min);
+    Store(Vec3x16{_mm512_permutex2var_ps(min.x, hi, max.x),
+                  _mm512_permutex2var_ps(min.y, hi, max.y),
+                  _mm512_permutex2var_ps(min.z, hi, max.z)},
+          &p[8].min);
+}
+
+inline void TransformAabbsScalar(Mat4 const& m, Aabb const* const in, Aabb* const out,
+                                 size_t const n)
+{
+    for (size_t ii = 0; ii < n; ++ii) {
+        out[ii] = TransformAabb(m, in[ii]);
+    }
+}
+inline void TransformAabbsSse(Mat4 const& m, Aabb const* const in, Aabb* const out, size_t const n)
+{
+    Mat4 const a = _AbsLinear(m);
+    __m128 const half = _mm_set1_ps(0.5f);
+    size_t ii = 0;
+    for (; ii + 4 <= n; ii += 4) {
+        __m128 min[3], max[3];
+        _LoadAabbx4Sse(in + ii, min, max);
+        __m128 const cx = _mm_mul_ps(_mm_add_ps(min[0], max[0]), half);
+        __m128 const cy = _mm_mul_ps(_mm_add_ps(min[1], max[1]), half);
+        __m128 const cz = _mm_mul_ps(_mm_add_ps(min[2], max[2]), half);
+        __m128 const ex = _mm_mul_ps(_mm_sub_ps(max[0], min[0]), half);
+        __m128 const ey = _mm_mul_ps(_mm_sub_ps(max[1], min[1]), half);
+        __m128 const ez = _mm_mul_ps(_mm_sub_ps(max[2], min[2]), half);
+        float const* const mc[] = {&m.c0.x, &m.c1.x, &m.c2.x, &m.c3.x};
+        float const* const ac[] = {&a.c0.x, &a.c1.x, &a.c2.x};
+        for (int rr = 0; rr < 3; ++rr) {
+            __m128 c = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(mc[0][rr]), cx),
+                                  _mm_mul_ps(_mm_set1_ps(mc[1][rr]), cy));
+            c = _mm_add_ps(c, _mm_add_ps(_mm_mul_ps(_mm_set1_ps(mc[2][rr]), cz),
+                                         _mm_set1_ps(mc[3][rr])));
+            __m128 e = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(ac[0][rr]), ex),
+                                  _mm_mul_ps(_mm_set1_ps(ac[1][rr]), ey));
+            e = _mm_add_ps(e, _mm_mul_ps(_mm_set1_ps(ac[2][rr]), ez));
+            min[rr] = _mm_sub_ps(c, e);
+            max[rr] = _mm_add_ps(c, e);
+        }
+        _StoreAabbx4Sse(out + ii, min, max);
+    }
+    TransformAabbsScalar(m, in + ii, out + ii, n - ii);
+}
+AK_TARGET_INLINE("avx2,fma")
+void TransformAabbsAvx(Mat4 const& m, Aabb const* const in, Aabb* const out, size_t const n)
+{
+    Mat4 const local = m;
+    Mat4 const a = _AbsLinear(m);
+    size_t ii = 0;
+    for (; ii + 8 <= n; ii += 8) {
+        Vec3x8 min, max;
+        _LoadAabbx8Avx(in + ii, min, max);
+        Vec3x8 const c = TransformPoint(local, (min + max) * 0.5f);
+        Vec3x8 const e = TransformDirection(a, (max - min) * 0.5f);
+        _StoreAabbx8Avx(out + ii, c - e, c + e);
+    }
+    TransformAabbsSse(m, in + ii, out + ii, n - ii);
+}
+AK_TARGET_INLINE("avx512f")
+void TransformAabbsAvx512(Mat4 const& m, Aabb const* const in, Aabb* const out, size_t const n)
+{
+    Mat4 const local = m;
+    Mat4 const a = _AbsLinear(m);
+    size_t ii = 0;
+    for (; ii + 16 <= n; ii += 16) {
+        Vec3x16 min, max;
+        _LoadAabbx16Avx512(in + ii, min, max);
+        Vec3x16 const c = TransformPoint(local, (min + max) * 0.5f);
+        Vec3x16 const e = TransformDirection(a, (max - min) * 0.5f);
+        _StoreAabbx16Avx512(out + ii, c - e, c + e);
+    }
+    TransformAabbsAvx(m, in + ii, out + ii, n - ii);
+}
+// out[i] = TransformAabb(m, in[i])
+inline void TransformAabbs(Mat4 const& m, Aabb const* const in, Aabb* const out, size_t const n)
+{
+    switch (ActiveSimdLevel()) {
+        case SimdLevel::kAvx512:
+            return TransformAabbsAvx512(m, in, out, n);
+        case SimdLevel::kAvx:
+            return TransformAabbsAvx(m, in, out, n);
+        case SimdLevel::kSse:
+            return TransformAabbsSse(m, in, out, n);
+        case SimdLevel::kScalar:
+            break;
+    }
+    TransformAabbsScalar(m, in, out, n);
+}
+
+/*
+ * Bounds
+ *
+ * AabbFromPoints bounds a point array and Union(boxes, n) merges a box array; both return
+ * Aabb::Empty() for n == 0. They share one kernel per ISA: a box array is a point array of
+ * alternating mins and maxes, and with `corners` set the kernel keeps the running minimum of the
+ * even points and the running maximum of the odd ones, so empty boxes in the array are ignored.
+ * The SIMD kernels step by an even number of points, so each lane always sees the same parity.
+ */
+inline Aabb _BoundsScalar(Vec3 const* const p, size_t const n, bool const corners)
+{
+    Aabb box = Aabb::Empty();
+    size_t const step = corners ? 2 : 1;
+    for (size_t ii = 0; ii < n; ii += step) {
+        box.min = Min(box.min, p[ii]);
+        box.max = Max(box.max, p[ii + step - 1]);
+    }
+    return box;
+}
+inline float _HminSse(__m128 v)
+{
+    v = _mm_min_ps(v, _mm_shuffle_ps(v, v, AK_SWIZZLE(2, 3, 0, 1)));
+    return _mm_cvtss_f32(_mm_min_ss(v, _mm_shuffle_ps(v, v, AK_SWIZZLE(1, 0, 3, 2))));
+}
+inline float _HmaxSse(__m128 v)
+{
+    v = _mm_max_ps(v, _mm_shuffle_ps(v, v, AK_SWIZZLE(2, 3, 0, 1)));
+    return _mm_cvtss_f32(_mm_max_ss(v, _mm_shuffle_ps(v, v, AK_SWIZZLE(1, 0, 3, 2))));
+}
+// Reduces per-lane running bounds of x, y and z to a box. With `corners`, the mins of the odd
+// lanes and the maxes of the even lanes are replaced by the empty box's before reducing.
+inline Aabb _ReduceBoundsSse(__m128 const (&lo)[3], __m128 const (&hi)[3], bool const corners)
+{
+    __m128 const odd = _mm_castsi128_ps(_mm_setr_epi32(0, -1, 0, -1));
+    __m128 const minMask = corners ? odd : _mm_setzero_ps();
+    __m128 const maxMask = corners ? _mm_xor_ps(odd, _mm_castsi128_ps(_mm_set1_epi32(-1)))
+                                   : _mm_setzero_ps();
+    __m128 const big = _mm_set1_ps(FLT_MAX);
+    __m128 const small = _mm_set1_ps(-FLT_MAX);
+    float r[6];
+    for (int ii = 0; ii < 3; ++ii) {
+        r[ii] = _HminSse(_mm_or_ps(_mm_andnot_ps(minMask, lo[ii]), _mm_and_ps(minMask, big)));
+        r[3 + ii] = _HmaxSse(_mm_or_ps(_mm_andnot_ps(maxMask, hi[ii]), _mm_and_ps(maxMask, small)));
+    }
+    return {{r[0], r[1], r[2]}, {r[3], r[4], r[5]}};
+}
+inline Aabb _BoundsSse(Vec3 const* const p, size_t const n, bool const corners)
+{
+    __m128 lo[3] = {_mm_set1_ps(FLT_MAX), _mm_set1_ps(FLT_MAX), _mm_set1_ps(FLT_MAX)};
+    __m128 hi[3] = {_mm_set1_ps(-FLT_MAX), _mm_set1_ps(-FLT_MAX), _mm_set1_ps(-FLT_MAX)};
+    size_t ii = 0;
+    for (; ii + 4 <= n; ii += 4) {
+        __m128 v[3];
+        _LoadVec3x4Sse(p + ii, v[0], v[1], v[2]);
+        for (int cc = 0; cc < 3; ++cc) {
+            lo[cc] = _mm_min_ps(lo[cc], v[cc]);
+            hi[cc] = _mm_max_ps(hi[cc], v[cc]);
+        }
+    }
+    return Union(_ReduceBoundsSse(lo, hi, corners), _BoundsScalar(p + ii, n - ii, corners));
+}
+AK_TARGET_INLINE("avx2,fma")
+Aabb _BoundsAvx(Vec3 const* const p, size_t const n, bool const corners)
+{
+    Vec3x8 lo = Vec3x8::Splat({FLT_MAX, FLT_MAX, FLT_MAX});
+    Vec3x8 hi = Vec3x8::Splat({-FLT_MAX, -FLT_MAX, -FLT_MAX});
+    size_t ii = 0;
+    for (; ii + 8 <= n; ii += 8) {
+        Vec3x8 const v = Vec3x8::Load(p + ii);
+        lo = Min(lo, v);
+        hi = Max(hi, v);
+    }
+    // Eight lanes fold into four with the same parity
+    __m128 const lo4[3] = {
+        _mm_min_ps(_mm256_castps256_ps128(lo.x), _mm256_extractf128_ps(lo.x, 1)),
+        _mm_min_ps(_mm256_castps256_ps128(lo.y), _mm256_extractf128_ps(lo.y, 1)),
+        _mm_min_ps(_mm256_castps256_ps128(lo.z), _mm256_extractf128_ps(lo.z, 1)),
+    };
+    __m128 const hi4[3] = {
+        _mm_max_ps(_mm256_castps256_ps128(hi.x), _mm256_extractf128_ps(hi.x, 1)),
+        _mm_max_ps(_mm256_castps256_ps128(hi.y), _mm256_extractf128_ps(hi.y, 1)),
+        _mm_max_ps(_mm256_castps256_ps128(hi.z), _mm256_extractf128_ps(hi.z, 1)),
+    };
+    return Union(_ReduceBoundsSse(lo4, hi4, corners), _BoundsSse(p + ii, n - ii, corners));
+}
+AK_TARGET_INLINE("avx512f") __m128 _FoldMinAvx512(__m512 const v)
+{
+    __m256 const a = _mm512_castps512_ps256(v);
+    __m256 const b = _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(v), 1));
+    __m256 const m = _mm256_min_ps(a, b);
+    return _mm_min_ps(_mm256_castps256_ps128(m), _mm256_extractf128_ps(m, 1));
+}
+AK_TARGET_INLINE("avx512f") __m128 _FoldMaxAvx512(__m512 const v)
+{
+    __m256 const a = _mm512_castps512_ps256(v);
+    __m256 const b = _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(v), 1));
+    __m256 const m = _mm256_max_ps(a, b);
+    return _mm_max_ps(_mm256_castps256_ps128(m), _mm256_extractf128_ps(m, 1));
+}
+AK_TARGET_INLINE("avx512f")
+Aabb _BoundsAvx512(Vec3 const* const p, size_t const n, bool const corners)
+{
+    Vec3x16 lo = Vec3x16::Splat({FLT_MAX, FLT_MAX, FLT_MAX});
+    Vec3x16 hi = Vec3x16::Splat({-FLT_MAX, -FLT_MAX, -FLT_MAX});
+    size_t ii = 0;
+    for (; ii + 16 <= n; ii += 16) {
+        Vec3x16 const v = Vec3x16::Load(p + ii);
+        lo = Min(lo, v);
+        hi = Max(hi, v);
+    }
+    __m128 const lo4[3] = {_FoldMinAvx512(lo.x), _FoldMinAvx512(lo.y), _FoldMinAvx512(lo.z)};
+    __m128 const hi4[3] = {_FoldMaxAvx512(hi.x), _FoldMaxAvx512(hi.y), _FoldMaxAvx512(hi.z)};
+    return Union(_ReduceBoundsSse(lo4, hi4, corners), _BoundsAvx(p + ii, n - ii, corners));
+}
+inline Aabb _Bounds(Vec3 const* const p, size_t const n, bool const corners)
+{
+    switch (ActiveSimdLevel()) {
+        case SimdLevel::kAvx512:
+            return _BoundsAvx512(p, n, corners);
+        case SimdLevel::kAvx:
+            return _BoundsAvx(p, n, corners);
+        case SimdLevel::kSse:
+            return _BoundsSse(p, n, corners);
+        case SimdLevel::kScalar:
+            break;
+    }
+    return _BoundsScalar(p, n, corners);
+}
+
+inline Aabb AabbFromPointsScalar(Vec3 const* const points, size_t const n)
+{
+    return _BoundsScalar(points, n, false);
+}
+inline Aabb AabbFromPointsSse(Vec3 const* const points, size_t const n)
+{
+    return _BoundsSse(points, n, false);
+}
+AK_TARGET_INLINE("avx2,fma") Aabb AabbFromPointsAvx(Vec3 const* const points, size_t const n)
+{
+    return _BoundsAvx(points, n, false);
+}
+AK_TARGET_INLINE("avx512f") Aabb AabbFromPointsAvx512(Vec3 const* const points, size_t const n)
+{
+    return _BoundsAvx512(points, n, false);
+}
+inline Aabb AabbFromPoints(Vec3 const* const points, size_t const n)
+{
+    return _Bounds(points, n, false);
+}
+inline Aabb UnionScalar(Aabb const* const boxes, size_t const n)
+{
+    return _BoundsScalar(reinterpret_cast<Vec3 const*>(boxes), 2 * n, true);
+}
+inline Aabb UnionSse(Aabb const* const boxes, size_t const n)
+{
+    return _BoundsSse(reinterpret_cast<Vec3 const*>(boxes), 2 * n, true);
+}
+AK_TARGET_INLINE("avx2,fma") Aabb UnionAvx(Aabb const* const boxes, size_t const n)
+{
+    return _BoundsAvx(reinterpret_cast<Vec3 const*>(boxes), 2 * n, true);
+}
+AK_TARGET_INLINE("avx512f") Aabb UnionAvx512(Aabb const* const boxes, size_t const n)
+{
+    return _BoundsAvx512(reinterpret_cast<Vec3 const*>(boxes), 2 * n, true);
+}
+inline Aabb Union(Aabb const* const boxes, size_t const n)
+{
+    return _Bounds(reinterpret_cast<Vec3 const*>(boxes), 2 * n, true);
+}
+
+/*
+ * Plane and frustum classification
+ *
+ * A box is inside a plane when it lies entirely in the positive half-space. Each plane tests two
+ * corners: the one farthest along the normal decides outside, the nearest one inside. A box is
+ * outside a frustum when it is outside any plane, and inside when it is inside all of them.
+ * Boxes outside the frustum but straddling two planes near an edge classify as intersecting, and
+ * NaN distances classify as outside.
+ */
+enum class Containment : uint8_t {
+    kOutside = 0,
+    kIntersecting = 1,
+    kInside = 2
+};
+
+inline Containment Classify(Vec4 const plane, Aabb const& box)
+{
+    Vec3 const farthest = {plane.x >= 0.0f ? box.max.x : box.min.x,
+                           plane.y >= 0.0f ? box.max.y : box.min.y,
+                           plane.z >= 0.0f ? box.max.z : box.min.z};
+    Vec3 const nearest = {plane.x >= 0.0f ? box.min.x : box.max.x,
+                          plane.y >= 0.0f ? box.min.y : box.max.y,
+                          plane.z >= 0.0f ? box.min.z : box.max.z};
+    if (!(PlaneDistance(plane, farthest) >= 0.0f)) {
+        return Containment::kOutside;
+    }
+    return PlaneDistance(plane, nearest) >= 0.0f ? Containment::kInside
+                                                  : Containment::kIntersecting;
+}
+inline Containment Classify(Vec4 const* const planes, size_t const planeCount, Aabb const& box)
+{
+    Containment result = Containment::kInside;
+    for (size_t ii = 0; ii < planeCount; ++ii) {
+        Containment const c = Classify(planes[ii], box);
+        if (c == Containment::kOutside) {
+            return c;
+        }
+        result = c == Containment::kIntersecting ? c : result;
+    }
+    return result;
+}
+inline Containment Classify(Frustum const& f, Aabb const& box)
+{
+    return Classify(f.planes, Frustum::kPlaneCount, box);
+}
+
+// out[i] = Classify(planes, planeCount, boxes[i]). The SIMD kernels classify 4, 8 or 16 boxes
+// per pass over the planes and write the results as bytes.
+inline void ClassifyAabbsScalar(Vec4 const* const planes, size_t const planeCount,
+                                Aabb const* const boxes, Containment* const out, size_t const n)
+{
+    for (size_t ii = 0; ii < n; ++ii) {
+        out[ii] = Classify(planes, planeCount, boxes[ii]);
+    }
+}
+inline void ClassifyAabbsSse(Vec4 const* const planes, size_t const planeCount,
+                             Aabb const* const boxes, Containment* const out, size_t const n)
+{
+    size_t ii = 0;
+    for (; ii + 4 <= n; ii += 4) {
+        __m128 min[3], max[3];
+        _LoadAabbx4Sse(boxes + ii, min, max);
+        __m128 outside = _mm_setzero_ps();
+        __m128 straddle = _mm_setzero_ps();
+        for (size_t pp = 0; pp < planeCount; ++pp) {
+            Vec4 const plane = planes[pp];
+            __m128 const nx = _mm_set1_ps(plane.x);
+            __m128 const ny = _mm_set1_ps(plane.y);
+            __m128 const nz = _mm_set1_ps(plane.z);
+            __m128 const w = _mm_set1_ps(plane.w);
+            __m128 const df = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(nx, plane.x >= 0.0f ? max[0] : min[0]),
+                           _mm_mul_ps(ny, plane.y >= 0.0f ? max[1] : min[1])),
+                _mm_add_ps(_mm_mul_ps(nz, plane.z >= 0.0f ? max[2] : min[2]), w));
+            __m128 const dn = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(nx, plane.x >= 0.0f ? min[0] : max[0]),
+                           _mm_mul_ps(ny, plane.y >= 0.0f ? min[1] : max[1])),
+                _mm_add_ps(_mm_mul_ps(nz, plane.z >= 0.0f ? min[2] : max[2]), w));
+            outside = _mm_or_ps(outside, _mm_cmpnge_ps(df, _mm_setzero_ps()));
+            straddle = _mm_or_ps(straddle, _mm_cmpnge_ps(dn, _mm_setzero_ps()));
+        }
+        // 2 - straddle, or 0 when outside, narrowed to bytes
+        __m128i const c = _mm_andnot_si128(
+            _mm_castps_si128(outside),
+            _mm_add_epi32(_mm_set1_epi32(2), _mm_castps_si128(straddle)));
+        __m128i const c16 = _mm_packs_epi32(c, c);
+        int const c8 = _mm_cvtsi128_si32(_mm_packus_epi16(c16, c16));
+        memcpy(out + ii, &c8, sizeof(c8));
+    }
+    ClassifyAabbsScalar(planes, planeCount, boxes + ii, out + ii, n - ii);
+}
+AK_TARGET_INLINE("avx2,fma")
+void ClassifyAabbsAvx(Vec4 const* const planes, size_t const planeCount, Aabb const* const boxes,
+                      Containment* const out, size_t const n)
+{
+    size_t ii = 0;
+    for (; ii + 8 <= n; ii += 8) {
+        Vec3x8 min, max;
+        _LoadAabbx8Avx(boxes + ii, min, max);
+        __m256 outside = _mm256_setzero_ps();
+        __m256 straddle = _mm256_setzero_ps();
+        for (size_t pp = 0; pp < planeCount; ++pp) {
+            Vec4 const plane = planes[pp];
+            __m256 const nx = _mm256_set1_ps(plane.x);
+            __m256 const ny = _mm256_set1_ps(plane.y);
+            __m256 const nz = _mm256_set1_ps(plane.z);
+            __m256 const w = _mm256_set1_ps(plane.w);
+            __m256 df = _mm256_fmadd_ps(nz, plane.z >= 0.0f ? max.z : min.z, w);
+            __m256 dn = _mm256_fmadd_ps(nz, plane.z >= 0.0f ? min.z : max.z, w);
+            df = _mm256_fmadd_ps(ny, plane.y >= 0.0f ? max.y : min.y, df);
+            dn = _mm256_fmadd_ps(ny, plane.y >= 0.0f ? min.y : max.y, dn);
+            df = _mm256_fmadd_ps(nx, plane.x >= 0.0f ? max.x : min.x, df);
+            dn = _mm256_fmadd_ps(nx, plane.x >= 0.0f ? min.x : max.x, dn);
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(df, _mm256_setzero_ps(), _CMP_NGE_UQ));
+            straddle = _mm256_or_ps(straddle, _mm256_cmp_ps(dn, _mm256_setzero_ps(), _CMP_NGE_UQ));
+        }
+        __m256i const c = _mm256_andnot_si256(
+            _mm256_castps_si256(outside),
+            _mm256_add_epi32(_mm256_set1_epi32(2), _mm256_castps_si256(straddle)));
+        __m128i const c16 =
+            _mm_packs_epi32(_mm256_castsi256_si128(c), _mm256_extracti128_si256(c, 1));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + ii), _mm_packus_epi16(c16, c16));
+    }
+    ClassifyAabbsSse(planes, planeCount, boxes + ii, out + ii, n - ii);
+}
+AK_TARGET_INLINE("avx512f")
+void ClassifyAabbsAvx512(Vec4 const* const planes, size_t const planeCount,
+                         Aabb const* const boxes, Containment* const out, size_t const n)
+{
+    __m512i const one = _mm512_set1_epi32(1);
+    __m512i const two = _mm512_set1_epi32(2);
+    size_t ii = 0;
+    for (; ii + 16 <= n; ii += 16) {
+        Vec3x16 min, max;
+        _LoadAabbx16Avx512(boxes + ii, min, max);
+        __mmask16 outside = 0;
+        __mmask16 straddle = 0;
+        for (size_t pp = 0; pp < planeCount; ++pp) {
+            Vec4 const plane = planes[pp];
+            __m512 const nx = _mm512_set1_ps(plane.x);
+            __m512 const ny = _mm512_set1_ps(plane.y);
+            __m512 const nz = _mm512_set1_ps(plane.z);
+            __m512 const w = _mm512_set1_ps(plane.w);
+            __m512 df = _mm512_fmadd_ps(nz, plane.z >= 0.0f ? max.z : min.z, w);
+            __m512 dn = _mm512_fmadd_ps(nz, plane.z >= 0.0f ? min.z : max.z, w);
+            df = _mm512_fmadd_ps(ny, plane.y >= 0.0f ? max.y : min.y, df);
+            dn = _mm512_fmadd_ps(ny, plane.y >= 0.0f ? min.y : max.y, dn);
+            df = _mm512_fmadd_ps(nx, plane.x >= 0.0f ? max.x : min.x, df);
+            dn = _mm512_fmadd_ps(nx, plane.x >= 0.0f ? min.x : max.x, dn);
+            outside |= _mm512_cmp_ps_mask(df, _mm512_setzero_ps(), _CMP_NGE_UQ);
+            straddle |= _mm512_cmp_ps_mask(dn, _mm512_setzero_ps(), _CMP_NGE_UQ);
+        }
+        __m512i const c =
+            _mm512_maskz_mov_epi32(static_cast<__mmask16>(~outside),
+                                   _mm512_mask_blend_epi32(straddle, two, one));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + ii), _mm512_cvtepi32_epi8(c));
+    }
+    ClassifyAabbsAvx(planes, planeCount, boxes + ii, out + ii, n - ii);
+}
+inline void ClassifyAabbs(Vec4 const* const planes, size_t const planeCount,
+                          Aabb const* const boxes, Containment* const out, size_t const n)
+{
+    switch (ActiveSimdLevel()) {
+        case SimdLevel::kAvx512:
+            return ClassifyAabbsAvx512(planes, planeCount, boxes, out, n);
+        case SimdLevel::kAvx:
+            return ClassifyAabbsAvx(planes, planeCount, boxes, out, n);
+        case SimdLevel::kSse:
+            return ClassifyAabbsSse(planes, planeCount, boxes, out, n);
+        case SimdLevel::kScalar:
+            break;
+    }
+    ClassifyAabbsScalar(planes, planeCount, boxes, out, n);
+}
+// out[i] = Classify(f, boxes[i])
+inline void ClassifyAabbs(Frustum const& f, Aabb const* const boxes, Containment* const out,
+                          size_t const n)
+{
+    ClassifyAabbs(f.planes, Frustum::kPlaneCount, boxes, out, n);
+}
+
+
+/*****************************************************************************\
+ * Quat                                                                       *
+\*****************************************************************************/
+constexpr inline Quat Quat::Identity()
+{
+    return {0, 0, 0, 1};
+}
+inline Quat Quat::RotationAxis(Vec3 const axis, float const rad)
+{
+    Vec3 const normAxis = Normalize(axis);
+    float s, c;
+    SinCos(rad * 0.5f, s, c);
+    return {normAxis.x * s, normAxis.y * s, normAxis.z * s, c};
+}
+// out[i] = Quat::RotationAxis(axes[i], rad[i])
+inline void RotationAxisMany(Vec3 const* const axes, float const* const rad, Quat* const out,
+                             size_t const n)
+{
+    _ForEachSinCos(rad, 0.5f, n, [axes, out](size_t const ii, float const s, float const c) {
+        Vec3 const a = Normalize(axes[ii]);
+        out[ii] = {a.x * s, a.y * s, a.z * s, c};
+    });
+}
+// Shepperd's method: the largest of w, x, y and z is recovered from the diagonal, which keeps the
+// square root and the division away from zero. `m` must be a rotation.
+inline Quat Quat::FromMatrix(Mat3 const& m)
+{
+    float const trace = m.c0.x + m.c1.y + m.c2.z;
+    if (trace > 0.0f) {
+        float const s = 0.5f / sqrtf(trace + 1.0f);
+        return {(m.c1.z - m.c2.y) * s, (m.c2.x - m.c0.z) * s, (m.c0.y - m.c1.x) * s, 0.25f / s};
+    }
+    if (m.c0.x > m.c1.y && m.c0.x > m.c2.z) {
+        float const s = 0.5f / sqrtf(1.0f + m.c0.x - m.c1.y - m.c2.z);
+        return {0.25f / s, (m.c1.x + m.c0.y) * s, (m.c2.x + m.c0.z) * s, (m.c1.z - m.c2.y) * s};
+    }
+    if (m.c1.y > m.c2.z) {
+        float const s = 0.5f / sqrtf(1.0f + m.c1.y - m.c0.x - m.c2.z);
+        return {(m.c1.x + m.c0.y) * s, 0.25f / s, (m.c2.y + m.c1.z) * s, (m.c2.x - m.c0.z) * s};
+    }
+    float const s = 0.5f / sqrtf(1.0f + m.c2.z - m.c0.x - m.c1.y);
+    return {(m.c2.x + m.c0.z) * s, (m.c2.y + m.c1.z) * s, 0.25f / s, (m.c0.y - m.c1.x) * s};
+}
+inline Quat Quat::FromMatrix(Mat4 const& m)
+{
+    return FromMatrix(
+        Mat3{{m.c0.x, m.c0.y, m.c0.z}, {m.c1.x, m.c1.y, m.c1.z}, {m.c2.x, m.c2.y, m.c2.z}});
+}
+inline Mat3 Mat3::Rotation(Quat const q)
+{
+    float const xx = q.x * q.x;
+    float const yy = q.y * q.y;
+    float const zz = q.z * q.z;
+    float const xy = q.x * q.y;
+    float const xz = q.x * q.z;
+    float const yz = q.y * q.z;
+    float const xw = q.x * q.w;
+    float const yw = q.y * q.w;
+    float const zw = q.z * q.w;
+    return {
+        {1 - 2 * (yy + zz), 2 * (xy + zw), 2 * (xz - yw)},
+        {2 * (xy - zw), 1 - 2 * (xx + zz), 2 * (yz + xw)},
+        {2 * (xz + yw), 2 * (yz - xw), 1 - 2 * (xx + yy)},
+    };
+}
+inline Mat4 Mat4::Rotation(Quat const q)
+{
+    Mat3 const m = Mat3::Rotation(q);
+    return {
+        {m.c0.x, m.c0.y, m.c0.z, 0},
+        {m.c1.x, m.c1.y, m.c1.z, 0},
+        {m.c2.x, m.c2.y, m.c2.z, 0},
+        {0, 0, 0, 1},
+    };
+}
+inline Mat4 Mat4::FromTransform(Transform const& t)
+{
+    Mat3 const m = Mat3::Rotation(t.orientation);
+    float const s = t.scale;
+    return {
+        {m.c0.x * s, m.c0.y * s, m.c0.z * s, 0},
+        {m.c1.x * s, m.c1.y * s, m.c1.z * s, 0},
+        {m.c2.x * s, m.c2.y * s, m.c2.z * s, 0},
+        {t.position.x, t.position.y, t.position.z, 1},
+    };
+}
+
+constexpr inline float Dot(Quat const a, Quat const b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+}
+inline float Length(Quat const q)
+{
+    return sqrtf(Dot(q, q));
+}
+inline Quat Normalize(Quat const q)
+{
+    float const inv = 1.0f / Length(q);
+    return {q.x * inv, q.y * inv, q.z * inv, q.w * inv};
+}
+constexpr inline Quat Conjugate(Quat const q)
+{
+    return {-q.x, -q.y, -q.z, q.w};
+}
+// For unit quaternions this is the conjugate
+inline Quat Inverse(Quat const q)
+{
+    float const inv = 1.0f / Dot(q, q);
+    return {-q.x * inv, -q.y * inv, -q.z * inv, q.w * inv};
+}
+constexpr inline Quat operator-(Quat const q)
+{
+    return {-q.x, -q.y, -q.z, -q.w};
+}
+
+/*
+ * Multiply
+ *
+ * Hamilton product: a * b rotates by b, then by a, like Mat4 products. The SIMD form adds
+ * a.w * b and the other three components of `a` times a permutation of `b` with per-lane signs.
+ * The permutes stay within 128-bit lanes, so AVX2 and AVX-512 multiply two and four pairs at a
+ * time with the same sequence.
+ */
+constexpr inline Quat MultiplyScalar(Quat const a, Quat const b)
+{
+    return {
+        a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+        a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+        a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+        a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z,
+    };
+}
+AK_FORCEINLINE __m128 _QuatMultiplySse(__m128 const a, __m128 const b)
+{
+    __m128 const sx = _mm_castsi128_ps(_mm_setr_epi32(0, INT32_MIN, 0, INT32_MIN));
+    __m128 const sy = _mm_castsi128_ps(_mm_setr_epi32(0, 0, INT32_MIN, INT32_MIN));
+    __m128 const sz = _mm_castsi128_ps(_mm_setr_epi32(INT32_MIN, 0, 0, INT32_MIN));
+    __m128 r = _mm_mul_ps(_mm_shuffle_ps(a, a, AK_SWIZZLE(3, 3, 3, 3)), b);
+    r = _MulAddSse(_mm_xor_ps(_mm_shuffle_ps(a, a, AK_SWIZZLE(0, 0, 0, 0)), sx),
+                   _mm_shuffle_ps(b, b, AK_SWIZZLE(3, 2, 1, 0)), r);
+    r = _MulAddSse(_mm_xor_ps(_mm_shuffle_ps(a, a, AK_SWIZZLE(1, 1, 1, 1)), sy),
+                   _mm_shuffle_ps(b, b, AK_SWIZZLE(2, 3, 0, 1)), r);
+    r = _MulAddSse(_mm_xor_ps(_mm_shuffle_ps(a, a, AK_SWIZZLE(2, 2, 2, 2)), sz),
+                   _mm_shuffle_ps(b, b, AK_SWIZZLE(1, 0, 3, 2)), r);
+    return r;
+}
+AK_FORCEINLINE Quat MultiplySse(Quat const a, Quat const b)
+{
+    Quat result;
+    _mm_store_ps(&result.x, _QuatMultiplySse(_mm_load_ps(&a.x), _mm_load_ps(&b.x)));
+    return result;
+}
+AK_FORCEINLINE Quat operator*(Quat const a, Quat const b)
+{
+    return MultiplySse(a, b);
+}
+
+// Rotates without building a matrix: with u = q.xyz and c = Cross(u, v), the result is
+// v + 2 * (q.w * c + Cross(u, c)). To rotate many vectors by one quaternion, transform them by
+// Mat3::Rotation(q) or Mat4::Rotation(q) instead, which costs less per vector.
+AK_FORCEINLINE __m128 _CrossSse(__m128 const a, __m128 const b)
+{
+    // (a * b.yzx - a.yzx * b).yzx
+    __m128 const c = _mm_sub_ps(_mm_mul_ps(a, _mm_shuffle_ps(b, b, AK_SWIZZLE(1, 2, 0, 3))),
+                                _mm_mul_ps(_mm_shuffle_ps(a, a, AK_SWIZZLE(1, 2, 0, 3)), b));
+    return _mm_shuffle_ps(c, c, AK_SWIZZLE(1, 2, 0, 3));
+}
+AK_FORCEINLINE Vec3 Rotate(Quat const q, Vec3 const v)
+{
+    __m128 const u = _mm_load_ps(&q.x);
+    __m128 const p = _mm_setr_ps(v.x, v.y, v.z, 0.0f);
+    __m128 const uv = _CrossSse(u, p);
+    __m128 const t = _mm_add_ps(_mm_mul_ps(uv, _mm_shuffle_ps(u, u, AK_SWIZZLE(3, 3, 3, 3))),
+                                _CrossSse(u, uv));
+    Vec4 result;
+    _mm_store_ps(&result.x, _mm_add_ps(p, _mm_add_ps(t, t)));
+    return {result.x, result.y, result.z};
+}
+inline Vec3 operator*(Quat const q, Vec3 const v)
+{
+    return Rotate(q, v);
+}
+
+/*
+ * Interpolation
+ *
+ * Both take the shorter arc: `b` is negated when Dot(a, b) < 0. Nlerp normalizes the linear
+ * blend, which is cheap and exact at the ends but not constant-speed. Slerp is constant-speed
+ * and falls back to Nlerp when the quaternions are within about 2 degrees, where sin(theta)
+ * loses precision.
+ */
+inline Quat Nlerp(Quat const a, Quat b, float const t)
+{
+    b = Dot(a, b) < 0.0f ? -b : b;
+    return Normalize(Quat{a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t,
+                          a.w + (b.w - a.w) * t});
+}
+inline Quat Slerp(Quat const a, Quat b, float const t)
+{
+    float cosTheta = Dot(a, b);
+    if (cosTheta < 0.0f) {
+        b = -b;
+        cosTheta = -cosTheta;
+    }
+    if (cosTheta > 0.9995f) {
+        return Nlerp(a, b, t);
+    }
+    float const theta = acosf(cosTheta);
+    float const inv = 1.0f / sinf(theta);
+    float const wa = sinf((1.0f - t) * theta) * inv;
+    float const wb = sinf(t * theta) * inv;
+    return {a.x * wa + b.x * wb, a.y * wa + b.y * wb, a.z * wa + b.z * wb, a.w * wa + b.w * wb};
+}
+
+/*
+ * Batched multiply and blending
+ *
+ * out[i] = a[i] * b[i] and out[i] = Nlerp(a[i], b[i], t), for blending two poses with one
+ * weight. `out` may be the same array as `a` or `b`, but must not partially overlap either.
+ * Quaternions stay packed: the AVX2 and AVX-512 kernels process two and four per register with
+ * in-lane shuffles, so arrays only need Quat's 16-byte alignment.
+ */
+inline void MultiplyManyScalar(Quat const* const a, Quat const* const b, Quat* const out,
+                               size_t const n)
+{
+    for (size_t ii = 0; ii < n; ++ii) {
+        out[ii] = MultiplyScalar(a[ii], b[ii]);
+    }
+}
+inline void MultiplyManySse(Quat const* const a, Quat const* const b, Quat* const out,
+                            size_t const n)
+{
+    for (size_t ii = 0; ii < n; ++ii) {
+        _mm_store_ps(&out[ii].x, _QuatMultiplySse(_mm_load_ps(&a[ii].x), _mm_load_ps(&b[ii].x)));
+    }
+}
+AK_TARGET_INLINE("avx2,fma") __m256 _QuatMultiplyAvx(__m256 const a, __m256 const b)
+{
+    __m256 const sx = _mm256_castsi256_ps(
+        _mm256_setr_epi32(0, INT32_MIN, 0, INT32_MIN, 0, INT32_MIN, 0, INT32_MIN));
+    __m256 const sy = _mm256_castsi256_ps(
+        _mm256_setr_epi32(0, 0, INT32_MIN, INT32_MIN, 0, 0, INT32_MIN, INT32_MIN));
+    __m256 const sz = _mm256_castsi256_ps(
+        _mm256_setr_epi32(INT32_MIN, 0, 0, INT32_MIN, INT32_MIN, 0, 0, INT32_MIN));
+    __m256 r = _mm256_mul_ps(_mm256_permute_ps(a, AK_SWIZZLE(3, 3, 3, 3)), b);
+    r = _mm256_fmadd_ps(_mm256_xor_ps(_mm256_permute_ps(a, AK_SWIZZLE(0, 0, 0, 0)), sx),
+                        _mm256_permute_ps(b, AK_SWIZZLE(3, 2, 1, 0)), r);
+    r = _mm256_fmadd_ps(_mm256_xor_ps(_mm256_permute_ps(a, AK_SWIZZLE(1, 1, 1, 1)), sy),
+                        _mm256_permute_ps(b, AK_SWIZZLE(2, 3, 0, 1)), r);
+    r = _mm256_fmadd_ps(_mm256_xor_ps(_mm256_permute_ps(a, AK_SWIZZLE(2, 2, 2, 2)), sz),
+                        _mm256_permute_ps(b, AK_SWIZZLE(1, 0, 3, 2)), r);
+    return r;
+}
+AK_TARGET_INLINE("avx2,fma")
+void MultiplyManyAvx(Quat const* const a, Quat const* const b, Quat* const out, size_t const n)
+{
+    size_t ii = 0;
+    for (; ii + 2 <= n; ii += 2) {
+        __m256 const r = _QuatMultiplyAvx(_mm256_loadu_ps(&a[ii].x), _mm256_loadu_ps(&b[ii].x));
+        _mm256_storeu_ps(&out[ii].x, r);
+    }
+    MultiplyManySse(a + ii, b + ii, out + ii, n - ii);
+}
+AK_TARGET_INLINE("avx512f") __m512 _QuatMultiplyAvx512(__m512 const a, __m512 const b)
+{
+    // Masked subtracts from zero negate the lanes that _QuatMultiplySse flips with xor
+    __m512 const zero = _mm512_setzero_ps();
+    __m512 const ax = _mm512_permute_ps(a, AK_SWIZZLE(0, 0, 0, 0));
+    __m512 const ay = _mm512_permute_ps(a, AK_SWIZZLE(1, 1, 1, 1));
+    __m512 const az = _mm512_permute_ps(a, AK_SWIZZLE(2, 2, 2, 2));
+    __m512 r = _mm512_mul_ps(_mm512_permute_ps(a, AK_SWIZZLE(3, 3, 3, 3)), b);
+    r = _mm512_fmadd_ps(_mm512_mask_sub_ps(ax, 0xaaaa, zero, ax),
+                        _mm512_permute_ps(b, AK_SWIZZLE(3, 2, 1, 0)), r);
+    r = _mm512_fmadd_ps(_mm512_mask_sub_ps(ay, 0xcccc, zero, ay),
+                        _mm512_permute_ps(b, AK_SWIZZLE(2, 3, 0, 1)), r);
+    r = _mm512_fmadd_ps(_mm512_mask_sub_ps(az, 0x9999, zero, az),
+                        _mm512_permute_ps(b, AK_SWIZZLE(1, 0, 3, 2)), r);
+    return r;
+}
+AK_TARGET_INLINE("avx512f")
+void MultiplyManyAvx512(Quat const* const a, Quat const* const b, Quat* const out,
+                        size_t const n)
+{
+    size_t ii = 0;
+    for (; ii + 4 <= n; ii += 4) {
+        __m512 const r = _QuatMultiplyAvx512(_mm512_loadu_ps(&a[ii].x), _mm512_loadu_ps(&b[ii].x));
+        _mm512_storeu_ps(&out[ii].x, r);
+    }
+    MultiplyManyAvx(a + ii, b + ii, out + ii, n - ii);
+}
+inline void MultiplyMany(Quat const* const a, Quat const* const b, Quat* const out,
+                         size_t const n)
+{
+    switch (ActiveSimdLevel()) {
+        case SimdLevel::kAvx512:
+            return MultiplyManyAvx512(a, b, out, n);
+        case SimdLevel::kAvx:
+            return MultiplyManyAvx(a, b, out, n);
+        case SimdLevel::kSse:
+            return MultiplyManySse(a, b, out, n);
+        case SimdLevel::kScalar:
+            break;
+    }
+    MultiplyManyScalar(a, b, out, n);
+}
+
+inline void NlerpManyScalar(Quat const* const a, Quat const* const b, float const t,
+                            Quat* const out, size_t const n)
+{
+    for (size_t ii = 0; ii < n; ++ii) {
+        out[ii] = Nlerp(a[ii], b[ii], t);
+    }
+}
+// Dot products are summed within each quaternion's four lanes and splatted across them
+inline __m128 _QuatNlerpSse(__m128 const a, __m128 b, __m128 const t)
+{
+    __m128 const sign = _mm_set1_ps(-0.0f);
+    b = _mm_xor_ps(b, _mm_and_ps(_mm_cmplt_ps(_HaddSplatSse(_mm_mul_ps(a, b)), _mm_setzero_ps()),
+                                 sign));
+    __m128 const r = _MulAddSse(_mm_sub_ps(b, a), t, a);
+    return _mm_div_ps(r, _mm_sqrt_ps(_HaddSplatSse(_mm_mul_ps(r, r))));
+}
+inline void NlerpManySse(Quat const* const a, Quat const* const b, float const t, Quat* const out,
+                         size_t const n)
+{
+    __m128 const tt = _mm_set1_ps(t);
+    for (size_t ii = 0; ii < n; ++ii) {
+        _mm_store_ps(&out[ii].x, _QuatNlerpSse(_mm_load_ps(&a[ii].x), _mm_load_ps(&b[ii].x), tt));
+    }
+}
+AK_TARGET_INLINE("avx2,fma") __m256 _HaddSplatAvx(__m256 v)
+{
+    v = _mm256_add_ps(v, _mm256_permute_ps(v, AK_SWIZZLE(1, 0, 3, 2)));
+    return _mm256_add_ps(v, _mm256_permute_ps(v, AK_SWIZZLE(2, 3, 0, 1)));
+}
+AK_TARGET_INLINE("avx2,fma")
+void NlerpManyAvx(Quat const* const a, Quat const* const b, float const t, Quat* const out,
+                  size_t const n)
+{
+    __m256 const tt = _mm256_set1_ps(t);
+    __m256 const sign = _mm256_set1_ps(-0.0f);
+    size_t ii = 0;
+    for (; ii + 2 <= n; ii += 2) {
+        __m256 const qa = _mm256_loadu_ps(&a[ii].x);
+        __m256 qb = _mm256_loadu_ps(&b[ii].x);
+        __m256 const d = _HaddSplatAvx(_mm256_mul_ps(qa, qb));
+        qb = _mm256_xor_ps(qb, _mm256_and_ps(_mm256_cmp_ps(d, _mm256_setzero_ps(), _CMP_LT_OQ),
+                                             sign));
+        __m256 const r = _mm256_fmadd_ps(_mm256_sub_ps(qb, qa), tt, qa);
+        _mm256_storeu_ps(&out[ii].x,
+                         _mm256_div_ps(r, _mm256_sqrt_ps(_HaddSplatAvx(_mm256_mul_ps(r, r)))));
+    }
+    NlerpManySse(a + ii, b + ii, t, out + ii, n - ii);
+}
+AK_TARGET_INLINE("avx512f") __m512 _HaddSplatAvx512(__m512 v)
+{
+    v = _mm512_add_ps(v, _mm512_permute_ps(v, AK_SWIZZLE(1, 0, 3, 2)));
+    return _mm512_add_ps(v, _mm512_permute_ps(v, AK_SWIZZLE(2, 3, 0, 1)));
+}
+AK_TARGET_INLINE("avx512f")
+void NlerpManyAvx512(Quat const* const a, Quat const* const b, float const t, Quat* const out,
+                     size_t const n)
+{
+    __m512 const tt = _mm512_set1_ps(t);
+    __m512 const zero = _mm512_setzero_ps();
+    size_t ii = 0;
+    for (; ii + 4 <= n; ii += 4) {
+        __m512 const qa = _mm512_loadu_ps(&a[ii].x);
+        __m512 qb = _mm512_loadu_ps(&b[ii].x);
+        __mmask16 const flip =
+            _mm512_cmp_ps_mask(_HaddSplatAvx512(_mm512_mul_ps(qa, qb)), zero, _CMP_LT_OQ);
+        qb = _mm512_mask_sub_ps(qb, flip, zero, qb);
+        __m512 const r = _mm512_fmadd_ps(_mm512_sub_ps(qb, qa), tt, qa);
+        _mm512_storeu_ps(&out[ii].x,
+                         _mm512_div_ps(r, _mm512_sqrt_ps(_HaddSplatAvx512(_mm512_mul_ps(r, r)))));
+    }
+    NlerpManyAvx(a + ii, b + ii, t, out + ii, n - ii);
+}
+inline void NlerpMany(Quat const* const a, Quat const* const b, float const t, Quat* const out,
+                      size_t const n)
+{
+    switch (ActiveSimdLevel()) {
+        case SimdLevel::kAvx512:
+            return NlerpManyAvx512(a, b, t, out, n);
+        case SimdLevel::kAvx:
+            return NlerpManyAvx(a, b, t, out, n);
+        case SimdLevel::kSse:
+            return NlerpManySse(a, b, t, out, n);
+        case SimdLevel::kScalar:
+            break;
+    }
+    NlerpManyScalar(a, b, t, out, n);
+}
+// Scalar only, as each element needs acosf and sinf. Use NlerpMany where constant speed isn't
+// needed.
+inline void SlerpMany(Quat const* const a, Quat const* const b, float const t, Quat* const out,
+                      size_t const n)
+{
+    for (size_t ii = 0; ii < n; ++ii) {
+        out[ii] = Slerp(a[ii], b[ii], t);
+    }
+}
+
+
+/*****************************************************************************\
+ * Poses                                                                      *
+\*****************************************************************************/
+// PoseSoA stores `count` bone transforms as eight lanes in one block laid out like Vec4SoA's: the
+// quaternion's x, y, z and w, the position's x, y and z, then the scale.
+struct PoseSoA
+{
+    PoseSoA() = default;
+    inline explicit PoseSoA(size_t const n);
+    inline PoseSoA(PoseSoA&& other);
+    inline PoseSoA& operator=(PoseSoA&& other);
+    PoseSoA(PoseSoA const&) = delete;
+    PoseSoA& operator=(PoseSoA const&) = delete;
+    inline ~PoseSoA();
+
+    inline Transform Get(size_t const ii) const;
+    inline void Set(size_t const ii, Transform const& t);
+
+    float* qx = nullptr;
+    float* qy = nullptr;
+    float* qz = nullptr;
+    float* qw = nullptr;
+    float* px = nullptr;
+    float* py = nullptr;
+    float* pz = nullptr;
+    float* scale = nullptr;
+    size_t count = 0;
+};
+
+inline PoseSoA::PoseSoA(size_t const n) : qx(_AllocateLanes(n, 8)), count(n)
+{
+    qy = qx + _SoAStride(n);
+    qz = qy + _SoAStride(n);
+    qw = qz + _SoAStride(n);
+    px = qw + _SoAStride(n);
+    py = px + _SoAStride(n);
+    pz = py + _SoAStride(n);
+    scale = pz + _SoAStride(n);
+}
+inline PoseSoA::PoseSoA(PoseSoA&& other)
+    : qx(other.qx)
+    , qy(other.qy)
+    , qz(other.qz)
+    , qw(other.qw)
+    , px(other.px)
+    , py(other.py)
+    , pz(other.pz)
+    , scale(other.scale)
+    , count(other.count)
+{
+    other.qx = other.qy = other.qz = other.qw = nullptr;
+    other.px = other.py = other.pz = other.scale = nullptr;
+    other.count = 0;
+}
+inline PoseSoA& PoseSoA::operator=(PoseSoA&& other)
+{
+    if (this != &other) {
+        _mm_free(qx);
+        qx = other.qx;
+        qy = other.qy;
+        qz = other.qz;
+        qw = other.qw;
+        px = other.px;
+        py = other.py;
+        pz = other.pz;
+        scale = other.scale;
+        count = other.count;
+        other.qx = other.qy = other.qz = other.qw = nullptr;
+        other.px = other.py = other.pz = other.scale = nullptr;
+        other.count = 0;
+    }
+    return *this;
+}
+inline PoseSoA::~PoseSoA()
+{
+    _mm_free(qx);
+}
+inline Transform PoseSoA::Get(size_t const ii) const
+{
+    assert(ii < count);
+    return {{qx[ii], qy[ii], qz[ii], qw[ii]}, {px[ii], py[ii], pz[ii]}, scale[ii]};
+}
+inline void PoseSoA::Set(size_t const ii, Transform const& t)
+{
+    assert(ii < count);
+    qx[ii] = t.orientation.x;
+    qy[ii] = t.orientation.y;
+    qz[ii] = t.orientation.z;
+    qw[ii] = t.orientation.w;
+    px[ii] = t.position.x;
+    py[ii] = t.position.y;
+    pz[ii] = t.position.z;
+    scale[ii] = t.scale;
+}
+
+// Lane kk of a pose: 0-3 are the rotation, 4-6 the position and 7 the scale
+inline float* _PoseLane(PoseSoA const& pose, int const kk)
+{
+    return pose.qx + kk * _SoAStride(pose.count);
+}
+
+/*
+ * Rotation blends
+ *
+ * Each blends rotations a and b with weight t for b as ca * a + cb * b. cb takes the sign of
+ * Dot(a, b), so the blend follows the shorter arc.
+ *
+ * _NlerpRotations normalizes the result, like Nlerp.
+ *
+ * _SlerpRotations gets ca and cb for Slerp without acos or sin, from Eberly's product
+ * approximation of sin(t * theta) / sin(theta) as a polynomial in t and cos(theta) ("A Fast and
+ * Accurate Algorithm for Computing SLERP", 2011). Twelve terms, with the last tuned to minimize the
+ * maximum error, bound the coefficient error by 7.2e-7 for any t in [0, 1].
+ */
+struct _SlerpPolynomial
+{
+    enum { kTerms = 12 };
+    static float U(int const ii)
+    {
+        static float const u[kTerms] = {
+            1.0f / 3,   1.0f / 10,  1.0f / 21,  1.0f / 36,  1.0f / 55,  1.0f / 78,
+            1.0f / 105, 1.0f / 136, 1.0f / 171, 1.0f / 210, 1.0f / 253, 1.8937130f / 300,
+        };
+        return u[ii];
+    }
+    static float V(int const ii)
+    {
+        static float const v[kTerms] = {
+            1.0f / 3,  2.0f / 5,   3.0f / 7,   4.0f / 9,   5.0f / 11,  6.0f / 13,
+            7.0f / 15, 8.0f / 17,  9.0f / 19,  10.0f / 21, 11.0f / 23, 1.8937130f * 12 / 25,
+        };
+        return v[ii];
+    }
+};
+
+struct _NlerpRotations
+{
+    void Scalar(float const (&a)[4], float const (&b)[4], float const t, float (&out)[4]) const
+    {
+        float const d = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+        float const cb = d < 0.0f ? -t : t;
+        for (int kk = 0; kk < 4; ++kk) {
+            out[kk] = a[kk] * (1.0f - t) + b[kk] * cb;
+        }
+        float const inv =
+            1.0f / sqrtf(out[0] * out[0] + out[1] * out[1] + out[2] * out[2] + out[3] * out[3]);
+        for (int kk = 0; kk < 4; ++kk) {
+            out[kk] *= inv;
+        }
+    }
+    void Sse(__m128 const (&a)[4], __m128 const (&b)[4], __m128 const t, __m128 (&out)[4]) const
+    {
+        __m128 const d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a[0], b[0]), _mm_mul_ps(a[1], b[1])),
+                                    _mm_add_ps(_mm_mul_ps(a[2], b[2]), _mm_mul_ps(a[3], b[3])));
+        __m128 const cb =
+            _mm_xor_ps(t, _mm_and_ps(_mm_cmplt_ps(d, _mm_setzero_ps()), _mm_set1_ps(-0.0f)));
+        __m128 const ca = _mm_sub_ps(_mm_set1_ps(1.0f), t);
+        __m128 lengthSq = _mm_setzero_ps();
+        for (int kk = 0; kk < 4; ++kk) {
+            out[kk] = _mm_add_ps(_mm_mul_ps(a[kk], ca), _mm_mul_ps(b[kk], cb));
+            lengthSq = _mm_add_ps(lengthSq, _mm_mul_ps(out[kk], out[kk]));
+        }
+        __m128 const inv = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(lengthSq));
+        for (int kk = 0; kk < 4; ++kk) {
+            out[kk] = _mm_mul_ps(out[kk], inv);
+        }
+    }
+    AK_TARGET_INLINE("avx2,fma")
+    void Avx(__m256 const (&a)[4], __m256 const (&b)[4], __m256 const t, __m256 (&out)[4]) const
+    {
+        __m256 d = _mm256_mul_ps(a[0], b[0]);
+        d = _mm256_fmadd_ps(a[1], b[1], d);
+        d = _mm256_fmadd_ps(a[2], b[2], d);
+        d = _mm256_fmadd_ps(a[3], b[3], d);
+        __m256 const cb = _mm256_xor_ps(
+            t, _mm256_and_ps(_mm256_cmp_ps(d, _mm256_setzero_ps(), _CMP_LT_OQ),
+                             _mm256_set1_ps(-0.0f)));
+        __m256 const ca = _mm256_sub_ps(_mm256_set1_ps(1.0f), t);
+        __m256 lengthSq = _mm256_setzero_ps();
+        for (int kk = 0; kk < 4; ++kk) {
+            out[kk] = _mm256_fmadd_ps(a[kk], ca, _mm256_mul_ps(b[kk], cb));
+            lengthSq = _mm256_fmadd_ps(out[kk], out[kk], lengthSq);
+        }
+        __m256 const inv = _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_sqrt_ps(lengthSq));
+        for (int kk = 0; kk < 4; ++kk) {
+            out[kk] = _mm256_mul_ps(out[kk], inv);
+        }
+    }
+    AK_TARGET_INLINE("avx512f")
+    void Avx512(__m512 const (&a)[4], __m512 const (&b)[4], __m512 const t,
+                __m512 (&out)[4]) const
+    {
+        __m512 d = _mm512_mul_ps(a[0], b[0]);
+        d = _mm512_fmadd_ps(a[1], b[1], d);
+        d = _mm512_fmadd_ps(a[2], b[2], d);
+        d = _mm512_fmadd_ps(a[3], b[3], d);
+        __mmask16 const flip = _mm512_cmp_ps_mask(d, _mm512_setzero_ps(), _CMP_LT_OQ);
+        __m512 const cb = _mm512_mask_sub_ps(t, flip, _mm512_setzero_ps(), t);
+        __m512 const ca = _mm512_sub_ps(_mm512_set1_ps(1.0f), t);
+        __m512 lengthSq = _mm512_setzero_ps();
+        for (int kk = 0; kk < 4; ++kk) {
+            out[kk] = _mm512_fmadd_ps(a[kk], ca, _mm512_mul_ps(b[kk], cb));
+            lengthSq = _mm512_fmadd_ps(out[kk], out[kk], lengthSq);
+        }
+        __m512 const inv = _mm512_div_ps(_mm512_set1_ps(1.0f), _mm512_sqrt_ps(lengthSq));
+        for (int kk = 0; kk < 4; ++kk) {
+            out[kk] = _mm512_mul_ps(out[kk], inv);
+        }
+    }
+};
+struct _SlerpRotations
+{
+    void Scalar(float const (&a)[4], float const (&b)[4], float const t, float (&out)[4]) const
+    {
+        float const d = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+        float const xm1 = fabsf(d) - 1.0f;
+        float const s = 1.0f - t;
+        float rt = 1.0f;
+        float rs = 1.0f;
+        for (int ii = _SlerpPolynomial::kTerms - 1; ii >= 0; --ii) {
+            float const u = _SlerpPolynomial::U(ii);
+            float const v = _SlerpPolynomial::V(ii);
+            rt = 1.0f + (u * t * t - v) * xm1 * rt;
+            rs = 1.0f + (u * s * s - v) * xm1 * rs;
+        }
+        float const ca = s * rs;
+        float const cb = d < 0.0f ? -t * rt : t * rt;
+        for (int kk = 0; kk < 4; ++kk) {
+            out[kk] = a[kk] * ca + b[kk] * cb;
+        }
+    }
+    void Sse(__m128 const (&a)[4], __m128 const (&b)[4], __m128 const t, __m128 (&out)[4]) const
+    {
+        __m128 const sign = _mm_set1_ps(-0.0f);
+        __m128 const one = _mm_set1_ps(1.0f);
+        __m128 const d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a[0], b[0]), _mm_mul_ps(a[1], b[1])),
+                                    _mm_add_ps(_mm_mul_ps(a[2], b[2]), _mm_mul_ps(a[3], b[3])));
+        __m128 const xm1 = _mm_sub_ps(_mm_andnot_ps(sign, d), one);
+        __m128 const s = _mm_sub_ps(one, t);
+        __m128 const tt = _mm_mul_ps(t, t);
+        __m128 const ss = _mm_mul_ps(s, s);
+        __m128 rt = one;
+        __m128 rs = one;
+        for (int ii = _SlerpPolynomial::kTerms - 1; ii >= 0; --ii) {
+            __m128 const u = _mm_set1_ps(_SlerpPolynomial::U(ii));
+            __m128 const v = _mm_set1_ps(_SlerpPolynomial::V(ii));
+            rt = _mm_add_ps(one, _mm_mul_ps(_mm_mul_ps(_mm_sub_ps(_mm_mul_ps(u, tt), v), xm1), rt));
+            rs = _mm_add_ps(one, _mm_mul_ps(_mm_mul_ps(_mm_sub_ps(_mm_mul_ps(u, ss), v), xm1), rs));
+        }
+        __m128 const ca = _mm_mul_ps(s, rs);
+        __m128 const cb = _mm_xor_ps(_mm_mul_ps(t, rt),
+                                     _mm_and_ps(_mm_cmplt_ps(d, _mm_setzero_ps()), sign));
+        for (int kk = 0; kk < 4; ++kk) {
+            out[kk] = _mm_add_ps(_mm_mul_ps(a[kk], ca), _mm_mul_ps(b[kk], cb));
+        }
+    }
+    AK_TARGET_INLINE("avx2,fma")
+    void Avx(__m256 const (&a)[4], __m256 const (&b)[4], __m256 const t, __m256 (&out)[4]) const
+    {
+        __m256 const sign = _mm256_set1_ps(-0.0f);
+        __m256 const one = _mm256_set1_ps(1.0f);
+        __m256 d = _mm256_mul_ps(a[0], b[0]);
+        d = _mm256_fmadd_ps(a[1], b[1], d);
+        d = _mm256_fmadd_ps(a[2], b[2], d);
+        d = _mm256_fmadd_ps(a[3], b[3], d);
+        __m256 const xm1 = _mm256_sub_ps(_mm256_andnot_ps(sign, d), one);
+        __m256 const s = _mm256_sub_ps(one, t);
+        __m256 const tt = _mm256_mul_ps(t, t);
+        __m256 const ss = _mm256_mul_ps(s, s);
+        __m256 rt = one;
+        __m256 rs = one;
+        for (int ii = _SlerpPolynomial::kTerms - 1; ii >= 0; --ii) {
+            __m256 const u = _mm256_set1_ps(_SlerpPolynomial::U(ii));
+            __m256 const v = _mm256_set1_ps(_SlerpPolynomial::V(ii));
+            rt = _mm256_fmadd_ps(_mm256_mul_ps(_mm256_fmsub_ps(u, tt, v), xm1), rt, one);
+            rs = _mm256_fmadd_ps(_mm256_mul_ps(_mm256_fmsub_ps(u, ss, v), xm1), rs, one);
+        }
+        __m256 const ca = _mm256_mul_ps(s, rs);
+        __m256 const cb = _mm256_xor_ps(
+            _mm256_mul_ps(t, rt),
+            _mm256_and_ps(_mm256_cmp_ps(d, _mm256_setzero_ps(), _CMP_LT_OQ), sign));
+        for (int kk = 0; kk < 4; ++kk) {
+            out[kk] = _mm256_fmadd_ps(a[kk], ca, _mm256_mul_ps(b[kk], cb));
+        }
+    }
+    AK_TARGET_INLINE("avx512f")
+    void Avx512(__m512 const (&a)[4], __m512 const (&b)[4], __m512 const t,
+                __m512 (&out)[4]) const
+    {
+        __m512 const one = _mm512_set1_ps(1.0f);
+        __m512 d = _mm512_mul_ps(a[0], b[0]);
+        d = _mm512_fmadd_ps(a[1], b[1], d);
+        d = _mm512_fmadd_ps(a[2], b[2], d);
+        d = _mm512_fmadd_ps(a[3], b[3], d);
+        __mmask16 const flip = _mm512_cmp_ps_mask(d, _mm512_setzero_ps(), _CMP_LT_OQ);
+        __m512 const xm1 = _mm512_sub_ps(_mm512_abs_ps(d), one);
+        __m512 const s = _mm512_sub_ps(one, t);
+        __m512 const tt = _mm512_mul_ps(t, t);
+        __m512 const ss = _mm512_mul_ps(s, s);
+        __m512 rt = one;
+        __m512 rs = one;
+        for (int ii = _SlerpPolynomial::kTerms - 1; ii >= 0; --ii) {
+            __m512 const u = _mm512_set1_ps(_SlerpPolynomial::U(ii));
+            __m512 const v = _mm512_set1_ps(_SlerpPolynomial::V(ii));
+            rt = _mm512_fmadd_ps(_mm512_mul_ps(_mm512_fmsub_ps(u, tt, v), xm1), rt, one);
+            rs = _mm512_fmadd_ps(_mm512_mul_ps(_mm512_fmsub_ps(u, ss, v), xm1), rs, one);
+        }
+        __m512 const ca = _mm512_mul_ps(s, rs);
+        __m512 cb = _mm512_mul_ps(t, rt);
+        cb = _mm512_mask_sub_ps(cb, flip, _mm512_setzero_ps(), cb);
+        for (int kk = 0; kk < 4; ++kk) {
+            out[kk] = _mm512_fmadd_ps(a[kk], ca, _mm512_mul_ps(b[kk], cb));
+        }
+    }
+};
+
+/*
+ * Two-pose blends
+ *
+ * out bone i = a bone i blended towards b bone i by weights[i]: 0 gives a, 1 gives b. Positions
+ * and scales are lerped. All three poses must have the same count; `out` may be `a` or `b`.
+ */
+template<typename Op>
+inline void _BlendPosesScalar(Op const op, PoseSoA const& a, PoseSoA const& b,
+                              float const* const weights, PoseSoA& out, size_t const begin)
+{
+    for (size_t ii = begin; ii < out.count; ++ii) {
+        float const t = weights[ii];
+        float const qa[4] = {a.qx[ii], a.qy[ii], a.qz[ii], a.qw[ii]};
+        float const qb[4] = {b.qx[ii], b.qy[ii], b.qz[ii], b.qw[ii]};
+        float q[4];
+        op.Scalar(qa, qb, t, q);
+        for (int kk = 0; kk < 8; ++kk) {
+            float const va = _PoseLane(a, kk)[ii];
+            _PoseLane(out, kk)[ii] = kk < 4 ? q[kk] : va + (_PoseLane(b, kk)[ii] - va) * t;
+        }
+    }
+}
+template<typename Op>
+inline void _BlendPosesSse(Op const op, PoseSoA const& a, PoseSoA const& b,
+                           float const* const weights, PoseSoA& out)
+{
+    size_t ii = 0;
+    for (; ii + 4 <= out.count; ii += 4) {
+        __m128 const t = _mm_loadu_ps(weights + ii);
+        __m128 qa[4], qb[4], q[4];
+        for (int kk = 0; kk < 4; ++kk) {
+            qa[kk] = _mm_load_ps(_PoseLane(a, kk) + ii);
+            qb[kk] = _mm_load_ps(_PoseLane(b, kk) + ii);
+        }
+        op.Sse(qa, qb, t, q);
+        for (int kk = 0; kk < 4; ++kk) {
+            _mm_store_ps(_PoseLane(out, kk) + ii, q[kk]);
+        }
+        for (int kk = 4; kk < 8; ++kk) {
+            __m128 const va = _mm_load_ps(_PoseLane(a, kk) + ii);
+            __m128 const vb = _mm_load_ps(_PoseLane(b, kk) + ii);
+            _mm_store_ps(_PoseLane(out, kk) + ii,
+                         _mm_add_ps(va, _mm_mul_ps(_mm_sub_ps(vb, va), t)));
+        }
+    }
+    _BlendPosesScalar(op, a, b, weights, out, ii);
+}
+template<typename Op>
+AK_TARGET_INLINE("avx2,fma")
+void _BlendPosesAvx(Op const op, PoseSoA const& a, PoseSoA const& b, float const* const weights,
+                    PoseSoA& out)
+{
+    size_t ii = 0;
+    for (; ii + 8 <= out.count; ii += 8) {
+        __m256 const t = _mm256_loadu_ps(weights + ii);
+        __m256 qa[4], qb[4], q[4];
+        for (int kk = 0; kk < 4; ++kk) {
+            qa[kk] = _mm256_load_ps(_PoseLane(a, kk) + ii);
+            qb[kk] = _mm256_load_ps(_PoseLane(b, kk) + ii);
+        }
+        op.Avx(qa, qb, t, q);
+        for (int kk = 0; kk < 4; ++kk) {
+            _mm256_store_ps(_PoseLane(out, kk) + ii, q[kk]);
+        }
+        for (int kk = 4; kk < 8; ++kk) {
+            __m256 const va = _mm256_load_ps(_PoseLane(a, kk) + ii);
+            __m256 const vb = _mm256_load_ps(_PoseLane(b, kk) + ii);
+            _mm256_store_ps(_PoseLane(out, kk) + ii,
+                            _mm256_fmadd_ps(_mm256_sub_ps(vb, va), t, va));
+        }
+    }
+    _BlendPosesScalar(op, a, b, weights, out, ii);
+}
+// Lanes are padded to 16 floats, so only the weights and the stores need the tail mask
+template<typename Op>
+AK_TARGET_INLINE("avx512f")
+void _BlendPosesAvx512(Op const op, PoseSoA const& a, PoseSoA const& b,
+                       float const* const weights, PoseSoA& out)
+{
+    for (size_t ii = 0; ii < out.count; ii += 16) {
+        __mmask16 const mask = out.count - ii >= 16 ? 0xffff : _TailMask(out.count - ii);
+        __m512 const t = _mm512_maskz_loadu_ps(mask, weights + ii);
+        __m512 qa[4], qb[4], q[4];
+        for (int kk = 0; kk < 4; ++kk) {
+            qa[kk] = _mm512_load_ps(_PoseLane(a, kk) + ii);
+            qb[kk] = _mm512_load_ps(_PoseLane(b, kk) + ii);
+        }
+        op.Avx512(qa, qb, t, q);
+        for (int kk = 0; kk < 4; ++kk) {
+            _mm512_mask_store_ps(_PoseLane(out, kk) + ii, mask, q[kk]);
+        }
+        for (int kk = 4; kk < 8; ++kk) {
+            __m512 const va = _mm512_load_ps(_PoseLane(a, kk) + ii);
+            __m512 const vb = _mm512_load_ps(_PoseLane(b, kk) + ii);
+            _mm512_mask_store_ps(_PoseLane(out, kk) + ii, mask,
+                                 _mm512_fmadd_ps(_mm512_sub_ps(vb, va), t, va));
+        }
+    }
+}
+
+// Rotations are nlerped
+inline void BlendPosesScalar(PoseSoA const& a, PoseSoA const& b, float const* const weights,
+                             PoseSoA& out)
+{
+    assert(a.count == out.count && b.count == out.count);
+    _BlendPosesScalar(_NlerpRotations(), a, b, weights, out, 0);
+}
+inline void BlendPosesSse(PoseSoA const& a, PoseSoA const& b, float const* const weights,
+                          PoseSoA& out)
+{
+    assert(a.count == out.count && b.count == out.count);
+    _BlendPosesSse(_NlerpRotations(), a, b, weights, out);
+}
+AK_TARGET_INLINE("avx2,fma")
+void BlendPosesAvx(PoseSoA const& a, PoseSoA const& b, float const* const weights, PoseSoA& out)
+{
+    assert(a.count == out.count && b.count == out.count);
+    _BlendPosesAvx(_NlerpRotations(), a, b, weights, out);
+}
+AK_TARGET_INLINE("avx512f")
+void BlendPosesAvx512(PoseSoA const& a, PoseSoA const& b, float const* const weights,
+                      PoseSoA& out)
+{
+    assert(a.count == out.count && b.count == out.count);
+    _BlendPosesAvx512(_NlerpRotations(), a, b, weights, out);
+}
+inline void BlendPoses(PoseSoA const& a, PoseSoA const& b, float const* const weights,
+                       PoseSoA& out)
+{
+    switch (ActiveSimdLevel()) {
+        case SimdLevel::kAvx512:
+            return BlendPosesAvx512(a, b, weights, out);
+        case SimdLevel::kAvx:
+            return BlendPosesAvx(a, b, weights, out);
+        case SimdLevel::kSse:
+            return BlendPosesSse(a, b, weights, out);
+        case SimdLevel::kScalar:
+            break;
+    }
+    BlendPosesScalar(a, b, weights, out);
+}
+// Rotations are slerped with the polynomial approximation, at roughly twice BlendPoses' cost
+inline void SlerpPosesScalar(PoseSoA const& a, PoseSoA const& b, float const* const weights,
+                             PoseSoA& out)
+{
+    assert(a.count == out.count && b.count == out.count);
+    _BlendPosesScalar(_SlerpRotations(), a, b, weights, out, 0);
+}
+inline void SlerpPosesSse(PoseSoA const& a, PoseSoA const& b, float const* const weights,
+                          PoseSoA& out)
+{
+    assert(a.count == out.count && b.count == out.count);
+    _BlendPosesSse(_SlerpRotations(), a, b, weights, out);
+}
+AK_TARGET_INLINE("avx2,fma")
+void SlerpPosesAvx(PoseSoA const& a, PoseSoA const& b, float const* const weights, PoseSoA& out)
+{
+    assert(a.count == out.count && b.count == out.count);
+    _BlendPosesAvx(_SlerpRotations(), a, b, weights, out);
+}
+AK_TARGET_INLINE("avx512f")
+void SlerpPosesAvx512(PoseSoA const& a, PoseSoA const& b, float const* const weights,
+                      PoseSoA& out)
+{
+    assert(a.count == out.count && b.count == out.count);
+    _BlendPosesAvx512(_SlerpRotations(), a, b, weights, out);
+}
+inline void SlerpPoses(PoseSoA const& a, PoseSoA const& b, float const* const weights,
+                       PoseSoA& out)
+{
+    switch (ActiveSimdLevel()) {
+        case SimdLevel::kAvx512:
+            return SlerpPosesAvx512(a, b, weights, out);
+        case SimdLevel::kAvx:
+            return SlerpPosesAvx(a, b, weights, out);
+        case SimdLevel::kSse:
+            return SlerpPosesSse(a, b, weights, out);
+        case SimdLevel::kScalar:
+            break;
+    }
+    SlerpPosesScalar(a, b, weights, out);
+}
+
+/*
+ * N-pose blends
+ *
+ * out bone i = the sum over k of weights[k][i] times poses[k] bone i, with the rotation sum
+ * normalized. Each rotation is negated where it's in the opposite hemisphere from poses[0]'s. The
+ * per-bone weights should sum to 1, since positions and scales are used as summed. Every pose
+ * must have out.count bones; `out` may be one of `poses`.
+ */
+inline void _BlendPosesScalar(PoseSoA const* const* const poses, float const* const* const weights,
+                              size_t const poseCount, PoseSoA& out, size_t const begin)
+{
+    for (size_t ii = begin; ii < out.count; ++ii) {
+        float const q0[4] = {poses[0]->qx[ii], poses[0]->qy[ii], poses[0]->qz[ii],
+                             poses[0]->qw[ii]};
+        float sum[8] = {};
+        for (size_t pp = 0; pp < poseCount; ++pp) {
+            float v[8];
+            for (int kk = 0; kk < 8; ++kk) {
+                v[kk] = _PoseLane(*poses[pp], kk)[ii];
+            }
+            float const w = weights[pp][ii];
+            float const d = q0[0] * v[0] + q0[1] * v[1] + q0[2] * v[2] + q0[3] * v[3];
+            float const wq = d < 0.0f ? -w : w;
+            for (int kk = 0; kk < 8; ++kk) {
+                sum[kk] += v[kk] * (kk < 4 ? wq : w);
+            }
+        }
+        float const inv =
+            1.0f / sqrtf(sum[0] * sum[0] + sum[1] * sum[1] + sum[2] * sum[2] + sum[3] * sum[3]);
+        for (int kk = 0; kk < 8; ++kk) {
+            _PoseLane(out, kk)[ii] = kk < 4 ? sum[kk] * inv : sum[kk];
+        }
+    }
+}
+inline void BlendPosesScalar(PoseSoA const* const* const poses, float const* const* const weights,
+                             size_t const poseCount, PoseSoA& out)
+{
+    _BlendPosesScalar(poses, weights, poseCount, out, 0);
+}
+inline void BlendPosesSse(PoseSoA const* const* const poses, float const* const* const weights,
+                          size_t const poseCount, PoseSoA& out)
+{
+    size_t ii = 0;
+    for (; ii + 4 <= out.count; ii += 4) {
+        __m128 q0[4];
+        __m128 sum[8];
+        for (int kk = 0; kk < 4; ++kk) {
+            q0[kk] = _mm_load_ps(_PoseLane(*poses[0], kk) + ii);
+        }
+        for (int kk = 0; kk < 8; ++kk) {
+            sum[kk] = _mm_setzero_ps();
+        }
+        for (size_t pp = 0; pp < poseCount; ++pp) {
+            __m128 v[8];
+            for (int kk = 0; kk < 8; ++kk) {
+                v[kk] = _mm_load_ps(_PoseLane(*poses[pp], kk) + ii);
+            }
+            __m128 const w = _mm_loadu_ps(weights[pp] + ii);
+            __m128 const d =
+                _mm_add_ps(_mm_add_ps(_mm_mul_ps(q0[0], v[0]), _mm_mul_ps(q0[1], v[1])),
+                           _mm_add_ps(_mm_mul_ps(q0[2], v[2]), _mm_mul_ps(q0[3], v[3])));
+            __m128 const wq = _mm_xor_ps(
+                w, _mm_and_ps(_mm_cmplt_ps(d, _mm_setzero_ps()), _mm_set1_ps(-0.0f)));
+            for (int kk = 0; kk < 8; ++kk) {
+                sum[kk] = _mm_add_ps(sum[kk], _mm_mul_ps(v[kk], kk < 4 ? wq : w));
+            }
+        }
+        __m128 const lengthSq =
+            _mm_add_ps(_mm_add_ps(_mm_mul_ps(sum[0], sum[0]), _mm_mul_ps(sum[1], sum[1])),
+                       _mm_add_ps(_mm_mul_ps(sum[2], sum[2]), _mm_mul_ps(sum[3], sum[3])));
+        __m128 const inv = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(lengthSq));
+        for (int kk = 0; kk < 8; ++kk) {
+            _mm_store_ps(_PoseLane(out, kk) + ii, kk < 4 ? _mm_mul_ps(sum[kk], inv) : sum[kk]);
+        }
+    }
+    _BlendPosesScalar(poses, weights, poseCount, out, ii);
+}
+AK_TARGET_INLINE("avx2,fma")
+void BlendPosesAvx(PoseSoA const* const* const poses, float const* const* const weights,
+                   size_t const poseCount, PoseSoA& out)
+{
+    size_t ii = 0;
+    for (; ii + 8 <= out.count; ii += 8) {
+        __m256 q0[4];
+        __m256 sum[8];
+        for (int kk = 0; kk < 4; ++kk) {
+            q0[kk] = _mm256_load_ps(_PoseLane(*poses[0], kk) + ii);
+        }
+        for (int kk = 0; kk < 8; ++kk) {
+            sum[kk] = _mm256_setzero_ps();
+        }
+        for (size_t pp = 0; pp < poseCount; ++pp) {
+            __m256 v[8];
+            for (int kk = 0; kk < 8; ++kk) {
+                v[kk] = _mm256_load_ps(_PoseLane(*poses[pp], kk) + ii);
+            }
+            __m256 const w = _mm256_loadu_ps(weights[pp] + ii);
+            __m256 d = _mm256_mul_ps(q0[0], v[0]);
+            d = _mm256_fmadd_ps(q0[1], v[1], d);
+            d = _mm256_fmadd_ps(q0[2], v[2], d);
+            d = _mm256_fmadd_ps(q0[3], v[3], d);
+            __m256 const wq = _mm256_xor_ps(
+                w, _mm256_and_ps(_mm256_cmp_ps(d, _mm256_setzero_ps(), _CMP_LT_OQ),
+                                 _mm256_set1_ps(-0.0f)));
+            for (int kk = 0; kk < 8; ++kk) {
+                sum[kk] = _mm256_fmadd_ps(v[kk], kk < 4 ? wq : w, sum[kk]);
+            }
+        }
+        __m256 lengthSq = _mm256_mul_ps(sum[0], sum[0]);
+        lengthSq = _mm256_fmadd_ps(sum[1], sum[1], lengthSq);
+        lengthSq = _mm256_fmadd_ps(sum[2], sum[2], lengthSq);
+        lengthSq = _mm256_fmadd_ps(sum[3], sum[3], lengthSq);
+        __m256 const inv = _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_sqrt_ps(lengthSq));
+        for (int kk = 0; kk < 8; ++kk) {
+            _mm256_store_ps(_PoseLane(out, kk) + ii,
+                            kk < 4 ? _mm256_mul_ps(sum[kk], inv) : sum[kk]);
+        }
+    }
+    _BlendPosesScalar(poses, weights, poseCount, out, ii);
+}
+AK_TARGET_INLINE("avx512f")
+void BlendPosesAvx512(PoseSoA const* const* const poses, float const* const* const weights,
+                      size_t const poseCount, PoseSoA& out)
+{
+    for (size_t ii = 0; ii < out.count; ii += 16) {
+        __mmask16 const mask = out.count - ii >= 16 ? 0xffff : _TailMask(out.count - ii);
+        __m512 q0[4];
+        __m512 sum[8];
+        for (int kk = 0; kk < 4; ++kk) {
+            q0[kk] = _mm512_load_ps(_PoseLane(*poses[0], kk) + ii);
+        }
+        for (int kk = 0; kk < 8; ++kk) {
+            sum[kk] = _mm512_setzero_ps();
+        }
+        for (size_t pp = 0; pp < poseCount; ++pp) {
+            __m512 v[8];
+            for (int kk = 0; kk < 8; ++kk) {
+                v[kk] = _mm512_load_ps(_PoseLane(*poses[pp], kk) + ii);
+            }
+            __m512 const w = _mm512_maskz_loadu_ps(mask, weights[pp] + ii);
+            __m512 d = _mm512_mul_ps(q0[0], v[0]);
+            d = _mm512_fmadd_ps(q0[1], v[1], d);
+            d = _mm512_fmadd_ps(q0[2], v[2], d);
+            d = _mm512_fmadd_ps(q0[3], v[3], d);
+            __mmask16 const flip = _mm512_cmp_ps_mask(d, _mm512_setzero_ps(), _CMP_LT_OQ);
+            __m512 const wq = _mm512_mask_sub_ps(w, flip, _mm512_setzero_ps(), w);
+            for (int kk = 0; kk < 8; ++kk) {
+                sum[kk] = _mm512_fmadd_ps(v[kk], kk < 4 ? wq : w, sum[kk]);
+            }
+        }
+        __m512 lengthSq = _mm512_mul_ps(sum[0], sum[0]);
+        lengthSq = _mm512_fmadd_ps(sum[1], sum[1], lengthSq);
+        lengthSq = _mm512_fmadd_ps(sum[2], sum[2], lengthSq);
+        lengthSq = _mm512_fmadd_ps(sum[3], sum[3], lengthSq);
+        __m512 const inv = _mm512_div_ps(_mm512_set1_ps(1.0f), _mm512_sqrt_ps(lengthSq));
+        for (int kk = 0; kk < 8; ++kk) {
+            _mm512_mask_store_ps(_PoseLane(out, kk) + ii, mask,
+                                 kk < 4 ? _mm512_mul_ps(sum[kk], inv) : sum[kk]);
+        }
+    }
+}
+inline void BlendPoses(PoseSoA const* const* const poses, float const* const* const weights,
+                       size_t const poseCount, PoseSoA& out)
+{
+    switch (ActiveSimdLevel()) {
+        case SimdLevel::kAvx512:
+            return BlendPosesAvx512(poses, weights, poseCount, out);
+        case SimdLevel::kAvx:
+            return BlendPosesAvx(poses, weights, poseCount, out);
+        case SimdLevel::kSse:
+            return BlendPosesSse(poses, weights, poseCount, out);
+        case SimdLevel::kScalar:
+            break;
+    }
+    BlendPosesScalar(poses, weights, poseCount, out);
+}
+
+
+/*****************************************************************************\
+ * Transform hierarchy                                                        *
+\*****************************************************************************/
+/*
+ * TransformHierarchy computes world matrices for a forest of nodes from their local Transforms.
+ * Callers name nodes by their index in the `parents` array passed to the constructor, where each
+ * parent precedes its children and roots have kNoParent.
+ *
+ * Internally the nodes are stored breadth first, in "slots": every depth is one contiguous run of
+ * slots, siblings are adjacent, and every parent's slot precedes its children's. The locals are a
+ * PoseSoA and the world matrices are twelve SoA lanes of their affine entries, column by column;
+ * the bottom row is always 0 0 0 1. Roots use slot `count` as their parent, which holds the
+ * identity, so every node is updated the same way.
+ *
+ * SetLocal marks a node dirty. UpdateHierarchy then walks the depths in order from the one holding
+ * the first dirty slot, marking each node dirty whose parent is, and recomputes world = parent
+ * world * local for the dirty nodes only. Clean nodes are not rewritten, but the dirty flags of
+ * every slot from that depth down are scanned, so the cost of an update grows with the slots
+ * below the shallowest change as well as with the number of dirty nodes. The constructor sets
+ * every local to the identity and marks every node dirty, so World is valid after the first
+ * update.
+ */
+struct TransformHierarchy
+{
+    static constexpr uint32_t kNoParent = UINT32_MAX;
+
+    TransformHierarchy() = default;
+    inline TransformHierarchy(uint32_t const* const nodeParents, size_t const n);
+    inline TransformHierarchy(TransformHierarchy&& other);
+    inline TransformHierarchy& operator=(TransformHierarchy&& other);
+    TransformHierarchy(TransformHierarchy const&) = delete;
+    TransformHierarchy& operator=(TransformHierarchy const&) = delete;
+    inline ~TransformHierarchy();
+
+    inline Transform GetLocal(size_t const node) const;
+    inline void SetLocal(size_t const node, Transform const& t);
+    inline Mat4 World(size_t const node) const;
+
+    PoseSoA locals;               // by slot
+    float* world = nullptr;       // 12 lanes of count + 1 slots
+    uint32_t* parents = nullptr;  // parent slot by slot
+    uint32_t* slots = nullptr;    // slot by node
+    uint32_t* levels = nullptr;   // first slot of each depth, then count
+    uint8_t* dirty = nullptr;     // by slot
+    size_t levelCount = 0;        // number of depths
+    size_t firstDirty = 0;        // lowest dirty slot, or count
+    size_t count = 0;
+};
+
+inline TransformHierarchy::TransformHierarchy(uint32_t const* const nodeParents, size_t const n)
+    : locals(n), world(_AllocateLanes(n + 1, 12)), firstDirty(0), count(n)
+{
+    parents = static_cast<uint32_t*>(_mm_malloc((3 * n + 1) * sizeof(uint32_t), 64));
+    slots = parents + n;
+    levels = slots + n;
+    dirty = static_cast<uint8_t*>(_mm_malloc(n + 1, 64));
+    assert(parents && dirty);
+
+    // Children of each node as index ranges into one array, then a breadth-first walk from the
+    // roots that records where each depth starts
+    uint32_t* const scratch =
+        static_cast<uint32_t*>(_mm_malloc((3 * n + 1) * sizeof(uint32_t), 64));
+    uint32_t* const first = scratch;
+    uint32_t* const children = first + n + 1;
+    uint32_t* const order = children + n;
+    memset(first, 0, (n + 1) * sizeof(uint32_t));
+    for (size_t ii = 0; ii < n; ++ii) {
+        assert(nodeParents[ii] == kNoParent || nodeParents[ii] < ii);
+        if (nodeParents[ii] != kNoParent) {
+            ++first[nodeParents[ii] + 1];
+        }
+    }
+    for (size_t ii = 0; ii < n; ++ii) {
+        first[ii + 1] += first[ii];
+    }
+    size_t tail = 0;
+    for (size_t ii = 0; ii < n; ++ii) {
+        if (nodeParents[ii] == kNoParent) {
+            order[tail++] = static_cast<uint32_t>(ii);
+        } else {
+            children[first[nodeParents[ii]]++] = static_cast<uint32_t>(ii);
+        }
+    }
+    // first[ii] now ends ii's children, which start at first[ii - 1]
+    levelCount = 0;
+    size_t levelEnd = 0;
+    for (size_t head = 0; head < tail; ++head) {
+        if (head == levelEnd) {
+            levels[levelCount++] = static_cast<uint32_t>(head);
+            levelEnd = tail;
+        }
+        uint32_t const node = order[head];
+        for (uint32_t cc = node == 0 ? 0 : first[node - 1]; cc < first[node]; ++cc) {
+            order[tail++] = children[cc];
+        }
+    }
+    assert(tail == n);
+    levels[levelCount] = static_cast<uint32_t>(n);
+
+    for (size_t ss = 0; ss < n; ++ss) {
+        slots[order[ss]] = static_cast<uint32_t>(ss);
+    }
+    for (size_t ss = 0; ss < n; ++ss) {
+        uint32_t const parent = nodeParents[order[ss]];
+        parents[ss] = parent == kNoParent ? static_cast<uint32_t>(n) : slots[parent];
+        locals.Set(ss, {Quat::Identity(), {0, 0, 0}, 1});
+    }
+    _mm_free(scratch);
+
+    size_t const stride = _SoAStride(n + 1);
+    for (int kk = 0; kk < 12; ++kk) {
+        world[kk * stride + n] = kk % 4 == 0 ? 1.0f : 0.0f;
+    }
+    memset(dirty, 1, n);
+    dirty[n] = 0;
+}
+inline TransformHierarchy::TransformHierarchy(TransformHierarchy&& other)
+    : locals(static_cast<PoseSoA&&>(other.locals))
+    , world(other.world)
+    , parents(other.parents)
+    , slots(other.slots)
+    , levels(other.levels)
+    , dirty(other.dirty)
+    , levelCount(other.levelCount)
+    , firstDirty(other.firstDirty)
+    , count(other.count)
+{
+    other.world = nullptr;
+    other.parents = other.slots = other.levels = nullptr;
+    other.dirty = nullptr;
+    other.levelCount = other.firstDirty = other.count = 0;
+}
+inline TransformHierarchy& TransformHierarchy::operator=(TransformHierarchy&& other)
+{
+    if (this != &other) {
+        _mm_free(world);
+        _mm_free(parents);
+        _mm_free(dirty);
+        locals = static_cast<PoseSoA&&>(other.locals);
+        world = other.world;
+        parents = other.parents;
+        slots = other.slots;
+        levels = other.levels;
+        dirty = other.dirty;
+        levelCount = other.levelCount;
+        firstDirty = other.firstDirty;
+        count = other.count;
+        other.world = nullptr;
+        other.parents = other.slots = other.levels = nullptr;
+        other.dirty = nullptr;
+        other.levelCount = other.firstDirty = other.count = 0;
+    }
+    return *this;
+}
+inline TransformHierarchy::~TransformHierarchy()
+{
+    _mm_free(world);
+    _mm_free(parents);
+    _mm_free(dirty);
+}
+inline Transform TransformHierarchy::GetLocal(size_t const node) const
+{
+    assert(node < count);
+    return locals.Get(slots[node]);
+}
+inline void TransformHierarchy::SetLocal(size_t const node, Transform const& t)
+{
+    assert(node < count);
+    size_t const slot = slots[node];
+    locals.Set(slot, t);
+    dirty[slot] = 1;
+    firstDirty = slot < firstDirty ? slot : firstDirty;
+}
+inline Mat4 TransformHierarchy::World(size_t const node) const
+{
+    assert(node < count);
+    float const* const w = world + slots[node];
+    size_t const stride = _SoAStride(count + 1);
+    return {
+        {w[0], w[stride], w[2 * stride], 0},
+        {w[3 * stride], w[4 * stride], w[5 * stride], 0},
+        {w[6 * stride], w[7 * stride], w[8 * stride], 0},
+        {w[9 * stride], w[10 * stride], w[11 * stride], 1},
+    };
+}
+
+// Lane kk of the world matrices: entry kk % 3 of column kk / 3
+inline float* _WorldLane(TransformHierarchy const& h, int const kk)
+{
+    return h.world + kk * _SoAStride(h.count + 1);
+}
+
+// Marks the slots in [begin, end) dirty where their parent is and returns how many are dirty
+inline size_t _PropagateDirty(TransformHierarchy& h, size_t const begin, size_t const end)
+{
+    size_t dirtyCount = 0;
+    for (size_t ss = begin; ss < end; ++ss) {
+        h.dirty[ss] |= h.dirty[h.parents[ss]];
+        dirtyCount += h.dirty[ss];
+    }
+    return dirtyCount;
+}
+// Bit i is set when slot begin + i is dirty
+inline int _DirtyBits(TransformHierarchy const& h, size_t const begin, size_t const n)
+{
+    int bits = 0;
+    for (size_t ii = 0; ii < n; ++ii) {
+        bits |= h.dirty[begin + ii] << ii;
+    }
+    return bits;
+}
+
+// Recomputes the world matrices of the dirty slots in [begin, end), whose flags are propagated
+inline void _UpdateDirtyScalar(TransformHierarchy& h, size_t const begin, size_t const end)
+{
+    for (size_t ss = begin; ss < end; ++ss) {
+        if (!h.dirty[ss]) {
+            continue;
+        }
+        uint32_t const parent = h.parents[ss];
+        Transform const t = h.locals.Get(ss);
+        Mat3 const r = Mat3::Rotation(t.orientation);
+        float const local[12] = {
+            r.c0.x * t.scale, r.c0.y * t.scale, r.c0.z * t.scale, r.c1.x * t.scale,
+            r.c1.y * t.scale, r.c1.z * t.scale, r.c2.x * t.scale, r.c2.y * t.scale,
+            r.c2.z * t.scale, t.position.x,     t.position.y,     t.position.z,
+        };
+        float p[12];
+        for (int kk = 0; kk < 12; ++kk) {
+            p[kk] = _WorldLane(h, kk)[parent];
+        }
+        for (int cc = 0; cc < 4; ++cc) {
+            for (int rr = 0; rr < 3; ++rr) {
+                float const v = p[rr] * local[cc * 3] + p[3 + rr] * local[cc * 3 + 1] +
+                                p[6 + rr] * local[cc * 3 + 2];
+                _WorldLane(h, cc * 3 + rr)[ss] = cc == 3 ? v + p[9 + rr] : v;
+            }
+        }
+    }
+}
+
+/*
+ * Node kernels update the slots in [begin, end) of one depth. The SIMD ones load each batch's
+ * parent world matrices with a gather and compute the whole batch, unless at most a quarter of it
+ * is dirty; those batches update their dirty nodes one at a time. Only dirty lanes are stored, so
+ * a clean node keeps its world matrix bit for bit even when a batch kernel would round it
+ * differently from the kernel that last wrote it.
+ */
+inline void _UpdateNodesScalar(TransformHierarchy& h, size_t const begin, size_t const end)
+{
+    _PropagateDirty(h, begin, end);
+    _UpdateDirtyScalar(h, begin, end);
+}
+inline void _UpdateNodesSse(TransformHierarchy& h, size_t const begin, size_t const end)
+{
+    size_t ss = begin;
+    for (; ss + 4 <= end; ss += 4) {
+        if (_PropagateDirty(h, ss, ss + 4) <= 1) {
+            _UpdateDirtyScalar(h, ss, ss + 4);
+            continue;
+        }
+        __m128i const laneBits = _mm_setr_epi32(1, 2, 4, 8);
+        __m128 const store = _mm_castsi128_ps(_mm_cmpeq_epi32(
+            _mm_and_si128(_mm_set1_epi32(_DirtyBits(h, ss, 4)), laneBits), laneBits));
+        uint32_t const* const parent = h.parents + ss;
+        __m128 p[12];
+        for (int kk = 0; kk < 12; ++kk) {
+            float const* const lane = _WorldLane(h, kk);
+            p[kk] = _mm_setr_ps(lane[parent[0]], lane[parent[1]], lane[parent[2]],
+                                lane[parent[3]]);
+        }
+        __m128 q[8];
+        for (int kk = 0; kk < 8; ++kk) {
+            q[kk] = _mm_loadu_ps(_PoseLane(h.locals, kk) + ss);
+        }
+        __m128 const s = q[7];
+        __m128 const s2 = _mm_add_ps(s, s);
+        __m128 const xx = _mm_mul_ps(q[0], q[0]);
+        __m128 const yy = _mm_mul_ps(q[1], q[1]);
+        __m128 const zz = _mm_mul_ps(q[2], q[2]);
+        __m128 const xy = _mm_mul_ps(q[0], q[1]);
+        __m128 const xz = _mm_mul_ps(q[0], q[2]);
+        __m128 const yz = _mm_mul_ps(q[1], q[2]);
+        __m128 const xw = _mm_mul_ps(q[0], q[3]);
+        __m128 const yw = _mm_mul_ps(q[1], q[3]);
+        __m128 const zw = _mm_mul_ps(q[2], q[3]);
+        __m128 const local[12] = {
+            _mm_sub_ps(s, _mm_mul_ps(s2, _mm_add_ps(yy, zz))),
+            _mm_mul_ps(s2, _mm_add_ps(xy, zw)),
+            _mm_mul_ps(s2, _mm_sub_ps(xz, yw)),
+            _mm_mul_ps(s2, _mm_sub_ps(xy, zw)),
+            _mm_sub_ps(s, _mm_mul_ps(s2, _mm_add_ps(xx, zz))),
+            _mm_mul_ps(s2, _mm_add_ps(yz, xw)),
+            _mm_mul_ps(s2, _mm_add_ps(xz, yw)),
+            _mm_mul_ps(s2, _mm_sub_ps(yz, xw)),
+            _mm_sub_ps(s, _mm_mul_ps(s2, _mm_add_ps(xx, yy))),
+            q[4],
+            q[5],
+            q[6],
+        };
+        for (int cc = 0; cc < 4; ++cc) {
+            for (int rr = 0; rr < 3; ++rr) {
+                __m128 v = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(p[rr], local[cc * 3]),
+                               _mm_mul_ps(p[3 + rr], local[cc * 3 + 1])),
+                    _mm_mul_ps(p[6 + rr], local[cc * 3 + 2]));
+                v = cc == 3 ? _mm_add_ps(v, p[9 + rr]) : v;
+                float* const out = _WorldLane(h, cc * 3 + rr) + ss;
+                _mm_storeu_ps(out, _mm_or_ps(_mm_and_ps(store, v),
+                                             _mm_andnot_ps(store, _mm_loadu_ps(out))));
+            }
+        }
+    }
+    _UpdateNodesScalar(h, ss, end);
+}
+AK_TARGET_INLINE("avx2,fma")
+void _UpdateNodesAvx(TransformHierarchy& h, size_t const begin, size_t const end)
+{
+    size_t ss = begin;
+    for (; ss + 8 <= end; ss += 8) {
+        if (_PropagateDirty(h, ss, ss + 8) <= 2) {
+            _UpdateDirtyScalar(h, ss, ss + 8);
+            continue;
+        }
+        __m256i const laneBits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+        __m256i const store = _mm256_cmpeq_epi32(
+            _mm256_and_si256(_mm256_set1_epi32(_DirtyBits(h, ss, 8)), laneBits), laneBits);
+        __m256i const parent =
+            _mm256_loadu_si256(reinterpret_cast<__m256i const*>(h.parents + ss));
+        __m256 p[12];
+        for (int kk = 0; kk < 12; ++kk) {
+            p[kk] = _mm256_i32gather_ps(_WorldLane(h, kk), parent, 4);
+        }
+        __m256 q[8];
+        for (int kk = 0; kk < 8; ++kk) {
+            q[kk] = _mm256_loadu_ps(_PoseLane(h.locals, kk) + ss);
+        }
+        __m256 const s = q[7];
+        __m256 const s2 = _mm256_add_ps(s, s);
+        __m256 const xx = _mm256_mul_ps(q[0], q[0]);
+        __m256 const yy = _mm256_mul_ps(q[1], q[1]);
+        __m256 const zz = _mm256_mul_ps(q[2], q[2]);
+        __m256 const xy = _mm256_mul_ps(q[0], q[1]);
+        __m256 const xz = _mm256_mul_ps(q[0], q[2]);
+        __m256 const yz = _mm256_mul_ps(q[1], q[2]);
+        __m256 const xw = _mm256_mul_ps(q[0], q[3]);
+        __m256 const yw = _mm256_mul_ps(q[1], q[3]);
+        __m256 const zw = _mm256_mul_ps(q[2], q[3]);
+        __m256 const local[12] = {
+            _mm256_fnmadd_ps(s2, _mm256_add_ps(yy, zz), s),
+            _mm256_mul_ps(s2, _mm256_add_ps(xy, zw)),
+            _mm256_mul_ps(s2, _mm256_sub_ps(xz, yw)),
+            _mm256_mul_ps(s2, _mm256_sub_ps(xy, zw)),
+            _mm256_fnmadd_ps(s2, _mm256_add_ps(xx, zz), s),
+            _mm256_mul_ps(s2, _mm256_add_ps(yz, xw)),
+            _mm256_mul_ps(s2, _mm256_add_ps(xz, yw)),
+            _mm256_mul_ps(s2, _mm256_sub_ps(yz, xw)),
+            _mm256_fnmadd_ps(s2, _mm256_add_ps(xx, yy), s),
+            q[4],
+            q[5],
+            q[6],
+        };
+        for (int cc = 0; cc < 4; ++cc) {
+            for (int rr = 0; rr < 3; ++rr) {
+                __m256 v = cc == 3 ? p[9 + rr] : _mm256_setzero_ps();
+                v = _mm256_fmadd_ps(p[rr], local[cc * 3], v);
+                v = _mm256_fmadd_ps(p[3 + rr], local[cc * 3 + 1], v);
+                v = _mm256_fmadd_ps(p[6 + rr], local[cc * 3 + 2], v);
+                _mm256_maskstore_ps(_WorldLane(h, cc * 3 + rr) + ss, store, v);
+            }
+        }
+    }
+    _UpdateNodesScalar(h, ss, end);
+}
+AK_TARGET_INLINE("avx512f")
+void _UpdateNodesAvx512(TransformHierarchy& h, size_t const begin, size_t const end)
+{
+    for (size_t ss = begin; ss < end; ss += 16) {
+        size_t const n = end - ss < 16 ? end - ss : 16;
+        if (_PropagateDirty(h, ss, ss + n) <= n / 4) {
+            _UpdateDirtyScalar(h, ss, ss + n);
+            continue;
+        }
+        __mmask16 const mask = n == 16 ? 0xffff : _TailMask(n);
+        __mmask16 const store = static_cast<__mmask16>(_DirtyBits(h, ss, n));
+        __m512i const parent = _mm512_maskz_loadu_epi32(mask, h.parents + ss);
+        __m512 p[12];
+        for (int kk = 0; kk < 12; ++kk) {
+            p[kk] = _mm512_mask_i32gather_ps(_mm512_setzero_ps(), mask, parent, _WorldLane(h, kk),
+                                             4);
+        }
+        __m512 q[8];
+        for (int kk = 0; kk < 8; ++kk) {
+            q[kk] = _mm512_maskz_loadu_ps(mask, _PoseLane(h.locals, kk) + ss);
+        }
+        __m512 const s = q[7];
+        __m512 const s2 = _mm512_add_ps(s, s);
+        __m512 const xx = _mm512_mul_ps(q[0], q[0]);
+        __m512 const yy = _mm512_mul_ps(q[1], q[1]);
+        __m512 const zz = _mm512_mul_ps(q[2], q[2]);
+        __m512 const xy = _mm512_mul_ps(q[0], q[1]);
+        __m512 const xz = _mm512_mul_ps(q[0], q[2]);
+        __m512 const yz = _mm512_mul_ps(q[1], q[2]);
+        __m512 const xw = _mm512_mul_ps(q[0], q[3]);
+        __m512 const yw = _mm512_mul_ps(q[1], q[3]);
+        __m512 const zw = _mm512_mul_ps(q[2], q[3]);
+        __m512 const local[12] = {
+            _mm512_fnmadd_ps(s2, _mm512_add_ps(yy, zz), s),
+            _mm512_mul_ps(s2, _mm512_add_ps(xy, zw)),
+            _mm512_mul_ps(s2, _mm512_sub_ps(xz, yw)),
+            _mm512_mul_ps(s2, _mm512_sub_ps(xy, zw)),
+            _mm512_fnmadd_ps(s2, _mm512_add_ps(xx, zz), s),
+            _mm512_mul_ps(s2, _mm512_add_ps(yz, xw)),
+            _mm512_mul_ps(s2, _mm512_add_ps(xz, yw)),
+            _mm512_mul_ps(s2, _mm512_sub_ps(yz, xw)),
+            _mm512_fnmadd_ps(s2, _mm512_add_ps(xx, yy), s),
+            q[4],
+            q[5],
+            q[6],
+        };
+        for (int cc = 0; cc < 4; ++cc) {
+            for (int rr = 0; rr < 3; ++rr) {
+                __m512 v = cc == 3 ? p[9 + rr] : _mm512_setzero_ps();
+                v = _mm512_fmadd_ps(p[rr], local[cc * 3], v);
+                v = _mm512_fmadd_ps(p[3 + rr], local[cc * 3 + 1], v);
+                v = _mm512_fmadd_ps(p[6 + rr], local[cc * 3 + 2], v);
+                _mm512_mask_storeu_ps(_WorldLane(h, cc * 3 + rr) + ss, store, v);
+            }
+        }
+    }
+}
+
+// Starts at the depth holding the first dirty slot, since nothing shallower can change
+template<void (*kNodes)(TransformHierarchy&, size_t, size_t)>
+inline void _UpdateHierarchy(TransformHierarchy& h)
+{
+    if (h.firstDirty >= h.count) {
+        return;
+    }
+    size_t lo = 0;
+    size_t hi = h.levelCount;
+    while (hi - lo > 1) {
+        size_t const mid = (lo + hi) / 2;
+        if (h.levels[mid] <= h.firstDirty) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    for (size_t ll = lo; ll < h.levelCount; ++ll) {
+        kNodes(h, h.levels[ll], h.levels[ll + 1]);
+    }
+    memset(h.dirty + h.levels[lo], 0, h.count - h.levels[lo]);
+    h.firstDirty = h.count;
+}
+inline void UpdateHierarchyScalar(TransformHierarchy& h)
+{
+    _UpdateHierarchy<_UpdateNodesScalar>(h);
+}
+inline void UpdateHierarchySse(TransformHierarchy& h)
+{
+    _UpdateHierarchy<_UpdateNodesSse>(h);
+}
+inline void UpdateHierarchyAvx(TransformHierarchy& h)
+{
+    _UpdateHierarchy<_UpdateNodesAvx>(h);
+}
+inline void UpdateHierarchyAvx512(TransformHierarchy& h)
+{
+    _UpdateHierarchy<_UpdateNodesAvx512>(h);
+}
+inline void UpdateHierarchy(TransformHierarchy& h)
+{
+    switch (ActiveSimdLevel()) {
+        case SimdLevel::kAvx512:
+            return UpdateHierarchyAvx512(h);
+        case SimdLevel::kAvx:
+            return UpdateHierarchyAvx(h);
+        case SimdLevel::kSse:
+            return UpdateHierarchySse(h);
+        case SimdLevel::kScalar:
+            break;
+    }
+    UpdateHierarchyScalar(h);
+}
+
+
+/*****************************************************************************\
+ * Skinning                                                                   *
+\*****************************************************************************/
+/*
+ * SkinInfluences stores the bones and weights of `count` vertices with 4 or 8 influences each.
+ * Influence k of vertex i is bones[k * _SoAStride(count) + i] with weights[...] at the same
+ * offset. Both arrays are lanes of one block, whose padding is bone 0 with weight 0; unused
+ * influences should be the same. The weights of a vertex should sum to 1.
+ */
+struct SkinInfluences
+{
+    SkinInfluences() = default;
+    inline SkinInfluences(size_t const n, int const influencesPerVertex);
+    inline SkinInfluences(SkinInfluences&& other);
+    inline SkinInfluences& operator=(SkinInfluences&& other);
+    SkinInfluences(SkinInfluences const&) = delete;
+    SkinInfluences& operator=(SkinInfluences const&) = delete;
+    inline ~SkinInfluences();
+
+    inline void Set(size_t const vertex, int const influence, uint32_t const bone,
+                    float const weight);
+
+    float* weights = nullptr;
+    uint32_t* bones = nullptr;
+    int influences = 0;
+    size_t count = 0;
+};
+
+inline SkinInfluences::SkinInfluences(size_t const n, int const influencesPerVertex)
+    : weights(_AllocateLanes(n, 2 * influencesPerVertex))
+    , influences(influencesPerVertex)
+    , count(n)
+{
+    assert(influencesPerVertex == 4 || influencesPerVertex == 8);
+    if (n > 0) {
+        memset(weights, 0, 2 * influencesPerVertex * _SoAStride(n) * sizeof(float));
+        bones = reinterpret_cast<uint32_t*>(weights + influencesPerVertex * _SoAStride(n));
+    }
+}
+inline SkinInfluences::SkinInfluences(SkinInfluences&& other)
+    : weights(other.weights), bones(other.bones), influences(other.influences), count(other.count)
+{
+    other.weights = nullptr;
+    other.bones = nullptr;
+    other.influences = 0;
+    other.count = 0;
+}
+inline SkinInfluences& SkinInfluences::operator=(SkinInfluences&& other)
+{
+    if (this != &other) {
+        _mm_free(weights);
+        weights = other.weights;
+        bones = other.bones;
+        influences = other.influences;
+        count = other.count;
+        other.weights = nullptr;
+        other.bones = nullptr;
+        other.influences = 0;
+        other.count = 0;
+    }
+    return *this;
+}
+inline SkinInfluences::~SkinInfluences()
+{
+    _mm_free(weights);
+}
+inline void SkinInfluences::Set(size_t const vertex, int const influence, uint32_t const bone,
+                                float const weight)
+{
+    assert(vertex < count && influence < influences);
+    bones[influence * _SoAStride(count) + vertex] = bone;
+    weights[influence * _SoAStride(count) + vertex] = weight;
+}
+
+// Input and output lanes of a skinning call: position x, y and z, then normal x, y and z, which
+// are null when only positions are skinned
+struct _SkinStreams
+{
+    float const* in[6];
+    float* out[6];
+};
+
+/*
+ * Linear blend skinning
+ *
+ * Each vertex blends its bones' palette matrices by weight into one matrix held in registers,
+ * then transforms its position as a point and its normal as a direction. The normals are exact
+ * where the blended matrix is a rotation with uniform scale, and aren't renormalized. SIMD
+ * kernels skin four vertices at a time and transpose the results into the output lanes.
+ *
+ * A Mat4 palette blends whole columns. A Mat4x3 palette is a quarter smaller and blends three
+ * rows per influence instead of four columns, then transposes the blend into columns once per
+ * vertex.
+ */
+inline void _AccumulateBoneScalar(Mat4 const& m, float const w, Vec3 (&c)[4])
+{
+    c[0] = c[0] + Vec3{m.c0.x, m.c0.y, m.c0.z} * w;
+    c[1] = c[1] + Vec3{m.c1.x, m.c1.y, m.c1.z} * w;
+    c[2] = c[2] + Vec3{m.c2.x, m.c2.y, m.c2.z} * w;
+    c[3] = c[3] + Vec3{m.c3.x, m.c3.y, m.c3.z} * w;
+}
+inline void _AccumulateBoneScalar(Mat4x3 const& m, float const w, Vec3 (&c)[4])
+{
+    c[0] = c[0] + Vec3{m.r0.x, m.r1.x, m.r2.x} * w;
+    c[1] = c[1] + Vec3{m.r0.y, m.r1.y, m.r2.y} * w;
+    c[2] = c[2] + Vec3{m.r0.z, m.r1.z, m.r2.z} * w;
+    c[3] = c[3] + Vec3{m.r0.w, m.r1.w, m.r2.w} * w;
+}
+template<typename Bone, int kInfluences>
+inline void _SkinLinearScalar(Bone const* const palette, SkinInfluences const& influences,
+                              _SkinStreams const& s, size_t const begin)
+{
+    size_t const stride = _SoAStride(influences.count);
+    for (size_t ii = begin; ii < influences.count; ++ii) {
+        Vec3 c[4] = {};
+        for (int kk = 0; kk < kInfluences; ++kk) {
+            _AccumulateBoneScalar(palette[influences.bones[kk * stride + ii]],
+                                  influences.weights[kk * stride + ii], c);
+        }
+        Vec3 const p = c[0] * s.in[0][ii] + c[1] * s.in[1][ii] + c[2] * s.in[2][ii] + c[3];
+        s.out[0][ii] = p.x;
+        s.out[1][ii] = p.y;
+        s.out[2][ii] = p.z;
+        if (s.in[3]) {
+            Vec3 const n = c[0] * s.in[3][ii] + c[1] * s.in[4][ii] + c[2] * s.in[5][ii];
+            s.out[3][ii] = n.x;
+            s.out[4][ii] = n.y;
+            s.out[5][ii] = n.z;
+        }
+    }
+}
+
+// Blends vertex ii's bones into columns c
+template<int kInfluences>
+inline void _BlendBonesSse(Mat4 const* const palette, SkinInfluences const& influences,
+                           size_t const ii, __m128 (&c)[4])
+{
+    size_t const stride = _SoAStride(influences.count);
+    c[0] = c[1] = c[2] = c[3] = _mm_setzero_ps();
+    for (int kk = 0; kk < kInfluences; ++kk) {
+        __m128 const w = _mm_set1_ps(influences.weights[kk * stride + ii]);
+        Mat4 const& m = palette[influences.bones[kk * stride + ii]];
+        c[0] = _mm_add_ps(c[0], _mm_mul_ps(_mm_load_ps(&m.c0.x), w));
+        c[1] = _mm_add_ps(c[1], _mm_mul_ps(_mm_load_ps(&m.c1.x), w));
+        c[2] = _mm_add_ps(c[2], _mm_mul_ps(_mm_load_ps(&m.c2.x), w));
+        c[3] = _mm_add_ps(c[3], _mm_mul_ps(_mm_load_ps(&m.c3.x), w));
+    }
+}
+template<int kInfluences>
+inline void _BlendBonesSse(Mat4x3 const* const palette, SkinInfluences const& influences,
+                           size_t const ii, __m128 (&c)[4])
+{
+    size_t const stride = _SoAStride(influences.count);
+    c[0] = c[1] = c[2] = c[3] = _mm_setzero_ps();
+    for (int kk = 0; kk < kInfluences; ++kk) {
+        __m128 const w = _mm_set1_ps(influences.weights[kk * stride + ii]);
+        Mat4x3 const& m = palette[influences.bones[kk * stride + ii]];
+        c[0] = _mm_add_ps(c[0], _mm_mul_ps(_mm_load_ps(&m.r0.x), w));
+        c[1] = _mm_add_ps(c[1], _mm_mul_ps(_mm_load_ps(&m.r1.x), w));
+        c[2] = _mm_add_ps(c[2], _mm_mul_ps(_mm_load_ps(&m.r2.x), w));
+    }
+    _MM_TRANSPOSE4_PS(c[0], c[1], c[2], c[3]);
+}
+template<typename Bone, int kInfluences>
+inline void _SkinLinearSse(Bone const* const palette, SkinInfluences const& influences,
+                           _SkinStreams const& s)
+{
+    size_t ii = 0;
+    for (; ii + 4 <= influences.count; ii += 4) {
+        __m128 p[4], n[4];
+        for (size_t jj = 0; jj < 4; ++jj) {
+            __m128 c[4];
+            _BlendBonesSse<kInfluences>(palette, influences, ii + jj, c);
+            p[jj] = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(c[0], _mm_set1_ps(s.in[0][ii + jj])),
+                           _mm_mul_ps(c[1], _mm_set1_ps(s.in[1][ii + jj]))),
+                _mm_add_ps(_mm_mul_ps(c[2], _mm_set1_ps(s.in[2][ii + jj])), c[3]));
+            if (s.in[3]) {
+                n[jj] = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(c[0], _mm_set1_ps(s.in[3][ii + jj])),
+                               _mm_mul_ps(c[1], _mm_set1_ps(s.in[4][ii + jj]))),
+                    _mm_mul_ps(c[2], _mm_set1_ps(s.in[5][ii + jj])));
+            }
+        }
+        _MM_TRANSPOSE4_PS(p[0], p[1], p[2], p[3]);
+        _mm_store_ps(s.out[0] + ii, p[0]);
+        _mm_store_ps(s.out[1] + ii, p[1]);
+        _mm_store_ps(s.out[2] + ii, p[2]);
+        if (s.in[3]) {
+            _MM_TRANSPOSE4_PS(n[0], n[1], n[2], n[3]);
+            _mm_store_ps(s.out[3] + ii, n[0]);
+            _mm_store_ps(s.out[4] + ii, n[1]);
+            _mm_store_ps(s.out[5] + ii, n[2]);
+        }
+    }
+    _SkinLinearScalar<Bone, kInfluences>(palette, influences, s, ii);
+}
+
+// AVX2 blends columns in pairs, c0:c1 and c2:c3, and broadcasts a point's coordinates to match
+template<int kInfluences>
+AK_TARGET_INLINE("avx2,fma")
+void _BlendBonesAvx(Mat4 const* const palette, SkinInfluences const& influences, size_t const ii,
+                    __m256& c01, __m256& c23)
+{
+    size_t const stride = _SoAStride(influences.count);
+    c01 = c23 = _mm256_setzero_ps();
+    for (int kk = 0; kk < kInfluences; ++kk) {
+        __m256 const w = _mm256_set1_ps(influences.weights[kk * stride + ii]);
+        Mat4 const& m = palette[influences.bones[kk * stride + ii]];
+        c01 = _mm256_fmadd_ps(_mm256_load_ps(&m.c0.x), w, c01);
+        c23 = _mm256_fmadd_ps(_mm256_load_ps(&m.c2.x), w, c23);
+    }
+}
+template<int kInfluences>
+AK_TARGET_INLINE("avx2,fma")
+void _BlendBonesAvx(Mat4x3 const* const palette, SkinInfluences const& influences,
+                    size_t const ii, __m256& c01, __m256& c23)
+{
+    size_t const stride = _SoAStride(influences.count);
+    __m256 r01 = _mm256_setzero_ps();
+    __m128 r2 = _mm_setzero_ps();
+    for (int kk = 0; kk < kInfluences; ++kk) {
+        float const w = influences.weights[kk * stride + ii];
+        Mat4x3 const& m = palette[influences.bones[kk * stride + ii]];
+        r01 = _mm256_fmadd_ps(_mm256_loadu_ps(&m.r0.x), _mm256_set1_ps(w), r01);
+        r2 = _mm_fmadd_ps(_mm_load_ps(&m.r2.x), _mm_set1_ps(w), r2);
+    }
+    __m128 c0 = _mm256_castps256_ps128(r01);
+    __m128 c1 = _mm256_extractf128_ps(r01, 1);
+    __m128 c2 = r2;
+    __m128 c3 = _mm_setzero_ps();
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+    c01 = _mm256_setr_m128(c0, c1);
+    c23 = _mm256_setr_m128(c2, c3);
+}
+template<typename Bone, int kInfluences>
+AK_TARGET_INLINE("avx2,fma")
+void _SkinLinearAvx(Bone const* const palette, SkinInfluences const& influences,
+                    _SkinStreams const& s)
+{
+    size_t ii = 0;
+    for (; ii + 4 <= influences.count; ii += 4) {
+        __m128 p[4], n[4];
+        for (size_t jj = 0; jj < 4; ++jj) {
+            __m256 c01, c23;
+            _BlendBonesAvx<kInfluences>(palette, influences, ii + jj, c01, c23);
+            __m256 const xy = _mm256_setr_m128(_mm_set1_ps(s.in[0][ii + jj]),
+                                               _mm_set1_ps(s.in[1][ii + jj]));
+            __m256 const z1 =
+                _mm256_setr_m128(_mm_set1_ps(s.in[2][ii + jj]), _mm_set1_ps(1.0f));
+            __m256 const p2 = _mm256_fmadd_ps(c01, xy, _mm256_mul_ps(c23, z1));
+            p[jj] = _mm_add_ps(_mm256_castps256_ps128(p2), _mm256_extractf128_ps(p2, 1));
+            if (s.in[3]) {
+                __m256 const nxy = _mm256_setr_m128(_mm_set1_ps(s.in[3][ii + jj]),
+                                                    _mm_set1_ps(s.in[4][ii + jj]));
+                __m256 const nz0 =
+                    _mm256_setr_m128(_mm_set1_ps(s.in[5][ii + jj]), _mm_setzero_ps());
+                __m256 const n2 = _mm256_fmadd_ps(c01, nxy, _mm256_mul_ps(c23, nz0));
+                n[jj] = _mm_add_ps(_mm256_castps256_ps128(n2), _mm256_extractf128_ps(n2, 1));
+            }
+        }
+        _MM_TRANSPOSE4_PS(p[0], p[1], p[2], p[3]);
+        _mm_store_ps(s.out[0] + ii, p[0]);
+        _mm_store_ps(s.out[1] + ii, p[1]);
+        _mm_store_ps(s.out[2] + ii, p[2]);
+        if (s.in[3]) {
+            _MM_TRANSPOSE4_PS(n[0], n[1], n[2], n[3]);
+            _mm_store_ps(s.out[3] + ii, n[0]);
+            _mm_store_ps(s.out[4] + ii, n[1]);
+            _mm_store_ps(s.out[5] + ii, n[2]);
+        }
+    }
+    _SkinLinearScalar<Bone, kInfluences>(palette, influences, s, ii);
+}
+
+// Sum of a register's four 128-bit quarters
+AK_TARGET_INLINE("avx512f")
+__m128 _SumQuarters(__m512 const v)
+{
+    __m256 const high = _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(v), 1));
+    __m256 const halves = _mm256_add_ps(_mm512_castps512_ps256(v), high);
+    return _mm_add_ps(_mm256_castps256_ps128(halves), _mm256_extractf128_ps(halves, 1));
+}
+// AVX-512 holds a whole blended matrix in one register, as columns. A Mat4x3 blend is the low
+// twelve lanes, rows, and one permute transposes it.
+template<int kInfluences>
+AK_TARGET_INLINE("avx512f")
+__m512 _BlendBonesAvx512(Mat4 const* const palette, SkinInfluences const& influences,
+                         size_t const ii)
+{
+    size_t const stride = _SoAStride(influences.count);
+    __m512 m = _mm512_setzero_ps();
+    for (int kk = 0; kk < kInfluences; ++kk) {
+        __m512 const w = _mm512_set1_ps(influences.weights[kk * stride + ii]);
+        Mat4 const& bone = palette[influences.bones[kk * stride + ii]];
+        m = _mm512_fmadd_ps(_mm512_load_ps(&bone.c0.x), w, m);
+    }
+    return m;
+}
+template<int kInfluences>
+AK_TARGET_INLINE("avx512f")
+__m512 _BlendBonesAvx512(Mat4x3 const* const palette, SkinInfluences const& influences,
+                         size_t const ii)
+{
+    size_t const stride = _SoAStride(influences.count);
+    __m512i const transpose =
+        _mm512_setr_epi32(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+    __m512 m = _mm512_setzero_ps();
+    for (int kk = 0; kk < kInfluences; ++kk) {
+        __m512 const w = _mm512_set1_ps(influences.weights[kk * stride + ii]);
+        Mat4x3 const& bone = palette[influences.bones[kk * stride + ii]];
+        m = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(0x0fff, &bone.r0.x), w, m);
+    }
+    return _mm512_permutexvar_ps(transpose, m);
+}
+// Points are widened to x x x x y y y y z z z z 1 1 1 1 and the products' column quarters summed
+template<typename Bone, int kInfluences>
+AK_TARGET_INLINE("avx512f")
+void _SkinLinearAvx512(Bone const* const palette, SkinInfluences const& influences,
+                       _SkinStreams const& s)
+{
+    __m512i const widen = _mm512_setr_epi32(0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3);
+    size_t ii = 0;
+    for (; ii + 4 <= influences.count; ii += 4) {
+        __m128 x = _mm_load_ps(s.in[0] + ii);
+        __m128 y = _mm_load_ps(s.in[1] + ii);
+        __m128 z = _mm_load_ps(s.in[2] + ii);
+        __m128 one = _mm_set1_ps(1.0f);
+        _MM_TRANSPOSE4_PS(x, y, z, one);
+        __m128 const points[4] = {x, y, z, one};
+        __m128 normals[4] = {};
+        if (s.in[3]) {
+            __m128 nx = _mm_load_ps(s.in[3] + ii);
+            __m128 ny = _mm_load_ps(s.in[4] + ii);
+            __m128 nz = _mm_load_ps(s.in[5] + ii);
+            __m128 zero = _mm_setzero_ps();
+            _MM_TRANSPOSE4_PS(nx, ny, nz, zero);
+            normals[0] = nx;
+            normals[1] = ny;
+            normals[2] = nz;
+            normals[3] = zero;
+        }
+
+        __m128 p[4], n[4];
+        for (size_t jj = 0; jj < 4; ++jj) {
+            __m512 const m = _BlendBonesAvx512<kInfluences>(palette, influences, ii + jj);
+            __m512 const p4 =
+                _mm512_mul_ps(m, _mm512_permutexvar_ps(widen, _mm512_castps128_ps512(points[jj])));
+            p[jj] = _SumQuarters(p4);
+            if (s.in[3]) {
+                __m512 const n4 = _mm512_mul_ps(
+                    m, _mm512_permutexvar_ps(widen, _mm512_castps128_ps512(normals[jj])));
+                n[jj] = _SumQuarters(n4);
+            }
+        }
+        _MM_TRANSPOSE4_PS(p[0], p[1], p[2], p[3]);
+        _mm_store_ps(s.out[0] + ii, p[0]);
+        _mm_store_ps(s.out[1] + ii, p[1]);
+        _mm_store_ps(s.out[2] + ii, p[2]);
+        if (s.in[3]) {
+            _MM_TRANSPOSE4_PS(n[0], n[1], n[2], n[3]);
+            _mm_store_ps(s.out[3] + ii, n[0]);
+            _mm_store_ps(s.out[4] + ii, n[1]);
+            _mm_store_ps(s.out[5] + ii, n[2]);
+        }
+    }
+    _SkinLinearScalar<Bone, kInfluences>(palette, influences, s, ii);
+}
+
+inline _SkinStreams _MakeSkinStreams(Vec3SoA const& positions, Vec3SoA const* const normals,
+                                     Vec3SoA& outPositions, Vec3SoA* const outNormals)
+{
+    assert(outPositions.count == positions.count);
+    assert(!normals || (outNormals && normals->count == positions.count &&
+                        outNormals->count == positions.count));
+    return {{positions.x, positions.y, positions.z, normals ? normals->x : nullptr,
+             normals ? normals->y : nullptr, normals ? normals->z : nullptr},
+            {outPositions.x, outPositions.y, outPositions.z, outNormals ? outNormals->x : nullptr,
+             outNormals ? outNormals->y : nullptr, outNormals ? outNormals->z : nullptr}};
+}
+template<typename Bone>
+inline void _SkinLinear(SimdLevel const level, Bone const* const palette,
+                        SkinInfluences const& influences, _SkinStreams const& s)
+{
+    assert(influences.influences == 4 || influences.influences == 8);
+    bool const eight = influences.influences == 8;
+    switch (level) {
+        case SimdLevel::kAvx512:
+            return eight ? _SkinLinearAvx512<Bone, 8>(palette, influences, s)
+                         : _SkinLinearAvx512<Bone, 4>(palette, influences, s);
+        case SimdLevel::kAvx:
+            return eight ? _SkinLinearAvx<Bone, 8>(palette, influences, s)
+                         : _SkinLinearAvx<Bone, 4>(palette, influences, s);
+        case SimdLevel::kSse:
+            return eight ? _SkinLinearSse<Bone, 8>(palette, influences, s)
+                         : _SkinLinearSse<Bone, 4>(palette, influences, s);
+        case SimdLevel::kScalar:
+            break;
+    }
+    return eight ? _SkinLinearScalar<Bone, 8>(palette, influences, s, 0)
+                 : _SkinLinearScalar<Bone, 4>(palette, influences, s, 0);
+}
+
+// Skins positions, and normals in the overloads that take them. The streams must have
+// influences.count vertices; outputs mustn't alias inputs. Mat4 palettes must be 64-byte aligned.
+inline void SkinLinearScalar(Mat4 const* const palette, SkinInfluences const& influences,
+                             Vec3SoA const& positions, Vec3SoA& outPositions)
+{
+    _SkinLinear(SimdLevel::kScalar, palette, influences,
+                _MakeSkinStreams(positions, nullptr, outPositions, nullptr));
+}
+inline void SkinLinearScalar(Mat4 const* const palette, SkinInfluences const& influences,
+                             Vec3SoA const& positions, Vec3SoA const& normals,
+                             Vec3SoA& outPositions, Vec3SoA& outNormals)
+{
+    _SkinLinear(SimdLevel::kScalar, palette, influences,
+                _MakeSkinStreams(positions, &normals, outPositions, &outNormals));
+}
+inline void SkinLinearSse(Mat4 const* const palette, SkinInfluences const& influences,
+                          Vec3SoA const& positions, Vec3SoA& outPositions)
+{
+    _SkinLinear(SimdLevel::kSse, palette, influences,
+                _MakeSkinStreams(positions, nullptr, outPositions, nullptr));
+}
+inline void SkinLinearSse(Mat4 const* const palette, SkinInfluences const& influences,
+                          Vec3SoA const& positions, Vec3SoA const& normals,
+                          Vec3SoA& outPositions, Vec3SoA& outNormals)
+{
+    _SkinLinear(SimdLevel::kSse, palette, influences,
+                _MakeSkinStreams(positions, &normals, outPositions, &outNormals));
+}
+inline void SkinLinearAvx(Mat4 const* const palette, SkinInfluences const& influences,
+                          Vec3SoA const& positions, Vec3SoA& outPositions)
+{
+    _SkinLinear(SimdLevel::kAvx, palette, influences,
+                _MakeSkinStreams(positions, nullptr, outPositions, nullptr));
+}
+inline void SkinLinearAvx(Mat4 const* const palette, SkinInfluences const& influences,
+                          Vec3SoA const& positions, Vec3SoA const& normals,
+                          Vec3SoA& outPositions, Vec3SoA& outNormals)
+{
+    _SkinLinear(SimdLevel::kAvx, palette, influences,
+                _MakeSkinStreams(positions, &normals, outPositions, &outNormals));
+}
+inline void SkinLinearAvx512(Mat4 const* const palette, SkinInfluences const& influences,
+                             Vec3SoA const& positions, Vec3SoA& outPositions)
+{
+    _SkinLinear(SimdLevel::kAvx512, palette, influences,
+                _MakeSkinStreams(positions, nullptr, outPositions, nullptr));
+}
+inline void SkinLinearAvx512(Mat4 const* const palette, SkinInfluences const& influences,
+                             Vec3SoA const& positions, Vec3SoA const& normals,
+                             Vec3SoA& outPositions, Vec3SoA& outNormals)
+{
+    _SkinLinear(SimdLevel::kAvx512, palette, influences,
+                _MakeSkinStreams(positions, &normals, outPositions, &outNormals));
+}
+inline void SkinLinear(Mat4 const* const palette, SkinInfluences const& influences,
+                       Vec3SoA const& positions, Vec3SoA& outPositions)
+{
+    _SkinLinear(ActiveSimdLevel(), palette, influences,
+                _MakeSkinStreams(positions, nullptr, outPositions, nullptr));
+}
+inline void SkinLinear(Mat4 const* const palette, SkinInfluences const& influences,
+                       Vec3SoA const& positions, Vec3SoA const& normals, Vec3SoA& outPositions,
+                       Vec3SoA& outNormals)
+{
+    _SkinLinear(ActiveSimdLevel(), palette, influences,
+                _MakeSkinStreams(positions, &normals, outPositions, &outNormals));
+}
+
+inline void SkinLinearScalar(Mat4x3 const* const palette, SkinInfluences const& influences,
+                             Vec3SoA const& positions, Vec3SoA& outPositions)
+{
+    _SkinLinear(SimdLevel::kScalar, palette, influences,
+                _MakeSkinStreams(positions, nullptr, outPositions, nullptr));
+}
+inline void SkinLinearScalar(Mat4x3 const* const palette, SkinInfluences const& influences,
+                             Vec3SoA const& positions, Vec3SoA const& normals,
+                             Vec3SoA& outPositions, Vec3SoA& outNormals)
+{
+    _SkinLinear(SimdLevel::kScalar, palette, influences,
+                _MakeSkinStreams(positions, &normals, outPositions, &outNormals));
+}
+inline void SkinLinearSse(Mat4x3 const* const palette, SkinInfluences const& influences,
+                          Vec3SoA const& positions, Vec3SoA& outPositions)
+{
+    _SkinLinear(SimdLevel::kSse, palette, influences,
+                _MakeSkinStreams(positions, nullptr, outPositions, nullptr));
+}
+inline void SkinLinearSse(Mat4x3 const* const palette, SkinInfluences const& influences,
+                          Vec3SoA const& positions, Vec3SoA const& normals,
+                          Vec3SoA& outPositions, Vec3SoA& outNormals)
+{
+    _SkinLinear(SimdLevel::kSse, palette, influences,
+                _MakeSkinStreams(positions, &normals, outPositions, &outNormals));
+}
+inline void SkinLinearAvx(Mat4x3 const* const palette, SkinInfluences const& influences,
+                          Vec3SoA const& positions, Vec3SoA& outPositions)
+{
+    _SkinLinear(SimdLevel::kAvx, palette, influences,
+                _MakeSkinStreams(positions, nullptr, outPositions, nullptr));
+}
+inline void SkinLinearAvx(Mat4x3 const* const palette, SkinInfluences const& influences,
+                          Vec3SoA const& positions, Vec3SoA const& normals,
+                          Vec3SoA& outPositions, Vec3SoA& outNormals)
+{
+    _SkinLinear(SimdLevel::kAvx, palette, influences,
+                _MakeSkinStreams(positions, &normals, outPositions, &outNormals));
+}
+inline void SkinLinearAvx512(Mat4x3 const* const palette, SkinInfluences const& influences,
+                             Vec3SoA const& positions, Vec3SoA& outPositions)
+{
+    _SkinLinear(SimdLevel::kAvx512, palette, influences,
+                _MakeSkinStreams(positions, nullptr, outPositions, nullptr));
+}
+inline void SkinLinearAvx512(Mat4x3 const* const palette, SkinInfluences const& influences,
+                             Vec3SoA const& positions, Vec3SoA const& normals,
+                             Vec3SoA& outPositions, Vec3SoA& outNormals)
+{
+    _SkinLinear(SimdLevel::kAvx512, palette, influences,
+                _MakeSkinStreams(positions, &normals, outPositions, &outNormals));
+}
+inline void SkinLinear(Mat4x3 const* const palette, SkinInfluences const& influences,
+                       Vec3SoA const& positions, Vec3SoA& outPositions)
+{
+    _SkinLinear(ActiveSimdLevel(), palette, influences,
+                _MakeSkinStreams(positions, nullptr, outPositions, nullptr));
+}
+inline void SkinLinear(Mat4x3 const* const palette, SkinInfluences const& influences,
+                       Vec3SoA const& positions, Vec3SoA const& normals,
+                       Vec3SoA& outPositions, Vec3SoA& outNormals)
+{
+    _SkinLinear(ActiveSimdLevel(), palette, influences,
+                _MakeSkinStreams(positions, &normals, outPositions, &outNormals));
+}
+
+/*
+ * Dual quaternion skinning
+ *
+ * Blends each vertex's bone dual quaternions by weight, negating those in the opposite
+ * hemisphere from its first influence, then normalizes the blend into a rigid transform. Unlike
+ * linear blending this doesn't collapse volume at twisting joints, but it can't represent scale,
+ * so FromTransform drops it. The palette takes half the memory of a Mat4 one.
+ *
+ * The SIMD kernels blend one vertex's eight floats in a register, then transpose eight (AVX2)
+ * or sixteen (AVX-512) blends into lanes to normalize and transform them together. SSE
+ * transforms each vertex on its own and transposes four results.
+ */
+constexpr inline DualQuat DualQuat::Identity()
+{
+    return {Quat::Identity(), {0, 0, 0, 0}};
+}
+inline DualQuat DualQuat::FromTransform(Transform const& t)
+{
+    Quat const half = {t.position.x * 0.5f, t.position.y * 0.5f, t.position.z * 0.5f, 0.0f};
+    return {t.orientation, MultiplyScalar(half, t.orientation)};
+}
+// Rotates by the real part, then translates by 2 * dual * Conjugate(real)
+inline Vec3 TransformPoint(DualQuat const& dq, Vec3 const p)
+{
+    Quat const t = MultiplyScalar(dq.dual, Conjugate(dq.real));
+    return Rotate(dq.real, p) + Vec3{t.x, t.y, t.z} * 2.0f;
+}
+
+template<int kInfluences>
+inline void _SkinDualQuatScalar(DualQuat const* const palette, SkinInfluences const& influences,
+                                _SkinStreams const& s, size_t const begin)
+{
+    size_t const stride = _SoAStride(influences.count);
+    for (size_t ii = begin; ii < influences.count; ++ii) {
+        Quat const pivot = palette[influences.bones[ii]].real;
+        Quat r = {0, 0, 0, 0}, d = {0, 0, 0, 0};
+        for (int kk = 0; kk < kInfluences; ++kk) {
+            DualQuat const& b = palette[influences.bones[kk * stride + ii]];
+            float const w = Dot(pivot, b.real) < 0.0f ? -influences.weights[kk * stride + ii]
+                                                      : influences.weights[kk * stride + ii];
+            r = {r.x + b.real.x * w, r.y + b.real.y * w, r.z + b.real.z * w, r.w + b.real.w * w};
+            d = {d.x + b.dual.x * w, d.y + b.dual.y * w, d.z + b.dual.z * w, d.w + b.dual.w * w};
+        }
+        float const inv = 1.0f / Length(r);
+        Vec3 const rv = Vec3{r.x, r.y, r.z} * inv;
+        Vec3 const dv = Vec3{d.x, d.y, d.z} * inv;
+        float const rw = r.w * inv, dw = d.w * inv;
+        Vec3 const t = (dv * rw - rv * dw + Cross(rv, dv)) * 2.0f;
+
+        Vec3 const p = {s.in[0][ii], s.in[1][ii], s.in[2][ii]};
+        Vec3 const c = Cross(rv, p) * 2.0f;
+        Vec3 const q = p + c * rw + Cross(rv, c) + t;
+        s.out[0][ii] = q.x;
+        s.out[1][ii] = q.y;
+        s.out[2][ii] = q.z;
+        if (s.in[3]) {
+            Vec3 const n = {s.in[3][ii], s.in[4][ii], s.in[5][ii]};
+            Vec3 const cn = Cross(rv, n) * 2.0f;
+            Vec3 const m = n + cn * rw + Cross(rv, cn);
+            s.out[3][ii] = m.x;
+            s.out[4][ii] = m.y;
+            s.out[5][ii] = m.z;
+        }
+    }
+}
+template<int kInfluences>
+inline void _SkinDualQuatSse(DualQuat const* const palette, SkinInfluences const& influences,
+                             _SkinStreams const& s)
+{
+    size_t const stride = _SoAStride(influences.count);
+    __m128 const sign = _mm_set1_ps(-0.0f);
+    __m128 const conjugate = _mm_setr_ps(-0.0f, -0.0f, -0.0f, 0.0f);
+    size_t ii = 0;
+    for (; ii + 4 <= influences.count; ii += 4) {
+        __m128 p[4], n[4];
+        for (size_t jj = 0; jj < 4; ++jj) {
+            __m128 const pivot = _mm_load_ps(&palette[influences.bones[ii + jj]].real.x);
+            __m128 r = _mm_setzero_ps(), d = r;
+            for (int kk = 0; kk < kInfluences; ++kk) {
+                DualQuat const& b = palette[influences.bones[kk * stride + ii + jj]];
+                __m128 const real = _mm_load_ps(&b.real.x);
+                __m128 dot = _mm_mul_ps(real, pivot);
+                dot = _mm_add_ps(dot, _mm_shuffle_ps(dot, dot, AK_SWIZZLE(1, 0, 3, 2)));
+                dot = _mm_add_ps(dot, _mm_shuffle_ps(dot, dot, AK_SWIZZLE(2, 3, 0, 1)));
+                __m128 const w = _mm_xor_ps(_mm_set1_ps(influences.weights[kk * stride + ii + jj]),
+                                            _mm_and_ps(dot, sign));
+                r = _mm_add_ps(r, _mm_mul_ps(real, w));
+                d = _mm_add_ps(d, _mm_mul_ps(_mm_load_ps(&b.dual.x), w));
+            }
+            __m128 len = _mm_mul_ps(r, r);
+            len = _mm_add_ps(len, _mm_shuffle_ps(len, len, AK_SWIZZLE(1, 0, 3, 2)));
+            len = _mm_add_ps(len, _mm_shuffle_ps(len, len, AK_SWIZZLE(2, 3, 0, 1)));
+            __m128 const inv = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(len));
+            r = _mm_mul_ps(r, inv);
+            d = _mm_mul_ps(d, inv);
+            __m128 const rw = _mm_shuffle_ps(r, r, AK_SWIZZLE(3, 3, 3, 3));
+            __m128 const t = _QuatMultiplySse(d, _mm_xor_ps(r, conjugate));
+
+            __m128 const v = _mm_setr_ps(s.in[0][ii + jj], s.in[1][ii + jj], s.in[2][ii + jj], 0);
+            __m128 const c = _CrossSse(r, v);
+            __m128 const q = _mm_add_ps(_mm_mul_ps(c, rw), _CrossSse(r, c));
+            p[jj] = _mm_add_ps(v, _mm_add_ps(_mm_add_ps(q, q), _mm_add_ps(t, t)));
+            if (s.in[3]) {
+                __m128 const vn =
+                    _mm_setr_ps(s.in[3][ii + jj], s.in[4][ii + jj], s.in[5][ii + jj], 0);
+                __m128 const cn = _CrossSse(r, vn);
+                __m128 const qn = _mm_add_ps(_mm_mul_ps(cn, rw), _CrossSse(r, cn));
+                n[jj] = _mm_add_ps(vn, _mm_add_ps(qn, qn));
+            }
+        }
+        _MM_TRANSPOSE4_PS(p[0], p[1], p[2], p[3]);
+        _mm_store_ps(s.out[0] + ii, p[0]);
+        _mm_store_ps(s.out[1] + ii, p[1]);
+        _mm_store_ps(s.out[2] + ii, p[2]);
+        if (s.in[3]) {
+            _MM_TRANSPOSE4_PS(n[0], n[1], n[2], n[3]);
+            _mm_store_ps(s.out[3] + ii, n[0]);
+            _mm_store_ps(s.out[4] + ii, n[1]);
+            _mm_store_ps(s.out[5] + ii, n[2]);
+        }
+    }
+    _SkinDualQuatScalar<kInfluences>(palette, influences, s, ii);
+}
+
+// Transposes eight rows of eight floats, within each 256-bit half of the registers
+AK_TARGET_INLINE("avx2,fma")
+void _Transpose8x8Avx(__m256 (&r)[8])
+{
+    __m256 t[8], u[8];
+    for (int ii = 0; ii < 8; ii += 2) {
+        t[ii] = _mm256_unpacklo_ps(r[ii], r[ii + 1]);
+        t[ii + 1] = _mm256_unpackhi_ps(r[ii], r[ii + 1]);
+    }
+    for (int ii = 0; ii < 8; ii += 4) {
+        u[ii] = _mm256_shuffle_ps(t[ii], t[ii + 2], AK_SWIZZLE(0, 1, 0, 1));
+        u[ii + 1] = _mm256_shuffle_ps(t[ii], t[ii + 2], AK_SWIZZLE(2, 3, 2, 3));
+        u[ii + 2] = _mm256_shuffle_ps(t[ii + 1], t[ii + 3], AK_SWIZZLE(0, 1, 0, 1));
+        u[ii + 3] = _mm256_shuffle_ps(t[ii + 1], t[ii + 3], AK_SWIZZLE(2, 3, 2, 3));
+    }
+    for (int ii = 0; ii < 4; ++ii) {
+        r[ii] = _mm256_permute2f128_ps(u[ii], u[ii + 4], 0x20);
+        r[ii + 4] = _mm256_permute2f128_ps(u[ii], u[ii + 4], 0x31);
+    }
+}
+AK_TARGET_INLINE("avx512f")
+void _Transpose8x8Avx512(__m512 (&r)[8])
+{
+    __m512i const low = _mm512_setr_epi32(0, 1, 2, 3, 16, 17, 18, 19, 8, 9, 10, 11, 24, 25, 26, 27);
+    __m512i const high =
+        _mm512_setr_epi32(4, 5, 6, 7, 20, 21, 22, 23, 12, 13, 14, 15, 28, 29, 30, 31);
+    __m512 t[8], u[8];
+    for (int ii = 0; ii < 8; ii += 2) {
+        t[ii] = _mm512_unpacklo_ps(r[ii], r[ii + 1]);
+        t[ii + 1] = _mm512_unpackhi_ps(r[ii], r[ii + 1]);
+    }
+    for (int ii = 0; ii < 8; ii += 4) {
+        u[ii] = _mm512_shuffle_ps(t[ii], t[ii + 2], AK_SWIZZLE(0, 1, 0, 1));
+        u[ii + 1] = _mm512_shuffle_ps(t[ii], t[ii + 2], AK_SWIZZLE(2, 3, 2, 3));
+        u[ii + 2] = _mm512_shuffle_ps(t[ii + 1], t[ii + 3], AK_SWIZZLE(0, 1, 0, 1));
+        u[ii + 3] = _mm512_shuffle_ps(t[ii + 1], t[ii + 3], AK_SWIZZLE(2, 3, 2, 3));
+    }
+    for (int ii = 0; ii < 4; ++ii) {
+        r[ii] = _mm512_permutex2var_ps(u[ii], low, u[ii + 4]);
+        r[ii + 4] = _mm512_permutex2var_ps(u[ii], high, u[ii + 4]);
+    }
+}
+
+template<int kInfluences>
+AK_TARGET_INLINE("avx2,fma")
+void _SkinDualQuatAvx(DualQuat const* const palette, SkinInfluences const& influences,
+                      _SkinStreams const& s)
+{
+    size_t const stride = _SoAStride(influences.count);
+    __m256 const sign = _mm256_set1_ps(-0.0f);
+    size_t ii = 0;
+    for (; ii + 8 <= influences.count; ii += 8) {
+        __m256 blend[8];
+        for (size_t jj = 0; jj < 8; ++jj) {
+            __m256 const pivot = _mm256_load_ps(&palette[influences.bones[ii + jj]].real.x);
+            blend[jj] = _mm256_setzero_ps();
+            for (int kk = 0; kk < kInfluences; ++kk) {
+                __m256 const dq =
+                    _mm256_load_ps(&palette[influences.bones[kk * stride + ii + jj]].real.x);
+                __m256 dot = _mm256_mul_ps(dq, pivot);
+                dot = _mm256_add_ps(dot, _mm256_permute_ps(dot, AK_SWIZZLE(1, 0, 3, 2)));
+                dot = _mm256_add_ps(dot, _mm256_permute_ps(dot, AK_SWIZZLE(2, 3, 0, 1)));
+                dot = _mm256_permute2f128_ps(dot, dot, 0x00);
+                __m256 const w =
+                    _mm256_xor_ps(_mm256_set1_ps(influences.weights[kk * stride + ii + jj]),
+                                  _mm256_and_ps(dot, sign));
+                blend[jj] = _mm256_fmadd_ps(dq, w, blend[jj]);
+            }
+        }
+        _Transpose8x8Avx(blend);
+
+        Vec3x8 rv = {blend[0], blend[1], blend[2]};
+        Vec3x8 dv = {blend[4], blend[5], blend[6]};
+        __m256 const inv = _mm256_div_ps(
+            _mm256_set1_ps(1.0f), _mm256_sqrt_ps(_mm256_fmadd_ps(blend[3], blend[3], Dot(rv, rv))));
+        rv = rv * inv;
+        dv = dv * inv;
+        __m256 const rw = _mm256_mul_ps(blend[3], inv);
+        __m256 const dw = _mm256_mul_ps(blend[7], inv);
+        Vec3x8 const t = (dv * rw - rv * dw + Cross(rv, dv)) * 2.0f;
+
+        Vec3x8 const p = Vec3x8::LoadLanes(s.in[0] + ii, s.in[1] + ii, s.in[2] + ii);
+        Vec3x8 const c = Cross(rv, p) * 2.0f;
+        StoreLanes(p + c * rw + Cross(rv, c) + t, s.out[0] + ii, s.out[1] + ii, s.out[2] + ii);
+        if (s.in[3]) {
+            Vec3x8 const n = Vec3x8::LoadLanes(s.in[3] + ii, s.in[4] + ii, s.in[5] + ii);
+            Vec3x8 const cn = Cross(rv, n) * 2.0f;
+            StoreLanes(n + cn * rw + Cross(rv, cn), s.out[3] + ii, s.out[4] + ii, s.out[5] + ii);
+        }
+    }
+    _SkinDualQuatScalar<kInfluences>(palette, influences, s, ii);
+}
+// One dual quaternion in each 256-bit half
+AK_TARGET_INLINE("avx512f")
+__m512 _Load2x8Avx512(DualQuat const* const low, DualQuat const* const high)
+{
+    __m512d const l = _mm512_castpd256_pd512(_mm256_castps_pd(_mm256_load_ps(&low->real.x)));
+    __m256d const h = _mm256_castps_pd(_mm256_load_ps(&high->real.x));
+    return _mm512_castpd_ps(_mm512_insertf64x4(l, h, 1));
+}
+// Register jj blends vertex ii + jj in its low half and ii + 8 + jj in its high half, so the
+// transpose leaves sixteen vertices in lane order. Padding lanes blend to zero and aren't stored.
+template<int kInfluences>
+AK_TARGET_INLINE("avx512f")
+void _SkinDualQuatAvx512(DualQuat const* const palette, SkinInfluences const& influences,
+                         _SkinStreams const& s)
+{
+    size_t const stride = _SoAStride(influences.count);
+    __m512 const zero = _mm512_setzero_ps();
+    for (size_t ii = 0; ii < influences.count; ii += 16) {
+        __mmask16 const mask =
+            influences.count - ii >= 16 ? 0xffff : _TailMask(influences.count - ii);
+        __m512 blend[8];
+        for (size_t jj = 0; jj < 8; ++jj) {
+            uint32_t const* const bones = influences.bones + ii + jj;
+            float const* const weights = influences.weights + ii + jj;
+            __m512 const pivot = _Load2x8Avx512(&palette[bones[0]], &palette[bones[8]]);
+            blend[jj] = zero;
+            for (int kk = 0; kk < kInfluences; ++kk) {
+                __m512 const dq =
+                    _Load2x8Avx512(&palette[bones[kk * stride]], &palette[bones[kk * stride + 8]]);
+                __m512 dot = _mm512_mul_ps(dq, pivot);
+                dot = _mm512_add_ps(dot, _mm512_permute_ps(dot, AK_SWIZZLE(1, 0, 3, 2)));
+                dot = _mm512_add_ps(dot, _mm512_permute_ps(dot, AK_SWIZZLE(2, 3, 0, 1)));
+                dot = _mm512_shuffle_f32x4(dot, dot, AK_SWIZZLE(0, 0, 2, 2));
+                __m512 w = _mm512_mask_blend_ps(0xff00, _mm512_set1_ps(weights[kk * stride]),
+                                                _mm512_set1_ps(weights[kk * stride + 8]));
+                w = _mm512_mask_sub_ps(w, _mm512_cmp_ps_mask(dot, zero, _CMP_LT_OQ), zero, w);
+                blend[jj] = _mm512_fmadd_ps(dq, w, blend[jj]);
+            }
+        }
+        _Transpose8x8Avx512(blend);
+
+        Vec3x16 rv = {blend[0], blend[1], blend[2]};
+        Vec3x16 dv = {blend[4], blend[5], blend[6]};
+        __m512 const inv = _mm512_div_ps(
+            _mm512_set1_ps(1.0f), _mm512_sqrt_ps(_mm512_fmadd_ps(blend[3], blend[3], Dot(rv, rv))));
+        rv = rv * inv;
+        dv = dv * inv;
+        __m512 const rw = _mm512_mul_ps(blend[3], inv);
+        __m512 const dw = _mm512_mul_ps(blend[7], inv);
+        Vec3x16 const t = (dv * rw - rv * dw + Cross(rv, dv)) * 2.0f;
+
+        Vec3x16 const p = Vec3x16::LoadLanes(s.in[0] + ii, s.in[1] + ii, s.in[2] + ii);
+        Vec3x16 const c = Cross(rv, p) * 2.0f;
+        Vec3x16 const q = p + c * rw + Cross(rv, c) + t;
+        _mm512_mask_storeu_ps(s.out[0] + ii, mask, q.x);
+        _mm512_mask_storeu_ps(s.out[1] + ii, mask, q.y);
+        _mm512_mask_storeu_ps(s.out[2] + ii, mask, q.z);
+        if (s.in[3]) {
+            Vec3x16 const n = Vec3x16::LoadLanes(s.in[3] + ii, s.in[4] + ii, s.in[5] + ii);
+            Vec3x16 const cn = Cross(rv, n) * 2.0f;
+            Vec3x16 const m = n + cn * rw + Cross(rv, cn);
+            _mm512_mask_storeu_ps(s.out[3] + ii, mask, m.x);
+            _mm512_mask_storeu_ps(s.out[4] + ii, mask, m.y);
+            _mm512_mask_storeu_ps(s.out[5] + ii, mask, m.z);
+        }
+    }
+}
+
+inline void _SkinDualQuat(SimdLevel const level, DualQuat const* const palette,
+                          SkinInfluences const& influences, _SkinStreams const& s)
+{
+    assert(influences.influences == 4 || influences.influences == 8);
+    bool const eight = influences.influences == 8;
+    switch (level) {
+        case SimdLevel::kAvx512:
+            return eight ? _SkinDualQuatAvx512<8>(palette, influences, s)
+                         : _SkinDualQuatAvx512<4>(palette, influences, s);
+        case SimdLevel::kAvx:
+            return eight ? _SkinDualQuatAvx<8>(palette, influences, s)
+                         : _SkinDualQuatAvx<4>(palette, influences, s);
+        case SimdLevel::kSse:
+            return eight ? _SkinDualQuatSse<8>(palette, influences, s)
+                         : _SkinDualQuatSse<4>(palette, influences, s);
+        case SimdLevel::kScalar:
+            break;
+    }
+    return eight ? _SkinDualQuatScalar<8>(palette, influences, s, 0)
+                 : _SkinDualQuatScalar<4>(palette, influences, s, 0);
+}
+
+// As SkinLinear, with a dual quaternion palette. Every vertex needs a nonzero weight.
+inline void SkinDualQuatScalar(DualQuat const* const palette, SkinInfluences const& influences,
+                               Vec3SoA const& positions, Vec3SoA& outPositions)
+{
+    _SkinDualQuat(SimdLevel::kScalar, palette, influences,
+                  _MakeSkinStreams(positions, nullptr, outPositions, nullptr));
+}
+inline void SkinDualQuatScalar(DualQuat const* const palette, SkinInfluences const& influences,
+                               Vec3SoA const& positions, Vec3SoA const& normals,
+                               Vec3SoA& outPositions, Vec3SoA& outNormals)
+{
+    _SkinDualQuat(SimdLevel::kScalar, palette, influences,
+                  _MakeSkinStreams(positions, &normals, outPositions, &outNormals));
+}
+inline void SkinDualQuatSse(DualQuat const* const palette, SkinInfluences const& influences,
+                            Vec3SoA const& positions, Vec3SoA& outPositions)
+{
+    _SkinDualQuat(SimdLevel::kSse, palette, influences,
+                  _MakeSkinStreams(positions, nullptr, outPositions, nullptr));
+}
+inline void SkinDualQuatSse(DualQuat const* const palette, SkinInfluences const& influences,
+                            Vec3SoA const& positions, Vec3SoA const& normals,
+                            Vec3SoA& outPositions, Vec3SoA& outNormals)
+{
+    _SkinDualQuat(SimdLevel::kSse, palette, influences,
+                  _MakeSkinStreams(positions, &normals, outPositions, &outNormals));
+}
+inline void SkinDualQuatAvx(DualQuat const* const palette, SkinInfluences const& influences,
+                            Vec3SoA const& positions, Vec3SoA& outPositions)
+{
+    _SkinDualQuat(SimdLevel::kAvx, palette, influences,
+                  _MakeSkinStreams(positions, nullptr, outPositions, nullptr));
+}
+inline void SkinDualQuatAvx(DualQuat const* const palette, SkinInfluences const& influences,
+                            Vec3SoA const& positions, Vec3SoA const& normals,
+                            Vec3SoA& outPositions, Vec3SoA& outNormals)
+{
+    _SkinDualQuat(SimdLevel::kAvx, palette, influences,
+                  _MakeSkinStreams(positions, &normals, outPositions, &outNormals));
+}
+inline void SkinDualQuatAvx512(DualQuat const* const palette, SkinInfluences const& influences,
+                               Vec3SoA const& positions, Vec3SoA& outPositions)
+{
+    _SkinDualQuat(SimdLevel::kAvx512, palette, influences,
+                  _MakeSkinStreams(positions, nullptr, outPositions, nullptr));
+}
+inline void SkinDualQuatAvx512(DualQuat const* const palette, SkinInfluences const& influences,
+                               Vec3SoA const& positions, Vec3SoA const& normals,
+                               Vec3SoA& outPositions, Vec3SoA& outNormals)
+{
+    _SkinDualQuat(SimdLevel::kAvx512, palette, influences,
+                  _MakeSkinStreams(positions, &normals, outPositions, &outNormals));
+}
+inline void SkinDualQuat(DualQuat const* const palette, SkinInfluences const& influences,
+                         Vec3SoA const& positions, Vec3SoA& outPositions)
+{
+    _SkinDualQuat(ActiveSimdLevel(), palette, influences,
+                  _MakeSkinStreams(positions, nullptr, outPositions, nullptr));
+}
+inline void SkinDualQuat(DualQuat const* const palette, SkinInfluences const& influences,
+                         Vec3SoA const& positions, Vec3SoA const& normals,
+                         Vec3SoA& outPositions, Vec3SoA& outNormals)
+{
+    _SkinDualQuat(ActiveSimdLevel(), palette, influences,
+                  _MakeSkinStreams(positions, &normals, outPositions, &outNormals));
+}
+
 }  // namespace ak
@@ -1281,7 +1281,13 @@ static const Transform transform_zero = {
 INLINE Transform transform_lerp(TRANSFORM_INPUT a, TRANSFORM_INPUT b, float t)
 {
     Transform T;
-    T.orientation = vec4_lerp(a.orientation, b.orientation, t);
+    Quaternion qb = b.orientation;
+    float d = a.orientation.x * qb.x + a.orientation.y * qb.y + a.orientation.z * qb.z +
+              a.orientation.w * qb.w;
+    if (d < 0.0f) {
+        qb = vec4_negate(qb);
+    }
+    T.orientation = quat_normalize(vec4_lerp(a.orientation, qb, t));
     T.position = vec3_lerp(a.position, b.position, t);
     T.scale = lerp(a.scale, b.scale, t);
     return T;
@@ -1,4 +1,6 @@
 #include <iostream>
+
+#if AK_HAS_DIRECTXMATH
 #include <DirectXMath.h>
 
 namespace DirectX {
@@ -25,6 +27,7 @@ inline std::ostream& operator<<(std::ostream& os, XMVECTOR const& value)
 }
 
 }  // namespace DirectX
+#endif  // AK_HAS_DIRECTXMATH
 
 #include <glm/glm.hpp>
 
@@ -5,8 +5,11 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
 
 #include <catch.hpp>
+#include <float.h>
+#include "test-utils.h"
 
 namespace glm {
 
@@ -20,13 +23,6 @@ inline T lerp(T const& a, T const& b, float const t)
 
 namespace {
 
-float RandFloat(float const min, float const max)
-{
-    float f = rand() / static_cast<float>(RAND_MAX);
-    f *= (max - min);
-    return f + min;
-}
-
 // vec2
 glm::vec2 GlmFromAk(const ak::Vec2& v)
 {
@@ -36,6 +32,119 @@ glm::vec2 GlmFromAk(const ak::Vec2& v)
     };
 }
 
+// vec3
+glm::vec3 GlmFromAk(const ak::Vec3& v)
+{
+    return {v.x, v.y, v.z};
+}
+
+// vec4
+glm::vec4 GlmFromAk(const ak::Vec4& v)
+{
+    return {v.x, v.y, v.z, v.w};
+}
+
+// mat3
+glm::mat3 GlmFromAk(const ak::Mat3& m)
+{
+    return glm::mat3{m.c0.x, m.c0.y, m.c0.z,  //
+                     m.c1.x, m.c1.y, m.c1.z,  //
+                     m.c2.x, m.c2.y, m.c2.z};
+}
+
+// mat4
+glm::mat4 GlmFromAk(const ak::Mat4& m)
+{
+    return glm::mat4{m.c0.x, m.c0.y, m.c0.z, m.c0.w,  //
+                     m.c1.x, m.c1.y, m.c1.z, m.c1.w,  //
+                     m.c2.x, m.c2.y, m.c2.z, m.c2.w,  //
+                     m.c3.x, m.c3.y, m.c3.z, m.c3.w};
+}
+
+// glm and ak sum their products in different orders, so results are compared within the rounding
+// error of their terms rather than relative to entries that may cancel to near zero. The terms of a
+// determinant sum to the permanent of |m|, and both libraries invert by cofactors over the
+// determinant, so an inverse is good to the error of its cofactor plus that of the determinant.
+template<typename T>
+T Abs(T v)
+{
+    for (int ii = 0; ii < T::length(); ++ii) {
+        v[ii] = glm::abs(v[ii]);
+    }
+    return v;
+}
+// m without column col and row row
+template<typename Sub, typename M>
+Sub Minor(M const& m, int const col, int const row)
+{
+    Sub sub;
+    for (int c = 0, subCol = 0; c < M::length(); ++c) {
+        if (c != col) {
+            for (int r = 0, subRow = 0; r < M::length(); ++r) {
+                if (r != row) {
+                    sub[subCol][subRow++] = m[c][r];
+                }
+            }
+            ++subCol;
+        }
+    }
+    return sub;
+}
+float Permanent(glm::mat2 const& m)
+{
+    return fabsf(m[0][0] * m[1][1]) + fabsf(m[1][0] * m[0][1]);
+}
+float Permanent(glm::mat3 const& m)
+{
+    float sum = 0.0f;
+    for (int c = 0; c < 3; ++c) {
+        sum += fabsf(m[c][0]) * Permanent(Minor<glm::mat2>(m, c, 0));
+    }
+    return sum;
+}
+float Permanent(glm::mat4 const& m)
+{
+    float sum = 0.0f;
+    for (int c = 0; c < 4; ++c) {
+        sum += fabsf(m[c][0]) * Permanent(Minor<glm::mat3>(m, c, 0));
+    }
+    return sum;
+}
+template<typename Sub, typename M>
+M InverseMagnitude(M const& m, M const& inverse)
+{
+    float const det = fabsf(glm::determinant(m));
+    float const permanent = Permanent(m);
+    M magnitude;
+    for (int c = 0; c < M::length(); ++c) {
+        for (int r = 0; r < M::length(); ++r) {
+            float const cofactor = Permanent(Minor<Sub>(m, r, c));
+            magnitude[c][r] = (cofactor + fabsf(inverse[c][r]) * permanent) / det;
+        }
+    }
+    return magnitude;
+}
+
+}  // namespace
+
+// Beside test-utils.h's Near(float, ...) rather than hidden from it in the unnamed namespace
+template<typename T>
+bool Near(T const& actual, T const& expected, T const& magnitude)
+{
+    float const* const pActual = glm::value_ptr(actual);
+    float const* const pExpected = glm::value_ptr(expected);
+    float const* const pMagnitude = glm::value_ptr(magnitude);
+    for (size_t ii = 0; ii < sizeof(T) / sizeof(float); ++ii) {
+        if (!Near(pActual[ii], pExpected[ii], pMagnitude[ii])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Mixed glm/ak comparisons live in ak so that Catch's templated comparisons find them through ADL.
+namespace ak {
+
 inline bool operator==(const glm::vec2& g, const ak::Vec2& k)
 {
     return g.x == Approx(k.x) && g.y == Approx(k.y);
@@ -45,12 +154,6 @@ inline bool operator==(const ak::Vec2& k, const glm::vec2& g)
     return g == k;
 }
 
-// vec3
-glm::vec3 GlmFromAk(const ak::Vec3& v)
-{
-    return {v.x, v.y, v.z};
-}
-
 inline bool operator==(const glm::vec3& g, const ak::Vec3& k)
 {
     return g.x == Approx(k.x) && g.y == Approx(k.y) && g.z == Approx(k.z);
@@ -60,12 +163,6 @@ inline bool operator==(const ak::Vec3& k, const glm::vec3& g)
     return g == k;
 }
 
-// vec4
-glm::vec4 GlmFromAk(const ak::Vec4& v)
-{
-    return {v.x, v.y, v.z, v.w};
-}
-
 inline bool operator==(const glm::vec4& g, const ak::Vec4& k)
 {
     return g.x == Approx(k.x) && g.y == Approx(k.y) && g.z == Approx(k.z) && g.w == Approx(k.w);
@@ -75,18 +172,11 @@ inline bool operator==(const ak::Vec4& k, const glm::vec4& g)
     return g == k;
 }
 
-// mat3
-glm::mat3 GlmFromAk(const ak::Mat3& m)
-{
-    return glm::mat3{m.c0.x, m.c0.y, m.c0.z,  //
-                     m.c1.x, m.c1.y, m.c1.z,  //
-                     m.c2.x, m.c2.y, m.c2.z};
-}
 inline bool operator==(const glm::mat3 g, const ak::Mat3& k)
 {
     float const* const pX = &g[0][0];
     float const* const pK = &k.c0.x;
-    for (int ii = 0; ii < sizeof(k) / sizeof(k.c0.x); ++ii) {
+    for (size_t ii = 0; ii < sizeof(k) / sizeof(k.c0.x); ++ii) {
         if (pX[ii] != Approx(pK[ii])) {
             return false;
         }
@@ -94,19 +184,11 @@ inline bool operator==(const glm::mat3 g, const ak::Mat3& k)
     return true;
 }
 
-// mat4
-glm::mat4 GlmFromAk(const ak::Mat4& m)
-{
-    return glm::mat4{m.c0.x, m.c0.y, m.c0.z, m.c0.w,  //
-                     m.c1.x, m.c1.y, m.c1.z, m.c1.w,  //
-                     m.c2.x, m.c2.y, m.c2.z, m.c2.w,  //
-                     m.c3.x, m.c3.y, m.c3.z, m.c3.w};
-}
 inline bool operator==(const glm::mat4 g, const ak::Mat4& k)
 {
     float const* const pX = &g[0][0];
     float const* const pK = &k.c0.x;
-    for (int ii = 0; ii < sizeof(k) / sizeof(k.c0.x); ++ii) {
+    for (size_t ii = 0; ii < sizeof(k) / sizeof(k.c0.x); ++ii) {
         if (pX[ii] != Approx(pK[ii])) {
             return false;
         }
@@ -114,7 +196,7 @@ inline bool operator==(const glm::mat4 g, const ak::Mat4& k)
     return true;
 }
 
-}  // namespace
+}  // namespace ak
 
 TEST_CASE("GLM - vec2 arithmatic", "[vec2]")
 {
@@ -180,12 +262,13 @@ TEST_CASE("GLM - vec2 arithmatic", "[vec2]")
 
     SECTION("length")
     {
-        REQUIRE(glm::length(a) == ak::Length(i));
-        REQUIRE(glm::length(b) * glm::length(b) == Approx(ak::LengthSq(j)));
+        REQUIRE(glm::length(a) == Approx(ak::Length(i)).epsilon(2 * FLT_EPSILON));
+        REQUIRE(glm::length(b) * glm::length(b) ==
+                Approx(ak::LengthSq(j)).epsilon(2 * FLT_EPSILON));
     }
     SECTION("distance")
     {
-        REQUIRE(glm::distance(a, b) == ak::Distance(i, j));
+        REQUIRE(glm::distance(a, b) == Approx(ak::Distance(i, j)).epsilon(2 * FLT_EPSILON));
         REQUIRE(ak::Distance(j, k) == ak::Distance(k, j));
     }
     SECTION("normalize")
@@ -278,12 +361,13 @@ TEST_CASE("GLM - vec3 arithmatic", "[vec3]")
 
     SECTION("length")
     {
-        REQUIRE(glm::length(a) == ak::Length(i));
-        REQUIRE(glm::length(b) * glm::length(b) == Approx(ak::LengthSq(j)));
+        REQUIRE(glm::length(a) == Approx(ak::Length(i)).epsilon(2 * FLT_EPSILON));
+        REQUIRE(glm::length(b) * glm::length(b) ==
+                Approx(ak::LengthSq(j)).epsilon(2 * FLT_EPSILON));
     }
     SECTION("distance")
     {
-        REQUIRE(glm::distance(a, b) == ak::Distance(i, j));
+        REQUIRE(glm::distance(a, b) == Approx(ak::Distance(i, j)).epsilon(2 * FLT_EPSILON));
         REQUIRE(ak::Distance(j, k) == ak::Distance(k, j));
     }
     SECTION("normalize")
@@ -310,7 +394,7 @@ TEST_CASE("GLM - vec3 arithmatic", "[vec3]")
 
     SECTION("dot")
     {
-        REQUIRE(glm::dot(a, b) == ak::Dot(i, j));
+        REQUIRE(glm::dot(a, b) == Approx(ak::Dot(i, j)).epsilon(2 * FLT_EPSILON));
     }
 
     SECTION("cross")
@@ -389,12 +473,13 @@ TEST_CASE("GLM - vec4 arithmatic", "[vec4]")
 
     SECTION("length")
     {
-        REQUIRE(glm::length(a) == ak::Length(i));
-        REQUIRE(glm::length(b) * glm::length(b) == Approx(ak::LengthSq(j)));
+        REQUIRE(glm::length(a) == Approx(ak::Length(i)).epsilon(2 * FLT_EPSILON));
+        REQUIRE(glm::length(b) * glm::length(b) ==
+                Approx(ak::LengthSq(j)).epsilon(2 * FLT_EPSILON));
     }
     SECTION("distance")
     {
-        REQUIRE(glm::distance(a, b) == ak::Distance(i, j));
+        REQUIRE(glm::distance(a, b) == Approx(ak::Distance(i, j)).epsilon(2 * FLT_EPSILON));
         REQUIRE(ak::Distance(j, k) == ak::Distance(k, j));
     }
     SECTION("normalize")
@@ -477,9 +562,7 @@ TEST_CASE("GLM - mat3 arithmatic", "[mat3]")
     }
     SECTION("multiplication")
     {
-        auto const m1 = a * b;
-        auto const m2 = i * j;
-        CHECK(m1 == m2);
+        CHECK(Near(GlmFromAk(i * j), a * b, Abs(a) * Abs(b)));
     }
     SECTION("transpose")
     {
@@ -487,11 +570,12 @@ TEST_CASE("GLM - mat3 arithmatic", "[mat3]")
     }
     SECTION("determinant")
     {
-        REQUIRE(glm::determinant(a) == Approx(ak::Determinant(i)));
+        REQUIRE(Near(ak::Determinant(i), glm::determinant(a), Permanent(a)));
     }
     SECTION("inverse")
     {
-        REQUIRE(glm::inverse(a) == ak::Inverse(i));
+        glm::mat3 const inverse = glm::inverse(a);
+        REQUIRE(Near(GlmFromAk(ak::Inverse(i)), inverse, InverseMagnitude<glm::mat2>(a, inverse)));
     }
     SECTION("vector multiplication")
     {
@@ -503,7 +587,7 @@ TEST_CASE("GLM - mat3 arithmatic", "[mat3]")
         ak::Vec3 const v{x, y, z};
         REQUIRE(u == v);
 
-        CHECK(a * u == i * v);
+        CHECK(Near(GlmFromAk(i * v), a * u, Abs(a) * Abs(u)));
     }
 }
 
@@ -579,9 +663,7 @@ TEST_CASE("GLM - mat4 arithmatic", "[mat4]")
     }
     SECTION("multiplication")
     {
-        auto const m1 = a * b;
-        auto const m2 = i * j;
-        CHECK(m1 == m2);
+        CHECK(Near(GlmFromAk(i * j), a * b, Abs(a) * Abs(b)));
     }
     SECTION("transpose")
     {
@@ -589,11 +671,12 @@ TEST_CASE("GLM - mat4 arithmatic", "[mat4]")
     }
     SECTION("determinant")
     {
-        REQUIRE(glm::determinant(a) == Approx(ak::Determinant(i)));
+        REQUIRE(Near(ak::Determinant(i), glm::determinant(a), Permanent(a)));
     }
     SECTION("inverse")
     {
-        REQUIRE(glm::inverse(a) == ak::Inverse(i));
+        glm::mat4 const inverse = glm::inverse(a);
+        REQUIRE(Near(GlmFromAk(ak::Inverse(i)), inverse, InverseMagnitude<glm::mat3>(a, inverse)));
     }
     SECTION("vector multiplication")
     {
@@ -606,6 +689,6 @@ TEST_CASE("GLM - mat4 arithmatic", "[mat4]")
         ak::Vec4 const v{x, y, z, w};
         REQUIRE(u == v);
 
-        CHECK(a * u == i * v);
+        CHECK(Near(GlmFromAk(i * v), a * u, Abs(a) * Abs(u)));
     }
 }
@@ -0,0 +1,154 @@
+#include "akmath-parallel.h"
+#include "catch.hpp"
+#include "test-utils.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+namespace {
+
+// The parallel kernels run the same per-item code as the serial ones, so results match exactly
+template<typename T>
+bool Same(T const* const a, T const* const b, size_t const n)
+{
+    return n == 0 || memcmp(a, b, n * sizeof(T)) == 0;
+}
+
+}  // namespace
+
+TEST_CASE("thread pool", "[parallel]")
+{
+    size_t const threadCounts[] = {1, 2, 3, 8};
+    size_t const chunkCounts[] = {0, 1, 5, 1000};
+    for (size_t const threadCount : threadCounts) {
+        ak::ThreadPool pool(threadCount);
+        CHECK(pool.ThreadCount() == threadCount);
+        for (size_t const chunkCount : chunkCounts) {
+            // Every chunk runs exactly once, on one of the pool's threads, job after job
+            for (int job = 0; job < 20; ++job) {
+                std::vector<std::atomic<int>> runs(chunkCount);
+                std::atomic<bool> badThread(false);
+                pool.Run(chunkCount, [&](size_t const chunk, size_t const thread) {
+                    runs[chunk].fetch_add(1);
+                    if (thread >= threadCount) {
+                        badThread = true;
+                    }
+                });
+                for (std::atomic<int> const& r : runs) {
+                    CHECK(r.load() == 1);
+                }
+                CHECK(!badThread);
+            }
+        }
+
+        // ParallelFor covers [0, n) with disjoint chunks. Catch isn't thread safe, so the jobs
+        // only record what they see.
+        size_t const n = 1013;
+        std::vector<int> covered(n);
+        std::atomic<bool> misaligned(false);
+        ak::ParallelFor(pool, n, 64, [&](size_t const begin, size_t const end, size_t) {
+            if (begin % 64 != 0) {
+                misaligned = true;
+            }
+            for (size_t ii = begin; ii < end; ++ii) {
+                ++covered[ii];
+            }
+        });
+        CHECK(!misaligned);
+        for (int const c : covered) {
+            CHECK(c == 1);
+        }
+
+        // Per-thread slots are on separate cache lines
+        ak::PerThread<int> perThread(pool, 7);
+        CHECK(perThread.Count() == threadCount);
+        for (size_t tt = 0; tt < perThread.Count(); ++tt) {
+            CHECK(perThread[tt] == 7);
+            CHECK(reinterpret_cast<uintptr_t>(&perThread[tt]) % ak::kCacheLineSize == 0);
+        }
+    }
+
+    CHECK(ak::L2CacheSize() > 0);
+    ak::ThreadPool pool(4);
+    size_t const sizes[] = {0, 1, 1000, 1 << 20};
+    for (size_t const n : sizes) {
+        size_t const chunk = ak::ChunkSize(pool, n, 64);
+        CHECK(chunk % 64 == 0);
+        CHECK(chunk * 64 <= ak::L2CacheSize() / 2 + 64 * 64);
+    }
+    CHECK(ak::ChunkSize(pool, 1 << 20, 4) * 16 <= (1 << 20));
+}
+
+TEST_CASE("parallel batch kernels", "[parallel][simd]")
+{
+    size_t const counts[] = {0, 1, 37, 1013, 100000};
+    size_t const threadCounts[] = {1, 3};
+    for (size_t const threadCount : threadCounts) {
+        ak::ThreadPool pool(threadCount);
+        for (size_t const count : counts) {
+            Mat4Array a(count), b(count), expected(count), actual(count);
+            ak::MultiplyMany(a.data, b.data, expected.data, count);
+            ak::MultiplyMany(pool, a.data, b.data, actual.data, count);
+            CHECK(Same(actual.data, expected.data, count));
+
+            ak::Mat4 const m = a.count > 0 ? a.data[0] : ak::Mat4::Identity();
+            std::vector<ak::Vec4> v4(count), v4Expected(count), v4Actual(count);
+            std::vector<ak::Vec3> v3(count), v3Expected(count), v3Actual(count);
+            for (size_t ii = 0; ii < count; ++ii) {
+                v4[ii] = RandVec4();
+                v3[ii] = RandVec3();
+            }
+            ak::TransformMany(m, v4.data(), v4Expected.data(), count);
+            ak::TransformMany(pool, m, v4.data(), v4Actual.data(), count);
+            CHECK(Same(v4Actual.data(), v4Expected.data(), count));
+            ak::TransformPoints(m, v3.data(), v3Expected.data(), count);
+            ak::TransformPoints(pool, m, v3.data(), v3Actual.data(), count);
+            CHECK(Same(v3Actual.data(), v3Expected.data(), count));
+            ak::TransformDirections(m, v3.data(), v3Expected.data(), count);
+            ak::TransformDirections(pool, m, v3.data(), v3Actual.data(), count);
+            CHECK(Same(v3Actual.data(), v3Expected.data(), count));
+
+            ak::Aabb const bounds = ak::AabbFromPoints(v3.data(), count);
+            ak::Aabb const parallelBounds = ak::AabbFromPoints(pool, v3.data(), count);
+            CHECK(Same(&parallelBounds, &bounds, 1));
+
+            std::vector<ak::Aabb> boxes(count), boxesExpected(count), boxesActual(count);
+            for (size_t ii = 0; ii < count; ++ii) {
+                ak::Vec3 const c = RandVec3();
+                ak::Vec3 const e = {RandFloat(0.0f, 5.0f), RandFloat(0.0f, 5.0f),
+                                    RandFloat(0.0f, 5.0f)};
+                boxes[ii] = {c - e, c + e};
+            }
+            ak::TransformAabbs(m, boxes.data(), boxesExpected.data(), count);
+            ak::TransformAabbs(pool, m, boxes.data(), boxesActual.data(), count);
+            CHECK(Same(boxesActual.data(), boxesExpected.data(), count));
+
+            ak::Frustum const f = ak::Frustum::FromMatrix(
+                {{0.5f, 0, 0, 0}, {0, 0.5f, 0, 0}, {0, 0, -0.02f, 0}, {0, 0, -1.0f, 1.0f}});
+            std::vector<ak::Containment> classes(count), classesActual(count);
+            ak::ClassifyAabbs(f, boxes.data(), classes.data(), count);
+            ak::ClassifyAabbs(pool, f, boxes.data(), classesActual.data(), count);
+            CHECK(Same(classesActual.data(), classes.data(), count));
+
+            ak::Vec3SoA soa3(count), soa3Expected(count), soa3Actual(count);
+            ak::Vec4SoA soa4(count), soa4Expected(count), soa4Actual(count);
+            for (size_t ii = 0; ii < count; ++ii) {
+                soa3.Set(ii, v3[ii]);
+                soa4.Set(ii, v4[ii]);
+            }
+            ak::Normalize(soa3, soa3Expected);
+            ak::Normalize(pool, soa3, soa3Actual);
+            CHECK(Same(soa3Actual.x, soa3Expected.x, 3 * ak::_SoAStride(count)));
+            ak::Normalize(soa4, soa4Expected);
+            ak::Normalize(pool, soa4, soa4Actual);
+            CHECK(Same(soa4Actual.x, soa4Expected.x, 4 * ak::_SoAStride(count)));
+            ak::NormalizeFast(soa3, soa3Expected);
+            ak::NormalizeFast(pool, soa3, soa3Actual);
+            CHECK(Same(soa3Actual.x, soa3Expected.x, 3 * ak::_SoAStride(count)));
+            ak::NormalizeFast(soa4, soa4Expected);
+            ak::NormalizeFast(pool, soa4, soa4Actual);
+            CHECK(Same(soa4Actual.x, soa4Expected.x, 4 * ak::_SoAStride(count)));
+        }
+    }
+}
@@ -0,0 +1,64 @@
+#include "akmath.h"
+#include "vec_math.h"
+
+#include <catch.hpp>
+#include "test-utils.h"
+
+// vec_math.h is the C reference the ak types keep their layouts from. These cases pin its
+// behavior where akmath.h provides the same operation.
+
+namespace {
+
+Transform ToVecMath(ak::Transform const& t)
+{
+    return {{t.orientation.x, t.orientation.y, t.orientation.z, t.orientation.w},
+            {t.position.x, t.position.y, t.position.z},
+            t.scale};
+}
+
+}  // namespace
+
+TEST_CASE("vec_math transform lerp", "[quat][vec_math]")
+{
+    auto const randTransform = []() {
+        ak::Quat const q = {RandFloat(-1.0f, 1.0f), RandFloat(-1.0f, 1.0f), RandFloat(-1.0f, 1.0f),
+                            RandFloat(-1.0f, 1.0f)};
+        return ak::Transform{ak::Normalize(q), RandVec3(), RandFloat(1.0f, 3.0f)};
+    };
+
+    // Every other pair starts in opposite hemispheres, where a plain 4D lerp takes the long way
+    // around and passes near zero
+    for (int ii = 0; ii < 1000; ++ii) {
+        ak::Transform const a = randTransform();
+        ak::Transform b = randTransform();
+        if ((ak::Dot(a.orientation, b.orientation) < 0.0f) != (ii % 2 == 0)) {
+            b.orientation = -b.orientation;
+        }
+        float const t = RandFloat(0.0f, 1.0f);
+
+        Transform const r = transform_lerp(ToVecMath(a), ToVecMath(b), t);
+        ak::Quat const expected = ak::Nlerp(a.orientation, b.orientation, t);
+        INFO("pair " << ii << ", t = " << t);
+        CHECK(r.orientation.x == Approx(expected.x).margin(1.0e-6));
+        CHECK(r.orientation.y == Approx(expected.y).margin(1.0e-6));
+        CHECK(r.orientation.z == Approx(expected.z).margin(1.0e-6));
+        CHECK(r.orientation.w == Approx(expected.w).margin(1.0e-6));
+        CHECK(vec4_length(r.orientation) == Approx(1.0f));
+
+        ak::Vec3 const position = a.position + (b.position - a.position) * t;
+        CHECK(r.position.x == Approx(position.x));
+        CHECK(r.position.y == Approx(position.y));
+        CHECK(r.position.z == Approx(position.z));
+        CHECK(r.scale == Approx(a.scale + (b.scale - a.scale) * t));
+    }
+
+    // Halfway between q and -q, the same rotation, is q rather than zero
+    ak::Transform const a = randTransform();
+    ak::Transform negated = a;
+    negated.orientation = -a.orientation;
+    Transform const r = transform_lerp(ToVecMath(a), ToVecMath(negated), 0.5f);
+    CHECK(r.orientation.x == Approx(a.orientation.x));
+    CHECK(r.orientation.y == Approx(a.orientation.y));
+    CHECK(r.orientation.z == Approx(a.orientation.z));
+    CHECK(r.orientation.w == Approx(a.orientation.w));
+}
@@ -1,2 +1,2229 @@
+// For the listener that seeds the tests' random inputs
+#define CATCH_CONFIG_EXTERNAL_INTERFACES
 #include "akmath.h"
 #include "catch.hpp"
+#include "test-utils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <float.h>
+#include <iterator>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+struct SeedRngPerTestCase : Catch::TestEventListenerBase
+{
+    using TestEventListenerBase::TestEventListenerBase;
+
+    void testCaseStarting(Catch::TestCaseInfo const& testInfo) override
+    {
+        SeedRng(testInfo.name);
+    }
+};
+CATCH_REGISTER_LISTENER(SeedRngPerTestCase)
+
+namespace {
+
+ak::Mat4 RandRigid()
+{
+    ak::Vec4 const axis = {RandFloat(-1.0f, 1.0f), RandFloat(-1.0f, 1.0f), RandFloat(-1.0f, 1.0f),
+                           0.0f};
+    ak::Mat4 m = ak::Mat4::RotationAxis(axis, RandFloat(-3.0f, 3.0f));
+    m.c3 = {RandFloat(-50.0f, 50.0f), RandFloat(-50.0f, 50.0f), RandFloat(-50.0f, 50.0f), 1.0f};
+    return m;
+}
+ak::Mat4 RandAffine()
+{
+    ak::Mat4 const scale =
+        ak::Mat4::Scaling(RandFloat(0.5f, 4.0f), RandFloat(0.5f, 4.0f), RandFloat(0.5f, 4.0f));
+    return ak::MultiplyScalar(RandRigid(), scale);
+}
+
+bool Equal(ak::Vec3 const a, ak::Vec3 const b)
+{
+    return a.x == Approx(b.x) && a.y == Approx(b.y) && a.z == Approx(b.z);
+}
+bool Equal(ak::Vec4 const a, ak::Vec4 const b)
+{
+    return a.x == Approx(b.x) && a.y == Approx(b.y) && a.z == Approx(b.z) && a.w == Approx(b.w);
+}
+template<typename T>
+bool Equal(std::vector<T> const& a, std::vector<T> const& b)
+{
+    for (size_t ii = 0; ii < a.size(); ++ii) {
+        if (!Equal(a[ii], b[ii])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Equal(ak::Mat4 const& a, ak::Mat4 const& b, float const epsilon = 1.0e-5f)
+{
+    float const* const pA = &a.c0.x;
+    float const* const pB = &b.c0.x;
+    for (size_t ii = 0; ii < sizeof(a) / sizeof(a.c0.x); ++ii) {
+        if (pA[ii] != Approx(pB[ii]).epsilon(epsilon)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Equal(Mat4Array const& a, Mat4Array const& b, float const epsilon = 1.0e-5f)
+{
+    for (size_t ii = 0; ii < a.count; ++ii) {
+        if (!Equal(a.data[ii], b.data[ii], epsilon)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+ak::Vec4 Abs(ak::Vec4 const v)
+{
+    return {fabsf(v.x), fabsf(v.y), fabsf(v.z), fabsf(v.w)};
+}
+// Magnitudes of the terms of m * v, Dot(a, b) and Cross(a, b)
+ak::Vec4 TransformMagnitude(ak::Mat4 const& m, ak::Vec4 const v)
+{
+    return Abs(m.c0) * fabsf(v.x) + Abs(m.c1) * fabsf(v.y) + Abs(m.c2) * fabsf(v.z) +
+           Abs(m.c3) * fabsf(v.w);
+}
+ak::Vec3 TransformMagnitude(ak::Mat4 const& m, ak::Vec3 const v, float const w)
+{
+    ak::Vec4 const r = TransformMagnitude(m, {v.x, v.y, v.z, w});
+    return {r.x, r.y, r.z};
+}
+float DotMagnitude(ak::Vec3 const a, ak::Vec3 const b)
+{
+    return fabsf(a.x * b.x) + fabsf(a.y * b.y) + fabsf(a.z * b.z);
+}
+float DotMagnitude(ak::Vec4 const a, ak::Vec4 const b)
+{
+    return fabsf(a.x * b.x) + fabsf(a.y * b.y) + fabsf(a.z * b.z) + fabsf(a.w * b.w);
+}
+ak::Vec3 CrossMagnitude(ak::Vec3 const a, ak::Vec3 const b)
+{
+    return {fabsf(a.y * b.z) + fabsf(a.z * b.y), fabsf(a.z * b.x) + fabsf(a.x * b.z),
+            fabsf(a.x * b.y) + fabsf(a.y * b.x)};
+}
+
+bool EqualProduct(ak::Mat4 const& a, ak::Mat4 const& b, ak::Mat4 const& product)
+{
+    ak::Mat4 absA = a;
+    ak::Mat4 absB = b;
+    float* const pAbsA = &absA.c0.x;
+    float* const pAbsB = &absB.c0.x;
+    for (size_t ii = 0; ii < sizeof(ak::Mat4) / sizeof(float); ++ii) {
+        pAbsA[ii] = fabsf(pAbsA[ii]);
+        pAbsB[ii] = fabsf(pAbsB[ii]);
+    }
+    ak::Mat4 const expected = ak::MultiplyScalar(a, b);
+    ak::Mat4 const scale = ak::MultiplyScalar(absA, absB);
+
+    float const* const pExpected = &expected.c0.x;
+    float const* const pScale = &scale.c0.x;
+    float const* const pProduct = &product.c0.x;
+    for (size_t ii = 0; ii < sizeof(ak::Mat4) / sizeof(float); ++ii) {
+        if (!Near(pProduct[ii], pExpected[ii], pScale[ii])) {
+            return false;
+        }
+    }
+    return true;
+}
+bool EqualProducts(Mat4Array const& a, Mat4Array const& b, Mat4Array const& products)
+{
+    for (size_t ii = 0; ii < products.count; ++ii) {
+        if (!EqualProduct(a.data[ii], b.data[ii], products.data[ii])) {
+            return false;
+        }
+    }
+    return true;
+}
+bool EqualProducts(ak::Mat4 const& a, Mat4Array const& b, Mat4Array const& products)
+{
+    for (size_t ii = 0; ii < products.count; ++ii) {
+        if (!EqualProduct(a, b.data[ii], products.data[ii])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+TEST_CASE("mat4 multiply dispatch", "[mat4][simd]")
+{
+    ak::SimdLevel const detected = ak::DetectSimdLevel();
+    ak::SimdLevel const active = ak::ActiveSimdLevel();
+    INFO("detected: " << ak::SimdLevelName(detected) << ", active: " << ak::SimdLevelName(active));
+
+#if !defined(AK_SIMD_LEVEL)
+    REQUIRE(active == detected);
+#endif
+
+    ak::Mat4 const a = RandMat4();
+    ak::Mat4 const b = RandMat4();
+
+    CHECK(EqualProduct(a, b, a * b));
+    if (detected >= ak::SimdLevel::kSse) {
+        CHECK(EqualProduct(a, b, ak::MultiplySse(a, b)));
+    }
+    if (detected >= ak::SimdLevel::kAvx) {
+        CHECK(EqualProduct(a, b, ak::MultiplyAvx(a, b)));
+    }
+    if (detected >= ak::SimdLevel::kAvx512) {
+        CHECK(EqualProduct(a, b, ak::MultiplyAvx512(a, b)));
+    }
+
+    // A broadcast operand that is also an element of the output, as in
+    // MultiplyMany(out[k], out, out, n), gives the same products at every level
+    using Broadcast = void (*)(ak::Mat4 const&, ak::Mat4 const*, ak::Mat4*, size_t);
+    std::vector<Broadcast> broadcasts = {ak::MultiplyMany, ak::MultiplyManyScalar};
+    if (detected >= ak::SimdLevel::kSse) {
+        broadcasts.push_back(ak::MultiplyManySse);
+    }
+    if (detected >= ak::SimdLevel::kAvx) {
+        broadcasts.push_back(ak::MultiplyManyAvx);
+    }
+    if (detected >= ak::SimdLevel::kAvx512) {
+        broadcasts.push_back(ak::MultiplyManyAvx512);
+    }
+    size_t const count = 7;
+    Mat4Array const in(count);
+    for (Broadcast const multiply : broadcasts) {
+        for (size_t const aliased : {size_t(0), count / 2}) {
+            Mat4Array out(count);
+            std::copy(in.data, in.data + count, out.data);
+            multiply(out.data[aliased], out.data, out.data, count);
+            CHECK(EqualProducts(in.data[aliased], in, out));
+        }
+    }
+}
+
+TEST_CASE("mat4 batched multiply", "[mat4][simd]")
+{
+    ak::SimdLevel const detected = ak::DetectSimdLevel();
+
+    // Odd counts exercise the unrolled kernels' tails; the large count takes the streaming path.
+    size_t const counts[] = {1, 7, ak::kStreamingStoreBytes / sizeof(ak::Mat4) + 1};
+
+    SECTION("pairwise")
+    {
+        for (size_t const count : counts) {
+            Mat4Array const a(count);
+            Mat4Array const b(count);
+            Mat4Array out(count);
+
+            ak::MultiplyManyScalar(a.data, b.data, out.data, count);
+            CHECK(EqualProducts(a, b, out));
+            ak::MultiplyMany(a.data, b.data, out.data, count);
+            CHECK(EqualProducts(a, b, out));
+            if (detected >= ak::SimdLevel::kSse) {
+                ak::MultiplyManySse(a.data, b.data, out.data, count);
+                CHECK(EqualProducts(a, b, out));
+            }
+            if (detected >= ak::SimdLevel::kAvx) {
+                ak::MultiplyManyAvx(a.data, b.data, out.data, count);
+                CHECK(EqualProducts(a, b, out));
+            }
+            if (detected >= ak::SimdLevel::kAvx512) {
+                ak::MultiplyManyAvx512(a.data, b.data, out.data, count);
+                CHECK(EqualProducts(a, b, out));
+            }
+        }
+    }
+    SECTION("broadcast")
+    {
+        for (size_t const count : counts) {
+            Mat4Array const a(1);
+            Mat4Array const b(count);
+            Mat4Array out(count);
+            ak::Mat4 const& parent = a.data[0];
+
+            ak::MultiplyManyScalar(parent, b.data, out.data, count);
+            CHECK(EqualProducts(parent, b, out));
+            ak::MultiplyMany(parent, b.data, out.data, count);
+            CHECK(EqualProducts(parent, b, out));
+            if (detected >= ak::SimdLevel::kSse) {
+                ak::MultiplyManySse(parent, b.data, out.data, count);
+                CHECK(EqualProducts(parent, b, out));
+            }
+            if (detected >= ak::SimdLevel::kAvx) {
+                ak::MultiplyManyAvx(parent, b.data, out.data, count);
+                CHECK(EqualProducts(parent, b, out));
+            }
+            if (detected >= ak::SimdLevel::kAvx512) {
+                ak::MultiplyManyAvx512(parent, b.data, out.data, count);
+                CHECK(EqualProducts(parent, b, out));
+            }
+        }
+    }
+}
+
+TEST_CASE("mat4 inverse", "[mat4][simd]")
+{
+    ak::SimdLevel const detected = ak::DetectSimdLevel();
+
+    // Different summation orders lose a few more bits on the larger random matrices
+    float const epsilon = 1.0e-3f;
+
+    SECTION("single")
+    {
+        ak::Mat4 const m = RandMat4();
+        ak::Mat4 const expected = ak::InverseScalar(m);
+        CHECK(Equal(expected, ak::Inverse(m), epsilon));
+        if (detected >= ak::SimdLevel::kSse) {
+            CHECK(Equal(expected, ak::InverseSse(m), epsilon));
+        }
+        CHECK(Equal(ak::Mat4::Identity(), ak::Inverse(ak::Mat4::Identity())));
+        CHECK(Equal(ak::Mat4::Scaling(0.5f, 0.25f, 2.0f),
+                    ak::Inverse(ak::Mat4::Scaling(2.0f, 4.0f, 0.5f))));
+    }
+    SECTION("batched")
+    {
+        // Covers the two- and four-wide kernels' tails
+        size_t const counts[] = {1, 2, 3, 4, 5, 7, 9};
+        for (size_t const count : counts) {
+            Mat4Array const m(count);
+            Mat4Array expected(count);
+            Mat4Array out(count);
+            ak::InverseManyScalar(m.data, expected.data, count);
+
+            ak::InverseMany(m.data, out.data, count);
+            CHECK(Equal(expected, out, epsilon));
+            if (detected >= ak::SimdLevel::kSse) {
+                ak::InverseManySse(m.data, out.data, count);
+                CHECK(Equal(expected, out, epsilon));
+            }
+            if (detected >= ak::SimdLevel::kAvx) {
+                ak::InverseManyAvx(m.data, out.data, count);
+                CHECK(Equal(expected, out, epsilon));
+            }
+            if (detected >= ak::SimdLevel::kAvx512) {
+                ak::InverseManyAvx512(m.data, out.data, count);
+                CHECK(Equal(expected, out, epsilon));
+            }
+        }
+    }
+}
+
+TEST_CASE("mat4 affine and rigid inverse", "[mat4][simd]")
+{
+    ak::SimdLevel const detected = ak::DetectSimdLevel();
+    float const epsilon = 1.0e-3f;
+
+    SECTION("single")
+    {
+        ak::Mat4 const affine = RandAffine();
+        ak::Mat4 const rigid = RandRigid();
+        REQUIRE(ak::IsAffine(affine));
+        REQUIRE(ak::IsRigid(rigid));
+        REQUIRE_FALSE(ak::IsRigid(affine));
+        REQUIRE_FALSE(ak::IsAffine(RandMat4()));
+
+        ak::Mat4 const expectedAffine = ak::InverseScalar(affine);
+        ak::Mat4 const expectedRigid = ak::InverseScalar(rigid);
+        CHECK(Equal(expectedAffine, ak::InverseAffineScalar(affine), epsilon));
+        CHECK(Equal(expectedAffine, ak::InverseAffine(affine), epsilon));
+        CHECK(Equal(expectedRigid, ak::InverseRigidScalar(rigid), epsilon));
+        CHECK(Equal(expectedRigid, ak::InverseRigid(rigid), epsilon));
+        if (detected >= ak::SimdLevel::kSse) {
+            CHECK(Equal(expectedAffine, ak::InverseAffineSse(affine), epsilon));
+            CHECK(Equal(expectedRigid, ak::InverseRigidSse(rigid), epsilon));
+        }
+    }
+    SECTION("batched")
+    {
+        size_t const counts[] = {1, 2, 5};
+        for (size_t const count : counts) {
+            Mat4Array affine(count);
+            Mat4Array rigid(count);
+            for (size_t ii = 0; ii < count; ++ii) {
+                affine.data[ii] = RandAffine();
+                rigid.data[ii] = RandRigid();
+            }
+            Mat4Array expectedAffine(count);
+            Mat4Array expectedRigid(count);
+            Mat4Array out(count);
+            ak::InverseManyScalar(affine.data, expectedAffine.data, count);
+            ak::InverseManyScalar(rigid.data, expectedRigid.data, count);
+
+            ak::InverseAffineMany(affine.data, out.data, count);
+            CHECK(Equal(expectedAffine, out, epsilon));
+            ak::InverseRigidMany(rigid.data, out.data, count);
+            CHECK(Equal(expectedRigid, out, epsilon));
+            if (detected >= ak::SimdLevel::kSse) {
+                ak::InverseAffineManySse(affine.data, out.data, count);
+                CHECK(Equal(expectedAffine, out, epsilon));
+                ak::InverseRigidManySse(rigid.data, out.data, count);
+                CHECK(Equal(expectedRigid, out, epsilon));
+            }
+            if (detected >= ak::SimdLevel::kAvx) {
+                ak::InverseAffineManyAvx(affine.data, out.data, count);
+                CHECK(Equal(expectedAffine, out, epsilon));
+                ak::InverseRigidManyAvx(rigid.data, out.data, count);
+                CHECK(Equal(expectedRigid, out, epsilon));
+            }
+        }
+    }
+}
+
+TEST_CASE("mat4 vector transform", "[mat4][simd]")
+{
+    ak::SimdLevel const detected = ak::DetectSimdLevel();
+    ak::Mat4 const m = RandMat4();
+
+    SECTION("single")
+    {
+        ak::Vec4 const v = RandVec4();
+        ak::Vec3 const p = RandVec3();
+        ak::Vec4 const expected = m.c0 * v.x + m.c1 * v.y + m.c2 * v.z + m.c3 * v.w;
+        ak::Vec4 const point = m.c0 * p.x + m.c1 * p.y + m.c2 * p.z + m.c3;
+        ak::Vec4 const direction = m.c0 * p.x + m.c1 * p.y + m.c2 * p.z;
+
+        CHECK(Near(m * v, expected, TransformMagnitude(m, v)));
+        CHECK(Near(ak::TransformPoint(m, p), {point.x, point.y, point.z},
+                   TransformMagnitude(m, p, 1.0f)));
+        CHECK(Near(ak::TransformDirection(m, p), {direction.x, direction.y, direction.z},
+                   TransformMagnitude(m, p, 0.0f)));
+    }
+    SECTION("batched")
+    {
+        // Covers the four-, eight- and sixteen-wide kernels' tails
+        size_t const counts[] = {1, 3, 4, 7, 8, 13, 16, 21, 37};
+        for (size_t const count : counts) {
+            std::vector<ak::Vec4> v(count);
+            std::vector<ak::Vec3> p(count);
+            for (size_t ii = 0; ii < count; ++ii) {
+                v[ii] = RandVec4();
+                p[ii] = RandVec3();
+            }
+            std::vector<ak::Vec4> expected4(count), out4(count);
+            std::vector<ak::Vec3> points(count), directions(count), out3(count);
+            for (size_t ii = 0; ii < count; ++ii) {
+                expected4[ii] = m * v[ii];
+                points[ii] = ak::TransformPoint(m, p[ii]);
+                directions[ii] = ak::TransformDirection(m, p[ii]);
+            }
+            auto const near4 = [&]() {
+                for (size_t ii = 0; ii < count; ++ii) {
+                    if (!Near(out4[ii], expected4[ii], TransformMagnitude(m, v[ii]))) {
+                        return false;
+                    }
+                }
+                return true;
+            };
+            auto const near3 = [&](std::vector<ak::Vec3> const& expected, float const w) {
+                for (size_t ii = 0; ii < count; ++ii) {
+                    if (!Near(out3[ii], expected[ii], TransformMagnitude(m, p[ii], w))) {
+                        return false;
+                    }
+                }
+                return true;
+            };
+
+            ak::TransformMany(m, v.data(), out4.data(), count);
+            CHECK(near4());
+            ak::TransformPoints(m, p.data(), out3.data(), count);
+            CHECK(near3(points, 1.0f));
+            ak::TransformDirections(m, p.data(), out3.data(), count);
+            CHECK(near3(directions, 0.0f));
+
+            ak::TransformManyScalar(m, v.data(), out4.data(), count);
+            CHECK(near4());
+            ak::TransformPointsScalar(m, p.data(), out3.data(), count);
+            CHECK(near3(points, 1.0f));
+            ak::TransformDirectionsScalar(m, p.data(), out3.data(), count);
+            CHECK(near3(directions, 0.0f));
+            if (detected >= ak::SimdLevel::kSse) {
+                ak::TransformManySse(m, v.data(), out4.data(), count);
+                CHECK(near4());
+                ak::TransformPointsSse(m, p.data(), out3.data(), count);
+                CHECK(near3(points, 1.0f));
+                ak::TransformDirectionsSse(m, p.data(), out3.data(), count);
+                CHECK(near3(directions, 0.0f));
+            }
+            if (detected >= ak::SimdLevel::kAvx) {
+                ak::TransformManyAvx(m, v.data(), out4.data(), count);
+                CHECK(near4());
+                ak::TransformPointsAvx(m, p.data(), out3.data(), count);
+                CHECK(near3(points, 1.0f));
+                ak::TransformDirectionsAvx(m, p.data(), out3.data(), count);
+                CHECK(near3(directions, 0.0f));
+            }
+            if (detected >= ak::SimdLevel::kAvx512) {
+                ak::TransformManyAvx512(m, v.data(), out4.data(), count);
+                CHECK(near4());
+                ak::TransformPointsAvx512(m, p.data(), out3.data(), count);
+                CHECK(near3(points, 1.0f));
+                ak::TransformDirectionsAvx512(m, p.data(), out3.data(), count);
+                CHECK(near3(directions, 0.0f));
+            }
+        }
+    }
+}
+
+TEST_CASE("soa streams", "[vec3][vec4][simd]")
+{
+    // Covers the four-, eight- and sixteen-wide kernels' tails
+    size_t const counts[] = {1, 5, 8, 13, 16, 37};
+    for (size_t const count : counts) {
+        std::vector<ak::Vec3> a3(count), b3(count), out3(count);
+        std::vector<ak::Vec4> a4(count), b4(count), out4(count);
+        for (size_t ii = 0; ii < count; ++ii) {
+            a3[ii] = RandVec3();
+            b3[ii] = RandVec3();
+            a4[ii] = RandVec4();
+            b4[ii] = RandVec4();
+        }
+        ak::Vec3SoA sa3(count), sb3(count), so3(count);
+        ak::Vec4SoA sa4(count), sb4(count), so4(count);
+        ak::ToSoA(a3.data(), sa3);
+        ak::ToSoA(b3.data(), sb3);
+        ak::ToSoA(a4.data(), sa4);
+        ak::ToSoA(b4.data(), sb4);
+        std::vector<float> dots(count);
+
+        // Layout and conversion
+        {
+            for (float const* const lane : {sa3.x, sa3.y, sa3.z, sa4.x, sa4.y, sa4.z, sa4.w}) {
+                CHECK(reinterpret_cast<uintptr_t>(lane) % 64 == 0);
+            }
+            for (size_t ii = 0; ii < count; ++ii) {
+                REQUIRE(sa3.Get(ii).x == a3[ii].x);
+                REQUIRE(sa3.Get(ii).z == a3[ii].z);
+                REQUIRE(sa4.Get(ii).y == a4[ii].y);
+                REQUIRE(sa4.Get(ii).w == a4[ii].w);
+            }
+            ak::ToAoS(sa3, out3.data());
+            ak::ToAoS(sa4, out4.data());
+            CHECK(memcmp(a3.data(), out3.data(), count * sizeof(ak::Vec3)) == 0);
+            CHECK(memcmp(a4.data(), out4.data(), count * sizeof(ak::Vec4)) == 0);
+        }
+        // Element-wise
+        {
+            ak::Add(sa3, sb3, so3);
+            ak::ToAoS(so3, out3.data());
+            for (size_t ii = 0; ii < count; ++ii) {
+                CHECK(Equal(a3[ii] + b3[ii], out3[ii]));
+            }
+            ak::Subtract(sa4, sb4, so4);
+            ak::ToAoS(so4, out4.data());
+            for (size_t ii = 0; ii < count; ++ii) {
+                CHECK(Equal(a4[ii] - b4[ii], out4[ii]));
+            }
+            ak::Multiply(sa3, sb3, so3);
+            ak::ToAoS(so3, out3.data());
+            for (size_t ii = 0; ii < count; ++ii) {
+                CHECK(Equal(a3[ii] * b3[ii], out3[ii]));
+            }
+            ak::Divide(sa4, sb4, so4);
+            ak::ToAoS(so4, out4.data());
+            for (size_t ii = 0; ii < count; ++ii) {
+                CHECK(Equal(a4[ii] / b4[ii], out4[ii]));
+            }
+            ak::Min(sa3, sb3, so3);
+            ak::ToAoS(so3, out3.data());
+            for (size_t ii = 0; ii < count; ++ii) {
+                CHECK(Equal(ak::Min(a3[ii], b3[ii]), out3[ii]));
+            }
+            ak::Max(sa4, sb4, so4);
+            ak::ToAoS(so4, out4.data());
+            for (size_t ii = 0; ii < count; ++ii) {
+                CHECK(Equal(ak::Max(a4[ii], b4[ii]), out4[ii]));
+            }
+            ak::Lerp(sa3, sb3, 0.25f, so3);
+            ak::ToAoS(so3, out3.data());
+            for (size_t ii = 0; ii < count; ++ii) {
+                CHECK(Equal(ak::Lerp(a3[ii], b3[ii], 0.25f), out3[ii]));
+            }
+        }
+        // Geometric
+        {
+            ak::Dot(sa3, sb3, dots.data());
+            for (size_t ii = 0; ii < count; ++ii) {
+                CHECK(Near(dots[ii], ak::Dot(a3[ii], b3[ii]), DotMagnitude(a3[ii], b3[ii])));
+            }
+            ak::Dot(sa4, sb4, dots.data());
+            for (size_t ii = 0; ii < count; ++ii) {
+                ak::Vec4 const v = a4[ii] * b4[ii];
+                CHECK(Near(dots[ii], ak::Hadd(v), DotMagnitude(a4[ii], b4[ii])));
+            }
+            ak::Length(sa3, dots.data());
+            for (size_t ii = 0; ii < count; ++ii) {
+                CHECK(dots[ii] == Approx(ak::Length(a3[ii])));
+            }
+            ak::Length(sa4, dots.data());
+            for (size_t ii = 0; ii < count; ++ii) {
+                CHECK(dots[ii] == Approx(ak::Length(a4[ii])));
+            }
+            ak::Normalize(sa3, so3);
+            ak::ToAoS(so3, out3.data());
+            for (size_t ii = 0; ii < count; ++ii) {
+                CHECK(Equal(ak::Normalize(a3[ii]), out3[ii]));
+            }
+            ak::Normalize(sa4, so4);
+            ak::ToAoS(so4, out4.data());
+            for (size_t ii = 0; ii < count; ++ii) {
+                CHECK(Equal(ak::Normalize(a4[ii]), out4[ii]));
+            }
+            ak::Cross(sa3, sb3, so3);
+            ak::ToAoS(so3, out3.data());
+            for (size_t ii = 0; ii < count; ++ii) {
+                CHECK(Near(out3[ii], ak::Cross(a3[ii], b3[ii]), CrossMagnitude(a3[ii], b3[ii])));
+            }
+        }
+        // In place, then moved from
+        {
+            ak::Add(sa4, sb4, sa4);
+            ak::ToAoS(sa4, out4.data());
+            for (size_t ii = 0; ii < count; ++ii) {
+                CHECK(Equal(a4[ii] + b4[ii], out4[ii]));
+            }
+
+            ak::Vec3SoA moved = static_cast<ak::Vec3SoA&&>(sa3);
+            CHECK(moved.count == count);
+            CHECK(sa3.count == 0);
+            CHECK(sa3.x == nullptr);
+        }
+    }
+}
+
+TEST_CASE("soa stream kernels", "[vec3][vec4][simd]")
+{
+    using Binary = void (*)(ak::_DivideOp, float const*, float const*, float*, size_t);
+    using Dot = void (*)(float const* const*, float const* const*, float*, size_t);
+    using Length = void (*)(float const* const*, float*, size_t);
+    using Normalize = void (*)(float const* const*, float* const*, size_t);
+    using Cross = void (*)(float const* const*, float const* const*, float* const*, size_t);
+    ak::SimdLevel const detected = ak::DetectSimdLevel();
+    std::vector<Binary> divides = {ak::_BinaryLanesScalar<ak::_DivideOp>};
+    std::vector<Dot> dots = {ak::_DotSoAScalar<4>};
+    std::vector<Length> lengths = {ak::_LengthSoAScalar<4>};
+    std::vector<Normalize> normalizes = {ak::_NormalizeSoAScalar<3, false>};
+    std::vector<Cross> crosses = {ak::_CrossSoAScalar};
+    if (detected >= ak::SimdLevel::kSse) {
+        divides.push_back(ak::_BinaryLanesSse<ak::_DivideOp>);
+        dots.push_back(ak::_DotSoASse<4>);
+        lengths.push_back(ak::_LengthSoASse<4>);
+        normalizes.push_back(ak::_NormalizeSoASse<3, false>);
+        crosses.push_back(ak::_CrossSoASse);
+    }
+    if (detected >= ak::SimdLevel::kAvx) {
+        divides.push_back(ak::_BinaryLanesAvx<ak::_DivideOp>);
+        dots.push_back(ak::_DotSoAAvx<4>);
+        lengths.push_back(ak::_LengthSoAAvx<4>);
+        normalizes.push_back(ak::_NormalizeSoAAvx<3, false>);
+        crosses.push_back(ak::_CrossSoAAvx);
+    }
+    if (detected >= ak::SimdLevel::kAvx512) {
+        divides.push_back(ak::_BinaryLanesAvx512<ak::_DivideOp>);
+        dots.push_back(ak::_DotSoAAvx512<4>);
+        lengths.push_back(ak::_LengthSoAAvx512<4>);
+        normalizes.push_back(ak::_NormalizeSoAAvx512<3, false>);
+        crosses.push_back(ak::_CrossSoAAvx512);
+    }
+
+    // Covers the four-, eight- and sixteen-wide kernels' tails
+    size_t const counts[] = {1, 5, 8, 13, 16, 37};
+    for (size_t const count : counts) {
+        std::vector<ak::Vec4> a4(count), b4(count);
+        ak::Vec4SoA sa4(count), sb4(count), so4(count);
+        ak::Vec3SoA sa3(count), sb3(count), so3(count);
+        for (size_t ii = 0; ii < count; ++ii) {
+            a4[ii] = RandVec4();
+            b4[ii] = RandVec4();
+            sa4.Set(ii, a4[ii]);
+            sb4.Set(ii, b4[ii]);
+            sa3.Set(ii, {a4[ii].x, a4[ii].y, a4[ii].z});
+            sb3.Set(ii, {b4[ii].x, b4[ii].y, b4[ii].z});
+        }
+        float const* const a4Lanes[] = {sa4.x, sa4.y, sa4.z, sa4.w};
+        float const* const b4Lanes[] = {sb4.x, sb4.y, sb4.z, sb4.w};
+        float* const o4Lanes[] = {so4.x, so4.y, so4.z, so4.w};
+        float const* const a3Lanes[] = {sa3.x, sa3.y, sa3.z};
+        float const* const b3Lanes[] = {sb3.x, sb3.y, sb3.z};
+        float* const o3Lanes[] = {so3.x, so3.y, so3.z};
+        std::vector<float> out(count);
+
+        // Division is correctly rounded on every path. The zeroed padding would turn into 0 / 0 if
+        // a kernel ran past `count`.
+        for (Binary const divide : divides) {
+            for (int ll = 0; ll < 4; ++ll) {
+                divide(ak::_DivideOp(), a4Lanes[ll], b4Lanes[ll], o4Lanes[ll], count);
+            }
+            for (size_t ii = 0; ii < count; ++ii) {
+                ak::Vec4 const expected = a4[ii] / b4[ii];
+                ak::Vec4 const actual = so4.Get(ii);
+                CHECK(memcmp(&expected, &actual, sizeof(expected)) == 0);
+            }
+            for (int ll = 0; ll < 4; ++ll) {
+                for (size_t ii = count; ii < ak::_SoAStride(count); ++ii) {
+                    REQUIRE(o4Lanes[ll][ii] == 0.0f);
+                }
+            }
+        }
+        ak::Divide(sa4, sb4, so4);
+        ak::Divide(sa3, sb3, so3);
+        for (size_t ii = count; ii < ak::_SoAStride(count); ++ii) {
+            REQUIRE(so4.x[ii] == 0.0f);
+            REQUIRE(so4.w[ii] == 0.0f);
+            REQUIRE(so3.x[ii] == 0.0f);
+            REQUIRE(so3.z[ii] == 0.0f);
+        }
+
+        for (Dot const dot : dots) {
+            dot(a4Lanes, b4Lanes, out.data(), count);
+            for (size_t ii = 0; ii < count; ++ii) {
+                ak::Vec4 const a = a4[ii];
+                ak::Vec4 const b = b4[ii];
+                CHECK(Near(out[ii], ak::Hadd(a * b), DotMagnitude(a, b)));
+            }
+        }
+        for (Length const length : lengths) {
+            length(a4Lanes, out.data(), count);
+            for (size_t ii = 0; ii < count; ++ii) {
+                CHECK(out[ii] == Approx(ak::Length(a4[ii])));
+            }
+        }
+        for (Normalize const normalize : normalizes) {
+            normalize(a3Lanes, o3Lanes, count);
+            for (size_t ii = 0; ii < count; ++ii) {
+                CHECK(Equal(ak::Normalize(sa3.Get(ii)), so3.Get(ii)));
+            }
+        }
+        for (Cross const cross : crosses) {
+            cross(a3Lanes, b3Lanes, o3Lanes, count);
+            for (size_t ii = 0; ii < count; ++ii) {
+                ak::Vec3 const a = sa3.Get(ii);
+                ak::Vec3 const b = sb3.Get(ii);
+                CHECK(Near(so3.Get(ii), ak::Cross(a, b), CrossMagnitude(a, b)));
+            }
+        }
+    }
+}
+
+// The scalar API stays usable at compile time alongside Vec4x
+static_assert(ak::Dot(ak::Vec4{1.0f, 2.0f, 3.0f, 4.0f}, ak::Vec4{1.0f, 1.0f, 1.0f, 1.0f}) == 10.0f,
+              "constexpr Vec4");
+
+TEST_CASE("vec4x", "[vec4][simd]")
+{
+    ak::Vec4 const a = RandVec4();
+    ak::Vec4 const b = RandVec4();
+    ak::Vec4x const i = ak::Load(a);
+    ak::Vec4x const j = ak::Load(b);
+    float const f = RandFloat(0.0f, 1.0f);
+
+    ak::Vec4 const roundTrip = ak::Store(i);
+    CHECK(memcmp(&a, &roundTrip, sizeof(a)) == 0);
+
+    CHECK(Equal(a + b, ak::Store(i + j)));
+    CHECK(Equal(a - b, ak::Store(i - j)));
+    CHECK(Equal(a * b, ak::Store(i * j)));
+    CHECK(Equal(a / b, ak::Store(i / j)));
+    CHECK(Equal(a * f, ak::Store(i * f)));
+    CHECK(Equal(a / f, ak::Store(i / f)));
+    CHECK(Equal(-a, ak::Store(-i)));
+    CHECK(Equal(a * f, ak::Store(i * ak::Splat(f))));
+
+    CHECK(ak::Dot(a, b) == Approx(ak::Dot(i, j)));
+    CHECK(ak::Hadd(a) == Approx(ak::Hadd(i)));
+    CHECK(ak::LengthSq(a) == Approx(ak::LengthSq(i)));
+    CHECK(ak::Length(a) == Approx(ak::Length(i)));
+    CHECK(ak::Distance(a, b) == Approx(ak::Distance(i, j)));
+    CHECK(ak::DistanceSq(a, b) == Approx(ak::DistanceSq(i, j)));
+    CHECK(Equal(ak::Normalize(a), ak::Store(ak::Normalize(i))));
+    CHECK(Equal(ak::Min(a, b), ak::Store(ak::Min(i, j))));
+    CHECK(Equal(ak::Max(a, b), ak::Store(ak::Max(i, j))));
+    CHECK(Equal(ak::Lerp(a, b, f), ak::Store(ak::Lerp(i, j, f))));
+
+    ak::Mat4 const m = RandMat4();
+    CHECK(Equal(m * a, ak::Store(m * i)));
+}
+
+namespace {
+
+// Packet functions that return a bare register must be called from code built for their ISA
+AK_TARGET_INLINE("avx2,fma")
+void StoreScalars(ak::Vec3x8 const a, ak::Vec3x8 const b, float* const dot, float* const length,
+                  float* const lengthSq)
+{
+    ak::StoreLanes(ak::Vec3x8{ak::Dot(a, b), ak::Length(a), ak::LengthSq(a)}, dot, length,
+                   lengthSq);
+}
+AK_TARGET_INLINE("avx512f")
+void StoreScalars(ak::Vec3x16 const a, ak::Vec3x16 const b, float* const dot, float* const length,
+                  float* const lengthSq)
+{
+    ak::StoreLanes(ak::Vec3x16{ak::Dot(a, b), ak::Length(a), ak::LengthSq(a)}, dot, length,
+                   lengthSq);
+}
+
+// Runs every packet operation on Packet-wide batches and compares them with the Vec3 API. Only
+// call it when the packet's ISA is available.
+template<typename Packet>
+void CheckPacket(size_t const width)
+{
+    std::vector<ak::Vec3> a(width), b(width), out(width);
+    for (size_t ii = 0; ii < width; ++ii) {
+        a[ii] = RandVec3();
+        b[ii] = RandVec3();
+    }
+    Packet const pa = Packet::Load(a.data());
+    Packet const pb = Packet::Load(b.data());
+    float const t = RandFloat(0.0f, 1.0f);
+    ak::Mat4 const m = RandMat4();
+
+    ak::Store(pa, out.data());
+    CHECK(memcmp(a.data(), out.data(), width * sizeof(ak::Vec3)) == 0);
+    ak::Store(Packet::Splat(a[0]), out.data());
+    for (size_t ii = 0; ii < width; ++ii) {
+        CHECK(Equal(a[0], out[ii]));
+    }
+
+    ak::Store(pa + pb, out.data());
+    for (size_t ii = 0; ii < width; ++ii) {
+        CHECK(Equal(a[ii] + b[ii], out[ii]));
+    }
+    ak::Store(pa - pb, out.data());
+    for (size_t ii = 0; ii < width; ++ii) {
+        CHECK(Equal(a[ii] - b[ii], out[ii]));
+    }
+    ak::Store(pa * pb, out.data());
+    for (size_t ii = 0; ii < width; ++ii) {
+        CHECK(Equal(a[ii] * b[ii], out[ii]));
+    }
+    ak::Store(pa / pb, out.data());
+    for (size_t ii = 0; ii < width; ++ii) {
+        CHECK(Equal(a[ii] / b[ii], out[ii]));
+    }
+    ak::Store(-(pa * t), out.data());
+    for (size_t ii = 0; ii < width; ++ii) {
+        CHECK(Equal(-(a[ii] * t), out[ii]));
+    }
+    ak::Store(ak::Min(pa, pb), out.data());
+    for (size_t ii = 0; ii < width; ++ii) {
+        CHECK(Equal(ak::Min(a[ii], b[ii]), out[ii]));
+    }
+    ak::Store(ak::Max(pa, pb), out.data());
+    for (size_t ii = 0; ii < width; ++ii) {
+        CHECK(Equal(ak::Max(a[ii], b[ii]), out[ii]));
+    }
+    ak::Store(ak::Lerp(pa, pb, t), out.data());
+    for (size_t ii = 0; ii < width; ++ii) {
+        CHECK(Equal(ak::Lerp(a[ii], b[ii], t), out[ii]));
+    }
+    ak::Store(ak::Normalize(pa), out.data());
+    for (size_t ii = 0; ii < width; ++ii) {
+        CHECK(Equal(ak::Normalize(a[ii]), out[ii]));
+    }
+    ak::Store(ak::NormalizeFast(pa), out.data());
+    for (size_t ii = 0; ii < width; ++ii) {
+        ak::Vec3 const n = ak::Normalize(a[ii]);
+        CHECK(out[ii].x == Approx(n.x).margin(1.0e-6));
+        CHECK(out[ii].y == Approx(n.y).margin(1.0e-6));
+        CHECK(out[ii].z == Approx(n.z).margin(1.0e-6));
+    }
+    ak::Store(ak::Cross(pa, pb), out.data());
+    for (size_t ii = 0; ii < width; ++ii) {
+        CHECK(Near(out[ii], ak::Cross(a[ii], b[ii]), CrossMagnitude(a[ii], b[ii])));
+    }
+    ak::Store(ak::TransformPoint(m, pa), out.data());
+    for (size_t ii = 0; ii < width; ++ii) {
+        CHECK(Near(out[ii], ak::TransformPoint(m, a[ii]), TransformMagnitude(m, a[ii], 1.0f)));
+    }
+    ak::Store(ak::TransformDirection(m, pa), out.data());
+    for (size_t ii = 0; ii < width; ++ii) {
+        CHECK(Near(out[ii], ak::TransformDirection(m, a[ii]), TransformMagnitude(m, a[ii], 0.0f)));
+    }
+
+    std::vector<float> dot(width), length(width), lengthSq(width);
+    StoreScalars(pa, pb, dot.data(), length.data(), lengthSq.data());
+    for (size_t ii = 0; ii < width; ++ii) {
+        CHECK(Near(dot[ii], ak::Dot(a[ii], b[ii]), DotMagnitude(a[ii], b[ii])));
+        CHECK(length[ii] == Approx(ak::Length(a[ii])));
+        CHECK(lengthSq[ii] == Approx(ak::LengthSq(a[ii])));
+    }
+    Packet const lanes = Packet::LoadLanes(dot.data(), length.data(), lengthSq.data());
+    ak::Store(lanes, out.data());
+    for (size_t ii = 0; ii < width; ++ii) {
+        CHECK(out[ii].x == dot[ii]);
+        CHECK(out[ii].y == length[ii]);
+        CHECK(out[ii].z == lengthSq[ii]);
+    }
+}
+
+}  // namespace
+
+TEST_CASE("vec3 packets", "[vec3][simd]")
+{
+    ak::SimdLevel const detected = ak::DetectSimdLevel();
+    if (detected >= ak::SimdLevel::kAvx) {
+        CheckPacket<ak::Vec3x8>(8);
+    }
+    if (detected >= ak::SimdLevel::kAvx512) {
+        CheckPacket<ak::Vec3x16>(16);
+    }
+}
+
+namespace {
+
+// Right-handed perspective looking down -z, with clip depth in [0, 1]
+ak::Mat4 Perspective(float const fovY, float const aspect, float const zNear, float const zFar)
+{
+    float const f = 1.0f / tanf(fovY * 0.5f);
+    return {
+        {f / aspect, 0.0f, 0.0f, 0.0f},
+        {0.0f, f, 0.0f, 0.0f},
+        {0.0f, 0.0f, zFar / (zNear - zFar), -1.0f},
+        {0.0f, 0.0f, zNear * zFar / (zNear - zFar), 0.0f},
+    };
+}
+
+}  // namespace
+
+TEST_CASE("frustum culling", "[frustum][simd]")
+{
+    ak::Mat4 const proj = Perspective(1.2f, 16.0f / 9.0f, 1.0f, 100.0f);
+    ak::Frustum const f = ak::Frustum::FromMatrix(proj);
+
+    SECTION("planes")
+    {
+        for (ak::Vec4 const& plane : f.planes) {
+            CHECK(ak::Length(ak::Vec3{plane.x, plane.y, plane.z}) == Approx(1.0f));
+        }
+        CHECK(ak::PlaneDistance(f.planes[ak::Frustum::kNear], {0.0f, 0.0f, -3.0f}) ==
+              Approx(2.0f));
+        CHECK(ak::PlaneDistance(f.planes[ak::Frustum::kFar], {0.0f, 0.0f, -3.0f}) ==
+              Approx(97.0f));
+
+        CHECK(ak::Intersects(f, {{0.0f, 0.0f, -5.0f}, 1.0f}));
+        CHECK_FALSE(ak::Intersects(f, {{0.0f, 0.0f, 5.0f}, 1.0f}));
+        CHECK_FALSE(ak::Intersects(f, {{0.0f, 0.0f, -102.0f}, 1.0f}));
+        CHECK(ak::Intersects(f, {{0.0f, 0.0f, -0.5f}, 0.6f}));
+        CHECK_FALSE(ak::Intersects(f, {{500.0f, 0.0f, -50.0f}, 1.0f}));
+        CHECK_FALSE(ak::Intersects(f, {{0.0f, -500.0f, -50.0f}, 1.0f}));
+
+        // The OpenGL depth range only moves the near plane
+        ak::Mat4 glProj = proj;
+        glProj.c2.z = (100.0f + 1.0f) / (1.0f - 100.0f);
+        glProj.c3.z = 2.0f * 100.0f * 1.0f / (1.0f - 100.0f);
+        ak::Frustum const gl = ak::Frustum::FromMatrix(glProj, ak::ClipDepth::kMinusOneToOne);
+        CHECK(ak::PlaneDistance(gl.planes[ak::Frustum::kNear], {0.0f, 0.0f, -3.0f}) ==
+              Approx(2.0f));
+        CHECK(ak::PlaneDistance(gl.planes[ak::Frustum::kFar], {0.0f, 0.0f, -3.0f}) ==
+              Approx(97.0f));
+    }
+    SECTION("culling")
+    {
+        // Covers the four-, eight- and sixteen-wide kernels' tails
+        size_t const counts[] = {1, 7, 16, 1000, 1013};
+        for (size_t const count : counts) {
+            ak::Vec4SoA spheres(count);
+            std::vector<uint32_t> expected;
+            for (size_t ii = 0; ii < count; ++ii) {
+                ak::Sphere const s = {
+                    {RandFloat(-80.0f, 80.0f), RandFloat(-80.0f, 80.0f), RandFloat(-120.0f, 20.0f)},
+                    RandFloat(0.1f, 5.0f)};
+                spheres.Set(ii, {s.center.x, s.center.y, s.center.z, s.radius});
+                if (ak::Intersects(f, s)) {
+                    expected.push_back(static_cast<uint32_t>(ii));
+                }
+            }
+
+            std::vector<uint32_t> visible(count);
+            auto const check = [&](size_t const visibleCount) {
+                REQUIRE(visibleCount == expected.size());
+                visible.resize(visibleCount);
+                CHECK(visible == expected);
+                visible.assign(count, 0);
+            };
+            ak::SimdLevel const detected = ak::DetectSimdLevel();
+            check(ak::CullSpheres(f, spheres, visible.data()));
+            check(ak::CullSpheresScalar(f, spheres, visible.data()));
+            if (detected >= ak::SimdLevel::kSse) {
+                check(ak::CullSpheresSse(f, spheres, visible.data()));
+            }
+            if (detected >= ak::SimdLevel::kAvx) {
+                check(ak::CullSpheresAvx(f, spheres, visible.data()));
+            }
+            if (detected >= ak::SimdLevel::kAvx512) {
+                check(ak::CullSpheresAvx512(f, spheres, visible.data()));
+            }
+        }
+    }
+}
+
+namespace {
+
+ak::Aabb RandAabb()
+{
+    ak::Vec3 const c = {
+        RandFloat(-80.0f, 80.0f), RandFloat(-80.0f, 80.0f), RandFloat(-120.0f, 20.0f)};
+    ak::Vec3 const e = {RandFloat(0.1f, 8.0f), RandFloat(0.1f, 8.0f), RandFloat(0.1f, 8.0f)};
+    return {c - e, c + e};
+}
+
+void CheckAabb(ak::Aabb const& a, ak::Aabb const& b)
+{
+    CHECK(a.min.x == Approx(b.min.x).margin(1.0e-3));
+    CHECK(a.min.y == Approx(b.min.y).margin(1.0e-3));
+    CHECK(a.min.z == Approx(b.min.z).margin(1.0e-3));
+    CHECK(a.max.x == Approx(b.max.x).margin(1.0e-3));
+    CHECK(a.max.y == Approx(b.max.y).margin(1.0e-3));
+    CHECK(a.max.z == Approx(b.max.z).margin(1.0e-3));
+}
+
+}  // namespace
+
+TEST_CASE("aabb", "[aabb][simd]")
+{
+    ak::SimdLevel const detected = ak::DetectSimdLevel();
+    // Covers the four-, eight- and sixteen-wide kernels' tails
+    size_t const counts[] = {0, 1, 7, 16, 37, 1013};
+
+    SECTION("basics")
+    {
+        ak::Aabb const a = {{0.0f, 0.0f, 0.0f}, {1.0f, 2.0f, 3.0f}};
+        ak::Aabb const b = {{-1.0f, 1.0f, 1.0f}, {0.5f, 4.0f, 2.0f}};
+        CHECK(ak::IsEmpty(ak::Aabb::Empty()));
+        CHECK_FALSE(ak::IsEmpty(a));
+        CHECK(Equal(ak::Center(a), ak::Vec3{0.5f, 1.0f, 1.5f}));
+        CHECK(Equal(ak::Extents(a), ak::Vec3{0.5f, 1.0f, 1.5f}));
+        CHECK(Equal(ak::Union(a, ak::Aabb::Empty()).min, a.min));
+        CHECK(Equal(ak::Union(a, ak::Aabb::Empty()).max, a.max));
+        CHECK(Equal(ak::Union(a, b).min, ak::Vec3{-1.0f, 0.0f, 0.0f}));
+        CHECK(Equal(ak::Union(a, b).max, ak::Vec3{1.0f, 4.0f, 3.0f}));
+        CHECK(Equal(ak::Union(a, ak::Vec3{2.0f, -1.0f, 1.0f}).max, ak::Vec3{2.0f, 2.0f, 3.0f}));
+        CHECK(ak::Contains(a, {1.0f, 2.0f, 3.0f}));
+        CHECK_FALSE(ak::Contains(a, {1.0f, 2.0f, 3.5f}));
+        CHECK(ak::Overlaps(a, b));
+        CHECK_FALSE(ak::Overlaps(a, {{2.0f, 0.0f, 0.0f}, {3.0f, 1.0f, 1.0f}}));
+    }
+    SECTION("transform")
+    {
+        ak::Mat4 m = ak::Mat4::RotationAxis({0.3f, -0.8f, 0.5f, 0.0f}, 1.1f) *
+                     ak::Mat4::Scaling(2.0f, 0.5f, 1.5f);
+        m.c3 = {4.0f, -2.0f, 7.0f, 1.0f};
+        for (size_t const count : counts) {
+            std::vector<ak::Aabb> in(count);
+            std::vector<ak::Aabb> expected(count);
+            for (size_t ii = 0; ii < count; ++ii) {
+                in[ii] = RandAabb();
+                // The tight bound of the eight transformed corners
+                ak::Aabb bound = ak::Aabb::Empty();
+                for (int cc = 0; cc < 8; ++cc) {
+                    ak::Vec3 const corner = {(cc & 1) ? in[ii].max.x : in[ii].min.x,
+                                             (cc & 2) ? in[ii].max.y : in[ii].min.y,
+                                             (cc & 4) ? in[ii].max.z : in[ii].min.z};
+                    bound = ak::Union(bound, ak::TransformPoint(m, corner));
+                }
+                expected[ii] = bound;
+                CheckAabb(ak::TransformAabb(m, in[ii]), bound);
+            }
+
+            std::vector<ak::Aabb> out(count);
+            auto const check = [&]() {
+                for (size_t ii = 0; ii < count; ++ii) {
+                    CheckAabb(out[ii], expected[ii]);
+                }
+                out.assign(count, ak::Aabb::Empty());
+            };
+            ak::TransformAabbs(m, in.data(), out.data(), count);
+            check();
+            ak::TransformAabbsScalar(m, in.data(), out.data(), count);
+            check();
+            if (detected >= ak::SimdLevel::kSse) {
+                ak::TransformAabbsSse(m, in.data(), out.data(), count);
+                check();
+            }
+            if (detected >= ak::SimdLevel::kAvx) {
+                ak::TransformAabbsAvx(m, in.data(), out.data(), count);
+                check();
+            }
+            if (detected >= ak::SimdLevel::kAvx512) {
+                ak::TransformAabbsAvx512(m, in.data(), out.data(), count);
+                check();
+            }
+        }
+    }
+    SECTION("bounds")
+    {
+        for (size_t const count : counts) {
+            std::vector<ak::Vec3> points(count);
+            std::vector<ak::Aabb> boxes(count);
+            ak::Aabb pointBound = ak::Aabb::Empty();
+            ak::Aabb boxBound = ak::Aabb::Empty();
+            for (size_t ii = 0; ii < count; ++ii) {
+                points[ii] = RandVec3();
+                pointBound = ak::Union(pointBound, points[ii]);
+                // Every fifth box is empty and must not contribute
+                boxes[ii] = ii % 5 == 3 ? ak::Aabb::Empty() : RandAabb();
+                boxBound = ak::Union(boxBound, boxes[ii]);
+            }
+
+            auto const check = [](ak::Aabb const& a, ak::Aabb const& b) {
+                CHECK(Equal(a.min, b.min));
+                CHECK(Equal(a.max, b.max));
+            };
+            check(ak::AabbFromPoints(points.data(), count), pointBound);
+            check(ak::AabbFromPointsScalar(points.data(), count), pointBound);
+            check(ak::Union(boxes.data(), count), boxBound);
+            check(ak::UnionScalar(boxes.data(), count), boxBound);
+            if (detected >= ak::SimdLevel::kSse) {
+                check(ak::AabbFromPointsSse(points.data(), count), pointBound);
+                check(ak::UnionSse(boxes.data(), count), boxBound);
+            }
+            if (detected >= ak::SimdLevel::kAvx) {
+                check(ak::AabbFromPointsAvx(points.data(), count), pointBound);
+                check(ak::UnionAvx(boxes.data(), count), boxBound);
+            }
+            if (detected >= ak::SimdLevel::kAvx512) {
+                check(ak::AabbFromPointsAvx512(points.data(), count), pointBound);
+                check(ak::UnionAvx512(boxes.data(), count), boxBound);
+            }
+        }
+    }
+    SECTION("classification")
+    {
+        ak::Vec4 const plane = ak::NormalizePlane({1.0f, -2.0f, 0.5f, 3.0f});
+        for (int ii = 0; ii < 1000; ++ii) {
+            // Against the eight corners, which is exact for a single plane
+            ak::Aabb const box = RandAabb();
+            int positive = 0;
+            for (int cc = 0; cc < 8; ++cc) {
+                ak::Vec3 const corner = {(cc & 1) ? box.max.x : box.min.x,
+                                         (cc & 2) ? box.max.y : box.min.y,
+                                         (cc & 4) ? box.max.z : box.min.z};
+                positive += ak::PlaneDistance(plane, corner) >= 0.0f;
+            }
+            ak::Containment const expected =
+                positive == 0 ? ak::Containment::kOutside
+                              : positive == 8 ? ak::Containment::kInside
+                                              : ak::Containment::kIntersecting;
+            CHECK(ak::Classify(plane, box) == expected);
+        }
+
+        ak::Frustum const f =
+            ak::Frustum::FromMatrix(Perspective(1.2f, 16.0f / 9.0f, 1.0f, 100.0f));
+        CHECK(ak::Classify(f, {{-1.0f, -1.0f, -6.0f}, {1.0f, 1.0f, -4.0f}}) ==
+              ak::Containment::kInside);
+        CHECK(ak::Classify(f, {{-1.0f, -1.0f, -2.0f}, {1.0f, 1.0f, 2.0f}}) ==
+              ak::Containment::kIntersecting);
+        CHECK(ak::Classify(f, {{-1.0f, -1.0f, 2.0f}, {1.0f, 1.0f, 4.0f}}) ==
+              ak::Containment::kOutside);
+
+        for (size_t const count : counts) {
+            std::vector<ak::Aabb> boxes(count);
+            std::vector<ak::Containment> expected(count);
+            for (size_t ii = 0; ii < count; ++ii) {
+                boxes[ii] = RandAabb();
+                expected[ii] = ak::Classify(f, boxes[ii]);
+            }
+
+            std::vector<ak::Containment> out(count);
+            auto const check = [&]() {
+                CHECK(out == expected);
+                out.assign(count, ak::Containment::kOutside);
+            };
+            ak::ClassifyAabbs(f, boxes.data(), out.data(), count);
+            check();
+            ak::ClassifyAabbsScalar(f.planes, ak::Frustum::kPlaneCount, boxes.data(), out.data(),
+                                    count);
+            check();
+            if (detected >= ak::SimdLevel::kSse) {
+                ak::ClassifyAabbsSse(f.planes, ak::Frustum::kPlaneCount, boxes.data(), out.data(),
+                                     count);
+                check();
+            }
+            if (detected >= ak::SimdLevel::kAvx) {
+                ak::ClassifyAabbsAvx(f.planes, ak::Frustum::kPlaneCount, boxes.data(), out.data(),
+                                     count);
+                check();
+            }
+            if (detected >= ak::SimdLevel::kAvx512) {
+                ak::ClassifyAabbsAvx512(f.planes, ak::Frustum::kPlaneCount, boxes.data(),
+                                        out.data(), count);
+                check();
+            }
+        }
+    }
+}
+
+namespace {
+
+ak::Quat RandQuat()
+{
+    return ak::Quat::RotationAxis(RandVec3(), RandFloat(-3.0f, 3.0f));
+}
+
+// q and -q are the same rotation
+bool SameRotation(ak::Quat const a, ak::Quat const b)
+{
+    return fabsf(ak::Dot(a, b)) == Approx(1.0f).epsilon(1.0e-4);
+}
+bool Equal(ak::Quat const a, ak::Quat const b)
+{
+    return a.x == Approx(b.x).margin(1.0e-5) && a.y == Approx(b.y).margin(1.0e-5) &&
+           a.z == Approx(b.z).margin(1.0e-5) && a.w == Approx(b.w).margin(1.0e-5);
+}
+bool Equal(ak::Mat3 const& a, ak::Mat3 const& b)
+{
+    float const* const fa = &a.c0.x;
+    float const* const fb = &b.c0.x;
+    for (int ii = 0; ii < 9; ++ii) {
+        if (fa[ii] != Approx(fb[ii]).margin(1.0e-5)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+TEST_CASE("quat", "[quat][simd]")
+{
+    SECTION("rotation")
+    {
+        ak::Vec3 const axis = {0.3f, -0.8f, 0.5f};
+        ak::Quat const q = ak::Quat::RotationAxis(axis, 1.1f);
+        CHECK(ak::Length(q) == Approx(1.0f));
+        CHECK(Equal(ak::Mat3::Rotation(q), ak::Mat3::RotationAxis(axis, 1.1f)));
+        CHECK(Equal(ak::Mat4::Rotation(q),
+                    ak::Mat4::RotationAxis({axis.x, axis.y, axis.z, 0.0f}, 1.1f)));
+        CHECK(Equal(ak::Mat3::Rotation(ak::Quat::Identity()), ak::Mat3::Identity()));
+
+        for (int ii = 0; ii < 100; ++ii) {
+            ak::Quat const a = RandQuat();
+            ak::Quat const b = RandQuat();
+            ak::Vec3 const v = RandVec3();
+            CHECK(Equal(ak::Rotate(a, v), ak::Mat3::Rotation(a) * v));
+            CHECK(Equal(a * v, ak::Mat3::Rotation(a) * v));
+
+            // Products compose like matrices: a * b rotates by b first
+            CHECK(Equal(a * b, ak::MultiplyScalar(a, b)));
+            CHECK(Equal(ak::Mat3::Rotation(a * b), ak::Mat3::Rotation(a) * ak::Mat3::Rotation(b)));
+            CHECK(Equal(a * ak::Inverse(a), ak::Quat::Identity()));
+            CHECK(Equal(ak::Inverse(a), ak::Conjugate(a)));
+
+            CHECK(SameRotation(ak::Quat::FromMatrix(ak::Mat3::Rotation(a)), a));
+            CHECK(SameRotation(ak::Quat::FromMatrix(ak::Mat4::Rotation(a)), a));
+        }
+        // Each branch of the matrix conversion
+        float const angles[] = {0.0f, 3.1f, -3.1f};
+        ak::Vec3 const axes[] = {{1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}};
+        for (float const angle : angles) {
+            for (ak::Vec3 const& a : axes) {
+                ak::Quat const r = ak::Quat::RotationAxis(a, angle);
+                CHECK(SameRotation(ak::Quat::FromMatrix(ak::Mat3::Rotation(r)), r));
+            }
+        }
+    }
+    SECTION("interpolation")
+    {
+        ak::Vec3 const axis = {0.0f, 1.0f, 0.0f};
+        ak::Quat const a = ak::Quat::RotationAxis(axis, 0.2f);
+        ak::Quat const b = ak::Quat::RotationAxis(axis, 1.4f);
+        CHECK(Equal(ak::Slerp(a, b, 0.0f), a));
+        CHECK(Equal(ak::Slerp(a, b, 1.0f), b));
+        CHECK(Equal(ak::Slerp(a, b, 0.25f), ak::Quat::RotationAxis(axis, 0.5f)));
+        CHECK(Equal(ak::Nlerp(a, b, 0.0f), a));
+        CHECK(Equal(ak::Nlerp(a, b, 1.0f), b));
+        CHECK(Equal(ak::Nlerp(a, b, 0.5f), ak::Quat::RotationAxis(axis, 0.8f)));
+        // Both take the shorter arc when the inputs are in opposite hemispheres
+        CHECK(SameRotation(ak::Slerp(a, -b, 0.25f), ak::Quat::RotationAxis(axis, 0.5f)));
+        CHECK(SameRotation(ak::Nlerp(a, -b, 0.5f), ak::Quat::RotationAxis(axis, 0.8f)));
+        // Nearly equal inputs take the Nlerp path
+        ak::Quat const c = ak::Quat::RotationAxis(axis, 0.2001f);
+        CHECK(ak::Length(ak::Slerp(a, c, 0.5f)) == Approx(1.0f));
+    }
+    SECTION("batched")
+    {
+        ak::SimdLevel const detected = ak::DetectSimdLevel();
+        size_t const counts[] = {0, 1, 3, 4, 37};
+        for (size_t const count : counts) {
+            std::vector<ak::Quat> a(count), b(count), product(count), nlerp(count);
+            for (size_t ii = 0; ii < count; ++ii) {
+                a[ii] = RandQuat();
+                b[ii] = RandQuat();
+                product[ii] = ak::MultiplyScalar(a[ii], b[ii]);
+                nlerp[ii] = ak::Nlerp(a[ii], b[ii], 0.3f);
+            }
+
+            std::vector<ak::Quat> out(count);
+            auto const check = [&](std::vector<ak::Quat> const& expected) {
+                for (size_t ii = 0; ii < count; ++ii) {
+                    CHECK(Equal(out[ii], expected[ii]));
+                }
+                out.assign(count, ak::Quat{});
+            };
+            ak::MultiplyMany(a.data(), b.data(), out.data(), count);
+            check(product);
+            ak::MultiplyManyScalar(a.data(), b.data(), out.data(), count);
+            check(product);
+            ak::NlerpMany(a.data(), b.data(), 0.3f, out.data(), count);
+            check(nlerp);
+            ak::NlerpManyScalar(a.data(), b.data(), 0.3f, out.data(), count);
+            check(nlerp);
+            if (detected >= ak::SimdLevel::kSse) {
+                ak::MultiplyManySse(a.data(), b.data(), out.data(), count);
+                check(product);
+                ak::NlerpManySse(a.data(), b.data(), 0.3f, out.data(), count);
+                check(nlerp);
+            }
+            if (detected >= ak::SimdLevel::kAvx) {
+                ak::MultiplyManyAvx(a.data(), b.data(), out.data(), count);
+                check(product);
+                ak::NlerpManyAvx(a.data(), b.data(), 0.3f, out.data(), count);
+                check(nlerp);
+            }
+            if (detected >= ak::SimdLevel::kAvx512) {
+                ak::MultiplyManyAvx512(a.data(), b.data(), out.data(), count);
+                check(product);
+                ak::NlerpManyAvx512(a.data(), b.data(), 0.3f, out.data(), count);
+                check(nlerp);
+            }
+            ak::SlerpMany(a.data(), b.data(), 0.3f, out.data(), count);
+            for (size_t ii = 0; ii < count; ++ii) {
+                CHECK(Equal(out[ii], ak::Slerp(a[ii], b[ii], 0.3f)));
+            }
+        }
+    }
+}
+
+namespace {
+
+ak::Transform RandTransform()
+{
+    return {RandQuat(), RandVec3(), RandFloat(0.5f, 2.0f)};
+}
+bool Equal(ak::Transform const& a, ak::Transform const& b)
+{
+    return SameRotation(a.orientation, b.orientation) && Equal(a.position, b.position) &&
+           a.scale == Approx(b.scale);
+}
+ak::Transform Blend(ak::Transform const& a, ak::Transform const& b, float const t, bool slerp)
+{
+    return {slerp ? ak::Slerp(a.orientation, b.orientation, t)
+                  : ak::Nlerp(a.orientation, b.orientation, t),
+            a.position + (b.position - a.position) * t, a.scale + (b.scale - a.scale) * t};
+}
+
+}  // namespace
+
+TEST_CASE("pose blending", "[pose][simd]")
+{
+    ak::SimdLevel const detected = ak::DetectSimdLevel();
+    size_t const counts[] = {0, 1, 7, 16, 37};
+    for (size_t const count : counts) {
+        ak::PoseSoA a(count), b(count), c(count), out(count);
+        std::vector<float> weights(count), half(count, 0.5f), zero(count, 0.0f);
+        for (size_t ii = 0; ii < count; ++ii) {
+            a.Set(ii, RandTransform());
+            b.Set(ii, RandTransform());
+            c.Set(ii, RandTransform());
+            weights[ii] = RandFloat(0.0f, 1.0f);
+        }
+        // Opposite hemispheres and nearly equal rotations
+        if (count > 2) {
+            ak::Transform t = a.Get(1);
+            t.orientation = -t.orientation;
+            b.Set(1, t);
+            t = a.Get(2);
+            t.orientation = ak::Normalize(ak::Quat{t.orientation.x + 1.0e-4f, t.orientation.y,
+                                                   t.orientation.z, t.orientation.w});
+            b.Set(2, t);
+        }
+
+        auto const check = [&](bool const slerp) {
+            for (size_t ii = 0; ii < count; ++ii) {
+                ak::Transform const expected = Blend(a.Get(ii), b.Get(ii), weights[ii], slerp);
+                ak::Transform const actual = out.Get(ii);
+                CHECK(Equal(actual.orientation, expected.orientation));
+                CHECK(Equal(actual.position, expected.position));
+                CHECK(actual.scale == Approx(expected.scale));
+            }
+            out = ak::PoseSoA(count);
+        };
+        ak::BlendPoses(a, b, weights.data(), out);
+        check(false);
+        ak::BlendPosesScalar(a, b, weights.data(), out);
+        check(false);
+        ak::SlerpPoses(a, b, weights.data(), out);
+        check(true);
+        ak::SlerpPosesScalar(a, b, weights.data(), out);
+        check(true);
+        if (detected >= ak::SimdLevel::kSse) {
+            ak::BlendPosesSse(a, b, weights.data(), out);
+            check(false);
+            ak::SlerpPosesSse(a, b, weights.data(), out);
+            check(true);
+        }
+        if (detected >= ak::SimdLevel::kAvx) {
+            ak::BlendPosesAvx(a, b, weights.data(), out);
+            check(false);
+            ak::SlerpPosesAvx(a, b, weights.data(), out);
+            check(true);
+        }
+        if (detected >= ak::SimdLevel::kAvx512) {
+            ak::BlendPosesAvx512(a, b, weights.data(), out);
+            check(false);
+            ak::SlerpPosesAvx512(a, b, weights.data(), out);
+            check(true);
+        }
+
+        // Blending in place
+        ak::PoseSoA inPlace(count);
+        for (size_t ii = 0; ii < count; ++ii) {
+            inPlace.Set(ii, a.Get(ii));
+        }
+        ak::BlendPoses(inPlace, b, weights.data(), inPlace);
+        for (size_t ii = 0; ii < count; ++ii) {
+            CHECK(Equal(inPlace.Get(ii), Blend(a.Get(ii), b.Get(ii), weights[ii], false)));
+        }
+
+        // N poses: weights 1 - t and t match the two-pose blend, and a zero weight drops a pose
+        std::vector<float> complement(count);
+        for (size_t ii = 0; ii < count; ++ii) {
+            complement[ii] = 1.0f - weights[ii];
+        }
+        ak::PoseSoA const* const poses[] = {&a, &b, &c};
+        float const* const poseWeights[] = {complement.data(), weights.data(), zero.data()};
+        ak::PoseSoA expected(count);
+        ak::BlendPosesScalar(a, b, weights.data(), expected);
+        auto const checkMany = [&]() {
+            for (size_t ii = 0; ii < count; ++ii) {
+                CHECK(Equal(out.Get(ii), expected.Get(ii)));
+            }
+            out = ak::PoseSoA(count);
+        };
+        ak::BlendPoses(poses, poseWeights, 3, out);
+        checkMany();
+        ak::BlendPosesScalar(poses, poseWeights, 3, out);
+        checkMany();
+        if (detected >= ak::SimdLevel::kSse) {
+            ak::BlendPosesSse(poses, poseWeights, 3, out);
+            checkMany();
+        }
+        if (detected >= ak::SimdLevel::kAvx) {
+            ak::BlendPosesAvx(poses, poseWeights, 3, out);
+            checkMany();
+        }
+        if (detected >= ak::SimdLevel::kAvx512) {
+            ak::BlendPosesAvx512(poses, poseWeights, 3, out);
+            checkMany();
+        }
+        // Equal weights on c and its negated rotations give c
+        ak::PoseSoA negated(count);
+        for (size_t ii = 0; ii < count; ++ii) {
+            ak::Transform t = c.Get(ii);
+            t.orientation = -t.orientation;
+            negated.Set(ii, t);
+        }
+        ak::PoseSoA const* const same[] = {&c, &negated};
+        float const* const sameWeights[] = {half.data(), half.data()};
+        ak::BlendPoses(same, sameWeights, 2, out);
+        for (size_t ii = 0; ii < count; ++ii) {
+            CHECK(Equal(out.Get(ii), c.Get(ii)));
+        }
+    }
+}
+
+namespace {
+
+// World matrices accumulate rounding with depth, and near-zero rotation entries need a margin
+bool EqualWorld(ak::Mat4 const& a, ak::Mat4 const& b)
+{
+    float const* const pA = &a.c0.x;
+    float const* const pB = &b.c0.x;
+    for (int ii = 0; ii < 16; ++ii) {
+        if (pA[ii] != Approx(pB[ii]).epsilon(1.0e-4).margin(1.0e-4)) {
+            return false;
+        }
+    }
+    return true;
+}
+ak::Transform RandLocal()
+{
+    return {RandQuat(),
+            {RandFloat(-5.0f, 5.0f), RandFloat(-5.0f, 5.0f), RandFloat(-5.0f, 5.0f)},
+            RandFloat(0.8f, 1.25f)};
+}
+
+}  // namespace
+
+TEST_CASE("transform hierarchy", "[hierarchy][simd]")
+{
+    uint32_t const none = ak::TransformHierarchy::kNoParent;
+    ak::SimdLevel const detected = ak::DetectSimdLevel();
+    size_t const counts[] = {0, 1, 7, 16, 37, 1013};
+    for (size_t const count : counts) {
+        // A few roots, wide and deep subtrees, and parents out of breadth-first order
+        std::vector<uint32_t> parents(count);
+        for (size_t ii = 0; ii < count; ++ii) {
+            uint32_t const r = Rng()();
+            parents[ii] = ii == 0 || r % 17 == 0 ? none
+                          : r % 3 == 0           ? static_cast<uint32_t>(ii - 1)
+                                                 : static_cast<uint32_t>(r % ii);
+        }
+        std::vector<ak::Transform> locals(count);
+        for (ak::Transform& t : locals) {
+            t = RandLocal();
+        }
+
+        std::vector<ak::TransformHierarchy> hierarchies;
+        std::vector<void (*)(ak::TransformHierarchy&)> updates = {ak::UpdateHierarchy,
+                                                                  ak::UpdateHierarchyScalar};
+        if (detected >= ak::SimdLevel::kSse) {
+            updates.push_back(ak::UpdateHierarchySse);
+        }
+        if (detected >= ak::SimdLevel::kAvx) {
+            updates.push_back(ak::UpdateHierarchyAvx);
+        }
+        if (detected >= ak::SimdLevel::kAvx512) {
+            updates.push_back(ak::UpdateHierarchyAvx512);
+        }
+        for (size_t uu = 0; uu < updates.size(); ++uu) {
+            hierarchies.emplace_back(parents.data(), count);
+        }
+
+        // Nodes outside the changed subtrees must keep their world matrices bit for bit
+        std::vector<char> changed(count, 1);
+        auto const check = [&]() {
+            Mat4Array expected(count);
+            for (size_t ii = 0; ii < count; ++ii) {
+                ak::Mat4 const local = ak::Mat4::FromTransform(locals[ii]);
+                expected.data[ii] =
+                    parents[ii] == none ? local : expected.data[parents[ii]] * local;
+                changed[ii] |= parents[ii] != none && changed[parents[ii]];
+            }
+            for (size_t uu = 0; uu < updates.size(); ++uu) {
+                ak::TransformHierarchy& h = hierarchies[uu];
+                Mat4Array before(count);
+                for (size_t ii = 0; ii < count; ++ii) {
+                    before.data[ii] = h.World(ii);
+                }
+                updates[uu](h);
+                for (size_t ii = 0; ii < count; ++ii) {
+                    ak::Mat4 const world = h.World(ii);
+                    CHECK(EqualWorld(world, expected.data[ii]));
+                    if (!changed[ii]) {
+                        CHECK(memcmp(&world, &before.data[ii], sizeof(world)) == 0);
+                    }
+                }
+                CHECK(h.firstDirty == count);
+            }
+            std::fill(changed.begin(), changed.end(), 0);
+        };
+
+        // Every node is dirty after construction
+        for (ak::TransformHierarchy& h : hierarchies) {
+            for (size_t ii = 0; ii < count; ++ii) {
+                CHECK(Equal(h.GetLocal(ii), {ak::Quat::Identity(), {0, 0, 0}, 1}));
+            }
+        }
+        for (size_t ii = 0; ii < count; ++ii) {
+            for (ak::TransformHierarchy& h : hierarchies) {
+                h.SetLocal(ii, locals[ii]);
+            }
+        }
+        check();
+
+        // Changing a few nodes updates their subtrees; a clean update changes nothing
+        for (int round = 0; round < 3; ++round) {
+            for (size_t ii = 0; ii < count; ii += 1 + RandIndex(50)) {
+                locals[ii] = RandLocal();
+                changed[ii] = 1;
+                for (ak::TransformHierarchy& h : hierarchies) {
+                    h.SetLocal(ii, locals[ii]);
+                }
+            }
+            check();
+        }
+        check();
+
+        // Slots are breadth first with parents before children
+        ak::TransformHierarchy const& h = hierarchies[0];
+        for (size_t ll = 0; ll < h.levelCount; ++ll) {
+            for (size_t ss = h.levels[ll]; ss < h.levels[ll + 1]; ++ss) {
+                if (ll == 0) {
+                    CHECK(h.parents[ss] == count);
+                } else {
+                    CHECK(h.parents[ss] >= h.levels[ll - 1]);
+                    CHECK(h.parents[ss] < h.levels[ll]);
+                }
+            }
+        }
+    }
+}
+
+namespace {
+
+// Skinned positions reach hundreds, so compare with a relative epsilon and a small margin
+bool EqualSkinned(ak::Vec3 const a, ak::Vec3 const b)
+{
+    return a.x == Approx(b.x).epsilon(1.0e-4).margin(1.0e-3) &&
+           a.y == Approx(b.y).epsilon(1.0e-4).margin(1.0e-3) &&
+           a.z == Approx(b.z).epsilon(1.0e-4).margin(1.0e-3);
+}
+
+// Heap arrays of Mat4x3 need explicit alignment too
+struct Mat4x3Array
+{
+    explicit Mat4x3Array(size_t const n)
+        : data(static_cast<ak::Mat4x3*>(_mm_malloc(n * sizeof(ak::Mat4x3), alignof(ak::Mat4x3))))
+        , count(n)
+    {
+        for (size_t ii = 0; ii < count; ++ii) {
+            data[ii] = ak::Mat4x3::FromMat4(RandAffine());
+        }
+    }
+    ~Mat4x3Array()
+    {
+        _mm_free(data);
+    }
+    Mat4x3Array(Mat4x3Array const&) = delete;
+    Mat4x3Array& operator=(Mat4x3Array const&) = delete;
+
+    ak::Mat4x3* data;
+    size_t count;
+};
+
+// Runs every linear blend skinning kernel the CPU supports on a Mat4 or Mat4x3 palette
+template<typename Bone>
+void CheckSkinLinear(Bone const* const palette, ak::SkinInfluences const& skin,
+                     ak::Vec3SoA const& positions, ak::Vec3SoA const& normals,
+                     std::vector<ak::Vec3> const& expectedPositions,
+                     std::vector<ak::Vec3> const& expectedNormals)
+{
+    using Skin = void (*)(Bone const*, ak::SkinInfluences const&, ak::Vec3SoA const&,
+                          ak::Vec3SoA&);
+    using SkinNormals = void (*)(Bone const*, ak::SkinInfluences const&, ak::Vec3SoA const&,
+                                 ak::Vec3SoA const&, ak::Vec3SoA&, ak::Vec3SoA&);
+    ak::SimdLevel const detected = ak::DetectSimdLevel();
+    std::vector<Skin> skins = {ak::SkinLinear, ak::SkinLinearScalar};
+    std::vector<SkinNormals> skinNormals = {ak::SkinLinear, ak::SkinLinearScalar};
+    if (detected >= ak::SimdLevel::kSse) {
+        skins.push_back(ak::SkinLinearSse);
+        skinNormals.push_back(ak::SkinLinearSse);
+    }
+    if (detected >= ak::SimdLevel::kAvx) {
+        skins.push_back(ak::SkinLinearAvx);
+        skinNormals.push_back(ak::SkinLinearAvx);
+    }
+    if (detected >= ak::SimdLevel::kAvx512) {
+        skins.push_back(ak::SkinLinearAvx512);
+        skinNormals.push_back(ak::SkinLinearAvx512);
+    }
+
+    size_t const count = skin.count;
+    for (Skin const s : skins) {
+        ak::Vec3SoA outPositions(count);
+        s(palette, skin, positions, outPositions);
+        for (size_t ii = 0; ii < count; ++ii) {
+            CHECK(EqualSkinned(outPositions.Get(ii), expectedPositions[ii]));
+        }
+    }
+    for (SkinNormals const s : skinNormals) {
+        ak::Vec3SoA outPositions(count), outNormals(count);
+        s(palette, skin, positions, normals, outPositions, outNormals);
+        for (size_t ii = 0; ii < count; ++ii) {
+            CHECK(EqualSkinned(outPositions.Get(ii), expectedPositions[ii]));
+            CHECK(EqualSkinned(outNormals.Get(ii), expectedNormals[ii]));
+        }
+    }
+}
+
+}  // namespace
+
+TEST_CASE("linear blend skinning", "[skinning][simd]")
+{
+    size_t const boneCount = 23;
+    Mat4Array palette(boneCount);
+    Mat4x3Array compactPalette(boneCount);
+    for (size_t bb = 0; bb < boneCount; ++bb) {
+        palette.data[bb] = ak::Mat4::FromMat4x3(compactPalette.data[bb]);
+    }
+
+    int const influenceCounts[] = {4, 8};
+    size_t const counts[] = {0, 1, 7, 16, 37, 1013};
+    for (int const influences : influenceCounts) {
+        for (size_t const count : counts) {
+            // Some vertices leave influences unused, with bone 0 and weight 0
+            ak::SkinInfluences skin(count, influences);
+            ak::Vec3SoA positions(count), normals(count);
+            std::vector<ak::Vec3> expectedPositions(count), expectedNormals(count);
+            for (size_t ii = 0; ii < count; ++ii) {
+                int const used = 1 + static_cast<int>(RandIndex(influences));
+                float weights[8];
+                float sum = 0.0f;
+                for (int kk = 0; kk < used; ++kk) {
+                    weights[kk] = RandFloat(0.1f, 1.0f);
+                    sum += weights[kk];
+                }
+                ak::Vec3 const p = {RandFloat(-5.0f, 5.0f), RandFloat(-5.0f, 5.0f),
+                                    RandFloat(-5.0f, 5.0f)};
+                ak::Vec3 const n = ak::Normalize(RandVec3());
+                positions.Set(ii, p);
+                normals.Set(ii, n);
+                ak::Vec4 position = {0, 0, 0, 0};
+                ak::Vec4 normal = {0, 0, 0, 0};
+                for (int kk = 0; kk < used; ++kk) {
+                    uint32_t const bone = RandIndex(boneCount);
+                    skin.Set(ii, kk, bone, weights[kk] / sum);
+                    position = position + (palette.data[bone] * ak::Vec4{p.x, p.y, p.z, 1.0f}) *
+                                              (weights[kk] / sum);
+                    normal = normal + (palette.data[bone] * ak::Vec4{n.x, n.y, n.z, 0.0f}) *
+                                          (weights[kk] / sum);
+                }
+                expectedPositions[ii] = {position.x, position.y, position.z};
+                expectedNormals[ii] = {normal.x, normal.y, normal.z};
+            }
+
+            CheckSkinLinear(palette.data, skin, positions, normals, expectedPositions,
+                            expectedNormals);
+            CheckSkinLinear(compactPalette.data, skin, positions, normals, expectedPositions,
+                            expectedNormals);
+        }
+    }
+}
+
+namespace {
+
+// Reference blend: the weighted sum of the bones' dual quaternions, each taken in the hemisphere
+// of the first influence's, normalized and applied as a rotation then a translation
+void SkinDualQuatReference(ak::DualQuat const* const palette, uint32_t const* const bones,
+                           float const* const weights, int const used, ak::Vec3 const p,
+                           ak::Vec3 const n, ak::Vec3& outP, ak::Vec3& outN)
+{
+    ak::Quat r = {0, 0, 0, 0}, d = {0, 0, 0, 0};
+    for (int kk = 0; kk < used; ++kk) {
+        ak::DualQuat const& b = palette[bones[kk]];
+        float const w = ak::Dot(palette[bones[0]].real, b.real) < 0 ? -weights[kk] : weights[kk];
+        r = {r.x + w * b.real.x, r.y + w * b.real.y, r.z + w * b.real.z, r.w + w * b.real.w};
+        d = {d.x + w * b.dual.x, d.y + w * b.dual.y, d.z + w * b.dual.z, d.w + w * b.dual.w};
+    }
+    float const inv = 1.0f / ak::Length(r);
+    ak::DualQuat const blend = {{r.x * inv, r.y * inv, r.z * inv, r.w * inv},
+                                {d.x * inv, d.y * inv, d.z * inv, d.w * inv}};
+    outP = ak::TransformPoint(blend, p);
+    outN = ak::Rotate(blend.real, n);
+}
+
+}  // namespace
+
+TEST_CASE("dual quaternion skinning", "[skinning][simd]")
+{
+    // A rigid transform's dual quaternion moves points as its matrix does
+    for (int ii = 0; ii < 100; ++ii) {
+        ak::Transform t = RandLocal();
+        t.scale = 1.0f;
+        ak::Vec3 const p = RandVec3();
+        ak::Vec3 const expected = ak::TransformPoint(ak::Mat4::FromTransform(t), p);
+        CHECK(EqualSkinned(ak::TransformPoint(ak::DualQuat::FromTransform(t), p), expected));
+    }
+    CHECK(Equal(ak::TransformPoint(ak::DualQuat::Identity(), {1, 2, 3}), {1, 2, 3}));
+
+    using Skin = void (*)(ak::DualQuat const*, ak::SkinInfluences const&, ak::Vec3SoA const&,
+                          ak::Vec3SoA&);
+    using SkinNormals = void (*)(ak::DualQuat const*, ak::SkinInfluences const&,
+                                 ak::Vec3SoA const&, ak::Vec3SoA const&, ak::Vec3SoA&,
+                                 ak::Vec3SoA&);
+    ak::SimdLevel const detected = ak::DetectSimdLevel();
+    std::vector<Skin> skins = {ak::SkinDualQuat, ak::SkinDualQuatScalar};
+    std::vector<SkinNormals> skinNormals = {ak::SkinDualQuat, ak::SkinDualQuatScalar};
+    if (detected >= ak::SimdLevel::kSse) {
+        skins.push_back(ak::SkinDualQuatSse);
+        skinNormals.push_back(ak::SkinDualQuatSse);
+    }
+    if (detected >= ak::SimdLevel::kAvx) {
+        skins.push_back(ak::SkinDualQuatAvx);
+        skinNormals.push_back(ak::SkinDualQuatAvx);
+    }
+    if (detected >= ak::SimdLevel::kAvx512) {
+        skins.push_back(ak::SkinDualQuatAvx512);
+        skinNormals.push_back(ak::SkinDualQuatAvx512);
+    }
+
+    // Odd bones are stored in the other hemisphere, which the blend must not depend on. Heap
+    // arrays of DualQuat need explicit alignment, as Mat4Array's do.
+    size_t const boneCount = 23;
+    ak::DualQuat* const palette = static_cast<ak::DualQuat*>(
+        _mm_malloc(boneCount * sizeof(ak::DualQuat), alignof(ak::DualQuat)));
+    for (size_t bb = 0; bb < boneCount; ++bb) {
+        ak::Transform t = RandLocal();
+        t.scale = 1.0f;
+        palette[bb] = ak::DualQuat::FromTransform(t);
+        if (bb % 2 == 1) {
+            palette[bb] = {-palette[bb].real, -palette[bb].dual};
+        }
+    }
+
+    int const influenceCounts[] = {4, 8};
+    size_t const counts[] = {0, 1, 7, 16, 37, 1013};
+    for (int const influences : influenceCounts) {
+        for (size_t const count : counts) {
+            ak::SkinInfluences skin(count, influences);
+            ak::Vec3SoA positions(count), normals(count);
+            std::vector<ak::Vec3> expectedPositions(count), expectedNormals(count);
+            for (size_t ii = 0; ii < count; ++ii) {
+                int const used = 1 + static_cast<int>(RandIndex(influences));
+                uint32_t bones[8];
+                float weights[8];
+                float sum = 0.0f;
+                for (int kk = 0; kk < used; ++kk) {
+                    bones[kk] = RandIndex(boneCount);
+                    weights[kk] = RandFloat(0.1f, 1.0f);
+                    sum += weights[kk];
+                }
+                for (int kk = 0; kk < used; ++kk) {
+                    weights[kk] /= sum;
+                    skin.Set(ii, kk, bones[kk], weights[kk]);
+                }
+                ak::Vec3 const p = {RandFloat(-5.0f, 5.0f), RandFloat(-5.0f, 5.0f),
+                                    RandFloat(-5.0f, 5.0f)};
+                ak::Vec3 const n = ak::Normalize(RandVec3());
+                positions.Set(ii, p);
+                normals.Set(ii, n);
+                SkinDualQuatReference(palette, bones, weights, used, p, n, expectedPositions[ii],
+                                      expectedNormals[ii]);
+            }
+
+            for (Skin const s : skins) {
+                ak::Vec3SoA outPositions(count);
+                s(palette, skin, positions, outPositions);
+                for (size_t ii = 0; ii < count; ++ii) {
+                    CHECK(EqualSkinned(outPositions.Get(ii), expectedPositions[ii]));
+                }
+            }
+            for (SkinNormals const s : skinNormals) {
+                ak::Vec3SoA outPositions(count), outNormals(count);
+                s(palette, skin, positions, normals, outPositions, outNormals);
+                for (size_t ii = 0; ii < count; ++ii) {
+                    CHECK(EqualSkinned(outPositions.Get(ii), expectedPositions[ii]));
+                    CHECK(EqualSkinned(outNormals.Get(ii), expectedNormals[ii]));
+                }
+            }
+        }
+    }
+    _mm_free(palette);
+}
+
+namespace {
+
+// Mat4x3 results come from a different order of operations than their Mat4 references, and
+// translations reach hundreds
+bool Equal(ak::Mat4x3 const& a, ak::Mat4 const& b)
+{
+    ak::Mat4 const m = ak::Mat4::FromMat4x3(a);
+    float const* const pA = &m.c0.x;
+    float const* const pB = &b.c0.x;
+    for (int ii = 0; ii < 16; ++ii) {
+        if (pA[ii] != Approx(pB[ii]).epsilon(1.0e-3).margin(1.0e-3)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+TEST_CASE("mat4x3", "[mat4x3][simd]")
+{
+    ak::SimdLevel const detected = ak::DetectSimdLevel();
+
+    SECTION("conversions")
+    {
+        static_assert(sizeof(ak::Mat4x3) == 48, "Mat4x3 is three rows of four floats");
+        CHECK(Equal(ak::Mat4::FromMat4x3(ak::Mat4x3::Identity()), ak::Mat4::Identity()));
+        for (int ii = 0; ii < 100; ++ii) {
+            ak::Mat4 const m = RandAffine();
+            ak::Mat4 const roundTrip = ak::Mat4::FromMat4x3(ak::Mat4x3::FromMat4(m));
+            CHECK(memcmp(&roundTrip, &m, sizeof(m)) == 0);
+
+            ak::Transform const t = RandTransform();
+            ak::Mat4x3 const fromTransform = ak::Mat4x3::FromTransform(t);
+            CHECK(Equal(fromTransform, ak::Mat4::FromTransform(t)));
+            CHECK(Equal(ak::ToTransform(fromTransform), t));
+        }
+    }
+    SECTION("multiply")
+    {
+        for (int ii = 0; ii < 100; ++ii) {
+            ak::Mat4 const a = RandAffine();
+            ak::Mat4 const b = RandAffine();
+            ak::Mat4x3 const a3 = ak::Mat4x3::FromMat4(a);
+            ak::Mat4x3 const b3 = ak::Mat4x3::FromMat4(b);
+            ak::Mat4 const expected = ak::MultiplyScalar(a, b);
+            CHECK(Equal(ak::MultiplyScalar(a3, b3), expected));
+            CHECK(Equal(a3 * b3, expected));
+            if (detected >= ak::SimdLevel::kSse) {
+                CHECK(Equal(ak::MultiplySse(a3, b3), expected));
+            }
+        }
+
+        using MultiplyMany = void (*)(ak::Mat4x3 const*, ak::Mat4x3 const*, ak::Mat4x3*, size_t);
+        std::vector<MultiplyMany> multiplies = {ak::MultiplyMany, ak::MultiplyManyScalar};
+        if (detected >= ak::SimdLevel::kSse) {
+            multiplies.push_back(ak::MultiplyManySse);
+        }
+        if (detected >= ak::SimdLevel::kAvx) {
+            multiplies.push_back(ak::MultiplyManyAvx);
+        }
+        if (detected >= ak::SimdLevel::kAvx512) {
+            multiplies.push_back(ak::MultiplyManyAvx512);
+        }
+        // The largest count takes the streaming store path
+        size_t const counts[] = {0, 1, 3, 5, 37, 1 << 17};
+        for (size_t const count : counts) {
+            Mat4x3Array a(count), b(count), out(count);
+            for (MultiplyMany const multiply : multiplies) {
+                memset(out.data, 0, count * sizeof(ak::Mat4x3));
+                multiply(a.data, b.data, out.data, count);
+                for (size_t ii = 0; ii < count; ++ii) {
+                    ak::Mat4 const expected = ak::MultiplyScalar(
+                        ak::Mat4::FromMat4x3(a.data[ii]), ak::Mat4::FromMat4x3(b.data[ii]));
+                    if (!Equal(out.data[ii], expected)) {
+                        FAIL_CHECK("mismatch at " << ii << " of " << count);
+                        break;
+                    }
+                }
+            }
+        }
+    }
+    SECTION("inverse")
+    {
+        for (int ii = 0; ii < 100; ++ii) {
+            ak::Mat4 const affine = RandAffine();
+            ak::Mat4 const rigid = RandRigid();
+            ak::Mat4x3 const affine3 = ak::Mat4x3::FromMat4(affine);
+            ak::Mat4x3 const rigid3 = ak::Mat4x3::FromMat4(rigid);
+            ak::Mat4 const expectedAffine = ak::InverseAffineScalar(affine);
+            ak::Mat4 const expectedRigid = ak::InverseRigidScalar(rigid);
+            CHECK(Equal(ak::InverseScalar(affine3), expectedAffine));
+            CHECK(Equal(ak::Inverse(affine3), expectedAffine));
+            CHECK(Equal(ak::InverseRigidScalar(rigid3), expectedRigid));
+            CHECK(Equal(ak::InverseRigid(rigid3), expectedRigid));
+            if (detected >= ak::SimdLevel::kSse) {
+                CHECK(Equal(ak::InverseSse(affine3), expectedAffine));
+                CHECK(Equal(ak::InverseRigidSse(rigid3), expectedRigid));
+            }
+        }
+    }
+    SECTION("transform")
+    {
+        ak::Mat4 const m = RandAffine();
+        ak::Mat4x3 const m3 = ak::Mat4x3::FromMat4(m);
+        size_t const count = 37;
+        std::vector<ak::Vec3> in(count), points(count), directions(count);
+        for (size_t ii = 0; ii < count; ++ii) {
+            in[ii] = RandVec3();
+        }
+        ak::TransformPoints(m3, in.data(), points.data(), count);
+        ak::TransformDirections(m3, in.data(), directions.data(), count);
+        for (size_t ii = 0; ii < count; ++ii) {
+            ak::Vec3 const v = in[ii];
+            ak::Vec4 const p = m * ak::Vec4{v.x, v.y, v.z, 1.0f};
+            ak::Vec4 const d = m * ak::Vec4{v.x, v.y, v.z, 0.0f};
+            CHECK(Equal(ak::TransformPoint(m3, v), ak::Vec3{p.x, p.y, p.z}));
+            CHECK(Equal(ak::TransformDirection(m3, v), ak::Vec3{d.x, d.y, d.z}));
+            CHECK(Equal(points[ii], ak::Vec3{p.x, p.y, p.z}));
+            CHECK(Equal(directions[ii], ak::Vec3{d.x, d.y, d.z}));
+        }
+    }
+}
+
+namespace {
+
+// Distance from the libm double result in units of the float result's last place
+double UlpError(float const value, double const exact)
+{
+    float const magnitude = static_cast<float>(fabs(exact));
+    double const ulp = magnitude < FLT_MIN ? FLT_MIN * FLT_EPSILON
+                                           : nextafterf(magnitude, INFINITY) - magnitude;
+    return fabs(value - exact) / ulp;
+}
+
+}  // namespace
+
+TEST_CASE("sincos", "[trig][simd]")
+{
+    // Dense sweeps of each range, plus zeros, tiny values and multiples of pi/2
+    std::vector<float> angles;
+    for (int ii = -65536; ii <= 65536; ++ii) {
+        angles.push_back(static_cast<float>(ii) / 65536.0f * 8192.0f);
+        angles.push_back(static_cast<float>(ii) / 65536.0f * 8.0f);
+    }
+    for (int ii = -5215; ii <= 5215; ++ii) {
+        angles.push_back(static_cast<float>(ii) * 1.57079632679f);
+    }
+    float const special[] = {0.0f, -0.0f, 1.0e-30f, -1.0e-7f, FLT_MIN, 8192.0f, -8192.0f};
+    angles.insert(angles.end(), std::begin(special), std::end(special));
+    size_t const count = angles.size();
+
+    using SinCosMany = void (*)(float const*, float*, float*, size_t);
+    ak::SimdLevel const detected = ak::DetectSimdLevel();
+    std::vector<SinCosMany> accurate = {ak::SinCosMany, ak::SinCosManyScalar};
+    std::vector<SinCosMany> fast = {ak::SinCosFastMany, ak::SinCosFastManyScalar};
+    if (detected >= ak::SimdLevel::kSse) {
+        accurate.push_back(ak::SinCosManySse);
+        fast.push_back(ak::SinCosFastManySse);
+    }
+    if (detected >= ak::SimdLevel::kAvx) {
+        accurate.push_back(ak::SinCosManyAvx);
+        fast.push_back(ak::SinCosFastManyAvx);
+    }
+    if (detected >= ak::SimdLevel::kAvx512) {
+        accurate.push_back(ak::SinCosManyAvx512);
+        fast.push_back(ak::SinCosFastManyAvx512);
+    }
+
+    std::vector<float> s(count), c(count);
+    for (SinCosMany const sinCos : accurate) {
+        sinCos(angles.data(), s.data(), c.data(), count);
+        double worst = 0.0;
+        for (size_t ii = 0; ii < count; ++ii) {
+            double const x = angles[ii];
+            double const bound = fabs(x) <= 1024.0 ? 1.5 : 2.5;
+            double const error = std::max(UlpError(s[ii], sin(x)), UlpError(c[ii], cos(x)));
+            if (error > bound) {
+                FAIL_CHECK("sincos(" << angles[ii] << ") is off by " << error << " ULP");
+            }
+            worst = std::max(worst, error);
+        }
+        CHECK(worst <= 2.5);
+    }
+    for (SinCosMany const sinCos : fast) {
+        sinCos(angles.data(), s.data(), c.data(), count);
+        double worst = 0.0;
+        for (size_t ii = 0; ii < count; ++ii) {
+            double const x = angles[ii];
+            worst = std::max(worst, std::max(fabs(s[ii] - sin(x)), fabs(c[ii] - cos(x))));
+        }
+        CHECK(worst <= 2.0e-5);
+    }
+
+    // The single forms evaluate the same polynomials as the batches
+    std::vector<float> batchS(count), batchC(count);
+    for (size_t ii = 0; ii < count; ++ii) {
+        float sv, cv;
+        ak::SinCos(angles[ii], sv, cv);
+        double const x = angles[ii];
+        double const error = std::max(UlpError(sv, sin(x)), UlpError(cv, cos(x)));
+        if (error > 2.5) {
+            FAIL_CHECK("SinCos(" << angles[ii] << ") is off by " << error << " ULP");
+        }
+    }
+    ak::Vec4x s4, c4;
+    ak::SinCos(ak::Load(ak::Vec4{angles[0], angles[1], angles[2], angles[3]}), s4, c4);
+    ak::SinCosManySse(angles.data(), batchS.data(), batchC.data(), 4);
+    CHECK(Equal(ak::Store(s4), ak::Vec4{batchS[0], batchS[1], batchS[2], batchS[3]}));
+    CHECK(Equal(ak::Store(c4), ak::Vec4{batchC[0], batchC[1], batchC[2], batchC[3]}));
+
+    float const nonFinite[] = {INFINITY, -INFINITY, NAN};
+    for (float const x : nonFinite) {
+        float sv, cv;
+        ak::SinCos(x, sv, cv);
+        CHECK(std::isnan(sv));
+        CHECK(std::isnan(cv));
+    }
+    float sv, cv;
+    ak::SinCosFast(NAN, sv, cv);
+    CHECK(std::isnan(sv));
+    CHECK(std::isnan(cv));
+}
+
+TEST_CASE("rotation builders", "[trig][mat4][quat]")
+{
+    // Crosses the builders' 256-angle chunks
+    size_t const counts[] = {0, 1, 300};
+    for (size_t const count : counts) {
+        std::vector<float> angles(count);
+        std::vector<ak::Vec3> axes(count);
+        for (size_t ii = 0; ii < count; ++ii) {
+            angles[ii] = RandFloat(-10.0f, 10.0f);
+            axes[ii] = RandVec3();
+        }
+        Mat4Array x(count), y(count), z(count), axis(count);
+        std::vector<ak::Quat> quats(count);
+        ak::RotationXMany(angles.data(), x.data, count);
+        ak::RotationYMany(angles.data(), y.data, count);
+        ak::RotationZMany(angles.data(), z.data, count);
+        ak::RotationAxisMany(axes.data(), angles.data(), axis.data, count);
+        ak::RotationAxisMany(axes.data(), angles.data(), quats.data(), count);
+        for (size_t ii = 0; ii < count; ++ii) {
+            ak::Vec4 const a = {axes[ii].x, axes[ii].y, axes[ii].z, 0.0f};
+            CHECK(EqualWorld(x.data[ii], ak::Mat4::RotationX(angles[ii])));
+            CHECK(EqualWorld(y.data[ii], ak::Mat4::RotationY(angles[ii])));
+            CHECK(EqualWorld(z.data[ii], ak::Mat4::RotationZ(angles[ii])));
+            CHECK(EqualWorld(axis.data[ii], ak::Mat4::RotationAxis(a, angles[ii])));
+            CHECK(Equal(quats[ii], ak::Quat::RotationAxis(axes[ii], angles[ii])));
+        }
+    }
+
+    // The constructors agree with libm
+    for (int ii = 0; ii < 100; ++ii) {
+        float const angle = RandFloat(-10.0f, 10.0f);
+        ak::Mat4 const m = ak::Mat4::RotationZ(angle);
+        CHECK(m.c0.x == Approx(cosf(angle)).margin(1.0e-6));
+        CHECK(m.c0.y == Approx(sinf(angle)).margin(1.0e-6));
+        ak::Quat const q = ak::Quat::RotationAxis({0, 0, 1}, angle);
+        CHECK(q.z == Approx(sinf(angle * 0.5f)).margin(1.0e-6));
+        CHECK(q.w == Approx(cosf(angle * 0.5f)).margin(1.0e-6));
+    }
+}
+
+namespace {
+
+// LengthInvFast's documented bound, for every estimate it may use
+float const kRsqrtError = 4.0e-7f;
+
+template<typename Vector>
+void CheckLengthInvFast(Vector const v)
+{
+    double const exact = 1.0 / sqrt(static_cast<double>(ak::LengthSq(v)));
+    CHECK(fabs(ak::LengthInvFast(v) - exact) <= kRsqrtError * exact);
+}
+
+// Runs the SoA LengthInvFast and NormalizeFast kernels of every level the host supports over
+// `count` vectors of kLanes components, every fifth of them zero
+template<int kLanes>
+void CheckFastSoAKernels(size_t const count)
+{
+    using LengthInv = void (*)(float const* const*, float*, size_t);
+    using Normalize = void (*)(float const* const*, float* const*, size_t);
+    ak::SimdLevel const detected = ak::DetectSimdLevel();
+    std::vector<LengthInv> lengthInvs = {[](float const* const* a, float* out, size_t n) {
+        ak::_LengthInvFastSoAScalar<kLanes>(a, out, 0, n);
+    }};
+    std::vector<Normalize> normalizes = {ak::_NormalizeSoAScalar<kLanes, true>};
+    if (detected >= ak::SimdLevel::kSse) {
+        lengthInvs.push_back(ak::_LengthInvFastSoASse<kLanes>);
+        normalizes.push_back(ak::_NormalizeSoASse<kLanes, true>);
+    }
+    if (detected >= ak::SimdLevel::kAvx) {
+        lengthInvs.push_back(ak::_LengthInvFastSoAAvx<kLanes>);
+        normalizes.push_back(ak::_NormalizeSoAAvx<kLanes, true>);
+    }
+    if (detected >= ak::SimdLevel::kAvx512) {
+        lengthInvs.push_back(ak::_LengthInvFastSoAAvx512<kLanes>);
+        normalizes.push_back(ak::_NormalizeSoAAvx512<kLanes, true>);
+    }
+
+    std::vector<float> in(kLanes * count), out(kLanes * count);
+    float const* inLanes[kLanes];
+    float* outLanes[kLanes];
+    for (int ll = 0; ll < kLanes; ++ll) {
+        inLanes[ll] = in.data() + ll * count;
+        outLanes[ll] = out.data() + ll * count;
+        for (size_t ii = 0; ii < count; ++ii) {
+            in[ll * count + ii] = ii % 5 == 0 ? 0.0f : RandFloat(-50.0f, 50.0f);
+        }
+    }
+    std::vector<double> exact(count);
+    for (size_t ii = 0; ii < count; ++ii) {
+        double lengthSq = 0.0;
+        for (int ll = 0; ll < kLanes; ++ll) {
+            lengthSq += static_cast<double>(inLanes[ll][ii]) * inLanes[ll][ii];
+        }
+        exact[ii] = 1.0 / sqrt(lengthSq);
+    }
+
+    std::vector<float> inv(count);
+    for (size_t kk = 0; kk < lengthInvs.size(); ++kk) {
+        INFO("level " << kk);
+        lengthInvs[kk](inLanes, inv.data(), count);
+        for (size_t ii = 0; ii < count; ++ii) {
+            if (ii % 5 == 0) {
+                CHECK(std::isfinite(inv[ii]));
+            } else {
+                CHECK(fabs(inv[ii] - exact[ii]) <= kRsqrtError * exact[ii]);
+            }
+        }
+    }
+    for (size_t kk = 0; kk < normalizes.size(); ++kk) {
+        INFO("level " << kk);
+        normalizes[kk](inLanes, outLanes, count);
+        for (size_t ii = 0; ii < count; ++ii) {
+            double lengthSq = 0.0;
+            for (int ll = 0; ll < kLanes; ++ll) {
+                lengthSq += static_cast<double>(outLanes[ll][ii]) * outLanes[ll][ii];
+            }
+            CHECK(sqrt(lengthSq) == Approx(ii % 5 == 0 ? 0.0 : 1.0).epsilon(kRsqrtError * 2));
+        }
+    }
+}
+
+}  // namespace
+
+TEST_CASE("fast normalization", "[vec3][vec4][simd]")
+{
+    for (int ii = 0; ii < 1000; ++ii) {
+        // Magnitudes from 1e-12 to 1e12
+        float const scale = powf(10.0f, RandFloat(-12.0f, 12.0f));
+        ak::Vec4 const v = RandVec4() * scale;
+        ak::Vec3 const v3 = {v.x, v.y, v.z};
+        ak::Vec2 const v2 = {v.x, v.y};
+        CheckLengthInvFast(v);
+        CheckLengthInvFast(v3);
+        CheckLengthInvFast(v2);
+        CHECK(ak::Length(ak::NormalizeFast(v)) == Approx(1.0f).epsilon(kRsqrtError * 2));
+        CHECK(ak::Length(ak::NormalizeFast(v3)) == Approx(1.0f).epsilon(kRsqrtError * 2));
+        CHECK(ak::Length(ak::NormalizeFast(v2)) == Approx(1.0f).epsilon(kRsqrtError * 2));
+
+        ak::Vec4 const n = ak::Normalize(v);
+        ak::Vec4 const fast = ak::Store(ak::NormalizeFast(ak::Load(v)));
+        CHECK(fast.x == Approx(n.x).margin(1.0e-6));
+        CHECK(fast.y == Approx(n.y).margin(1.0e-6));
+        CHECK(fast.z == Approx(n.z).margin(1.0e-6));
+        CHECK(fast.w == Approx(n.w).margin(1.0e-6));
+        CHECK(ak::LengthInvFast(ak::Load(v)) == Approx(ak::LengthInvFast(v)));
+    }
+
+    // Zero vectors normalize to zero, without a branch
+    ak::Vec3 const zero = ak::NormalizeFast(ak::Vec3{0, 0, 0});
+    CHECK(zero.x == 0.0f);
+    CHECK(zero.y == 0.0f);
+    CHECK(zero.z == 0.0f);
+    CHECK(std::isfinite(ak::LengthInvFast(ak::Vec4{0, 0, 0, 0})));
+    ak::Vec4 const zero4 = ak::Store(ak::NormalizeFast(ak::Load(ak::Vec4{0, 0, 0, 0})));
+    CHECK(Equal(zero4, ak::Vec4{0, 0, 0, 0}));
+
+    size_t const counts[] = {0, 1, 7, 37, 1013};
+    for (size_t const count : counts) {
+        ak::Vec3SoA a3(count), out3(count);
+        ak::Vec4SoA a4(count), out4(count);
+        for (size_t ii = 0; ii < count; ++ii) {
+            bool const isZero = ii % 5 == 0;
+            a3.Set(ii, isZero ? ak::Vec3{0, 0, 0} : RandVec3());
+            a4.Set(ii, isZero ? ak::Vec4{0, 0, 0, 0} : RandVec4());
+        }
+        std::vector<float> inv3(count), inv4(count);
+        ak::NormalizeFast(a3, out3);
+        ak::NormalizeFast(a4, out4);
+        ak::LengthInvFast(a3, inv3.data());
+        ak::LengthInvFast(a4, inv4.data());
+        for (size_t ii = 0; ii < count; ++ii) {
+            ak::Vec3 const v3 = a3.Get(ii);
+            ak::Vec4 const v4 = a4.Get(ii);
+            if (ii % 5 == 0) {
+                CHECK(Equal(out3.Get(ii), ak::Vec3{0, 0, 0}));
+                CHECK(Equal(out4.Get(ii), ak::Vec4{0, 0, 0, 0}));
+                CHECK(std::isfinite(inv3[ii]));
+                CHECK(std::isfinite(inv4[ii]));
+                continue;
+            }
+            CHECK(ak::Length(out3.Get(ii)) == Approx(1.0f).epsilon(kRsqrtError * 2));
+            CHECK(ak::Length(out4.Get(ii)) == Approx(1.0f).epsilon(kRsqrtError * 2));
+            CHECK(inv3[ii] == Approx(1.0f / ak::Length(v3)).epsilon(kRsqrtError));
+            CHECK(inv4[ii] == Approx(1.0f / ak::Length(v4)).epsilon(kRsqrtError));
+        }
+
+        CheckFastSoAKernels<3>(count);
+        CheckFastSoAKernels<4>(count);
+    }
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include "akmath.h"
+
+#include <float.h>
+#include <math.h>
+#include <random>
+#include <stdint.h>
+#include <string>
+
+// Random inputs shared by the test files. Every TEST_CASE draws from one generator, which a
+// listener in math-test.cpp reseeds from the test case's name, so a test sees the same inputs
+// however many other tests ran before it or were filtered out.
+inline std::mt19937& Rng()
+{
+    static std::mt19937 rng;
+    return rng;
+}
+inline void SeedRng(std::string const& name)
+{
+    std::seed_seq seed(name.begin(), name.end());
+    Rng().seed(seed);
+}
+
+inline float RandFloat(float const min, float const max)
+{
+    return std::uniform_real_distribution<float>(min, max)(Rng());
+}
+// Uniform in [0, n)
+inline uint32_t RandIndex(size_t const n)
+{
+    return std::uniform_int_distribution<uint32_t>(0, static_cast<uint32_t>(n - 1))(Rng());
+}
+
+inline ak::Vec3 RandVec3()
+{
+    return {RandFloat(-50.0f, 50.0f), RandFloat(-50.0f, 50.0f), RandFloat(-50.0f, 50.0f)};
+}
+inline ak::Vec4 RandVec4()
+{
+    return {RandFloat(-50.0f, 50.0f), RandFloat(-50.0f, 50.0f), RandFloat(-50.0f, 50.0f),
+            RandFloat(-50.0f, 50.0f)};
+}
+inline ak::Mat4 RandMat4()
+{
+    return {RandVec4(), RandVec4(), RandVec4(), RandVec4()};
+}
+
+// The rounding error of a sum of products is bounded by the sum of its terms' magnitudes, so
+// results that cancel to near zero are compared against that sum rather than against their own
+// value. FMA and separately rounded kernels both stay within a few epsilon of it.
+inline bool Near(float const actual, float const expected, float const magnitude)
+{
+    return fabsf(actual - expected) <= 4.0f * FLT_EPSILON * magnitude;
+}
+inline bool Near(ak::Vec3 const actual, ak::Vec3 const expected, ak::Vec3 const magnitude)
+{
+    return Near(actual.x, expected.x, magnitude.x) && Near(actual.y, expected.y, magnitude.y) &&
+           Near(actual.z, expected.z, magnitude.z);
+}
+inline bool Near(ak::Vec4 const actual, ak::Vec4 const expected, ak::Vec4 const magnitude)
+{
+    return Near(actual.x, expected.x, magnitude.x) && Near(actual.y, expected.y, magnitude.y) &&
+           Near(actual.z, expected.z, magnitude.z) && Near(actual.w, expected.w, magnitude.w);
+}
+
+// Heap arrays of Mat4 need explicit alignment until C++17's aligned new.
+struct Mat4Array
+{
+    explicit Mat4Array(size_t const n)
+        : data(static_cast<ak::Mat4*>(_mm_malloc(n * sizeof(ak::Mat4), alignof(ak::Mat4))))
+        , count(n)
+    {
+        for (size_t ii = 0; ii < count; ++ii) {
+            data[ii] = RandMat4();
+        }
+    }
+    ~Mat4Array()
+    {
+        _mm_free(data);
+    }
+    Mat4Array(Mat4Array const&) = delete;
+    Mat4Array& operator=(Mat4Array const&) = delete;
+
+    ak::Mat4* data;
+    size_t count;
+};